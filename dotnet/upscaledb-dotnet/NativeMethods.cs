@@ -48,6 +48,8 @@ namespace Upscaledb
       public Int32 size;
       public byte *data;
       public Int32 flags;
+      public Int32 partial_offset;
+      public Int32 partial_size;
     }
 
     [StructLayout(LayoutKind.Sequential)]
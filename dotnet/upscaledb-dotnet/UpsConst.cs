@@ -112,6 +112,8 @@ namespace Upscaledb
     /// <summary>Flag for Database.Open</summary>
     public const int UPS_READ_ONLY              =  0x004;
     /// <summary>Flag for Database.Create</summary>
+    public const int UPS_ENABLE_RECORD_DEDUPLICATION = 0x008;
+    /// <summary>Flag for Database.Create</summary>
     public const int UPS_IN_MEMORY              =  0x00080;
     /// <summary>Flag for Database.Open, Database.Create</summary>
     public const int UPS_DISABLE_MMAP           =  0x00200;
@@ -189,6 +191,25 @@ namespace Upscaledb
     public const int UPS_PARAM_RECORD_COMPRESSION   = 0x1001;
     /// <summary>Value for Database.Create, /// Database.Open</summary>
     public const int UPS_PARAM_KEY_COMPRESSION      = 0x1002;
+    /// <summary>Value for Environment.Create, Environment.Open,
+    /// Database.Create, Database.Open</summary>
+    public const int UPS_PARAM_COMPRESSION_LEVEL    = 0x1003;
+    /// <summary>Value for Environment.Create</summary>
+    public const int UPS_PARAM_PAGE_COMPRESSION     = 0x1004;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_COMPRESSED_CACHE_SIZE = 0x1005;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_JOURNAL_DELTAS       = 0x1006;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_JOURNAL_SEGMENT_SIZE = 0x1007;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_JOURNAL_SEGMENTS     = 0x1008;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL = 0x1009;
+    /// <summary>Value for Environment.Open</summary>
+    public const int UPS_PARAM_RECOVERY_THREADS     = 0x100a;
+    /// <summary>Value for Environment.Create, Environment.Open</summary>
+    public const int UPS_PARAM_UQI_THREADS          = 0x113;
     /// <summary>"null" compression</summary>
     public const int UPS_COMPRESSION_NONE                 =      0;
     /// <summary>zlib compression</summary>
@@ -199,6 +220,10 @@ namespace Upscaledb
     public const int UPS_COMPRESSION_LZF                  =      3;
     /// <summary>lzop compression</summary>
     public const int UPS_COMPRESSION_LZOP                 =      4;
+    /// <summary>lz4 compression</summary>
+    public const int UPS_COMPRESSION_LZ4                  =      4;
+    /// <summary>zstd compression</summary>
+    public const int UPS_COMPRESSION_ZSTD                 =      9;
 
     // Database operations
     /// <summary>Flag for Database.Insert, Cursor.Insert</summary>
@@ -140,11 +140,13 @@ extern "C" {
  *   2.1.5:  new freelist; version is 3
  *   2.1.9:  changes in btree node format; version is 4
  *   2.1.13: changes in btree node format; version is 5
+ *   2.2.2:  size-class based blob pages, deduplicated blobs, record
+ *           compression dictionaries, compressed leaf pages; version is 6
  */
 #define UPS_VERSION_MAJ     2
 #define UPS_VERSION_MIN     2
 #define UPS_VERSION_REV     1
-#define UPS_FILE_VERSION    5
+#define UPS_FILE_VERSION    6
 
 /**
  * The upscaledb Database structure
@@ -209,6 +211,12 @@ typedef struct {
   /** The record flags; see @ref UPS_RECORD_USER_ALLOC */
   uint32_t flags;
 
+  /** The offset of a partial read; see @ref UPS_PARTIAL */
+  uint32_t partial_offset;
+
+  /** The size of a partial read; see @ref UPS_PARTIAL */
+  uint32_t partial_size;
+
 } ups_record_t;
 
 /** Flag for @ref ups_record_t (only really useful in combination with
@@ -222,7 +230,7 @@ typedef struct {
  * Usage:
  *    ups_record_t rec = ups_make_record(ptr, size);
  */
-#define ups_make_record(PTR, SIZE) { SIZE, PTR, 0 }
+#define ups_make_record(PTR, SIZE) { SIZE, PTR, 0, 0, 0 }
 
 /**
  * A generic key.
@@ -537,6 +545,13 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  * upscaledb documentation for more details. This parameter is not
  * persisted.
  *
+ * The B+tree leaf pages can be compressed when they are written to disk
+ * by supplying the parameter @ref UPS_PARAM_PAGE_COMPRESSION. A compressed
+ * page only reads and writes its compressed data; the unused storage of
+ * the page is released (on file systems which support sparse files).
+ * This parameter is persisted and cannot be combined with
+ * @ref UPS_IN_MEMORY or @ref UPS_PARAM_ENCRYPTION_KEY.
+ *
  * Upscaledb can transparently encrypt the generated file using
  * 128bit AES in CBC mode. The transactional journal is not encrypted.
  * Encryption can be enabled by specifying @ref UPS_PARAM_ENCRYPTION_KEY
@@ -609,6 +624,29 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      waiting for data from a remote server. By default, no timeout is set.
  *    <li>@ref UPS_PARAM_ENABLE_JOURNAL_COMPRESSION</li> Compresses
  *      the journal files to reduce I/O. See notes above.
+ *    <li>@ref UPS_PARAM_JOURNAL_DELTAS</li> Logs only the modified
+ *      bytes of a page instead of the whole page. Disabled (0) by
+ *      default; not persisted.
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENT_SIZE</li> The size of a journal
+ *      segment file, in bytes. Default is 4 MB; not persisted.
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENTS</li> The number of preallocated
+ *      journal segment files. Default is 2; not persisted.
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> The number of
+ *      journal bytes between two checkpoints. Default is 1 MB; not
+ *      persisted.
+ *    <li>@ref UPS_PARAM_PAGE_COMPRESSION</li> Compresses the B+tree
+ *      leaf pages to reduce the file size and I/O. See notes above.
+ *    <li>@ref UPS_PARAM_COMPRESSED_CACHE_SIZE</li> The size (in bytes) of
+ *      a secondary cache which stores compressed images of clean pages
+ *      evicted from the cache; they are decompressed instead of being
+ *      read from disk. Disabled (0) by default. Not allowed in
+ *      combination with @ref UPS_IN_MEMORY; not persisted.
+ *    <li>@ref UPS_PARAM_UQI_THREADS</li> The number of threads for
+ *      scanning a Database with @ref uqi_select_range. See the
+ *      documentation of @ref UPS_PARAM_UQI_THREADS. Disabled (0) by
+ *      default; not persisted.
+ *    <li>@ref UPS_PARAM_COMPRESSION_LEVEL</li> The compression level
+ *      of the journal and the pages (for zlib and zstd); not persisted.
  *    <li>@ref UPS_PARAM_ENCRYPTION_KEY</li> The 16 byte long AES
  *      encryption key; enables AES encryption for the Environment file. Not
  *      allowed for In-Memory Environments. Ignored for remote Environments.
@@ -706,6 +744,14 @@ ups_env_create(ups_env_t **env, const char *filename,
  *    <li>@ref UPS_PARAM_CACHE_SIZE </li> The size of the Database cache,
  *      in bytes. The default size is defined in src/config.h
  *      as @a UPS_DEFAULT_CACHE_SIZE - usually 2MB
+ *    <li>@ref UPS_PARAM_COMPRESSED_CACHE_SIZE</li> The size (in bytes) of
+ *      the compressed cache for evicted pages. Disabled (0) by default.
+ *    <li>@ref UPS_PARAM_UQI_THREADS</li> The number of threads for
+ *      scanning a Database with @ref uqi_select_range. Disabled (0) by
+ *      default.
+ *    <li>@ref UPS_PARAM_RECOVERY_THREADS</li> The number of threads
+ *      which write the recovered pages if @ref UPS_AUTO_RECOVERY is
+ *      specified. Default is 1.
  *    <li>@ref UPS_PARAM_POSIX_FADVISE</li> Sets the "advice" for
  *      posix_fadvise(). Only on supported platforms. Allowed values are
  *      @ref UPS_POSIX_FADVICE_NORMAL (which is the default) or
@@ -720,6 +766,17 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      waiting for data from a remote server. By default, no timeout is set.
  *    <li>@ref UPS_PARAM_JOURNAL_COMPRESSION</li> Compresses
  *      the journal files to reduce I/O. See notes above.
+ *    <li>@ref UPS_PARAM_JOURNAL_DELTAS</li> Logs only the modified
+ *      bytes of a page instead of the whole page. Disabled (0) by
+ *      default.
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENT_SIZE</li> The size of a journal
+ *      segment file, in bytes. Default is 4 MB.
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENTS</li> The number of preallocated
+ *      journal segment files. Default is 2.
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> The number of
+ *      journal bytes between two checkpoints. Default is 1 MB.
+ *    <li>@ref UPS_PARAM_COMPRESSION_LEVEL</li> The compression level
+ *      of the journal (for zlib and zstd); not persisted.
  *    <li>@ref UPS_PARAM_ENCRYPTION_KEY</li> The 16 byte long AES
  *      encryption key; enables AES encryption for the Environment file. Not
  *      allowed for In-Memory Environments. Ignored for remote Environments.
@@ -766,6 +823,23 @@ ups_env_open(ups_env_t **env, const char *filename,
  *    <li>@ref UPS_PARAM_JOURNAL_COMPRESSION</li> Returns the
  *        selected algorithm for journal compression, or 0 if compression
  *        is disabled
+ *    <li>@ref UPS_PARAM_PAGE_COMPRESSION</li> Returns the
+ *        selected algorithm for page compression, or 0 if compression
+ *        is disabled
+ *    <li>@ref UPS_PARAM_COMPRESSED_CACHE_SIZE</li> Returns the size
+ *        of the compressed cache, or 0 if it is disabled
+ *    <li>@ref UPS_PARAM_JOURNAL_DELTAS</li> Returns 1 if the journal
+ *        logs page deltas, otherwise 0
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENT_SIZE</li> Returns the size of
+ *        a journal segment file, or 0 if the default is used
+ *    <li>@ref UPS_PARAM_JOURNAL_SEGMENTS</li> Returns the number of
+ *        preallocated journal segments, or 0 if the default is used
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> Returns the
+ *        checkpoint interval, or 0 if the default is used
+ *    <li>@ref UPS_PARAM_RECOVERY_THREADS</li> Returns the number of
+ *        threads for the recovery, or 0 if the default is used
+ *    <li>@ref UPS_PARAM_UQI_THREADS</li> Returns the number of threads
+ *        for parallel scans, or 0 if parallel scans are disabled
  *    </ul>
  *
  * @param env A valid Environment handle
@@ -892,6 +966,16 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  *      a plain C implementation.</li>
  * </ul>
  *
+ * Databases with the type @ref UPS_TYPE_UINT64 (including record number
+ * Databases created with @ref UPS_RECORD_NUMBER64) can use
+ *
+ * <ul>
+ *   <li>@ref UPS_COMPRESSOR_UINT64_VARBYTE: delta-encoded variable-length
+ *      integers; good compression for sparse keys.</li>
+ *   <li>@ref UPS_COMPRESSOR_UINT64_FOR: Frame Of Reference; fast lookups,
+ *      best for dense keys (i.e. record numbers or timestamps).</li>
+ * </ul>
+ *
  * @param env A valid Environment handle.
  * @param db A valid Database handle, which will point to the created
  *      Database. To close the handle, use @ref ups_db_close.
@@ -916,6 +1000,12 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  *      (and key->flags is @ref UPS_KEY_USER_ALLOC), the value of the current
  *      key is returned in @a key. If key-data is NULL and key->size is 0,
  *      key->data is temporarily allocated by upscaledb.
+ *     <li>@ref UPS_ENABLE_RECORD_DEDUPLICATION </li> Stores identical
+ *      records only once. Records are identified by a hash of their
+ *      contents; keys with identical records share the same blob, which is
+ *      reference counted. Only records which are not stored in the B+Tree
+ *      leaf (i.e. larger than 8 bytes) are deduplicated. Not allowed in
+ *      In-Memory Environments.
  *    </ul>
  *
  * @param params An array of ups_parameter_t structures. The following
@@ -937,6 +1027,8 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  *      the records.
  *    <li>@ref UPS_PARAM_KEY_COMPRESSION</li> Compresses
  *      the keys.
+ *    <li>@ref UPS_PARAM_COMPRESSION_LEVEL</li> The compression level
+ *      of the records and keys (for zlib and zstd); not persisted.
  *    <li>@ref UPS_PARAM_CUSTOM_COMPARE_NAME</li> Specifies the name of the
  *      custom compare function (only if @a UPS_PARAM_KEY_TYPE is @a
  *      UPS_TYPE_CUSTOM).
@@ -991,7 +1083,12 @@ ups_env_create_db(ups_env_t *env, ups_db_t **db,
  *      Operations that need write access (i.e. @ref ups_db_insert) will
  *      return @ref UPS_WRITE_PROTECTED.
  *   </ul>
- * @param params Reserved; set to NULL
+ * @param params An array of ups_parameter_t structures. The following
+ *    parameters are available:
+ *    <ul>
+ *    <li>@ref UPS_PARAM_COMPRESSION_LEVEL</li> The compression level
+ *      of the records and keys (for zlib and zstd); not persisted.
+ *    </ul>
  *
  * @return @ref UPS_SUCCESS upon success
  * @return @ref UPS_INV_PARAMETER if the @a env pointer is NULL or an
@@ -1275,7 +1372,9 @@ ups_txn_abort(ups_txn_t *txn, uint32_t flags);
  * This flag is non persistent. */
 #define UPS_READ_ONLY                               0x00000004
 
-/* unused                                           0x00000008 */
+/** Flag for @ref ups_env_create_db.
+ * This flag is persisted in the Database. */
+#define UPS_ENABLE_RECORD_DEDUPLICATION             0x00000008
 
 /* unused                                           0x00000010 */
 
@@ -1459,6 +1558,9 @@ ups_db_set_compare_func(ups_db_t *db, ups_compare_func_t foo);
  *        the first record which' key is larger than the specified
  *        key, whichever of these records is located first.
  *        When such records cannot be located, an error is returned.
+ *    <li>@ref UPS_PARTIAL </li> Only reads the window of the record
+ *        which is specified by @a record.partial_offset and
+ *        @a record.partial_size.
  *    </ul>
  *
  * @return @ref UPS_SUCCESS upon success
@@ -1580,6 +1682,20 @@ ups_db_insert(ups_db_t *db, ups_txn_t *txn, ups_key_t *key,
 /* internal flag */
 #define UPS_DIRECT_ACCESS               0x0040
 
+/**
+ * Flag for @ref ups_db_find, @ref ups_cursor_find and @ref ups_cursor_move:
+ * only reads the window of @a record.partial_size bytes, starting at
+ * @a record.partial_offset. The window is clamped to the size of the
+ * record; @a record.size returns the number of bytes that were read.
+ *
+ * Only the pages covering the window are read. If the window is stored
+ * in memory-mapped storage then @a record.data points directly into the
+ * mapping (unless @ref UPS_RECORD_USER_ALLOC is set).
+ *
+ * Not supported by remote Databases.
+ */
+#define UPS_PARTIAL                     0x0080
+
 /* internal flag */
 #define UPS_FORCE_DEEP_COPY             0x0100
 
@@ -1681,9 +1797,52 @@ ups_db_count(ups_db_t *db, ups_txn_t *txn, uint32_t flags, uint64_t *count);
 UPS_EXPORT ups_status_t UPS_CALLCONV
 ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 
+/**
+ * Trains a dictionary for the record compression
+ *
+ * Small, similar records compress badly if each record is compressed on
+ * its own. This function samples records of the Database, trains a
+ * dictionary and stores it in the Environment. All records which are
+ * inserted or overwritten afterwards are compressed with this dictionary.
+ *
+ * The function can be called again at any time to train a new dictionary,
+ * i.e. when the data has changed. Existing records are not recompressed;
+ * they continue to use the dictionary they were compressed with, and
+ * therefore old dictionaries are never deleted.
+ *
+ * Dictionaries are supported by @ref UPS_COMPRESSOR_ZLIB and
+ * @ref UPS_COMPRESSOR_ZSTD. zstd trains a real dictionary; for zlib the
+ * dictionary is built from the sampled records.
+ *
+ * Records which are stored in pending Transactions are not sampled.
+ * In-Memory Databases do not persist the dictionary.
+ *
+ * This API is not supported by remote Databases.
+ *
+ * @param db A valid Database handle
+ * @param sample_count The maximum number of records which are sampled;
+ *        the samples are spread evenly over the Database. 0 uses the
+ *        default (1000)
+ * @param dictionary_size The maximum size of the dictionary, in bytes.
+ *        0 uses the default (16 kb); zlib uses at most 32 kb
+ * @param flags Unused, set to 0
+ *
+ * @return @ref UPS_SUCCESS upon success
+ * @return @ref UPS_INV_PARAMETER if the @a db pointer is NULL or if the
+ *        record compressor does not support dictionaries
+ * @return @ref UPS_KEY_NOT_FOUND if the Database does not have any records
+ * @return @ref UPS_WRITE_PROTECTED if the Database is read-only
+ * @return @ref UPS_LIMITS_REACHED if the Database already has 65535
+ *        dictionaries
+ * @return @ref UPS_NOT_IMPLEMENTED if the Database is remote
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_db_train_dictionary(ups_db_t *db, uint32_t sample_count,
+                uint32_t dictionary_size, uint32_t flags);
+
 /** Parameter name for @ref ups_env_open, @ref ups_env_create;
- * Journal files are switched whenever the number of new Transactions exceeds
- * this threshold. */
+ * deprecated and ignored. Journal segments are switched when they are full
+ * (see @ref UPS_PARAM_JOURNAL_SEGMENT_SIZE). */
 #define UPS_PARAM_JOURNAL_SWITCH_THRESHOLD 0x00001
 
 /** Parameter name for @ref ups_env_open, @ref ups_env_create;
@@ -1738,6 +1897,27 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 /** Parameter name for @ref ups_env_create_db; sets the record type */
 #define UPS_PARAM_RECORD_TYPE           0x00000112
 
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of threads which scan a Database in parallel for
+ * @ref uqi_select_range.
+ *
+ * The leaf pages are split into ranges, and each range is scanned by
+ * a separate thread; the partial results are merged afterwards. This is
+ * only done for the builtin functions "sum", "count", "min", "max",
+ * "average", "top" and "bottom" (with or without a predicate), if the
+ * whole Database is scanned, if the Database has no duplicate keys and no
+ * pending Transactions, and if the keys (or records) which are scanned
+ * are stored in the B+tree pages (i.e. fixed-length keys, or records
+ * with @ref UPS_FORCE_RECORDS_INLINE). Otherwise the Database is scanned
+ * by the calling thread.
+ *
+ * Predicate plugins are called concurrently and therefore must be
+ * thread-safe. A value of 0 or 1 disables parallel scans. This
+ * parameter is not persisted.
+ */
+#define UPS_PARAM_UQI_THREADS           0x00000113
+
 /** Value for @ref UPS_PARAM_POSIX_FADVISE */
 #define UPS_POSIX_FADVICE_NORMAL                 0
 
@@ -1800,6 +1980,71 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
  */
 #define UPS_PARAM_KEY_COMPRESSION       0x00001002
 
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open,
+ * @ref ups_env_create_db and @ref ups_env_open_db; sets the compression
+ * level of the journal (Environment parameter) or of the records and keys
+ * (Database parameter). Only used by @ref UPS_COMPRESSOR_ZLIB (1 - 9) and
+ * @ref UPS_COMPRESSOR_ZSTD (1 - 22). The default (0) uses the library's
+ * default level. This parameter is not persisted.
+ */
+#define UPS_PARAM_COMPRESSION_LEVEL     0x00001003
+
+/**
+ * Parameter name for @ref ups_env_create; compresses the B+tree leaf
+ * pages when they are written to disk. This parameter is persisted.
+ */
+#define UPS_PARAM_PAGE_COMPRESSION      0x00001004
+
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * size (in bytes) of a compressed cache for pages which were evicted
+ * from the cache. This parameter is not persisted.
+ */
+#define UPS_PARAM_COMPRESSED_CACHE_SIZE 0x00001005
+
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; if set to 1
+ * then the journal only stores the modified bytes of each page instead
+ * of the full page images. Recovery applies the deltas to the pages of the
+ * Environment file. This parameter is not persisted.
+ */
+#define UPS_PARAM_JOURNAL_DELTAS        0x00001006
+
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * size (in bytes) of a journal segment file. The journal is stored in
+ * segment files of this size, which are preallocated and recycled when
+ * their entries are no longer required for recovery. Default is 4 MB;
+ * not persisted.
+ */
+#define UPS_PARAM_JOURNAL_SEGMENT_SIZE  0x00001007
+
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of preallocated journal segment files. Additional segments are
+ * created if no segment can be recycled. Default is 2; not persisted.
+ */
+#define UPS_PARAM_JOURNAL_SEGMENTS      0x00001008
+
+/**
+ * Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of journal bytes between two checkpoints. A checkpoint records
+ * which changesets were already written to the Environment file; recovery
+ * does not re-apply these changesets. The database file is flushed in
+ * the background before the checkpoint is written. Default is 1 MB;
+ * not persisted.
+ */
+#define UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL   0x00001009
+
+/**
+ * Parameter name for @ref ups_env_open; sets the number of threads which
+ * re-apply the journal's changesets if @ref UPS_AUTO_RECOVERY is
+ * specified. The pages are partitioned by their address; each page is
+ * written by a single thread. Default is 1; not persisted.
+ */
+#define UPS_PARAM_RECOVERY_THREADS      0x0000100a
+
 /** helper macro for disabling compression */
 #define UPS_COMPRESSOR_NONE         0
 
@@ -1821,6 +2066,19 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
  */
 #define UPS_COMPRESSOR_LZF          3
 
+/**
+ * selects lz4 compression
+ * http://lz4.github.io/lz4/
+ */
+#define UPS_COMPRESSOR_LZ4          4
+
+/**
+ * selects zstandard compression; the compression level can be set with
+ * @ref UPS_PARAM_COMPRESSION_LEVEL
+ * http://facebook.github.io/zstd/
+ */
+#define UPS_COMPRESSOR_ZSTD         9
+
 /** uint32 key compression (varbyte) */
 #define UPS_COMPRESSOR_UINT32_VARBYTE       5
 #define UPS_COMPRESSOR_UINT32_MASKEDVBYTE   UPS_COMPRESSOR_UINT32_VARBYTE
@@ -1840,6 +2098,12 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 /** uint32 key compression (SIMDFOR - Frame Of Reference w/ SIMD) */
 #define UPS_COMPRESSOR_UINT32_SIMDFOR      11
 
+/** uint64 key compression (varbyte) */
+#define UPS_COMPRESSOR_UINT64_VARBYTE      12
+
+/** uint64 key compression (Frame Of Reference) */
+#define UPS_COMPRESSOR_UINT64_FOR          13
+
 /**
  * Retrieves the Environment handle of a Database
  *
@@ -2017,6 +2281,9 @@ ups_cursor_clone(ups_cursor_t *src, ups_cursor_t **dest);
  *      <li>@ref UPS_ONLY_DUPLICATES </li> only move through duplicate keys
  *        of the current key. Not allowed in combination with
  *        @ref UPS_SKIP_DUPLICATES.
+ *      <li>@ref UPS_PARTIAL </li> only reads the window of the record
+ *        which is specified by @a record.partial_offset and
+ *        @a record.partial_size.
  *   </ul>
  *
  * @return @ref UPS_SUCCESS upon success
@@ -213,6 +213,12 @@ class record {
       _record.flags = flags;
     }
 
+    /** Sets the window for partial reads; see @ref UPS_PARTIAL. */
+    void set_partial(uint32_t offset, uint32_t size) {
+      _record.partial_offset = offset;
+      _record.partial_size = size;
+    }
+
     /** Returns a pointer to the internal ups_record_t structure. */
     ups_record_t *get_handle() {
       return &_record;
@@ -396,6 +402,15 @@ class db {
         throw error(st);
     }
 
+    /** Trains a dictionary for the record compression. */
+    void train_dictionary(uint32_t sample_count = 0,
+                    uint32_t dictionary_size = 0) {
+      ups_status_t st = ups_db_train_dictionary(_db, sample_count,
+                      dictionary_size, 0);
+      if (st)
+        throw error(st);
+    }
+
     /** Closes the Database.
      * Ignores the flag |UPS_AUTO_CLEANUP|. All objects will be destroyed
      * automatically when they are destructed.
@@ -209,7 +209,7 @@ typedef struct btree_metrics_t {
  * Metrics marked "global" are stored globally and shared between multiple
  * Environments.
  */
-#define UPS_METRICS_VERSION         9
+#define UPS_METRICS_VERSION         12
 
 typedef struct ups_env_metrics_t {
   /* the version indicator - must be UPS_METRICS_VERSION */
@@ -265,6 +265,36 @@ typedef struct ups_env_metrics_t {
   /* number of blobs read */
   uint64_t blob_total_read;
 
+  /* number of blobs allocated in size-class (slab) pages */
+  uint64_t blob_slab_allocated;
+
+  /* number of slab allocations which reused a free slot of an existing page */
+  uint64_t blob_slab_reused;
+
+  /* bytes lost because slab blobs are rounded up to their size class */
+  uint64_t blob_slab_padding;
+
+  /* number of slab pages with free slots (from the persistent index) */
+  uint64_t blob_slab_pages_with_free_space;
+
+  /* number of partial blob reads (UPS_PARTIAL) */
+  uint64_t blob_partial_read;
+
+  /* number of bytes returned by partial blob reads */
+  uint64_t blob_partial_read_bytes;
+
+  /* number of records which were stored as a reference to an existing,
+   * identical blob (UPS_ENABLE_RECORD_DEDUPLICATION) */
+  uint64_t blob_dedup_hits;
+
+  /* number of record bytes written to deduplicated databases */
+  uint64_t blob_dedup_logical_bytes;
+
+  /* number of record bytes which were actually stored by deduplicated
+   * databases; the deduplication ratio is
+   * blob_dedup_logical_bytes / blob_dedup_stored_bytes */
+  uint64_t blob_dedup_stored_bytes;
+
   /* (global) number of btree page splits */
   uint64_t btree_smo_split;
 
@@ -286,6 +316,34 @@ typedef struct ups_env_metrics_t {
   /* log/journal bytes after compression */
   uint64_t journal_bytes_after_compression;
 
+  /* log/journal bytes which are queued for the journal writer thread */
+  uint64_t journal_queued_bytes;
+
+  /* number of writes of the journal writer thread */
+  uint64_t journal_writes;
+
+  /* accumulated latency of these writes (including fsync), in
+   * microseconds */
+  uint64_t journal_write_latency_us;
+
+  /* maximum latency of a single journal write, in microseconds */
+  uint64_t journal_max_write_latency_us;
+
+  /* number of journal segment files */
+  uint64_t journal_segments;
+
+  /* number of journal segments which were recycled */
+  uint64_t journal_segments_recycled;
+
+  /* number of journal checkpoints */
+  uint64_t journal_checkpoints;
+
+  /* number of changesets which would be re-applied by a recovery */
+  uint64_t journal_recovery_changesets;
+
+  /* number of journal bytes which would be read by a recovery */
+  uint64_t journal_recovery_bytes;
+
   /* record bytes before compression */
   uint64_t record_bytes_before_compression;
 
@@ -298,6 +356,21 @@ typedef struct ups_env_metrics_t {
   /* key bytes after compression */
   uint64_t key_bytes_after_compression;
 
+  /* B+tree leaf page bytes before compression */
+  uint64_t page_bytes_before_compression;
+
+  /* B+tree leaf page bytes after compression */
+  uint64_t page_bytes_after_compression;
+
+  /* number of pages which were decompressed from the compressed cache */
+  uint64_t compressed_cache_hits;
+
+  /* number of pages which were not found in the compressed cache */
+  uint64_t compressed_cache_misses;
+
+  /* number of bytes currently stored in the compressed cache */
+  uint64_t compressed_cache_bytes;
+
   /* btree metrics for leaf nodes */
   btree_metrics_t btree_leaf_metrics;
 
@@ -406,6 +479,120 @@ ups_db_bulk_operations(ups_db_t *db, ups_txn_t *txn,
                     struct ups_operation_t *operations,
                     size_t operations_length, uint32_t flags);
 
+/**
+ * A cursor which reads the committed entries of an Environment's journal
+ */
+struct ups_journal_cursor_t;
+typedef struct ups_journal_cursor_t ups_journal_cursor_t;
+
+/**
+ * A journal entry, as returned by @ref ups_journal_cursor_next
+ */
+typedef struct ups_journal_entry_t {
+  /** The lsn of the entry */
+  uint64_t lsn;
+
+  /** The id of the Transaction; 0 for operations without Transaction */
+  uint64_t txn_id;
+
+  /** The type of the entry; one of the UPS_JOURNAL_ENTRY_* values */
+  uint32_t type;
+
+  /** The name of the modified Database */
+  uint16_t dbname;
+
+  /** The size of @a data */
+  uint32_t size;
+
+  /** The serialized entry; can be stored or sent to another process,
+   * and is applied with @ref ups_env_apply_journal_entry */
+  const void *data;
+} ups_journal_entry_t;
+
+#define UPS_JOURNAL_ENTRY_TXN_BEGIN         1
+#define UPS_JOURNAL_ENTRY_TXN_COMMIT        3
+#define UPS_JOURNAL_ENTRY_INSERT            4
+#define UPS_JOURNAL_ENTRY_ERASE             5
+#define UPS_JOURNAL_ENTRY_CHANGESET         6
+#define UPS_JOURNAL_ENTRY_CHANGESET_DELTA   7
+
+/** Flag for @ref ups_env_open_journal_cursor: also return the changesets */
+#define UPS_JOURNAL_INCLUDE_CHANGESETS      1
+
+/**
+ * Opens a cursor which reads the committed entries of the journal
+ *
+ * The entries are returned in the order of their commits. The entries of
+ * a Transaction (begin, inserts, erases and commit) are returned back to
+ * back when it was committed; aborted Transactions are not returned.
+ * Entries whose lsn is <= @a start_lsn are skipped; for a Transaction,
+ * the lsn of the commit entry is relevant. A follower therefore resumes
+ * with the lsn of the last entry which it applied.
+ *
+ * Only the entries which are still stored in the journal can be returned;
+ * the journal segments which are not yet read by the cursor are not
+ * recycled while the cursor is open.
+ *
+ * The changesets (the modified pages of the database file) are only
+ * returned if @ref UPS_JOURNAL_INCLUDE_CHANGESETS is specified.
+ *
+ * The cursor has to be closed with @ref ups_journal_cursor_close before
+ * the Environment is closed.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a env or @a cursor is null, or if the
+ *      Environment does not have a journal
+ * @return UPS_NOT_IMPLEMENTED if @a env is a remote Environment
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_env_open_journal_cursor(ups_env_t *env, uint64_t start_lsn,
+                    uint32_t flags, ups_journal_cursor_t **cursor);
+
+/**
+ * Returns the next committed journal entry
+ *
+ * The @a entry (and its data) is valid till the next call. If there are
+ * no further entries then UPS_KEY_NOT_FOUND is returned; entries which
+ * are committed afterwards are returned by the next call.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a cursor or @a entry is null
+ * @return UPS_KEY_NOT_FOUND if there are no further entries
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_journal_cursor_next(ups_journal_cursor_t *cursor,
+                    ups_journal_entry_t *entry);
+
+/**
+ * Closes a journal cursor
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_journal_cursor_close(ups_journal_cursor_t *cursor);
+
+/**
+ * Applies a journal entry to another Environment
+ *
+ * The entry was returned by @ref ups_journal_cursor_next, maybe in
+ * another process. Inserts and erases are applied to the Database with
+ * the same name, which has to exist in @a env (creating a Database is
+ * not journalled). Databases which are not yet open are opened, and stay
+ * open till the Environment is closed (see
+ * @ref ups_env_get_open_database). If @a env has Transactions then the
+ * entries of a Transaction are applied in a Transaction as well.
+ * Changesets are ignored, because @a env maintains its own file.
+ *
+ * Like the recovery, an insert of an existing key or an erase of
+ * a missing key do not fail.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a env or @a entry is null, or if the
+ *      entry is invalid
+ * @return UPS_DATABASE_NOT_FOUND if the Database does not exist
+ * @return UPS_NOT_IMPLEMENTED if @a env is a remote Environment
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_env_apply_journal_entry(ups_env_t *env, const ups_journal_entry_t *entry);
+
 /**
  * @}
  */
@@ -40,6 +40,18 @@ extern "C" {
 struct uqi_result_t;
 typedef struct uqi_result_t uqi_result_t;
 
+/**
+ * A prepared "UQI Select" query.
+ */
+struct uqi_statement_t;
+typedef struct uqi_statement_t uqi_statement_t;
+
+/**
+ * A cursor which returns the results of a query in chunks.
+ */
+struct uqi_cursor_t;
+typedef struct uqi_cursor_t uqi_cursor_t;
+
 /**
  * Returns the number of rows stored in a query result
  */
@@ -356,6 +368,106 @@ UPS_EXPORT ups_status_t UPS_CALLCONV
 uqi_select_range(ups_env_t *env, const char *query, ups_cursor_t *begin,
                             const ups_cursor_t *end, uqi_result_t **result);
 
+/**
+ * Prepares a "UQI Select" query for repeated execution.
+ *
+ * The @a query string (see @a uqi_select_range for the syntax) is parsed,
+ * and the plugins are resolved, only once. The prepared statement is then
+ * executed with @a uqi_execute, and has to be released with
+ * @a uqi_statement_close. It must not be used after the Environment
+ * was closed.
+ *
+ * For remote Environments, the query string is parsed by the server.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if any of the pointers is null
+ * @return UPS_PARSER_ERROR Failed to parse the @a query string
+ * @return UPS_PLUGIN_NOT_FOUND A plugin library could not be loaded
+ *
+ * @sa uqi_execute
+ * @sa uqi_statement_close
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_prepare(ups_env_t *env, const char *query, uqi_statement_t **statement);
+
+/**
+ * Executes a prepared "UQI Select" query.
+ *
+ * This function behaves like @a uqi_select_range; the cursors @a begin
+ * and @a end are optional and limit the range of the data. The @a result
+ * object is allocated automatically and has to be released with
+ * @a uqi_result_close by the caller.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a statement or @a result is null
+ * @return UPS_PARSER_ERROR if the function or predicate is not valid
+ *      for the database
+ *
+ * @sa uqi_prepare
+ * @sa uqi_select_range
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_execute(uqi_statement_t *statement, ups_cursor_t *begin,
+                            const ups_cursor_t *end, uqi_result_t **result);
+
+/**
+ * Releases a prepared statement
+ */
+UPS_EXPORT void UPS_CALLCONV
+uqi_statement_close(uqi_statement_t *statement);
+
+/**
+ * Opens a cursor for a "UQI Select" query.
+ *
+ * Unlike @a uqi_select_range, the rows of the result are not collected
+ * in a single @a uqi_result_t object. Instead, the Database is scanned
+ * incrementally, and @a uqi_cursor_next returns the rows in chunks. Use
+ * this for queries which return many rows, i.e. the function VALUE
+ * (with or without a predicate), to limit the memory consumption.
+ * Aggregating functions (i.e. SUM or COUNT) return their result in
+ * a single chunk when the scan is complete.
+ *
+ * The cursors @a begin and @a end are optional and limit the range of
+ * the data; they are cloned and are not modified.
+ *
+ * The cursor has to be closed with @a uqi_cursor_close before the Database
+ * is closed. If the Database is not yet opened, it will be opened in
+ * background till the cursor is closed.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a env, @a query or @a cursor is null
+ * @return UPS_PARSER_ERROR Failed to parse the @a query string
+ * @return UPS_PLUGIN_NOT_FOUND The specified function is not available
+ *
+ * @sa uqi_cursor_next
+ * @sa uqi_cursor_close
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_cursor_open(ups_env_t *env, const char *query, ups_cursor_t *begin,
+                            const ups_cursor_t *end, uqi_cursor_t **cursor);
+
+/**
+ * Retrieves the next chunk of rows from a query cursor.
+ *
+ * The @a result object is allocated automatically and has to be released
+ * with @a uqi_result_close by the caller. Modifications of the Database
+ * are visible in the following chunks.
+ *
+ * @return UPS_SUCCESS upon success
+ * @return UPS_INV_PARAMETER if @a cursor or @a result is null
+ * @return UPS_KEY_NOT_FOUND if there are no more rows
+ *
+ * @sa uqi_cursor_open
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_cursor_next(uqi_cursor_t *cursor, uqi_result_t **result);
+
+/**
+ * Closes a query cursor
+ */
+UPS_EXPORT void UPS_CALLCONV
+uqi_cursor_close(uqi_cursor_t *cursor);
+
 /**
  * @}
  */
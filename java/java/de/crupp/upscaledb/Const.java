@@ -147,6 +147,9 @@ public class Const {
   /** Flag for Database.open() */
   public final static int UPS_READ_ONLY             =  0x004;
 
+  /** Flag for Database.create() */
+  public final static int UPS_ENABLE_RECORD_DEDUPLICATION = 0x008;
+
   /** Flag for Database.create() */
   public final static int UPS_IN_MEMORY_DB          =  0x080;
 
@@ -214,6 +217,9 @@ public class Const {
   /** Parameter name for Environment.open(), Environment.create() */
   public final static int UPS_PARAM_CUSTOM_COMPARE_NAME =  0x111;
 
+  /** Parameter name for Environment.open(), Environment.create() */
+  public final static int UPS_PARAM_UQI_THREADS =  0x113;
+
   /** Value for unlimited record sizes */
   public final static int UPS_RECORD_SIZE_UNLIMITED =  0xffffffff;
 
@@ -245,6 +251,31 @@ public class Const {
   /** upscaledb pro: Parameter name for Database.create(), Database.open() */
   public final static int UPS_PARAM_KEY_COMPRESSION       = 0x01002;
 
+  /** upscaledb pro: Parameter name for Environment.create(),
+   * Environment.open(), Database.create(), Database.open() */
+  public final static int UPS_PARAM_COMPRESSION_LEVEL     = 0x01003;
+
+  /** upscaledb pro: Parameter name for Environment.create() */
+  public final static int UPS_PARAM_PAGE_COMPRESSION      = 0x01004;
+
+  /** Parameter name for Environment.create(), Environment.open() */
+  public final static int UPS_PARAM_COMPRESSED_CACHE_SIZE = 0x01005;
+
+  /** Parameter name for Environment.create(), Environment.open() */
+  public final static int UPS_PARAM_JOURNAL_DELTAS        = 0x01006;
+
+  /** Parameter name for Environment.create(), Environment.open() */
+  public final static int UPS_PARAM_JOURNAL_SEGMENT_SIZE  = 0x01007;
+
+  /** Parameter name for Environment.create(), Environment.open() */
+  public final static int UPS_PARAM_JOURNAL_SEGMENTS      = 0x01008;
+
+  /** Parameter name for Environment.create(), Environment.open() */
+  public final static int UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL = 0x01009;
+
+  /** Parameter name for Environment.open() */
+  public final static int UPS_PARAM_RECOVERY_THREADS      = 0x0100a;
+
   /** upscaledb pro: "null" compression */
   public final static int UPS_COMPRESSOR_NONE         =    0;
 
@@ -260,6 +291,12 @@ public class Const {
   /** upscaledb pro: lzop compression */
   public final static int UPS_COMPRESSOR_LZOP         =    4;
 
+  /** upscaledb pro: lz4 compression */
+  public final static int UPS_COMPRESSOR_LZ4          =    4;
+
+  /** upscaledb pro: zstd compression */
+  public final static int UPS_COMPRESSOR_ZSTD         =    9;
+
   /** Flag for Database.insert(), Cursor.insert() */
   public final static int UPS_OVERWRITE             =    1;
 
@@ -1651,6 +1651,8 @@ initupscaledb()
   add_const(d, "UPS_RECORD_NUMBER32", UPS_RECORD_NUMBER32);
   add_const(d, "UPS_RECORD_NUMBER64", UPS_RECORD_NUMBER64);
   add_const(d, "UPS_ENABLE_DUPLICATE_KEYS", UPS_ENABLE_DUPLICATE_KEYS);
+  add_const(d, "UPS_ENABLE_RECORD_DEDUPLICATION",
+                  UPS_ENABLE_RECORD_DEDUPLICATION);
   add_const(d, "UPS_AUTO_RECOVERY", UPS_AUTO_RECOVERY);
   add_const(d, "UPS_ENABLE_TRANSACTIONS", UPS_ENABLE_TRANSACTIONS);
   add_const(d, "UPS_CACHE_UNLIMITED", UPS_CACHE_UNLIMITED);
@@ -1692,11 +1694,25 @@ initupscaledb()
   add_const(d, "UPS_PARAM_JOURNAL_COMPRESSION", UPS_PARAM_JOURNAL_COMPRESSION);
   add_const(d, "UPS_PARAM_RECORD_COMPRESSION", UPS_PARAM_RECORD_COMPRESSION);
   add_const(d, "UPS_PARAM_KEY_COMPRESSION", UPS_PARAM_KEY_COMPRESSION);
+  add_const(d, "UPS_PARAM_COMPRESSION_LEVEL", UPS_PARAM_COMPRESSION_LEVEL);
+  add_const(d, "UPS_PARAM_PAGE_COMPRESSION", UPS_PARAM_PAGE_COMPRESSION);
+  add_const(d, "UPS_PARAM_COMPRESSED_CACHE_SIZE",
+                  UPS_PARAM_COMPRESSED_CACHE_SIZE);
+  add_const(d, "UPS_PARAM_JOURNAL_DELTAS", UPS_PARAM_JOURNAL_DELTAS);
+  add_const(d, "UPS_PARAM_JOURNAL_SEGMENT_SIZE",
+                  UPS_PARAM_JOURNAL_SEGMENT_SIZE);
+  add_const(d, "UPS_PARAM_JOURNAL_SEGMENTS", UPS_PARAM_JOURNAL_SEGMENTS);
+  add_const(d, "UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL",
+                  UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL);
+  add_const(d, "UPS_PARAM_RECOVERY_THREADS", UPS_PARAM_RECOVERY_THREADS);
   add_const(d, "UPS_PARAM_CUSTOM_COMPARE_NAME", UPS_PARAM_CUSTOM_COMPARE_NAME);
+  add_const(d, "UPS_PARAM_UQI_THREADS", UPS_PARAM_UQI_THREADS);
   add_const(d, "UPS_COMPRESSOR_NONE", UPS_COMPRESSOR_NONE);
   add_const(d, "UPS_COMPRESSOR_ZLIB", UPS_COMPRESSOR_ZLIB);
   add_const(d, "UPS_COMPRESSOR_SNAPPY", UPS_COMPRESSOR_SNAPPY);
   add_const(d, "UPS_COMPRESSOR_LZF", UPS_COMPRESSOR_LZF);
+  add_const(d, "UPS_COMPRESSOR_LZ4", UPS_COMPRESSOR_LZ4);
+  add_const(d, "UPS_COMPRESSOR_ZSTD", UPS_COMPRESSOR_ZSTD);
   add_const(d, "UPS_TXN_AUTO_ABORT", UPS_TXN_AUTO_ABORT);
   add_const(d, "UPS_TXN_AUTO_COMMIT", UPS_TXN_AUTO_COMMIT);
   add_const(d, "UPS_CURSOR_FIRST", UPS_CURSOR_FIRST);
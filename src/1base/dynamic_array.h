@@ -27,6 +27,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1mem/mem.h"
@@ -141,6 +142,13 @@ struct DynamicArray {
     _own = false;
   }
 
+  // Exchanges the contents (and ownership) with |other|
+  void swap(DynamicArray &other) {
+    std::swap(_ptr, other._ptr);
+    std::swap(_size, other._size);
+    std::swap(_own, other._own);
+  }
+
   // Pointer to the data
   T *_ptr;
 
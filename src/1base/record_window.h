@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Helpers for partial record reads (see UPS_PARTIAL).
+ */
+
+#ifndef UPS_RECORD_WINDOW_H
+#define UPS_RECORD_WINDOW_H
+
+#include "0root/root.h"
+
+#include <string.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/dynamic_array.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// The window of a record which is read. Without UPS_PARTIAL the window
+// spans the full record, otherwise it is clamped to the record's size.
+struct RecordWindow
+{
+  RecordWindow(const ups_record_t *record, uint32_t record_size,
+                  uint32_t flags)
+    : offset(0), size(record_size) {
+    if (unlikely(ISSET(flags, UPS_PARTIAL))) {
+      offset = record->partial_offset < record_size
+                  ? record->partial_offset
+                  : record_size;
+      if (record->partial_size < record_size - offset)
+        size = record->partial_size;
+      else
+        size = record_size - offset;
+    }
+  }
+
+  // The offset of the window, relative to the start of the record
+  uint32_t offset;
+
+  // The number of bytes in the window
+  uint32_t size;
+};
+
+// Assigns the window of a record which is fully available in memory.
+// Respects UPS_DIRECT_ACCESS and UPS_RECORD_USER_ALLOC.
+static inline void
+assign_record_window(ups_record_t *record, ByteArray *arena,
+                const void *data, uint32_t record_size, uint32_t flags)
+{
+  RecordWindow window(record, record_size, flags);
+  const uint8_t *p = (const uint8_t *)data + window.offset;
+
+  record->size = window.size;
+  if (window.size == 0)
+    record->data = 0;
+  else if (ISSET(flags, UPS_DIRECT_ACCESS))
+    record->data = (void *)p;
+  else {
+    if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
+      arena->resize(window.size);
+      record->data = arena->data();
+    }
+    ::memcpy(record->data, p, window.size);
+  }
+}
+
+} // namespace upscaledb
+
+#endif // UPS_RECORD_WINDOW_H
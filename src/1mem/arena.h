@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Region-based allocators for short-lived objects.
+ *
+ * The Arena hands out memory from larger chunks. Allocations are not
+ * released individually; all memory is released at once when the Arena
+ * is cleared or destroyed.
+ *
+ * The ObjectPool recycles objects of a single type. Its memory is
+ * allocated from an Arena.
+ *
+ * @exception_safe: strong
+ * @thread_safe: no
+ */
+
+#ifndef UPS_ARENA_H
+#define UPS_ARENA_H
+
+#include "0root/root.h"
+
+#include <stddef.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1mem/mem.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct Arena {
+  enum {
+    // the size of the first chunk; each further chunk doubles in size
+    kMinChunkSize = 512,
+
+    // the maximum size of a chunk, unless a larger object is allocated
+    kMaxChunkSize = 64 * 1024,
+
+    // all allocations are aligned to this boundary
+    kAlignment = 8
+  };
+
+  // A chunk of memory; the payload follows the header
+  struct Chunk {
+    // Returns a pointer to the payload
+    uint8_t *data() {
+      return (uint8_t *)(this + 1);
+    }
+
+    // The next (older) chunk
+    Chunk *next;
+
+    // The size of the payload
+    size_t capacity;
+
+    // The number of allocated bytes
+    size_t used;
+  };
+
+  Arena()
+    : head(0), next_chunk_size(kMinChunkSize) {
+  }
+
+  // Releases all chunks
+  ~Arena() {
+    clear();
+  }
+
+  // Returns |size| bytes of uninitialized memory
+  void *allocate(size_t size) {
+    size = (size + kAlignment - 1) & ~(size_t)(kAlignment - 1);
+    if (unlikely(!head || head->used + size > head->capacity))
+      add_chunk(size);
+
+    // an oversized chunk is stored behind the current one
+    Chunk *chunk = head->used + size <= head->capacity ? head : head->next;
+    uint8_t *p = chunk->data() + chunk->used;
+    chunk->used += size;
+    return p;
+  }
+
+  // Releases all chunks except the first one, which is reused
+  void reset() {
+    while (head && head->next) {
+      Chunk *next = head->next;
+      Memory::release(head);
+      head = next;
+    }
+    if (head)
+      head->used = 0;
+    next_chunk_size = kMinChunkSize * 2;
+  }
+
+  // Releases all chunks
+  void clear() {
+    while (head) {
+      Chunk *next = head->next;
+      Memory::release(head);
+      head = next;
+    }
+    next_chunk_size = kMinChunkSize;
+  }
+
+  // Allocates a new chunk with at least |size| bytes
+  void add_chunk(size_t size) {
+    // a large object gets a chunk of its own; the remaining space of the
+    // current chunk can then still be used by smaller objects
+    if (head && size > next_chunk_size) {
+      Chunk *chunk = Memory::allocate<Chunk>(sizeof(Chunk) + size);
+      chunk->capacity = size;
+      chunk->used = 0;
+      chunk->next = head->next;
+      head->next = chunk;
+      return;
+    }
+
+    size_t capacity = size > next_chunk_size ? size : next_chunk_size;
+    Chunk *chunk = Memory::allocate<Chunk>(sizeof(Chunk) + capacity);
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->next = head;
+    head = chunk;
+    if (next_chunk_size < kMaxChunkSize)
+      next_chunk_size *= 2;
+  }
+
+  // The newest chunk; new objects are allocated from this chunk
+  Chunk *head;
+
+  // The size of the next chunk
+  size_t next_chunk_size;
+};
+
+template<typename T>
+struct ObjectPool {
+  // A released object; stores the next free object
+  struct FreeObject {
+    FreeObject *next;
+  };
+
+  enum {
+    kObjectSize = sizeof(T) > sizeof(FreeObject)
+                    ? sizeof(T)
+                    : sizeof(FreeObject)
+  };
+
+  ObjectPool()
+    : free_list(0), count(0) {
+  }
+
+  // Returns uninitialized memory for an object of type T; the object
+  // has to be constructed with placement new
+  void *allocate() {
+    count++;
+    if (free_list) {
+      FreeObject *p = free_list;
+      free_list = p->next;
+      return p;
+    }
+    return arena.allocate(kObjectSize);
+  }
+
+  // Releases an object; the destructor was already called by the caller.
+  // When the last object is released then the memory is returned to the
+  // Arena.
+  void release(void *ptr) {
+    FreeObject *p = (FreeObject *)ptr;
+    p->next = free_list;
+    free_list = p;
+    if (--count == 0) {
+      free_list = 0;
+      arena.reset();
+    }
+  }
+
+  // The memory of the objects
+  Arena arena;
+
+  // The released objects
+  FreeObject *free_list;
+
+  // The number of allocated objects
+  size_t count;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_ARENA_H
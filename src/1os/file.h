@@ -135,6 +135,11 @@ class File
     // Truncate/resize the file
     void truncate(uint64_t newsize);
 
+    // Releases the storage of a range in the file; the range then reads
+    // as zeroes and the file size does not change. This is a hint - it is
+    // ignored if the operating system or file system does not support it
+    void punch_hole(uint64_t offset, uint64_t len);
+
     // Closes the file descriptor
     void close();
 
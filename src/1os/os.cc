@@ -73,6 +73,48 @@ os_has_avx()
   return available;
 }
 
+bool
+os_has_avx2()
+{
+  static bool available = false;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+
+    int info[4];
+    cpuid(info, 0);
+    int num_ids = info[0];
+    if (num_ids < 7)
+      return available;
+
+    // the CPU supports AVX and XSAVE is enabled by the operating system
+    cpuid(info, 0x00000001);
+    if ((info[2] & ((int)1 << 27)) == 0 || (info[2] & ((int)1 << 28)) == 0)
+      return available;
+
+    // the operating system saves the ymm registers on a context switch
+#ifdef _WIN32
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+    if ((xcr0 & 6) != 6)
+      return available;
+
+    // extended features: EBX bit 5 is AVX2
+#ifdef _WIN32
+    __cpuidex(info, 7, 0);
+#else
+    __cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+    available = (info[1] & ((int)1 << 5)) != 0;
+  }
+
+  return available;
+}
+
 #else // !HAVE_SSE2
 
 bool
@@ -81,6 +123,12 @@ os_has_avx()
   return false;
 }
 
+bool
+os_has_avx2()
+{
+  return false;
+}
+
 #endif // HAVE_SSE2
 
 } // namespace upscaledb
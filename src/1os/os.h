@@ -66,6 +66,10 @@ typedef SOCKET             ups_socket_t;
 extern bool
 os_has_avx();
 
+// Returns true if the CPU and the operating system support AVX2
+extern bool
+os_has_avx2();
+
 } // namespace upscaledb
 
 #endif /* UPS_OS_H */
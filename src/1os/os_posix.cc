@@ -322,6 +322,18 @@ File::truncate(uint64_t newsize)
     throw Exception(UPS_IO_ERROR);
 }
 
+void
+File::punch_hole(uint64_t offset, uint64_t len)
+{
+  os_log(("File::punch_hole: fd=%d, offset=%lld, len=%lld", m_fd, offset,
+              len));
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+  // errors (i.e. EOPNOTSUPP) are ignored; the storage is simply not released
+  (void)::fallocate(m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  (off_t)offset, (off_t)len);
+#endif
+}
+
 void
 File::create(const char *filename, uint32_t mode)
 {
@@ -329,6 +329,14 @@ File::truncate(uint64_t newsize)
   assert(newsize == file_size());
 }
 
+void
+File::punch_hole(uint64_t offset, uint64_t len)
+{
+  // not supported; the storage is not released
+  (void)offset;
+  (void)len;
+}
+
 void
 File::create(const char *filename, uint32_t mode)
 {
@@ -72,6 +72,11 @@ struct Compressor {
   virtual void decompress(const uint8_t *inp, uint32_t inlength,
                   uint32_t outlength, uint8_t *destination) = 0;
 
+  // Sets a dictionary which is used by all subsequent calls to compress()
+  // and decompress(). Returns false if the compressor does not support
+  // dictionaries.
+  virtual bool set_dictionary(const uint8_t *data, uint32_t size) = 0;
+
   // Reserves |n| bytes in the output buffer; can be used by the caller
   // to insert flags or sizes
   void reserve(int n) {
@@ -134,6 +139,12 @@ struct CompressorImpl : public Compressor
     impl.decompress(inp, inlength, destination, outlength);
   }
 
+  // Sets a dictionary which is used by all subsequent calls to compress()
+  // and decompress()
+  virtual bool set_dictionary(const uint8_t *data, uint32_t size) {
+    return impl.set_dictionary(data, size);
+  }
+
   // The implementation object
   T impl;
 };
@@ -18,11 +18,17 @@
 
 #include "0root/root.h"
 
+#ifdef HAVE_ZSTD_H
+#  include <zdict.h>
+#endif
+
 // Always verify that a file of level N does not include headers > N!
 #include "2compressor/compressor_factory.h"
 #include "2compressor/compressor_zlib.h"
 #include "2compressor/compressor_snappy.h"
 #include "2compressor/compressor_lzf.h"
+#include "2compressor/compressor_lz4.h"
+#include "2compressor/compressor_zstd.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -45,6 +51,8 @@ CompressorFactory::is_available(int type)
     case UPS_COMPRESSOR_UINT32_VARBYTE:
     case UPS_COMPRESSOR_UINT32_GROUPVARINT:
     case UPS_COMPRESSOR_UINT32_FOR:
+    case UPS_COMPRESSOR_UINT64_VARBYTE:
+    case UPS_COMPRESSOR_UINT64_FOR:
       return true;
     case UPS_COMPRESSOR_ZLIB:
 #ifdef HAVE_ZLIB_H
@@ -61,18 +69,38 @@ CompressorFactory::is_available(int type)
     case UPS_COMPRESSOR_LZF:
       // this is always available
       return true;
+    case UPS_COMPRESSOR_LZ4:
+#ifdef HAVE_LZ4_H
+      return true;
+#else
+      return false;
+#endif
+    case UPS_COMPRESSOR_ZSTD:
+#ifdef HAVE_ZSTD_H
+      return true;
+#else
+      return false;
+#endif
     default:
       return false;
   }
 }
 
 Compressor *
-CompressorFactory::create(int type)
+CompressorFactory::create(int type, int level)
 {
   switch (type) {
     case UPS_COMPRESSOR_ZLIB:
 #ifdef HAVE_ZLIB_H
-      return new CompressorImpl<ZlibCompressor>();
+      if (unlikely(level > 9)) {
+        ups_trace(("invalid zlib compression level %d", level));
+        throw Exception(UPS_INV_PARAMETER);
+      }
+      {
+        CompressorImpl<ZlibCompressor> *c = new CompressorImpl<ZlibCompressor>();
+        c->impl.level = level;
+        return c;
+      }
 #else
       ups_log(("upscaledb was built without support for zlib compression"));
       throw Exception(UPS_INV_PARAMETER);
@@ -87,6 +115,24 @@ CompressorFactory::create(int type)
     case UPS_COMPRESSOR_LZF:
       // this is always available
       return new CompressorImpl<LzfCompressor>();
+    case UPS_COMPRESSOR_LZ4:
+#ifdef HAVE_LZ4_H
+      return new CompressorImpl<Lz4Compressor>();
+#else
+      ups_log(("upscaledb was built without support for lz4 compression"));
+      throw Exception(UPS_INV_PARAMETER);
+#endif
+    case UPS_COMPRESSOR_ZSTD:
+#ifdef HAVE_ZSTD_H
+      {
+        CompressorImpl<ZstdCompressor> *c = new CompressorImpl<ZstdCompressor>();
+        c->impl.level = level;
+        return c;
+      }
+#else
+      ups_log(("upscaledb was built without support for zstd compression"));
+      throw Exception(UPS_INV_PARAMETER);
+#endif
     default:
       ups_log(("Unknown compressor type %d", type));
       throw Exception(UPS_INV_PARAMETER);
@@ -94,4 +140,90 @@ CompressorFactory::create(int type)
   throw Exception(UPS_INV_PARAMETER);
 }
 
+bool
+CompressorFactory::supports_dictionary(int type)
+{
+  switch (type) {
+    case UPS_COMPRESSOR_ZLIB:
+    case UPS_COMPRESSOR_ZSTD:
+      return is_available(type);
+    default:
+      return false;
+  }
+}
+
+// Builds a "raw content" dictionary from the samples. The compressors
+// prefer matches close to the end of the dictionary, therefore the most
+// recent samples are stored last. Identical consecutive samples are
+// skipped.
+static void
+build_raw_dictionary(const ByteArray &samples,
+                const std::vector<size_t> &sample_sizes, uint32_t max_size,
+                ByteArray *dictionary)
+{
+  size_t total = 0;
+  size_t first = sample_sizes.size();
+  while (first > 0 && total + sample_sizes[first - 1] <= max_size) {
+    first--;
+    total += sample_sizes[first];
+  }
+
+  size_t offset = 0;
+  for (size_t i = 0; i < first; i++)
+    offset += sample_sizes[i];
+
+  dictionary->set_size(0);
+
+  // even the last sample is too large: use its tail
+  if (first > 0 && first == sample_sizes.size()) {
+    dictionary->append(samples.data() + offset - max_size, max_size);
+    return;
+  }
+
+  const uint8_t *previous = 0;
+  size_t previous_size = 0;
+  for (size_t i = first; i < sample_sizes.size(); i++) {
+    const uint8_t *p = samples.data() + offset;
+    if (previous == 0 || previous_size != sample_sizes[i]
+          || ::memcmp(previous, p, previous_size) != 0)
+      dictionary->append(p, sample_sizes[i]);
+    previous = p;
+    previous_size = sample_sizes[i];
+    offset += sample_sizes[i];
+  }
+}
+
+void
+CompressorFactory::train_dictionary(int type, const ByteArray &samples,
+                const std::vector<size_t> &sample_sizes, uint32_t max_size,
+                ByteArray *dictionary)
+{
+  switch (type) {
+    case UPS_COMPRESSOR_ZLIB:
+      // zlib has no trainer and only uses the last 32 kb of the dictionary
+      build_raw_dictionary(samples, sample_sizes,
+                      std::min(max_size, 32u * 1024), dictionary);
+      return;
+    case UPS_COMPRESSOR_ZSTD:
+#ifdef HAVE_ZSTD_H
+      {
+        dictionary->resize(max_size);
+        size_t size = ::ZDICT_trainFromBuffer(dictionary->data(), max_size,
+                        samples.data(), &sample_sizes[0],
+                        (unsigned)sample_sizes.size());
+        // the trainer fails if there are not enough samples; fall back
+        // to a raw content dictionary
+        if (::ZDICT_isError(size))
+          build_raw_dictionary(samples, sample_sizes, max_size, dictionary);
+        else
+          dictionary->set_size(size);
+        return;
+      }
+#endif
+    default:
+      ups_trace(("compressor %d does not support dictionaries", type));
+      throw Exception(UPS_INV_PARAMETER);
+  }
+}
+
 }; // namespace upscaledb
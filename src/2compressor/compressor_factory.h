@@ -28,6 +28,8 @@
 
 #include "0root/root.h"
 
+#include <vector>
+
 // Always verify that a file of level N does not include headers > N!
 #include "2compressor/compressor.h"
 
@@ -42,8 +44,19 @@ struct CompressorFactory {
   static bool is_available(int type);
 
   // Creates a new Compressor instance for the specified |type| (being
-  // UPS_COMPRESSOR_ZLIB, UPS_COMPRESSOR_SNAPPY etc)
-  static Compressor *create(int type);
+  // UPS_COMPRESSOR_ZLIB, UPS_COMPRESSOR_SNAPPY etc). |level| is the
+  // compression level (only for zlib and zstd); 0 selects the default
+  static Compressor *create(int type, int level = 0);
+
+  // Returns true if the specified compressor supports dictionaries
+  static bool supports_dictionary(int type);
+
+  // Trains a dictionary of at most |max_size| bytes for the compressor
+  // |type|. |samples| stores all sample records back to back, their sizes
+  // are in |sample_sizes|.
+  static void train_dictionary(int type, const ByteArray &samples,
+                  const std::vector<size_t> &sample_sizes, uint32_t max_size,
+                  ByteArray *dictionary);
 };
 
 }; // namespace upscaledb
@@ -62,6 +62,11 @@ struct SnappyCompressor {
                 (char *)outp))
       throw Exception(UPS_INTERNAL_ERROR);
   }
+
+  // Dictionaries are not supported
+  bool set_dictionary(const uint8_t *, uint32_t) {
+    return false;
+  }
 };
 
 }; // namespace upscaledb
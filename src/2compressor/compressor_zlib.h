@@ -37,28 +37,110 @@
 namespace upscaledb {
 
 struct ZlibCompressor {
+  ZlibCompressor()
+    : level(0), deflate_initialized(false), inflate_initialized(false) {
+  }
+
+  ~ZlibCompressor() {
+    if (deflate_initialized)
+      ::deflateEnd(&deflate_stream);
+    if (inflate_initialized)
+      ::inflateEnd(&inflate_stream);
+  }
+
   uint32_t compressed_length(uint32_t length) {
-    return ::compressBound(length);
+    // the zlib header stores the checksum of the dictionary
+    return ::compressBound(length) + (dictionary.size() ? 4 : 0);
   }
 
   uint32_t compress(const uint8_t *inp, uint32_t inlength,
                             uint8_t *outp, uint32_t outlength) {
-    uLongf real_outlength = outlength;
-    int zret = ::compress((Bytef *)outp, &real_outlength,
-                      (const Bytef *)inp, inlength);
-    if (zret != 0)
+    if (dictionary.size() == 0) {
+      uLongf real_outlength = outlength;
+      int zret = ::compress2((Bytef *)outp, &real_outlength,
+                        (const Bytef *)inp, inlength,
+                        level ? level : Z_DEFAULT_COMPRESSION);
+      if (zret != 0)
+        throw Exception(UPS_INTERNAL_ERROR);
+      return real_outlength;
+    }
+
+    // with a dictionary: the stream is reused for all records to avoid
+    // the costs of deflateInit()
+    if (!deflate_initialized) {
+      ::memset(&deflate_stream, 0, sizeof(deflate_stream));
+      if (::deflateInit(&deflate_stream,
+                        level ? level : Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw Exception(UPS_OUT_OF_MEMORY);
+      deflate_initialized = true;
+    }
+    else
+      ::deflateReset(&deflate_stream);
+
+    ::deflateSetDictionary(&deflate_stream, dictionary.data(),
+                    (uInt)dictionary.size());
+    deflate_stream.next_in = (Bytef *)inp;
+    deflate_stream.avail_in = inlength;
+    deflate_stream.next_out = (Bytef *)outp;
+    deflate_stream.avail_out = outlength;
+    if (::deflate(&deflate_stream, Z_FINISH) != Z_STREAM_END)
       throw Exception(UPS_INTERNAL_ERROR);
-    return real_outlength;
+    return (uint32_t)deflate_stream.total_out;
   }
 
   void decompress(const uint8_t *inp, uint32_t inlength,
                             uint8_t *outp, uint32_t outlength) {
-    uLongf real_outlength = outlength;
-    int zret = ::uncompress((Bytef *)outp, &real_outlength,
-                          (const Bytef *)inp, inlength);
-    if (zret != 0)
+    if (dictionary.size() == 0) {
+      uLongf real_outlength = outlength;
+      int zret = ::uncompress((Bytef *)outp, &real_outlength,
+                            (const Bytef *)inp, inlength);
+      if (zret != 0)
+        throw Exception(UPS_INTERNAL_ERROR);
+      return;
+    }
+
+    if (!inflate_initialized) {
+      ::memset(&inflate_stream, 0, sizeof(inflate_stream));
+      if (::inflateInit(&inflate_stream) != Z_OK)
+        throw Exception(UPS_OUT_OF_MEMORY);
+      inflate_initialized = true;
+    }
+    else
+      ::inflateReset(&inflate_stream);
+
+    inflate_stream.next_in = (Bytef *)inp;
+    inflate_stream.avail_in = inlength;
+    inflate_stream.next_out = (Bytef *)outp;
+    inflate_stream.avail_out = outlength;
+    int zret = ::inflate(&inflate_stream, Z_FINISH);
+    if (zret == Z_NEED_DICT) {
+      ::inflateSetDictionary(&inflate_stream, dictionary.data(),
+                    (uInt)dictionary.size());
+      zret = ::inflate(&inflate_stream, Z_FINISH);
+    }
+    if (zret != Z_STREAM_END || inflate_stream.total_out != outlength)
       throw Exception(UPS_INTERNAL_ERROR);
   }
+
+  // Stores a copy of the dictionary; zlib only uses the last 32 kb
+  bool set_dictionary(const uint8_t *data, uint32_t size) {
+    dictionary.copy(data, size);
+    return true;
+  }
+
+  // The compression level (1 - 9); 0 is the default level
+  int level;
+
+  // The dictionary; can be empty
+  ByteArray dictionary;
+
+  // The stream for compressing with a dictionary
+  z_stream deflate_stream;
+  bool deflate_initialized;
+
+  // The stream for decompressing with a dictionary
+  z_stream inflate_stream;
+  bool inflate_initialized;
 };
 
 }; // namespace upscaledb;
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A compressor which uses zstandard. The compression and decompression
+ * contexts are allocated once and reused for each call. A dictionary is
+ * digested once (ZSTD_CDict/ZSTD_DDict) and then shared by all calls.
+ *
+ * @exception_safe: unknown
+ * @thread_safe: no
+ */
+
+#ifndef UPS_COMPRESSOR_ZSTD_H
+#define UPS_COMPRESSOR_ZSTD_H
+
+#ifdef HAVE_ZSTD_H
+
+#include "0root/root.h"
+
+#include <zstd.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "2compressor/compressor.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct ZstdCompressor {
+  ZstdCompressor()
+    : level(0), cctx(0), dctx(0), cdict(0), ddict(0) {
+  }
+
+  ~ZstdCompressor() {
+    if (cctx)
+      ::ZSTD_freeCCtx(cctx);
+    if (dctx)
+      ::ZSTD_freeDCtx(dctx);
+    if (cdict)
+      ::ZSTD_freeCDict(cdict);
+    if (ddict)
+      ::ZSTD_freeDDict(ddict);
+  }
+
+  uint32_t compressed_length(uint32_t length) {
+    return (uint32_t)::ZSTD_compressBound(length);
+  }
+
+  uint32_t compress(const uint8_t *inp, uint32_t inlength,
+                          uint8_t *outp, uint32_t outlength) {
+    if (!cctx)
+      cctx = ::ZSTD_createCCtx();
+    // level 0 selects zstd's default level
+    size_t real_outlength = cdict
+                  ? ::ZSTD_compress_usingCDict(cctx, outp, outlength,
+                          inp, inlength, cdict)
+                  : ::ZSTD_compressCCtx(cctx, outp, outlength,
+                          inp, inlength, level);
+    if (::ZSTD_isError(real_outlength))
+      throw Exception(UPS_INTERNAL_ERROR);
+    return (uint32_t)real_outlength;
+  }
+
+  void decompress(const uint8_t *inp, uint32_t inlength,
+                          uint8_t *outp, uint32_t outlength) {
+    if (!dctx)
+      dctx = ::ZSTD_createDCtx();
+    size_t real_outlength = ddict
+                  ? ::ZSTD_decompress_usingDDict(dctx, outp, outlength,
+                          inp, inlength, ddict)
+                  : ::ZSTD_decompressDCtx(dctx, outp, outlength,
+                          inp, inlength);
+    if (::ZSTD_isError(real_outlength) || real_outlength != outlength)
+      throw Exception(UPS_INTERNAL_ERROR);
+  }
+
+  // Digests the dictionary; trained dictionaries and raw content are
+  // both supported
+  bool set_dictionary(const uint8_t *data, uint32_t size) {
+    if (cdict)
+      ::ZSTD_freeCDict(cdict);
+    if (ddict)
+      ::ZSTD_freeDDict(ddict);
+    cdict = ::ZSTD_createCDict(data, size, level);
+    ddict = ::ZSTD_createDDict(data, size);
+    if (!cdict || !ddict)
+      throw Exception(UPS_OUT_OF_MEMORY);
+    return true;
+  }
+
+  // The compression level (1 - ZSTD_maxCLevel()); 0 is the default level
+  int level;
+
+  // The compression context
+  ZSTD_CCtx *cctx;
+
+  // The decompression context
+  ZSTD_DCtx *dctx;
+
+  // The digested dictionary for compression; can be null
+  ZSTD_CDict *cdict;
+
+  // The digested dictionary for decompression; can be null
+  ZSTD_DDict *ddict;
+};
+
+}; // namespace upscaledb
+
+#endif // HAVE_ZSTD_H
+
+#endif // UPS_COMPRESSOR_ZSTD_H
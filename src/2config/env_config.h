@@ -49,11 +49,15 @@ struct EnvConfig
   EnvConfig()
     : flags(0), file_mode(0644), max_databases(0),
       page_size_bytes(UPS_DEFAULT_PAGE_SIZE),
-      cache_size_bytes(UPS_DEFAULT_CACHE_SIZE),
+      cache_size_bytes(UPS_DEFAULT_CACHE_SIZE), compressed_cache_size_bytes(0),
       file_size_limit_bytes(std::numeric_limits<size_t>::max()), 
-      remote_timeout_sec(0), journal_compressor(0),
+      remote_timeout_sec(0), journal_compressor(0), page_compressor(0),
+      compression_level(0),
       is_encryption_enabled(false), journal_switch_threshold(0),
-      posix_advice(UPS_POSIX_FADVICE_NORMAL) {
+      journal_segment_size(0), journal_segments(0),
+      journal_checkpoint_interval(0), recovery_threads(0),
+      journal_deltas(false),
+      posix_advice(UPS_POSIX_FADVICE_NORMAL), uqi_threads(0) {
   }
 
   // the environment's flags
@@ -71,6 +75,9 @@ struct EnvConfig
   // the cache size (in bytes)
   uint64_t cache_size_bytes;
 
+  // the size of the compressed secondary cache (in bytes); not persisted
+  uint64_t compressed_cache_size_bytes;
+
   // the file size limit (in bytes)
   size_t file_size_limit_bytes;
 
@@ -86,17 +93,41 @@ struct EnvConfig
   // the algorithm for journal compression
   int journal_compressor;
 
+  // the algorithm for compressing B+tree leaf pages
+  int page_compressor;
+
+  // the compression level (0: the compressor's default); not persisted
+  int compression_level;
+
   // true if AES encryption is enabled
   bool is_encryption_enabled;
 
   // the AES encryption key
   uint8_t encryption_key[16];
 
-  // threshold for switching journal files
+  // threshold for switching journal files; deprecated and ignored
   size_t journal_switch_threshold;
 
+  // size of a journal segment file (in bytes); 0 for the default
+  uint64_t journal_segment_size;
+
+  // number of preallocated journal segments; 0 for the default
+  uint32_t journal_segments;
+
+  // number of journal bytes between two checkpoints; 0 for the default
+  uint64_t journal_checkpoint_interval;
+
+  // number of threads re-applying the changesets; 0 for the default
+  uint32_t recovery_threads;
+
+  // true if changesets are logged as page deltas; not persisted
+  bool journal_deltas;
+
   // parameter for posix_fadvise()
   int posix_advice;
+
+  // the number of threads for parallel UQI scans; not persisted
+  int uqi_threads;
 };
 
 } // namespace upscaledb
@@ -45,7 +45,8 @@ class Page;
 struct Device {
   // Constructor
   Device(const EnvConfig &config)
-  : config(config) {
+  : config(config), page_bytes_before_compression(0),
+    page_bytes_after_compression(0) {
   }
 
   // virtual destructor
@@ -94,9 +95,15 @@ struct Device {
   // will *NOT* use mmap. returns the offset of the allocated storage.
   virtual uint64_t alloc(size_t len) = 0;
 
-  // Reads a page from the device; this function CAN use mmap
+  // Reads a page from the device; this function CAN use mmap.
+  // Compressed pages are decompressed.
   virtual void read_page(Page *page, uint64_t address) = 0;
 
+  // Writes a page to the device; this function does not use mmap.
+  // If |compress| is true and page compression is enabled then the page
+  // is compressed.
+  virtual void write_page(Page *page, bool compress) = 0;
+
   // Allocate storage for a page from this device; this function
   // can use mmap if available
   virtual void alloc_page(Page *page) = 0;
@@ -114,6 +121,12 @@ struct Device {
 
   // the Environment configuration settings
   const EnvConfig &config;
+
+  // page bytes before compression (for the metrics)
+  uint64_t page_bytes_before_compression;
+
+  // page bytes after compression (for the metrics)
+  uint64_t page_bytes_after_compression;
 };
 
 } // namespace upscaledb
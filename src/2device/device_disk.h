@@ -28,6 +28,7 @@
 #ifndef UPS_DEVICE_DISK_H
 #define UPS_DEVICE_DISK_H
 
+#include <algorithm>
 #include <utility>
 
 #include "0root/root.h"
@@ -35,11 +36,13 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
 #include "1base/dynamic_array.h"
+#include "1base/scoped_ptr.h"
 #include "1mem/mem.h"
 #include "1os/file.h"
 #ifdef UPS_ENABLE_ENCRYPTION
 #  include "2aes/aes.h"
 #endif
+#include "2compressor/compressor_factory.h"
 #include "2device/device.h"
 #include "2page/page.h"
 
@@ -208,19 +211,50 @@ class DiskDevice : public Device {
     // filters
     virtual void write(uint64_t offset, void *buffer, size_t len) {
       ScopedSpinlock lock(m_mutex);
-#ifdef UPS_ENABLE_ENCRYPTION
-      if (config.is_encryption_enabled) {
-        // encryption disables direct I/O -> only full pages are allowed
-        assert(offset % len == 0);
+      write_nolock(offset, buffer, len);
+    }
 
-        uint8_t *encryption_buffer = (uint8_t *)::alloca(len);
-        AesCipher aes(config.encryption_key, offset);
-        aes.encrypt((uint8_t *)buffer, encryption_buffer, len);
-        m_state.file.pwrite(offset, encryption_buffer, len);
-        return;
+    // writes a page to the device; this function does not use mmap.
+    // A compressed page only occupies the beginning of its storage; the
+    // remaining storage is released.
+    virtual void write_page(Page *page, bool compress) {
+      ScopedSpinlock lock(m_mutex);
+      uint32_t page_size = config.page_size_bytes;
+
+      if (compress && config.page_compressor
+              && !config.is_encryption_enabled) {
+        Compressor *compressor = page_compressor();
+        compressor->reserve(Page::kSizeofCompressedHeader);
+        uint32_t len = compressor->compress(page->raw_payload(), page_size);
+        uint32_t disk_size = Page::kSizeofCompressedHeader + len;
+        page_bytes_before_compression += page_size;
+
+        // store the page uncompressed if less than 1/8th of the page
+        // is saved
+        if (disk_size <= page_size - page_size / 8) {
+          PCompressedPageHeader *header =
+                  (PCompressedPageHeader *)compressor->arena.data();
+          header->flags = Page::kTypeCompressed;
+          header->compressed_size = len;
+          m_state.file.pwrite(page->address(), header, disk_size);
+
+          uint32_t previous_size = page->disk_size()
+                                      ? page->disk_size()
+                                      : page_size;
+          if (previous_size > disk_size)
+            m_state.file.punch_hole(page->address() + disk_size,
+                            previous_size - disk_size);
+
+          page_bytes_after_compression += disk_size;
+          page->set_disk_size(disk_size);
+          return;
+        }
+
+        page_bytes_after_compression += page_size;
       }
-#endif
-      m_state.file.pwrite(offset, buffer, len);
+
+      write_nolock(page->address(), page->data(), page_size);
+      page->set_disk_size(0);
     }
 
     // allocate storage from this device; this function
@@ -272,10 +306,25 @@ class DiskDevice : public Device {
       // if this page is in the mapped area: return a pointer into that area.
       // otherwise fall back to read/write.
       if (address < m_state.mapped_size && m_state.mmapptr != 0) {
+        uint8_t *mapped = &m_state.mmapptr[address];
         // the following line will not throw a C++ exception, but can
         // raise a signal. If that's the case then we don't catch it because
         // something is seriously wrong and proper recovery is not possible.
-        page->assign_mapped_buffer(&m_state.mmapptr[address], address);
+        uint32_t disk_size = page->is_without_header()
+                                ? 0
+                                : compressed_disk_size(mapped);
+        if (disk_size == 0) {
+          page->assign_mapped_buffer(mapped, address);
+          page->set_disk_size(0);
+          return;
+        }
+
+        // compressed pages are decompressed into an allocated buffer
+        if (page->data() == 0 || !page->is_allocated()) {
+          uint8_t *p = Memory::allocate<uint8_t>(config.page_size_bytes);
+          page->assign_allocated_buffer(p, address);
+        }
+        decompress_page(page, mapped, disk_size);
         return;
       }
 
@@ -288,7 +337,32 @@ class DiskDevice : public Device {
         page->assign_allocated_buffer(p, address);
       }
 
-      m_state.file.pread(address, page->data(), config.page_size_bytes);
+      // if the page was compressed when it was written then only read
+      // the compressed data
+      uint32_t size = config.page_size_bytes;
+      if (page->disk_size() > 0 && page->disk_size() < size)
+        size = page->disk_size();
+      m_state.file.pread(address, page->data(), size);
+
+      uint32_t disk_size = page->is_without_header()
+                              ? 0
+                              : compressed_disk_size((uint8_t *)page->data());
+      if (disk_size > 0) {
+        m_compressed_page.resize(disk_size);
+        ::memcpy(m_compressed_page.data(), page->data(),
+                        std::min(size, disk_size));
+        if (disk_size > size)
+          m_state.file.pread(address + size, m_compressed_page.data() + size,
+                          disk_size - size);
+        decompress_page(page, m_compressed_page.data(), disk_size);
+        return;
+      }
+
+      // the page is not (or no longer) compressed: read the remaining data
+      if (size < config.page_size_bytes)
+        m_state.file.pread(address + size, (uint8_t *)page->data() + size,
+                        config.page_size_bytes - size);
+      page->set_disk_size(0);
 #ifdef UPS_ENABLE_ENCRYPTION
       if (config.is_encryption_enabled) {
         AesCipher aes(config.encryption_key, page->address());
@@ -336,6 +410,57 @@ class DiskDevice : public Device {
     }
 
   private:
+    // writes to the device, sans locking
+    void write_nolock(uint64_t offset, void *buffer, size_t len) {
+#ifdef UPS_ENABLE_ENCRYPTION
+      if (config.is_encryption_enabled) {
+        // encryption disables direct I/O -> only full pages are allowed
+        assert(offset % len == 0);
+
+        uint8_t *encryption_buffer = (uint8_t *)::alloca(len);
+        AesCipher aes(config.encryption_key, offset);
+        aes.encrypt((uint8_t *)buffer, encryption_buffer, len);
+        m_state.file.pwrite(offset, encryption_buffer, len);
+        return;
+      }
+#endif
+      m_state.file.pwrite(offset, buffer, len);
+    }
+
+    // Returns the compressor for B+tree leaf pages
+    Compressor *page_compressor() {
+      if (!m_compressor)
+        m_compressor.reset(CompressorFactory::create(config.page_compressor,
+                                config.compression_level));
+      return m_compressor.get();
+    }
+
+    // Returns the size of a compressed page on disk, or 0 if |data| is
+    // not a compressed page
+    uint32_t compressed_disk_size(const uint8_t *data) const {
+      if (!config.page_compressor || config.is_encryption_enabled)
+        return 0;
+      const PCompressedPageHeader *header = (const PCompressedPageHeader *)data;
+      if (header->flags != Page::kTypeCompressed)
+        return 0;
+      uint32_t disk_size = Page::kSizeofCompressedHeader
+                              + header->compressed_size;
+      if (unlikely(disk_size > config.page_size_bytes)) {
+        ups_trace(("compressed page has invalid size %u", disk_size));
+        throw Exception(UPS_INTEGRITY_VIOLATED);
+      }
+      return disk_size;
+    }
+
+    // Decompresses the compressed page in |data| into the buffer of |page|;
+    // both must not overlap
+    void decompress_page(Page *page, const uint8_t *data, uint32_t disk_size) {
+      const PCompressedPageHeader *header = (const PCompressedPageHeader *)data;
+      page_compressor()->decompress(header->payload, header->compressed_size,
+                      config.page_size_bytes, (uint8_t *)page->data());
+      page->set_disk_size(disk_size);
+    }
+
     // truncate/resize the device, sans locking
     void truncate_nolock(uint64_t new_file_size) {
       if (new_file_size > config.file_size_limit_bytes)
@@ -348,6 +473,12 @@ class DiskDevice : public Device {
     Spinlock m_mutex;
 
     State m_state;
+
+    // The compressor for B+tree leaf pages (if page compression is enabled)
+    ScopedPtr<Compressor> m_compressor;
+
+    // Temporary buffer for reading compressed pages
+    ByteArray m_compressed_page;
 };
 
 } // namespace upscaledb
@@ -112,6 +112,10 @@ struct InMemoryDevice : public Device {
     throw Exception(UPS_NOT_IMPLEMENTED);
   }
 
+  // writes a page to the device 
+  virtual void write_page(Page *page, bool compress) {
+  }
+
   // allocate storage from this device; this function
   // will *NOT* use mmap.  
   virtual uint64_t alloc(size_t size) {
@@ -87,13 +87,23 @@ Page::flush()
                          (uint32_t)persisted_data.address,
                          &persisted_data.raw_data->header.crc32);
     }
-    device_->write(persisted_data.address, persisted_data.raw_data,
-                    persisted_data.size);
+    device_->write_page(this, is_compressible());
     persisted_data.is_dirty = false;
     ms_page_count_flushed++;
   }
 }
 
+bool
+Page::is_compressible()
+{
+  if (persisted_data.is_without_header || persisted_data.address == 0)
+    return false;
+  uint32_t t = type();
+  if (t != kTypeBindex && t != kTypeBroot)
+    return false;
+  return PBtreeNode::from_page(this)->is_leaf();
+}
+
 void
 Page::free_buffer()
 {
@@ -60,6 +60,28 @@ typedef UPS_PACK_0 struct UPS_PACK_1 PPageHeader {
 
 #include "1base/packstart.h"
 
+/*
+ * The header of a compressed page on disk; it replaces the PPageHeader
+ * of the uncompressed page. Only B+tree leaf pages are compressed, and only
+ * if page compression is enabled (UPS_PARAM_PAGE_COMPRESSION). The
+ * remaining storage of the page is unused.
+ */
+typedef UPS_PACK_0 struct UPS_PACK_1 PCompressedPageHeader {
+  // always Page::kTypeCompressed
+  uint32_t flags;
+
+  // the size of the compressed data
+  uint32_t compressed_size;
+
+  // the compressed page, including its original PPageHeader
+  uint8_t payload[1];
+
+} UPS_PACK_2 PCompressedPageHeader;
+
+#include "1base/packstop.h"
+
+#include "1base/packstart.h"
+
 /*
  * A union combining the page header and a pointer to the raw page data.
  *
@@ -83,12 +105,13 @@ class Page {
     // A wrapper around the persisted page data
     struct PersistedData {
       PersistedData()
-        : address(0), size(0), is_dirty(false), is_allocated(false),
-          is_without_header(false), raw_data(0) {
+        : address(0), size(0), disk_size(0), is_dirty(false),
+          is_allocated(false), is_without_header(false), raw_data(0) {
       }
 
       PersistedData(const PersistedData &other)
-        : address(other.address), size(other.size), is_dirty(other.is_dirty),
+        : address(other.address), size(other.size),
+          disk_size(other.disk_size), is_dirty(other.is_dirty),
           is_allocated(other.is_allocated),
           is_without_header(other.is_without_header), raw_data(other.raw_data) {
       }
@@ -111,6 +134,10 @@ class Page {
       // the size of this page
       uint32_t size;
 
+      // the number of bytes which this page occupies on disk if it is
+      // compressed; 0 if the page is not compressed (or if it's unknown)
+      uint32_t disk_size;
+
       // is this page dirty and needs to be flushed to disk?
       bool is_dirty;
 
@@ -130,6 +157,9 @@ class Page {
       // sizeof the persistent page header
       kSizeofPersistentHeader = sizeof(PPageHeader) - 1,
 
+      // sizeof the header of a compressed page
+      kSizeofCompressedHeader = sizeof(PCompressedPageHeader) - 1,
+
       // instruct Page::alloc() to reset the page with zeroes
       kInitializeWithZeroes,
     };
@@ -180,7 +210,11 @@ class Page {
       kTypePageManager        =  0x40000000,
 
       // a page which stores blobs
-      kTypeBlob               =  0x50000000
+      kTypeBlob               =  0x50000000,
+
+      // a compressed B+tree leaf page; this type is only stored on disk
+      // and replaced with the original type when the page is decompressed
+      kTypeCompressed         =  0x60000000
     };
 
     // Default constructor
@@ -301,6 +335,21 @@ class Page {
       persisted_data.is_without_header = is_without_header;
     }
 
+    // Returns the number of bytes which this page occupies on disk if it
+    // is compressed, or 0
+    uint32_t disk_size() const {
+      return persisted_data.disk_size;
+    }
+
+    // Sets the number of bytes which this page occupies on disk
+    void set_disk_size(uint32_t disk_size) {
+      persisted_data.disk_size = disk_size;
+    }
+
+    // Returns true if this page is a B+tree leaf page and therefore a
+    // candidate for page compression
+    bool is_compressible();
+
     // Assign a buffer which was allocated with malloc()
     void assign_allocated_buffer(void *buffer, uint64_t address) {
       free_buffer();
@@ -53,7 +53,15 @@ struct Context;
 UPS_PACK_0 struct UPS_PACK_1 PBlobHeader {
   enum {
     // Blob is compressed
-    kIsCompressed = 1
+    kIsCompressed = 1,
+
+    // Blob is shared by several records and is followed by a
+    // PBlobDedupHeader (only for disk-based Environments)
+    kIsDeduplicated = 2,
+
+    // A compressed blob stores the id of its compression dictionary in
+    // the upper 16 bits of the flags (0: no dictionary)
+    kDictionaryShift = 16
   };
 
   PBlobHeader() {
@@ -66,6 +74,16 @@ UPS_PACK_0 struct UPS_PACK_1 PBlobHeader {
   return (PBlobHeader *)&page->raw_payload()[readstart];
   }
 
+  // Returns the id of the compression dictionary
+  uint16_t dictionary_id() const {
+    return (uint16_t)(flags >> kDictionaryShift);
+  }
+
+  // Sets the id of the compression dictionary
+  void set_dictionary_id(uint16_t id) {
+    flags = (flags & 0xffff) | ((uint32_t)id << kDictionaryShift);
+  }
+
   // The blob id - which is the absolute address/offset of this
   // structure in the file
   uint64_t blob_id;
@@ -106,14 +124,22 @@ struct BlobManager {
   // the flags for ups_db_insert()
   enum {
     // Do not compress the blob, even if compression is enabled
-    kDisableCompression = 0x10000000
+    kDisableCompression = 0x10000000,
+
+    // Do not share the blob with other records, even if the Database
+    // was created with UPS_ENABLE_RECORD_DEDUPLICATION
+    kDisableDeduplication = 0x20000000
   };
 
   BlobManager(const EnvConfig *config_, PageManager *page_manager_,
                   Device *device_)
     : config(config_), page_manager(page_manager_), device(device_),
       metric_before_compression(0), metric_after_compression(0),
-      metric_total_allocated(0), metric_total_read(0) {
+      metric_total_allocated(0), metric_total_read(0),
+      metric_slab_allocated(0), metric_slab_reused(0),
+      metric_slab_padding(0), metric_partial_read(0),
+      metric_partial_read_bytes(0), metric_dedup_hits(0),
+      metric_dedup_logical_bytes(0), metric_dedup_stored_bytes(0) {
   }
 
   virtual ~BlobManager() { }
@@ -122,12 +148,13 @@ struct BlobManager {
   // This function returns the blob-id (the start address of the blob
   // header)
   //
-  // |flags| can be kDisableCompression // TODO replace with bool value?
+  // |flags| can be kDisableCompression and kDisableDeduplication
   virtual uint64_t allocate(Context *context, ups_record_t *record,
                   uint32_t flags) = 0;
 
   // Reads a blob and stores the data in @a record.
-  // @ref flags: either 0 or UPS_DIRECT_ACCESS
+  // @ref flags: either 0 or UPS_DIRECT_ACCESS, optionally combined with
+  // UPS_PARTIAL
   virtual void read(Context *context, uint64_t blob_id, ups_record_t *record,
                   uint32_t flags, ByteArray *arena) = 0;
 
@@ -157,6 +184,14 @@ struct BlobManager {
   void fill_metrics(ups_env_metrics_t *metrics) const {
     metrics->blob_total_allocated = metric_total_allocated;
     metrics->blob_total_read = metric_total_read;
+    metrics->blob_slab_allocated = metric_slab_allocated;
+    metrics->blob_slab_reused = metric_slab_reused;
+    metrics->blob_slab_padding = metric_slab_padding;
+    metrics->blob_partial_read = metric_partial_read;
+    metrics->blob_partial_read_bytes = metric_partial_read_bytes;
+    metrics->blob_dedup_hits = metric_dedup_hits;
+    metrics->blob_dedup_logical_bytes = metric_dedup_logical_bytes;
+    metrics->blob_dedup_stored_bytes = metric_dedup_stored_bytes;
     metrics->record_bytes_before_compression = metric_before_compression;
     metrics->record_bytes_after_compression = metric_after_compression;
   }
@@ -181,6 +216,32 @@ struct BlobManager {
 
   // Usage tracking - number of blobs read
   uint64_t metric_total_read;
+
+  // Usage tracking - number of blobs allocated in slab pages
+  uint64_t metric_slab_allocated;
+
+  // Usage tracking - number of slab allocations in existing pages
+  uint64_t metric_slab_reused;
+
+  // Usage tracking - bytes lost due to size class rounding
+  uint64_t metric_slab_padding;
+
+  // Usage tracking - number of partial reads (UPS_PARTIAL)
+  uint64_t metric_partial_read;
+
+  // Usage tracking - number of bytes returned by partial reads
+  uint64_t metric_partial_read_bytes;
+
+  // Usage tracking - number of records which share an existing blob
+  uint64_t metric_dedup_hits;
+
+  // Usage tracking - number of record bytes written to deduplicated
+  // databases
+  uint64_t metric_dedup_logical_bytes;
+
+  // Usage tracking - number of record bytes stored by deduplicated
+  // databases
+  uint64_t metric_dedup_stored_bytes;
 };
 
 } // namespace upscaledb
@@ -26,6 +26,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "2compressor/compressor.h"
 #include "2device/device_disk.h"
 #include "3blob_manager/blob_manager_disk.h"
@@ -39,6 +40,64 @@
 
 using namespace upscaledb;
 
+// The slot sizes of the size classes; each class is roughly 1.5x larger
+// than its predecessor, therefore the padding of a blob does not
+// exceed 33%
+static const uint32_t kSlotSizes[DiskBlobManager::kSizeClasses] = {
+  32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+int
+DiskBlobManager::size_class(uint32_t page_size, uint32_t alloc_size)
+{
+  uint32_t usable = page_size - kPageOverhead;
+  for (int i = 0; i < kSizeClasses; i++) {
+    if (alloc_size <= kSlotSizes[i])
+      return kSlotSizes[i] * kMinSlotsPerSlab <= usable ? i + 1 : 0;
+  }
+  return 0;
+}
+
+uint32_t
+DiskBlobManager::slot_size(int size_class)
+{
+  assert(size_class > 0 && size_class <= kSizeClasses);
+  return kSlotSizes[size_class - 1];
+}
+
+uint32_t
+DiskBlobManager::slot_count(uint32_t page_size, int size_class)
+{
+  return std::min((uint32_t)PBlobPageHeader::kMaxSlots,
+                  (page_size - kPageOverhead) / slot_size(size_class));
+}
+
+// Returns the offset of the payload, relative to the blob id
+static inline uint32_t
+payload_offset(const PBlobHeader *blob_header)
+{
+  return ISSET(blob_header->flags, PBlobHeader::kIsDeduplicated)
+            ? sizeof(PBlobHeader) + sizeof(PBlobDedupHeader)
+            : sizeof(PBlobHeader);
+}
+
+// Returns true if the record is stored in a deduplicated blob
+static inline bool
+is_deduplicated(Context *context, uint32_t flags)
+{
+  return NOTSET(flags, BlobManager::kDisableDeduplication)
+            && ISSET(context->db->flags(), UPS_ENABLE_RECORD_DEDUPLICATION);
+}
+
+// Calculates the hash of a record which is used for deduplication
+static inline uint64_t
+record_hash(const ups_record_t *record)
+{
+  uint64_t hash[2];
+  MurmurHash3_x64_128(record->data, (int)record->size, 0, hash);
+  return hash[0];
+}
+
 static bool
 check_integrity(DiskBlobManager *dbm, PBlobPageHeader *header)
 {
@@ -50,6 +109,27 @@ check_integrity(DiskBlobManager *dbm, PBlobPageHeader *header)
     return false;
   }
 
+  // slab pages do not use the freelist; verify the slot bitmap instead
+  if (header->size_class) {
+    int size_class = (int)header->size_class;
+    if (header->num_pages != 1 || size_class > DiskBlobManager::kSizeClasses) {
+      ups_trace(("integrity violated: invalid slab page"));
+      return false;
+    }
+    uint32_t slot_count = DiskBlobManager::slot_count(
+                    dbm->config->page_size_bytes, size_class);
+    uint32_t free_slots = 0;
+    for (uint32_t i = 0; i < slot_count; i++)
+      if (!header->is_slot_used(i))
+        free_slots++;
+    if (free_slots * DiskBlobManager::slot_size(size_class)
+          != header->free_bytes) {
+      ups_trace(("integrity violated: free slots do not match free bytes"));
+      return false;
+    }
+    return true;
+  }
+
   // freelist is not used if this is a multi-page blob
   if (header->num_pages > 1)
     return true;
@@ -182,6 +262,117 @@ alloc_from_freelist(DiskBlobManager *dbm, PBlobPageHeader *header,
   return false;
 }
 
+// Allocates a slot in a slab page of |size_class|. Pages with free slots
+// are looked up in the PageManager's index; a new page is allocated if
+// there is none. Returns the address of the slot and stores the page
+// in |*ppage|.
+static uint64_t
+alloc_from_slab(DiskBlobManager *dbm, Context *context, int size_class,
+                Page **ppage)
+{
+  PageManager *page_manager = dbm->page_manager;
+  uint32_t page_size = dbm->config->page_size_bytes;
+  uint32_t slot_size = DiskBlobManager::slot_size(size_class);
+  uint32_t slot_count = DiskBlobManager::slot_count(page_size, size_class);
+
+  Page *page = 0;
+  PBlobPageHeader *header = 0;
+
+  // The index is not logged and therefore can be stale after a crash.
+  // Verify that the indexed page is still a slab page of this size class
+  // with free space, otherwise drop it from the index.
+  while (uint64_t page_id = page_manager->slab_page_id(size_class)) {
+    page = page_manager->fetch(context, page_id);
+    header = PBlobPageHeader::from_page(page);
+    if (page->type() == Page::kTypeBlob
+          && header->num_pages == 1
+          && header->size_class == (uint32_t)size_class
+          && header->free_bytes >= slot_size) {
+      dbm->metric_slab_reused++;
+      break;
+    }
+    page_manager->remove_slab_page(page_id);
+    page = 0;
+  }
+
+  // no page with free slots available? then allocate a new one
+  if (!page) {
+    page = page_manager->alloc(context, Page::kTypeBlob);
+    header = PBlobPageHeader::from_page(page);
+    header->initialize();
+    header->num_pages = 1;
+    header->size_class = (uint32_t)size_class;
+    header->free_bytes = slot_count * slot_size;
+    page_manager->add_slab_page(page->address(), size_class);
+  }
+
+  assert(check_integrity(dbm, header));
+
+  // pick the first free slot; skip words where all slots are occupied
+  uint32_t slot = slot_count;
+  for (uint32_t w = 0; w * 64 < slot_count && slot == slot_count; w++) {
+    if (header->slots[w] == ~(uint64_t)0)
+      continue;
+    for (uint32_t i = w * 64; i < slot_count && i < (w + 1) * 64; i++) {
+      if (!header->is_slot_used(i)) {
+        slot = i;
+        break;
+      }
+    }
+  }
+
+  if (unlikely(slot == slot_count)) {
+    ups_trace(("integrity violated: slab page %lu has no free slot",
+                page->address()));
+    throw Exception(UPS_INTEGRITY_VIOLATED);
+  }
+
+  header->set_slot_used(slot, true);
+  header->free_bytes -= slot_size;
+  page->set_dirty(true);
+
+  // the page is full? then remove it from the index
+  if (header->free_bytes < slot_size)
+    page_manager->remove_slab_page(page->address());
+
+  *ppage = page;
+  return page->address() + DiskBlobManager::kPageOverhead + slot * slot_size;
+}
+
+// Releases the slot of |blob_id| in a slab page. If the page is empty
+// afterwards then it is moved to the PageManager's freelist.
+static void
+erase_from_slab(DiskBlobManager *dbm, Context *context, Page *page,
+                PBlobPageHeader *header, uint64_t blob_id)
+{
+  PageManager *page_manager = dbm->page_manager;
+  int size_class = (int)header->size_class;
+  uint32_t slot_size = DiskBlobManager::slot_size(size_class);
+  uint32_t slot_count = DiskBlobManager::slot_count(
+                  dbm->config->page_size_bytes, size_class);
+  uint32_t slot = (uint32_t)(blob_id - page->address()
+                  - DiskBlobManager::kPageOverhead) / slot_size;
+
+  assert(slot < slot_count);
+  assert(header->is_slot_used(slot));
+
+  header->set_slot_used(slot, false);
+  header->free_bytes += slot_size;
+  page->set_dirty(true);
+
+  // the page is now completely empty? then move it to the freelist
+  if (header->free_bytes == slot_count * slot_size) {
+    page_manager->remove_slab_page(page->address());
+    page_manager->del(context, page, 1);
+    header->initialize();
+    return;
+  }
+
+  // otherwise make the free slot available for future allocations
+  page_manager->add_slab_page(page->address(), size_class);
+  assert(check_integrity(dbm, header));
+}
+
 static uint8_t *
 read_chunk(DiskBlobManager *dbm, Context *context, Page *page, Page **ppage,
                 uint64_t address, bool fetch_read_only, bool mapped_pointer)
@@ -190,19 +381,25 @@ read_chunk(DiskBlobManager *dbm, Context *context, Page *page, Page **ppage,
   uint32_t page_size = dbm->config->page_size_bytes;
   uint64_t pageid = address - (address % page_size);
 
+  uint8_t *data;
+
+  // if the caller passed the blob's first page then any other page is a
+  // continuation page without header
+  bool has_header = (page == 0);
+
   // is this the current page? if yes then continue working with this page,
   // otherwise fetch the page
   if (page && page->address() != pageid)
     page = 0;
 
-  uint8_t *data;
-
   if (unlikely(!page)) {
     uint32_t flags = 0;
     if (fetch_read_only)
       flags |= PageManager::kReadOnly;
     if (mapped_pointer)
       flags |= PageManager::kOnlyFromCache;
+    if (!has_header)
+      flags |= PageManager::kNoHeader;
     page = dbm->page_manager->fetch(context, pageid, flags);
     if (ppage)
       *ppage = page;
@@ -216,7 +413,8 @@ read_chunk(DiskBlobManager *dbm, Context *context, Page *page, Page **ppage,
   else
     data = page->raw_payload();
 
-  uint32_t read_start = (uint32_t)(address - page->address());
+  // |page| is null if the data was read from the mapping
+  uint32_t read_start = (uint32_t)(address - pageid);
   return &data[read_start];
 }
 
@@ -226,7 +424,9 @@ copy_chunk(DiskBlobManager *dbm, Context *context, Page *page, Page **ppage,
                 bool fetch_read_only)
 {
   uint32_t page_size = dbm->config->page_size_bytes;
-  bool first_page = true;
+  // if the caller passed the blob's first page then any other page is a
+  // continuation page without header
+  bool first_page = (page == 0);
 
   while (size) {
     // get the page-id from this chunk
@@ -305,19 +505,38 @@ uint64_t
 DiskBlobManager::allocate(Context *context, ups_record_t *record,
                 uint32_t flags)
 {
+  // deduplication enabled? then try to share an existing blob with
+  // identical contents
+  bool dedup = is_deduplicated(context, flags);
+  uint64_t hash = 0;
+  if (dedup) {
+    hash = record_hash(record);
+    metric_dedup_logical_bytes += record->size;
+    uint64_t blob_id = find_duplicate(context, record, hash);
+    if (blob_id) {
+      metric_dedup_hits++;
+      return blob_id;
+    }
+    metric_dedup_stored_bytes += record->size;
+  }
+
   metric_total_allocated++;
 
-  uint8_t *chunk_data[2];
-  uint32_t chunk_size[2];
+  uint8_t *chunk_data[3];
+  uint32_t chunk_size[3];
+  uint32_t chunks = 0;
   uint32_t page_size = config->page_size_bytes;
 
   void *record_data = record->data;
   uint32_t record_size = record->size;
   uint32_t original_size = record->size;
 
-  // compression enabled? then try to compress the data
-  Compressor *compressor = context->db->record_compressor.get();
-  if (compressor && !(flags & kDisableCompression)) {
+  // compression enabled? then try to compress the data; new blobs use
+  // the most recently trained dictionary
+  Compressor *compressor = NOTSET(flags, kDisableCompression)
+                                ? context->db->current_record_compressor()
+                                : 0;
+  if (compressor) {
     metric_before_compression += record_size;
     uint32_t len = compressor->compress((uint8_t *)record->data,
                         record->size);
@@ -328,17 +547,67 @@ DiskBlobManager::allocate(Context *context, ups_record_t *record,
     metric_after_compression += record_size;
   }
   PBlobHeader blob_header;
+  PBlobDedupHeader dedup_header;
   uint32_t alloc_size = sizeof(PBlobHeader) + record_size;
+  if (dedup)
+    alloc_size += sizeof(PBlobDedupHeader);
+
+  // initialize the blob header
+  blob_header.allocated_size = alloc_size;
+  blob_header.size = record->size;
+  blob_header.flags = original_size != record_size
+                            ? PBlobHeader::kIsCompressed
+                            : 0;
+  if (original_size != record_size)
+    blob_header.set_dictionary_id(context->db->current_dictionary_id());
+
+  chunk_data[chunks] = (uint8_t *)&blob_header;
+  chunk_size[chunks] = sizeof(blob_header);
+  chunks++;
+
+  // deduplicated blobs store the hash and a reference counter
+  if (dedup) {
+    blob_header.flags |= PBlobHeader::kIsDeduplicated;
+    dedup_header.hash = hash;
+    dedup_header.refcount = 1;
+    dedup_header.db_name = context->db->name();
+
+    chunk_data[chunks] = (uint8_t *)&dedup_header;
+    chunk_size[chunks] = sizeof(dedup_header);
+    chunks++;
+  }
 
-  // first check if we can add another blob to the last used page
-  Page *page = page_manager->last_blob_page(context);
+  chunk_data[chunks] = (uint8_t *)record_data;
+  chunk_size[chunks] = record_size;
+  chunks++;
+
+  Page *page = 0;
+
+  // small blobs are stored in the slab pages of their size class
+  int sclass = size_class(page_size, alloc_size);
+  if (sclass) {
+    blob_header.blob_id = alloc_from_slab(this, context, sclass, &page);
+    metric_slab_allocated++;
+    metric_slab_padding += slot_size(sclass) - alloc_size;
+
+    write_chunks(this, context, page, blob_header.blob_id, chunk_data,
+                    chunk_size, chunks);
+    if (dedup)
+      dedup_index[DedupKey(context->db->name(), hash)] = blob_header.blob_id;
+    return blob_header.blob_id;
+  }
+
+  // otherwise check if we can add another blob to the last used page
+  page = page_manager->last_blob_page(context);
 
   PBlobPageHeader *header = 0;
   uint64_t address = 0;
   if (page) {
     header = PBlobPageHeader::from_page(page);
-    // allocate space for the blob
-    if (!alloc_from_freelist(this, header, alloc_size, &address))
+    // allocate space for the blob; slab pages are never used for
+    // larger blobs
+    if (header->size_class
+          || !alloc_from_freelist(this, header, alloc_size, &address))
       page = 0;
     else
       address += page->address();
@@ -394,28 +663,65 @@ DiskBlobManager::allocate(Context *context, ups_record_t *record,
   else
     page_manager->set_last_blob_page(0);
 
-  // initialize the blob header
-  blob_header.allocated_size = alloc_size;
-  blob_header.size = record->size;
   blob_header.blob_id = address;
-  blob_header.flags = original_size != record_size
-                            ? PBlobHeader::kIsCompressed
-                            : 0;
-
-  chunk_data[0] = (uint8_t *)&blob_header;
-  chunk_size[0] = sizeof(blob_header);
-  chunk_data[1] = (uint8_t *)record_data;
-  chunk_size[1] = record_size;
 
-  write_chunks(this, context, page, address, chunk_data, chunk_size, 2);
-  address += chunk_size[0] + chunk_size[1];
+  write_chunks(this, context, page, address, chunk_data, chunk_size, chunks);
 
   // store the blob_id; it will be returned to the caller
   uint64_t blob_id = blob_header.blob_id;
+  if (dedup)
+    dedup_index[DedupKey(context->db->name(), hash)] = blob_id;
   assert(check_integrity(this, header));
   return blob_id;
 }
 
+uint64_t
+DiskBlobManager::find_duplicate(Context *context, ups_record_t *record,
+                uint64_t hash)
+{
+  DedupKey key(context->db->name(), hash);
+  DedupIndex::iterator it = dedup_index.find(key);
+  if (it == dedup_index.end())
+    return 0;
+
+  uint64_t blob_id = it->second;
+
+  // verify the indexed blob before it is shared
+  Page *page;
+  PBlobHeader *blob_header = (PBlobHeader *)read_chunk(this, context, 0, &page,
+                  blob_id, true, false);
+  PBlobDedupHeader *dedup_header =
+                  PBlobDedupHeader::from_blob_header(blob_header);
+  if (unlikely(blob_header->blob_id != blob_id
+        || NOTSET(blob_header->flags, PBlobHeader::kIsDeduplicated)
+        || dedup_header->db_name != key.first
+        || dedup_header->hash != hash
+        || dedup_header->refcount == 0)) {
+    dedup_index.erase(it);
+    return 0;
+  }
+
+  // different size, hash collision or the reference counter would
+  // overflow? then the caller allocates a new blob
+  if (blob_header->size != record->size
+        || dedup_header->refcount == 0xffffffffu)
+    return 0;
+
+  ByteArray arena;
+  ups_record_t stored = {0};
+  read(context, blob_id, &stored, UPS_FORCE_DEEP_COPY, &arena);
+  if (::memcmp(stored.data, record->data, record->size) != 0)
+    return 0;
+
+  // fetch the header again, this time for writing
+  blob_header = (PBlobHeader *)read_chunk(this, context, 0, &page,
+                  blob_id, false, false);
+  dedup_header = PBlobDedupHeader::from_blob_header(blob_header);
+  dedup_header->refcount++;
+  page->set_dirty(true);
+  return blob_id;
+}
+
 void
 DiskBlobManager::read(Context *context, uint64_t blob_id,
                 ups_record_t *record, uint32_t flags, ByteArray *arena)
@@ -433,7 +739,21 @@ DiskBlobManager::read(Context *context, uint64_t blob_id,
     throw Exception(UPS_BLOB_NOT_FOUND);
   }
 
+  // add deduplicated blobs to the index; it is not persisted and therefore
+  // rebuilt while the blobs are read
+  if (unlikely(ISSET(blob_header->flags, PBlobHeader::kIsDeduplicated))) {
+    PBlobDedupHeader *dedup_header =
+                  PBlobDedupHeader::from_blob_header(blob_header);
+    dedup_index.insert(DedupIndex::value_type(
+                  DedupKey((uint16_t)dedup_header->db_name,
+                           (uint64_t)dedup_header->hash),
+                  blob_id));
+  }
+
   uint32_t blobsize = (uint32_t)blob_header->size;
+  uint64_t payload = blob_id + payload_offset(blob_header);
+  uint32_t stored_size = blob_header->allocated_size
+                  - payload_offset(blob_header);
   record->size = blobsize;
 
   // empty blob?
@@ -443,14 +763,21 @@ DiskBlobManager::read(Context *context, uint64_t blob_id,
     return;
   }
 
+  // partial read of an uncompressed blob: only fetch the pages which
+  // cover the requested window
+  if (unlikely(ISSET(flags, UPS_PARTIAL))
+        && NOTSET(blob_header->flags, PBlobHeader::kIsCompressed)) {
+    read_window(context, page, payload, blobsize, record, flags, arena);
+    return;
+  }
+
   // if the blob is in memory-mapped storage (and the user does not require
   // a copy of the data): simply return a pointer
   if (NOTSET(flags, UPS_FORCE_DEEP_COPY)
         && device->is_mapped(blob_id, blobsize)
         && NOTSET(blob_header->flags, PBlobHeader::kIsCompressed)
         && NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-    record->data = read_chunk(this, context, page, 0,
-                        blob_id + sizeof(PBlobHeader), true, true);
+    record->data = read_chunk(this, context, page, 0, payload, true, true);
   }
   // otherwise resize the blob buffer and copy the blob data into the buffer
   else {
@@ -458,28 +785,36 @@ DiskBlobManager::read(Context *context, uint64_t blob_id,
     // read into the Compressor's arena, otherwise read directly into the
     // caller's arena
     if (ISSET(blob_header->flags, PBlobHeader::kIsCompressed)) {
-      Compressor *compressor = context->db->record_compressor.get();
+      Compressor *compressor = context->db->record_compressor_for(
+                      blob_header->dictionary_id());
       assert(compressor != 0);
 
       // read into temporary buffer; we reuse the compressor's memory arena
       // for this
       ByteArray *dest = &compressor->arena;
-      dest->resize(blob_header->allocated_size - sizeof(PBlobHeader));
-
-      copy_chunk(this, context, page, 0, blob_id + sizeof(PBlobHeader),
-                    dest->data(),
-                    blob_header->allocated_size - sizeof(PBlobHeader), true);
+      dest->resize(stored_size);
+
+      copy_chunk(this, context, page, 0, payload, dest->data(),
+                    stored_size, true);
+
+      // partial read: uncompress the full blob, then return the window
+      if (unlikely(ISSET(flags, UPS_PARTIAL))) {
+        compressor->decompress(dest->data(), stored_size, blobsize, arena);
+        assign_record_window(record, arena, arena->data(), blobsize,
+                      ISSET(record->flags, UPS_RECORD_USER_ALLOC)
+                          ? UPS_PARTIAL
+                          : UPS_PARTIAL | UPS_DIRECT_ACCESS);
+        return;
+      }
 
       // now uncompress into the caller's memory arena
       if (ISSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-        compressor->decompress(dest->data(),
-                      blob_header->allocated_size - sizeof(PBlobHeader),
+        compressor->decompress(dest->data(), stored_size,
                       blobsize, (uint8_t *)record->data);
       }
       else {
         arena->resize(blobsize);
-        compressor->decompress(dest->data(),
-                      blob_header->allocated_size - sizeof(PBlobHeader),
+        compressor->decompress(dest->data(), stored_size,
                       blobsize, arena);
         record->data = arena->data();
       }
@@ -492,8 +827,7 @@ DiskBlobManager::read(Context *context, uint64_t blob_id,
         record->data = arena->data();
       }
 
-      copy_chunk(this, context, page, 0,
-                  blob_id + sizeof(PBlobHeader),
+      copy_chunk(this, context, page, 0, payload,
                   (uint8_t *)record->data, blobsize, true);
     }
   }
@@ -514,6 +848,41 @@ DiskBlobManager::read(Context *context, uint64_t blob_id,
   }
 }
 
+void
+DiskBlobManager::read_window(Context *context, Page *page, uint64_t payload,
+                uint32_t blobsize, ups_record_t *record, uint32_t flags,
+                ByteArray *arena)
+{
+  RecordWindow window(record, blobsize, flags);
+  record->size = window.size;
+
+  metric_partial_read++;
+  metric_partial_read_bytes += window.size;
+
+  if (unlikely(window.size == 0)) {
+    record->data = 0;
+    return;
+  }
+
+  uint64_t address = payload + window.offset;
+
+  // the window is memory-mapped: return a pointer into the mapping
+  if (NOTSET(flags, UPS_FORCE_DEEP_COPY)
+        && device->is_mapped(address, window.size)
+        && NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
+    record->data = read_chunk(this, context, page, 0, address, true, true);
+    return;
+  }
+
+  if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
+    arena->resize(window.size);
+    record->data = arena->data();
+  }
+
+  copy_chunk(this, context, page, 0, address, (uint8_t *)record->data,
+                window.size, true);
+}
+
 uint32_t
 DiskBlobManager::blob_size(Context *context, uint64_t blob_id)
 {
@@ -554,12 +923,53 @@ DiskBlobManager::overwrite(Context *context, uint64_t old_blobid,
   if (unlikely(old_blob_header->blob_id != old_blobid))
     throw Exception(UPS_BLOB_NOT_FOUND);
 
+  // Deduplicated blobs can be shared with other records and are never
+  // overwritten in place. The new record is deduplicated as well.
+  if (ISSET(old_blob_header->flags, PBlobHeader::kIsDeduplicated)
+        || is_deduplicated(context, flags)) {
+    uint64_t new_blobid = allocate(context, record, flags);
+    erase(context, old_blobid, 0, 0);
+    return new_blobid;
+  }
+
+  // Slab pages: the blob is overwritten in place if it still belongs to
+  // the same size class. Otherwise it is moved to a slab page of the
+  // new size class.
+  PBlobPageHeader *old_header = PBlobPageHeader::from_page(page);
+  if (old_header->size_class) {
+    if (size_class(config->page_size_bytes, alloc_size)
+            != (int)old_header->size_class) {
+      uint64_t new_blobid = allocate(context, record, flags);
+      erase(context, old_blobid, 0, 0);
+      return new_blobid;
+    }
+
+    uint8_t *chunk_data[2];
+    uint32_t chunk_size[2];
+
+    new_blob_header.blob_id = old_blobid;
+    new_blob_header.size = record->size;
+    new_blob_header.allocated_size = alloc_size;
+    new_blob_header.flags = 0; // disable compression, just in case...
+
+    chunk_data[0] = (uint8_t *)&new_blob_header;
+    chunk_size[0] = sizeof(new_blob_header);
+    chunk_data[1] = (uint8_t *)record->data;
+    chunk_size[1] = record->size;
+
+    write_chunks(this, context, page, old_blobid, chunk_data, chunk_size, 2);
+    return old_blobid;
+  }
+
   // now compare the sizes; does the new data fit in the old allocated
   // space?
   if (alloc_size <= old_blob_header->allocated_size) {
     uint8_t *chunk_data[2];
     uint32_t chunk_size[2];
 
+    // |old_blob_header| points into the page and is overwritten below
+    uint32_t old_allocated_size = old_blob_header->allocated_size;
+
     // setup the new blob header
     new_blob_header.blob_id = old_blob_header->blob_id;
     new_blob_header.size = record->size;
@@ -577,12 +987,11 @@ DiskBlobManager::overwrite(Context *context, uint64_t old_blobid,
     PBlobPageHeader *header = PBlobPageHeader::from_page(page);
 
     // move remaining data to the freelist
-    if (alloc_size < old_blob_header->allocated_size) {
-      PBlobPageHeader *header = PBlobPageHeader::from_page(page);
-      header->free_bytes += old_blob_header->allocated_size - alloc_size;
+    if (alloc_size < old_allocated_size) {
+      header->free_bytes += old_allocated_size - alloc_size;
       add_to_freelist(this, header,
                   (uint32_t)(old_blobid + alloc_size) - page->address(),
-                  (uint32_t)old_blob_header->allocated_size - alloc_size);
+                  old_allocated_size - alloc_size);
     }
 
     // multi-page blobs store their CRC in the first freelist offset
@@ -634,10 +1043,13 @@ DiskBlobManager::overwrite_regions(Context *context, uint64_t old_blob_id,
 
   // only overwrite the regions if
   // - the blob does not grow
-  // - blob is compressed
+  // - blob is not compressed
+  // - blob is not deduplicated
   if (alloc_size > blob_header->allocated_size
         || header->num_pages == 1
-        || ISSET(blob_header->flags, PBlobHeader::kIsCompressed))
+        || ISSET(blob_header->flags, PBlobHeader::kIsCompressed)
+        || ISSET(blob_header->flags, PBlobHeader::kIsDeduplicated)
+        || is_deduplicated(context, flags))
     return overwrite(context, old_blob_id, record, flags);
 
   uint8_t *chunk_data[2];
@@ -705,8 +1117,33 @@ DiskBlobManager::erase(Context *context, uint64_t blob_id, Page *page,
   if (unlikely(blob_header->blob_id != blob_id))
     throw Exception(UPS_BLOB_NOT_FOUND);
 
-  // update the "free bytes" counter in the blob page header
+  // deduplicated blobs are only released when the last reference is gone
+  if (ISSET(blob_header->flags, PBlobHeader::kIsDeduplicated)) {
+    PBlobDedupHeader *dedup_header =
+                  PBlobDedupHeader::from_blob_header(blob_header);
+    if (dedup_header->refcount > 1) {
+      dedup_header->refcount--;
+      page->set_dirty(true);
+      return;
+    }
+
+    dedup_header->refcount = 0;
+    DedupIndex::iterator it = dedup_index.find(
+                  DedupKey((uint16_t)dedup_header->db_name,
+                           (uint64_t)dedup_header->hash));
+    if (it != dedup_index.end() && it->second == blob_id)
+      dedup_index.erase(it);
+  }
+
   PBlobPageHeader *header = PBlobPageHeader::from_page(page);
+
+  // slab pages manage their slots in a bitmap
+  if (header->size_class) {
+    erase_from_slab(this, context, page, header, blob_id);
+    return;
+  }
+
+  // update the "free bytes" counter in the blob page header
   header->free_bytes += blob_header->allocated_size;
 
   // if the page is now completely empty (all blobs were erased) then move
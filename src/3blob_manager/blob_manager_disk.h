@@ -21,6 +21,8 @@
 
 #include "0root/root.h"
 
+#include <map>
+
 // Always verify that a file of level N does not include headers > N!
 #include "3blob_manager/blob_manager.h"
 
@@ -36,13 +38,18 @@ namespace upscaledb {
  * The header of a blob page
  *
  * Contains a fixed length freelist and a couter for the number of free
- * bytes
+ * bytes. Pages which store small blobs of a single size class ("slab pages")
+ * are split into equally sized slots; they use a bitmap of occupied slots
+ * instead of the freelist.
  */
 UPS_PACK_0 struct UPS_PACK_1 PBlobPageHeader
 {
   enum {
     // Freelist entries
-    kFreelistLength = 32
+    kFreelistLength = 32,
+
+    // Maximum number of slots in a slab page
+    kMaxSlots = kFreelistLength * 64
   };
 
   void initialize() {
@@ -54,6 +61,19 @@ UPS_PACK_0 struct UPS_PACK_1 PBlobPageHeader
     return (PBlobPageHeader *)&page->payload()[0];
   }
 
+  // Returns true if slot |i| of a slab page is occupied
+  bool is_slot_used(uint32_t i) const {
+    return (slots[i / 64] & (1ull << (i % 64))) != 0;
+  }
+
+  // Marks slot |i| of a slab page as occupied or free
+  void set_slot_used(uint32_t i, bool used) {
+    if (used)
+      slots[i / 64] |= 1ull << (i % 64);
+    else
+      slots[i / 64] &= ~(1ull << (i % 64));
+  }
+
   // Number of "regular" pages for this blob; used for blobs exceeding
   // a page size
   uint32_t num_pages;
@@ -61,11 +81,49 @@ UPS_PACK_0 struct UPS_PACK_1 PBlobPageHeader
   // Number of free bytes in this page
   uint32_t free_bytes;
 
-  // The freelist - offset/size pairs in this page
+  // The (1-based) size class if this is a slab page; 0 otherwise
+  uint32_t size_class;
+
   struct FreelistEntry {
     uint32_t offset;
     uint32_t size;
-  } freelist[kFreelistLength];
+  };
+
+  union {
+    // The freelist - offset/size pairs in this page
+    FreelistEntry freelist[kFreelistLength];
+
+    // Slab pages: a bitmap of the occupied slots
+    uint64_t slots[kFreelistLength];
+  };
+} UPS_PACK_2;
+
+/*
+ * The header of a deduplicated blob; it directly follows the PBlobHeader
+ * if the blob has the flag PBlobHeader::kIsDeduplicated
+ */
+UPS_PACK_0 struct UPS_PACK_1 PBlobDedupHeader
+{
+  PBlobDedupHeader() {
+    ::memset(this, 0, sizeof(PBlobDedupHeader));
+  }
+
+  // Returns the PBlobDedupHeader of a deduplicated blob
+  static PBlobDedupHeader *from_blob_header(PBlobHeader *blob_header) {
+    return (PBlobDedupHeader *)(blob_header + 1);
+  }
+
+  // The hash of the (uncompressed) record
+  uint64_t hash;
+
+  // The number of records which reference this blob
+  uint32_t refcount;
+
+  // The name of the database which owns this blob
+  uint16_t db_name;
+
+  // Reserved, for padding
+  uint16_t reserved;
 } UPS_PACK_2;
 
 #include "1base/packstop.h"
@@ -78,7 +136,13 @@ struct DiskBlobManager : public BlobManager
 {
   enum {
     // Overhead per page
-    kPageOverhead = Page::kSizeofPersistentHeader + sizeof(PBlobPageHeader)
+    kPageOverhead = Page::kSizeofPersistentHeader + sizeof(PBlobPageHeader),
+
+    // Number of size classes for small blobs
+    kSizeClasses = 15,
+
+    // A slab page stores at least this number of blobs
+    kMinSlotsPerSlab = 4
   };
 
   DiskBlobManager(const EnvConfig *config,
@@ -93,7 +157,8 @@ struct DiskBlobManager : public BlobManager
 
   // reads a blob and stores the data in |record|. The pointer |record.data|
   // is backed by the |arena|, unless |UPS_RECORD_USER_ALLOC| is set.
-  // flags: either 0 or UPS_DIRECT_ACCESS
+  // flags: either 0 or UPS_DIRECT_ACCESS, optionally combined with
+  // UPS_PARTIAL
   virtual void read(Context *context, uint64_t blobid, ups_record_t *record,
                   uint32_t flags, ByteArray *arena);
 
@@ -118,6 +183,37 @@ struct DiskBlobManager : public BlobManager
   // delete an existing blob
   virtual void erase(Context *context, uint64_t blobid,
                   Page *page = 0, uint32_t flags = 0);
+
+  // Returns the (1-based) size class for a blob with |alloc_size| bytes
+  // (including the PBlobHeader), or 0 if the blob is too large for a
+  // slab page
+  static int size_class(uint32_t page_size, uint32_t alloc_size);
+
+  // Returns the slot size of a (1-based) size class
+  static uint32_t slot_size(int size_class);
+
+  // Returns the number of slots of a slab page
+  static uint32_t slot_count(uint32_t page_size, int size_class);
+
+ private:
+  // Looks up a blob of the current database with the same contents as
+  // |record|. If one is found then its reference counter is incremented
+  // and the blob id is returned; otherwise returns 0
+  uint64_t find_duplicate(Context *context, ups_record_t *record,
+                  uint64_t hash);
+
+  // Reads the window of an uncompressed blob (UPS_PARTIAL); |page| is the
+  // page with the blob header, |payload| is the address of the blob's data
+  void read_window(Context *context, Page *page, uint64_t payload,
+                  uint32_t blobsize, ups_record_t *record, uint32_t flags,
+                  ByteArray *arena);
+
+  // Maps (database name, record hash) to the id of a deduplicated blob.
+  // The index is not persisted; it is populated whenever a deduplicated
+  // blob is allocated or read. Entries are verified before they're used.
+  typedef std::pair<uint16_t, uint64_t> DedupKey;
+  typedef std::map<DedupKey, uint64_t> DedupIndex;
+  DedupIndex dedup_index;
 };
 
 } // namespace upscaledb
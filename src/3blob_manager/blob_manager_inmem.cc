@@ -20,6 +20,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "2device/device_inmem.h"
 #include "2compressor/compressor.h"
 #include "3blob_manager/blob_manager_inmem.h"
@@ -42,8 +43,9 @@ InMemoryBlobManager::allocate(Context *context, ups_record_t *record,
   uint32_t record_size = record->size;
   uint32_t original_size = record->size;
 
-  // compression enabled? then try to compress the data
-  Compressor *compressor = context->db->record_compressor.get();
+  // compression enabled? then try to compress the data; new blobs use
+  // the most recently trained dictionary
+  Compressor *compressor = context->db->current_record_compressor();
   if (compressor) {
     metric_before_compression += record_size;
     uint32_t len = compressor->compress((uint8_t *)record->data,
@@ -65,6 +67,8 @@ InMemoryBlobManager::allocate(Context *context, ups_record_t *record,
   blob_header->flags = original_size != record_size
                             ? PBlobHeader::kIsCompressed
                             : 0;
+  if (original_size != record_size)
+    blob_header->set_dictionary_id(context->db->current_dictionary_id());
   blob_header->allocated_size = record_size + sizeof(PBlobHeader);
   blob_header->size = original_size;
 
@@ -98,11 +102,30 @@ InMemoryBlobManager::read(Context *context, uint64_t blobid,
   // is the record compressed? if yes then decompress directly in the
   // caller's memory arena to avoid additional memcpys
   if (ISSET(blob_header->flags, PBlobHeader::kIsCompressed)) {
-    Compressor *compressor = context->db->record_compressor.get();
+    Compressor *compressor = context->db->record_compressor_for(
+                    blob_header->dictionary_id());
     compressor->decompress(blob_data,
                   blob_header->allocated_size - sizeof(PBlobHeader),
                   blob_size, arena);
-    record->data = arena->data();
+
+    // partial read: return the window of the decompressed blob
+    if (unlikely(ISSET(flags, UPS_PARTIAL)))
+      assign_record_window(record, arena, arena->data(), blob_size,
+                      ISSET(record->flags, UPS_RECORD_USER_ALLOC)
+                          ? UPS_PARTIAL
+                          : UPS_PARTIAL | UPS_DIRECT_ACCESS);
+    else
+      record->data = arena->data();
+    return;
+  }
+
+  // partial read: only copy the window
+  if (unlikely(ISSET(flags, UPS_PARTIAL))) {
+    RecordWindow window(record, blob_size, flags);
+    metric_partial_read++;
+    metric_partial_read_bytes += window.size;
+    assign_record_window(record, arena, blob_data, blob_size,
+                    flags & UPS_PARTIAL);
     return;
   }
 
@@ -46,7 +46,8 @@ struct InMemoryBlobManager : public BlobManager {
                   uint32_t flags);
 
   // Reads a blob and stores the data in |record|
-  // |flags|: either 0 or UPS_DIRECT_ACCESS
+  // |flags|: either 0 or UPS_DIRECT_ACCESS, optionally combined with
+  // UPS_PARTIAL
   virtual void read(Context *context, uint64_t blobid, ups_record_t *record,
                   uint32_t flags, ByteArray *arena);
 
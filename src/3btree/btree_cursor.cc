@@ -405,6 +405,7 @@ BtreeCursor::overwrite(Context *context, ups_record_t *record, uint32_t flags)
 
   // copy the key flags, and remove all flags concerning the key size
   BtreeNodeProxy *node = st_.btree->get_node_from_page(st_.coupled_page);
+  st_.btree->zone_map()->invalidate(st_.coupled_page->address());
   node->set_record(context, st_.coupled_index, record, st_.duplicate_index,
                     flags | UPS_OVERWRITE, 0);
 
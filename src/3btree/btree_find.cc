@@ -48,7 +48,8 @@ struct BtreeFindAction
                   ups_record_t *record_, ByteArray *record_arena_,
                   uint32_t flags_)
     : btree(btree_), context(context_), cursor(cursor_), key(key_),
-      record(record_), flags(flags_), key_arena(key_arena_),
+      record(record_), flags(flags_ & ~UPS_PARTIAL),
+      record_flags(flags_ & UPS_PARTIAL), key_arena(key_arena_),
       record_arena(record_arena_) {
   }
 
@@ -173,7 +174,7 @@ return_result:
       node->key(context, slot, key_arena, key);
 
     if (likely(record != 0))
-      node->record(context, slot, record_arena, record, flags);
+      node->record(context, slot, record_arena, record, flags | record_flags);
 
     return 0;
   }
@@ -243,6 +244,9 @@ return_result:
   // flags of ups_db_find()
   uint32_t flags;
 
+  // flags for retrieving the record (UPS_PARTIAL)
+  uint32_t record_flags;
+
   // allocator for the key data
   ByteArray *key_arena;
 
@@ -35,6 +35,7 @@
 #include "3btree/btree_node.h"
 #include "3btree/btree_keys_base.h"
 #include "3btree/btree_visitor.h"
+#include "3btree/btree_zone_map.h"
 #include "4uqi/statements.h"
 #include "4uqi/scanvisitor.h"
 #include "4context/context.h"
@@ -110,6 +111,41 @@ struct BaseNodeImpl {
                       new_duplicate_index);
     }
 
+    // Calculates the minimum and maximum of the numeric keys and records
+    void calc_zone(Context *context, BtreeZone *zone) {
+      *zone = BtreeZone();
+      size_t length = node->length();
+      if (length == 0)
+        return;
+      zone->is_empty = false;
+
+      const DbConfig &config = page->db()->config;
+      ByteArray *key_arena = context->scan_key_arena
+                                ? context->scan_key_arena
+                                : &context->db->key_arena(context->txn);
+      ByteArray *rec_arena = context->scan_record_arena
+                                ? context->scan_record_arena
+                                : &context->db->record_arena(context->txn);
+
+      // the keys are sorted
+      if (KeyList::kSupportsBlockScans && is_numeric_type(config.key_type)) {
+        ScanResult sr = keys.scan(key_arena, length, 0);
+        const uint8_t *p = (const uint8_t *)sr.first;
+        zone->has_key_bounds = true;
+        zone->min_key = to_numeric_value(config.key_type, p);
+        zone->max_key = to_numeric_value(config.key_type,
+                        p + (length - 1) * config.key_size);
+      }
+
+      if (RecordList::kSupportsBlockScans
+            && is_numeric_type(config.record_type)) {
+        ScanResult sr = records.scan(rec_arena, length, 0);
+        zone->has_record_bounds = true;
+        BtreeZone::calc_bounds(config.record_type, sr.first, length,
+                        &zone->min_record, &zone->max_record);
+      }
+    }
+
     // Iterates all keys, calls the |visitor| on each
     void scan(Context *context, ScanVisitor *visitor,
                     SelectStatement *statement, uint32_t start, bool distinct) {
@@ -122,8 +158,12 @@ struct BaseNodeImpl {
       if (!requires_records)
         distinct = true;
 
-      ByteArray *key_arena = &context->db->key_arena(context->txn);
-      ByteArray *rec_arena = &context->db->record_arena(context->txn);
+      ByteArray *key_arena = context->scan_key_arena
+                                ? context->scan_key_arena
+                                : &context->db->key_arena(context->txn);
+      ByteArray *rec_arena = context->scan_record_arena
+                                ? context->scan_record_arena
+                                : &context->db->record_arena(context->txn);
 
       // this branch handles non-duplicate block scans without an iterator
       if (distinct) {
@@ -31,6 +31,7 @@
 #include "3btree/btree_cursor.h"
 #include "3btree/btree_stats.h"
 #include "3btree/btree_node.h"
+#include "3btree/btree_zone_map.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -160,6 +161,9 @@ struct BtreeIndexState {
 
   // the btree statistics
   BtreeStatistics statistics;
+
+  // the zones of the leaf pages
+  BtreeZoneMap zone_map;
 };
 
 //
@@ -300,6 +304,11 @@ struct BtreeIndex {
     return &state.statistics;
   }
 
+  // Returns the zone map of the leaf pages
+  BtreeZoneMap *zone_map() {
+    return &state.zone_map;
+  }
+
   // Returns the class name (for testing)
   std::string test_get_classname() const {
     return state.leaf_traits->test_get_classname();
@@ -34,6 +34,7 @@
 #include "3btree/btree_zint32_simdfor.h"
 #include "3btree/btree_zint32_streamvbyte.h"
 #include "3btree/btree_zint32_varbyte.h"
+#include "3btree/btree_zint64.h"
 #include "3btree/btree_records_default.h"
 #include "3btree/btree_records_inline.h"
 #include "3btree/btree_records_internal.h"
@@ -220,7 +221,15 @@ struct BtreeIndexFactory {
       case UPS_TYPE_UINT64:
         if (!is_leaf)
           PAX_INTERNAL_NUMERIC(uint64_t);
-        PAX_LEAF_NUMERIC(uint64_t);
+        switch (key_compression) {
+          case UPS_COMPRESSOR_UINT64_VARBYTE:
+            PAX_LEAF_NODE(Zint32::Varbyte64KeyList, NumericCompare<uint64_t>);
+          case UPS_COMPRESSOR_UINT64_FOR:
+            PAX_LEAF_NODE(Zint32::For64KeyList, NumericCompare<uint64_t>);
+          default:
+            // no key compression
+            PAX_LEAF_NUMERIC(uint64_t);
+        }
       // 32bit float
       case UPS_TYPE_REAL32:
         if (!is_leaf)
@@ -94,7 +94,8 @@ struct VariableLengthKeyList : BaseKeyList {
     size_t page_size = env->config.page_size_bytes;
     int algo = db->config.key_compressor;
     if (algo)
-      _compressor.reset(CompressorFactory::create(algo));
+      _compressor.reset(CompressorFactory::create(algo,
+                                db->config.compression_level));
     if (unlikely(Globals::ms_extended_threshold))
       _extkey_threshold = Globals::ms_extended_threshold;
     else {
@@ -488,11 +489,13 @@ struct VariableLengthKeyList : BaseKeyList {
 
     // if keys are compressed then disable the compression for the
     // extended blob, because compressing already compressed data usually
-    // has not much of an effect
+    // has not much of an effect. Keys are unique, therefore they are
+    // never deduplicated.
     uint64_t blob_id = _blob_manager->allocate(context, &rec,
-                                      _compressor
-                                          ? BlobManager::kDisableCompression
-                                          : 0);
+                                      BlobManager::kDisableDeduplication
+                                        | (_compressor
+                                            ? BlobManager::kDisableCompression
+                                            : 0));
     assert(blob_id != 0);
     assert(_extkey_cache->find(blob_id) == _extkey_cache->end());
 
@@ -132,6 +132,10 @@ struct BtreeNodeProxy {
                   SelectStatement *statement, uint32_t start,
                   bool distinct) = 0;
 
+  // Calculates the zone (the minimum and maximum key and record) of
+  // a leaf
+  virtual void calc_zone(Context *context, BtreeZone *zone) = 0;
+
   // Compares the two keys. Returns 0 if both are equal, otherwise -1 (if
   // |lhs| is greater) or +1 (if |rhs| is greater).
   virtual int compare(const ups_key_t *lhs, const ups_key_t *rhs) const = 0;
@@ -352,6 +356,11 @@ struct BtreeNodeProxyImpl : BtreeNodeProxy {
     impl.scan(context, visitor, statement, start, distinct);
   }
 
+  // Calculates the zone of a leaf
+  virtual void calc_zone(Context *context, BtreeZone *zone) {
+    impl.calc_zone(context, zone);
+  }
+
   // Compares two internal keys using the supplied comparator
   virtual int compare(const ups_key_t *lhs, const ups_key_t *rhs) const {
     Comparator cmp(page->db());
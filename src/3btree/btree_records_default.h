@@ -35,6 +35,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/array_view.h"
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "3blob_manager/blob_manager.h"
 #include "3btree/btree_records_base.h"
 
@@ -119,24 +120,10 @@ struct DefaultRecordList : BaseRecordList {
   void record(Context *context, int slot, ByteArray *arena,
                   ups_record_t *record, uint32_t flags,
                   int duplicate_index) const {
-    bool direct_access = ISSET(flags, UPS_DIRECT_ACCESS);
-
     // the record is stored inline
     if (is_record_inline(slot)) {
-      record->size = inline_record_size(slot);
-      if (record->size == 0) {
-        record->data = 0;
-        return;
-      }
-      if (direct_access)
-        record->data = (void *)&data[slot];
-      else {
-        if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-          arena->resize(record->size);
-          record->data = arena->data();
-        }
-        ::memcpy(record->data, &data[slot], record->size);
-      }
+      assign_record_window(record, arena, &data[slot],
+                      inline_record_size(slot), flags);
       return;
     }
 
@@ -51,6 +51,7 @@
 #include "1globals/globals.h"
 #include "1base/scoped_ptr.h"
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "2page/page.h"
 #include "3blob_manager/blob_manager.h"
 #include "3btree/btree_node.h"
@@ -155,13 +156,12 @@ struct DuplicateTable {
   void record(Context *context, ByteArray *arena, ups_record_t *record,
                   uint32_t flags, int duplicate_index) {
     assert(duplicate_index < record_count());
-    bool direct_access = ISSET(flags, UPS_DIRECT_ACCESS);
 
     uint8_t record_flags;
     uint8_t *p = record_data(duplicate_index, &record_flags);
 
     if (_inline_records) {
-      assign_record(p, _record_size, direct_access, arena, record);
+      assign_record_window(record, arena, p, _record_size, flags);
       return;
     }
 
@@ -174,12 +174,12 @@ struct DuplicateTable {
     }
 
     if (ISSET(record_flags, BtreeRecord::kBlobSizeTiny)) {
-      assign_record(p, p[sizeof(uint64_t) - 1], direct_access, arena, record);
+      assign_record_window(record, arena, p, p[sizeof(uint64_t) - 1], flags);
       return;
     }
 
     if (ISSET(record_flags, BtreeRecord::kBlobSizeSmall)) {
-      assign_record(p, sizeof(uint64_t), direct_access, arena, record);
+      assign_record_window(record, arena, p, sizeof(uint64_t), flags);
       return;
     }
 
@@ -382,21 +382,6 @@ struct DuplicateTable {
     return (int) *(uint32_t *)(_table.data() + 4);
   }
 
-  void assign_record(uint8_t *record_data, uint32_t record_size,
-                  bool direct_access, ByteArray *arena,
-                  ups_record_t *record) {
-    record->size = record_size;
-    if (direct_access)
-      record->data = record_data;
-    else {
-      if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-        arena->resize(record->size);
-        record->data = arena->data();
-      }
-      ::memcpy(record->data, record_data, record_size);
-    }
-  }
-
   // Doubles the capacity of the ByteArray which backs the table
   void grow_duplicate_table() {
     int capacity = record_capacity();
@@ -413,13 +398,15 @@ struct DuplicateTable {
     ups_record_t record = {0};
     record.data = _table.data();
     record.size = _table.size();
+    // the table is modified in place and therefore never shared
+    uint32_t flags = BlobManager::kDisableDeduplication;
     if (unlikely(!_table_id))
-      _table_id = _blob_manager->allocate(context, &record, 0);
+      _table_id = _blob_manager->allocate(context, &record, flags);
     else if (used_regions > 0)
       _table_id = _blob_manager->overwrite_regions(context, _table_id,
-                      &record, 0, regions, used_regions);
+                      &record, flags, regions, used_regions);
     else
-      _table_id = _blob_manager->overwrite(context, _table_id, &record, 0);
+      _table_id = _blob_manager->overwrite(context, _table_id, &record, flags);
 
     return _table_id;
   }
@@ -710,20 +697,10 @@ struct DuplicateInlineRecordList : DuplicateRecordList {
     }
 
     assert(duplicate_index < (int)inline_record_count(slot));
-    bool direct_access = ISSET(flags, UPS_DIRECT_ACCESS);
 
     // the record is always stored inline
     const uint8_t *ptr = record_data(slot, duplicate_index);
-    record->size = record_size_;
-    if (direct_access)
-      record->data = (void *)ptr;
-    else {
-      if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-        arena->resize(record->size);
-        record->data = arena->data();
-      }
-      ::memcpy(record->data, ptr, record_size_);
-    }
+    assign_record_window(record, arena, ptr, record_size_, flags);
   }
 
   // Adds or overwrites a record
@@ -1119,7 +1096,6 @@ struct DuplicateDefaultRecordList : DuplicateRecordList {
     }
 
     assert(duplicate_index < (int)inline_record_count(slot));
-    bool direct_access = ISSET(flags, UPS_DIRECT_ACCESS);
 
     uint8_t *p = &data_[offset + 1 + 9 * duplicate_index];
     uint8_t record_flags = *(p++);
@@ -1131,30 +1107,12 @@ struct DuplicateDefaultRecordList : DuplicateRecordList {
     }
 
     if (ISSET(record_flags, BtreeRecord::kBlobSizeTiny)) {
-      record->size = p[sizeof(uint64_t) - 1];
-      if (direct_access)
-        record->data = &p[0];
-      else {
-        if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-          arena->resize(record->size);
-          record->data = arena->data();
-        }
-        ::memcpy(record->data, &p[0], record->size);
-      }
+      assign_record_window(record, arena, p, p[sizeof(uint64_t) - 1], flags);
       return;
     }
 
     if (ISSET(record_flags, BtreeRecord::kBlobSizeSmall)) {
-      record->size = sizeof(uint64_t);
-      if (direct_access)
-        record->data = &p[0];
-      else {
-        if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-          arena->resize(record->size);
-          record->data = arena->data();
-        }
-        ::memcpy(record->data, &p[0], record->size);
-      }
+      assign_record_window(record, arena, p, sizeof(uint64_t), flags);
       return;
     }
 
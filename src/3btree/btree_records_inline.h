@@ -34,6 +34,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/array_view.h"
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "3btree/btree_records_base.h"
 
 #ifndef UPS_ROOT_H
@@ -93,22 +94,9 @@ struct InlineRecordList : BaseRecordList {
   // allocated by the caller
   void record(Context *, int slot, ByteArray *arena, ups_record_t *record,
                   uint32_t flags, int) const {
-    bool direct_access = ISSET(flags, UPS_DIRECT_ACCESS);
-
     // the record is stored inline
-    record->size = _record_size;
-
-    if (_record_size == 0)
-      record->data = 0;
-    else if (direct_access)
-      record->data = (void *)&range_data[slot * _record_size];
-    else {
-      if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-        arena->resize(record->size);
-        record->data = arena->data();
-      }
-      ::memcpy(record->data, &range_data[slot * _record_size], record->size);
-    }
+    assign_record_window(record, arena, &range_data[slot * _record_size],
+                    _record_size, flags);
   }
 
   // Updates the record of a key
@@ -34,6 +34,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/array_view.h"
 #include "1base/dynamic_array.h"
+#include "1base/record_window.h"
 #include "3btree/btree_records_base.h"
 
 #ifndef UPS_ROOT_H
@@ -93,19 +94,7 @@ struct PodRecordList : BaseRecordList {
   // allocated by the caller
   void record(Context *, int slot, ByteArray *arena, ups_record_t *record,
                   uint32_t flags, int) const {
-    record->size = sizeof(T);
-
-    if (unlikely(ISSET(flags, UPS_DIRECT_ACCESS))) {
-      record->data = (void *)&range_data[slot];
-      return;
-    }
-
-    if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-      arena->resize(record->size);
-      record->data = arena->data();
-    }
-
-    ::memcpy(record->data, &range_data[slot], record->size);
+    assign_record_window(record, arena, &range_data[slot], sizeof(T), flags);
   }
 
   // Updates the record of a key
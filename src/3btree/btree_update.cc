@@ -110,8 +110,11 @@ merge_page(BtreeUpdateAction &state, Page *page, Page *sibling)
   BtreeNodeProxy *node = state.btree->get_node_from_page(page);
   BtreeNodeProxy *sib_node = state.btree->get_node_from_page(sibling);
 
-  if (sib_node->is_leaf())
+  if (sib_node->is_leaf()) {
     BtreeCursor::uncouple_all_cursors(state.context, sibling, 0);
+    state.btree->zone_map()->invalidate(page->address());
+    state.btree->zone_map()->invalidate(sibling->address());
+  }
 
   node->merge_from(state.context, sib_node);
   page->set_dirty(true);
@@ -287,8 +290,11 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
     old_node->key(context, pivot, &pivot_key_arena, &pivot_key);
 
     /* leaf page: uncouple all cursors */
-    if (old_node->is_leaf())
+    if (old_node->is_leaf()) {
       BtreeCursor::uncouple_all_cursors(context, old_page, pivot);
+      btree->zone_map()->invalidate(old_page->address());
+      btree->zone_map()->invalidate(new_page->address());
+    }
     /* internal page: fix the ptr_down of the new page
      * (it must point to the ptr of the pivot key) */
     else
@@ -346,6 +352,8 @@ BtreeUpdateAction::insert_in_page(Page *page, ups_key_t *key,
   bool exists = false;
 
   BtreeNodeProxy *node = btree->get_node_from_page(page);
+  if (node->is_leaf())
+    btree->zone_map()->invalidate(page->address());
 
   int flags = 0;
   if (force_prepend)
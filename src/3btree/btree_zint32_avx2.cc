@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#ifdef HAVE_SSE2
+
+#include "0root/root.h"
+
+#include <string.h>
+#include <algorithm>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+#include "3rdparty/simdcomp/include/simdcomp.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "3btree/btree_zint32_avx2.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace SimdFor {
+
+extern const uint32_t *
+simd_uncompress_length(const uint32_t *in, uint32_t *out, uint32_t nvalue);
+
+extern uint32_t
+bits(const uint32_t v);
+
+}
+
+// The kernels are compiled for AVX2 even if the remaining library is not;
+// they are only called if os_has_avx2() returns true
+#if defined(__GNUC__) && !defined(__AVX2__)
+#  define UPS_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#  define UPS_AVX2_TARGET
+#endif
+
+namespace upscaledb {
+
+namespace Zint32 {
+
+static inline int
+count_trailing_zeroes(uint32_t v)
+{
+#ifdef _MSC_VER
+  unsigned long r;
+  _BitScanForward(&r, v);
+  return (int)r;
+#else
+  return __builtin_ctz(v);
+#endif
+}
+
+// Unpacks the two rows |row| and |row + 1| (8 integers) of a bit-packed
+// block. Row |r| starts at bit offset |r * bit| of the four interleaved
+// 32bit lanes. |bit| must be in [1, 31].
+UPS_AVX2_TARGET static inline __m256i
+unpack_two_rows(const uint32_t *in, uint32_t row, uint32_t bit, __m256i mask)
+{
+  uint32_t o0 = row * bit;
+  uint32_t o1 = o0 + bit;
+  uint32_t w0 = o0 >> 5, s0 = o0 & 31;
+  uint32_t w1 = o1 >> 5, s1 = o1 & 31;
+
+  __m256i cur = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)(in + 4 * w0))),
+                    _mm_loadu_si128((const __m128i *)(in + 4 * w1)), 1);
+  // the following words are only loaded if the integers overlap
+  __m128i n0 = s0 + bit > 32
+                ? _mm_loadu_si128((const __m128i *)(in + 4 * (w0 + 1)))
+                : _mm_setzero_si128();
+  __m128i n1 = s1 + bit > 32
+                ? _mm_loadu_si128((const __m128i *)(in + 4 * (w1 + 1)))
+                : _mm_setzero_si128();
+  __m256i next = _mm256_inserti128_si256(_mm256_castsi128_si256(n0), n1, 1);
+
+  __m256i right = _mm256_setr_epi32(s0, s0, s0, s0, s1, s1, s1, s1);
+  __m256i left = _mm256_setr_epi32(32 - s0, 32 - s0, 32 - s0, 32 - s0,
+                  32 - s1, 32 - s1, 32 - s1, 32 - s1);
+  // a shift count of 32 yields 0
+  __m256i v = _mm256_or_si256(_mm256_srlv_epi32(cur, right),
+                  _mm256_sllv_epi32(next, left));
+  return _mm256_and_si256(v, mask);
+}
+
+// Unpacks the single row |row| (4 integers); |bit| must be in [1, 31]
+UPS_AVX2_TARGET static inline __m128i
+unpack_row(const uint32_t *in, uint32_t row, uint32_t bit, __m128i mask)
+{
+  uint32_t o = row * bit;
+  uint32_t w = o >> 5, s = o & 31;
+
+  __m128i v = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(in + 4 * w)),
+                  (int)s);
+  if (s + bit > 32)
+    v = _mm_or_si128(v, _mm_slli_epi32(
+                _mm_loadu_si128((const __m128i *)(in + 4 * (w + 1))),
+                (int)(32 - s)));
+  return _mm_and_si128(v, mask);
+}
+
+// Calculates the prefix sum of 8 deltas; |*base| is broadcast in all
+// elements and is updated with the last value
+UPS_AVX2_TARGET static inline __m256i
+prefix_sum(__m256i v, __m256i *base)
+{
+  v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+  v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+  // carry the sum of the lower half into the upper half
+  __m256i carry = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(3));
+  v = _mm256_add_epi32(v, _mm256_blend_epi32(_mm256_setzero_si256(),
+                          carry, 0xf0));
+  v = _mm256_add_epi32(v, *base);
+  *base = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(7));
+  return v;
+}
+
+UPS_AVX2_TARGET void
+avx2_unpackd1(uint32_t initvalue, const uint32_t *in, uint32_t *out,
+                uint32_t bit)
+{
+  if (bit == 0 || bit == 32) {
+    simdunpackd1(initvalue, (const __m128i *)in, out, bit);
+    return;
+  }
+
+  __m256i mask = _mm256_set1_epi32((int)((1u << bit) - 1));
+  __m256i base = _mm256_set1_epi32((int)initvalue);
+  for (uint32_t row = 0; row < 32; row += 2) {
+    __m256i v = prefix_sum(unpack_two_rows(in, row, bit, mask), &base);
+    _mm256_storeu_si256((__m256i *)(out + 4 * row), v);
+  }
+}
+
+UPS_AVX2_TARGET int
+avx2_searchd1(uint32_t initvalue, const uint32_t *in, uint32_t bit,
+                int length, uint32_t key, uint32_t *presult)
+{
+  if (bit == 0 || bit == 32)
+    return simdsearchwithlengthd1(initvalue, (const __m128i *)in, bit,
+                    length, key, presult);
+
+  __m256i mask = _mm256_set1_epi32((int)((1u << bit) - 1));
+  __m256i base = _mm256_set1_epi32((int)initvalue);
+  __m256i key8 = _mm256_set1_epi32((int)key);
+  for (int i = 0; i < length; i += 8) {
+    __m256i v = prefix_sum(unpack_two_rows(in, i / 4, bit, mask), &base);
+    // unsigned comparison: v >= key if max(v, key) == v
+    __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(v, key8), v);
+    uint32_t hits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(ge));
+    if (length - i < 8)
+      hits &= (1u << (length - i)) - 1;
+    if (hits) {
+      uint32_t values[8];
+      _mm256_storeu_si256((__m256i *)values, v);
+      int offset = count_trailing_zeroes(hits);
+      *presult = values[offset];
+      return i + offset;
+    }
+  }
+
+  *presult = key + 1;
+  return length;
+}
+
+UPS_AVX2_TARGET void
+avx2_for_uncompress(const uint32_t *in, uint32_t *out, uint32_t nvalue)
+{
+  if (nvalue == 0)
+    return;
+
+  uint32_t m = in[0];
+  uint32_t bit = SimdFor::bits(in[1] - m);
+  if (bit == 0 || bit == 32) {
+    SimdFor::simd_uncompress_length(in, out, nvalue);
+    return;
+  }
+
+  const uint32_t *data = in + 2;
+  __m256i mask = _mm256_set1_epi32((int)((1u << bit) - 1));
+  __m256i offset = _mm256_set1_epi32((int)m);
+
+  // full blocks of 128 integers
+  for (uint32_t k = 0; k < nvalue / 128; k++) {
+    for (uint32_t row = 0; row < 32; row += 2) {
+      __m256i v = _mm256_add_epi32(unpack_two_rows(data, row, bit, mask),
+                      offset);
+      _mm256_storeu_si256((__m256i *)(out + 4 * row), v);
+    }
+    data += 4 * bit;
+    out += 128;
+  }
+
+  // the remaining integers; words are only read if they were written
+  uint32_t remaining = nvalue % 128;
+  uint32_t full_rows = remaining / 4;
+  uint32_t row = 0;
+  for (; row + 1 < full_rows; row += 2) {
+    __m256i v = _mm256_add_epi32(unpack_two_rows(data, row, bit, mask),
+                    offset);
+    _mm256_storeu_si256((__m256i *)(out + 4 * row), v);
+  }
+
+  __m128i mask4 = _mm256_castsi256_si128(mask);
+  __m128i offset4 = _mm256_castsi256_si128(offset);
+  if (row < full_rows) {
+    __m128i v = _mm_add_epi32(unpack_row(data, row, bit, mask4), offset4);
+    _mm_storeu_si128((__m128i *)(out + 4 * row), v);
+    row++;
+  }
+  if (remaining % 4 != 0) {
+    uint32_t buffer[4];
+    __m128i v = _mm_add_epi32(unpack_row(data, row, bit, mask4), offset4);
+    _mm_storeu_si128((__m128i *)buffer, v);
+    ::memcpy(out + 4 * row, buffer, (remaining % 4) * sizeof(uint32_t));
+  }
+}
+
+UPS_AVX2_TARGET int
+avx2_for_search(const uint32_t *in, uint32_t length, uint32_t key,
+                uint32_t *presult)
+{
+  uint32_t m = in[0];
+  uint32_t M = in[1];
+  if (key <= m) {
+    *presult = m;
+    return 0;
+  }
+  if (key > M) {
+    *presult = key + 1;
+    return (int)length;
+  }
+
+  const uint32_t *data = in + 2;
+  uint32_t bit = SimdFor::bits(M - m);
+  // not packed
+  if (bit == 32) {
+    const uint32_t *it = std::lower_bound(data, data + length, key);
+    *presult = *it;
+    return (int)(it - data);
+  }
+
+  // |key| > m, therefore |bit| > 0; compare the packed values with the
+  // packed key
+  __m256i mask = _mm256_set1_epi32((int)((1u << bit) - 1));
+  __m256i key8 = _mm256_set1_epi32((int)(key - m));
+  __m128i mask4 = _mm256_castsi256_si128(mask);
+
+  for (uint32_t start = 0; start < length; start += 128, data += 4 * bit) {
+    uint32_t n = std::min(length - start, 128u);
+    uint32_t rows = (n + 3) / 4;
+    for (uint32_t row = 0; row < rows; row += 2) {
+      // the second row only exists if it was written
+      __m256i v = row + 1 < rows
+                    ? unpack_two_rows(data, row, bit, mask)
+                    : _mm256_inserti128_si256(_mm256_setzero_si256(),
+                            unpack_row(data, row, bit, mask4), 0);
+      __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(v, key8), v);
+      uint32_t hits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(ge));
+      uint32_t valid = n - 4 * row;
+      if (valid < 8)
+        hits &= (1u << valid) - 1;
+      if (hits) {
+        uint32_t values[8];
+        _mm256_storeu_si256((__m256i *)values, v);
+        int offset = count_trailing_zeroes(hits);
+        *presult = m + values[offset];
+        return (int)(start + 4 * row + offset);
+      }
+    }
+  }
+
+  // not reached because |key| <= M
+  *presult = key + 1;
+  return (int)length;
+}
+
+} // namespace Zint32
+
+} // namespace upscaledb
+
+#endif // HAVE_SSE2
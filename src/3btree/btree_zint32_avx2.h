@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * AVX2 kernels for the SIMD-based integer codecs
+ *
+ * These functions decode the 128bit-interleaved bit-packed format of
+ * libsimdcomp (used by UPS_COMPRESSOR_UINT32_SIMDCOMP and
+ * UPS_COMPRESSOR_UINT32_SIMDFOR) with 256bit registers; two rows of four
+ * integers are unpacked in one step. The persistent format is not
+ * modified, therefore the kernels are selected at runtime if the CPU
+ * supports AVX2 (see |os_has_avx2()|).
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_BTREE_ZINT32_AVX2_H
+#define UPS_BTREE_ZINT32_AVX2_H
+
+#include "0root/root.h"
+
+#include "ups/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/os.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+namespace Zint32 {
+
+// Decodes a block of 128 delta-encoded integers with |bit| bits per
+// integer; the equivalent of simdunpackd1()
+extern void
+avx2_unpackd1(uint32_t initvalue, const uint32_t *in, uint32_t *out,
+                uint32_t bit);
+
+// Performs a lower bound search for |key| in the first |length| integers
+// of a delta-encoded block; the equivalent of simdsearchwithlengthd1().
+// Returns the position of the first integer >= |key| and stores it in
+// |*presult|. If there is no such integer then |length| is returned and
+// |*presult| is set to |key + 1|.
+extern int
+avx2_searchd1(uint32_t initvalue, const uint32_t *in, uint32_t bit,
+                int length, uint32_t key, uint32_t *presult);
+
+// Decodes |nvalue| integers of a SIMDFOR stream (a header with the minimum
+// and maximum value, followed by the bit-packed integers); the equivalent
+// of SimdFor::simd_uncompress_length()
+extern void
+avx2_for_uncompress(const uint32_t *in, uint32_t *out, uint32_t nvalue);
+
+// Performs a lower bound search for |key| in the first |length| integers
+// of a SIMDFOR stream without decoding it; the packed lanes are compared
+// against |key - minimum|, and the search stops at the first match.
+// Returns the position of the first integer >= |key| and stores it in
+// |*presult|. If there is no such integer then |length| is returned and
+// |*presult| is set to |key + 1|.
+extern int
+avx2_for_search(const uint32_t *in, uint32_t length, uint32_t key,
+                uint32_t *presult);
+
+} // namespace Zint32
+
+} // namespace upscaledb
+
+#endif // UPS_BTREE_ZINT32_AVX2_H
@@ -58,22 +58,79 @@ sort_by_offset(const SortHelper &lhs, const SortHelper &rhs)
 }
 
 // The BlockCache is used to speed up multiple select() operations for
-// a single block. This is frequently used when iterating over a block
+// the same blocks. This is frequently used when iterating over a block
 // with a cursor.
+//
+// The cache stores up to |kMaxBlocks| decoded blocks; if it is full then
+// the oldest block is replaced. A block is only decoded if it was already
+// accessed by the previous select() call, i.e. single lookups do not pay
+// for decoding the whole block if the codec supports random access.
+//
+// Setting |is_active| to false invalidates all blocks.
+template<typename T, int kMaxKeys>
 struct BlockCache {
+  enum {
+    // The number of cached blocks
+    kMaxBlocks = 4,
+  };
+
   BlockCache()
-    : is_active(false) {
+    : is_active(false), count(0), next(0), last_miss(0) {
+  }
+
+  // Returns the decoded keys of the block starting with |index_value|, or
+  // null if the block is not cached
+  T *get(T index_value) {
+    if (!is_active)
+      return 0;
+    for (int i = 0; i < count; i++)
+      if (index_values[i] == index_value)
+        return data[i];
+    return 0;
+  }
+
+  // Returns the storage for the block starting with |index_value|; the
+  // caller decodes the keys
+  T *put(T index_value) {
+    if (!is_active) {
+      count = 0;
+      next = 0;
+      is_active = true;
+    }
+    int i = next;
+    next = (next + 1) % kMaxBlocks;
+    if (count < kMaxBlocks)
+      count++;
+    index_values[i] = index_value;
+    return data[i];
   }
 
+  // true if the cached blocks are valid
   bool is_active;
-  uint32_t index_value;
-  uint32_t data[256]; // TODO replace with kMaxKeysPerBlock
+
+  // the number of cached blocks
+  int count;
+
+  // the slot which is replaced next
+  int next;
+
+  // the block of the previous cache miss
+  T last_miss;
+
+  // the first key of each cached block
+  T index_values[kMaxBlocks];
+
+  // the decoded keys; some codecs decode groups of 4 keys
+  T data[kMaxBlocks][((kMaxKeys + 3) / 4) * 4];
 };
 
 // This structure is an "index" entry which describes the location
 // of a variable-length block
 #include "1base/packstart.h"
 UPS_PACK_0 struct UPS_PACK_1 IndexBase {
+  // the type of the keys
+  typedef uint32_t value_type;
+
   // initialize this block index
   void initialize(uint32_t offset, uint8_t *, size_t) {
     ::memset(this, 0, sizeof(*this));
@@ -122,9 +179,65 @@ UPS_PACK_0 struct UPS_PACK_1 IndexBase {
 } UPS_PACK_2;
 #include "1base/packstop.h"
 
+// Same as IndexBase, but for 64bit keys
+#include "1base/packstart.h"
+UPS_PACK_0 struct UPS_PACK_1 IndexBase64 {
+  // the type of the keys
+  typedef uint64_t value_type;
+
+  // initialize this block index
+  void initialize(uint32_t offset, uint8_t *, size_t) {
+    ::memset(this, 0, sizeof(*this));
+    _offset = offset;
+  }
+
+  // returns the offset of the payload
+  uint16_t offset() const {
+    return _offset;
+  }
+
+  // sets the offset of the payload
+  void set_offset(uint16_t offset) {
+    _offset = offset;
+  }
+
+  // returns the initial value
+  uint64_t value() const {
+    return _value;
+  }
+
+  // sets the initial value
+  void set_value(uint64_t value) {
+    _value = value;
+  }
+
+  // returns the highest value
+  uint64_t highest() const {
+    return _highest;
+  }
+
+  // sets the highest value
+  void set_highest(uint64_t highest) {
+    _highest = highest;
+  }
+
+  // offset of the payload, relative to the beginning of the payloads
+  // (starts after the Index structures)
+  uint16_t _offset;
+
+  // the start value of this block
+  uint64_t _value;
+
+  // the highest value of this block
+  uint64_t _highest;
+} UPS_PACK_2;
+#include "1base/packstop.h"
+
 // Base class for a BlockCodec
 template <typename Index>
 struct BlockCodecBase {
+  typedef typename Index::value_type T;
+
   enum {
     kHasCompressApi = 0,
     kHasFindLowerBoundApi = 0,
@@ -132,35 +245,36 @@ struct BlockCodecBase {
     kHasInsertApi = 0,
     kHasAppendApi = 0,
     kHasSelectApi = 0,
+    kHasRandomAccessSelectApi = 0,
     kCompressInPlace = 0,
   };
 
-  static uint32_t compress_block(Index *index, const uint32_t *in,
+  static uint32_t compress_block(Index *index, const T *in,
                   uint32_t *out) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
-  static uint32_t *uncompress_block(Index *index, const uint32_t *block_data,
-                  uint32_t *out) {
+  static T *uncompress_block(Index *index, const uint32_t *block_data,
+                  T *out) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
   static int find_lower_bound(Index *index, const uint32_t *block_data,
-                  uint32_t key, uint32_t *result) {
+                  T key, T *result) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
   static bool insert(Index *index, uint32_t *block_data,
-                  uint32_t key, int *pslot) {
+                  T key, int *pslot) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
   static bool append(Index *index, uint32_t *block_data,
-                  uint32_t key, int *pslot) {
+                  T key, int *pslot) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
@@ -172,7 +286,7 @@ struct BlockCodecBase {
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
-  static uint32_t select(Index *index, uint32_t *block_data, int slot) {
+  static T select(Index *index, uint32_t *block_data, int slot) {
     assert(!"shouldn't be here");
     throw Exception(UPS_INTERNAL_ERROR);
   }
@@ -182,9 +296,11 @@ template<typename BlockIndex, typename BlockCodec>
 struct Zint32Codec {
   typedef BlockIndex Index;
   typedef BlockCodec Codec;
+  typedef typename Index::value_type T;
+  typedef Zint32::BlockCache<T, Index::kMaxKeysPerBlock> Cache;
 
-  static uint32_t compress_block(Index *index, BlockCache *block_cache,
-                    const uint32_t *in, uint32_t *out) {
+  static uint32_t compress_block(Index *index, Cache *block_cache,
+                    const T *in, uint32_t *out) {
     block_cache->is_active = false;
 
     if (Codec::kHasCompressApi)
@@ -193,8 +309,8 @@ struct Zint32Codec {
     throw Exception(UPS_INTERNAL_ERROR);
   }
 
-  static uint32_t *uncompress_block(Index *index, const uint32_t *block_data,
-                  uint32_t *out) {
+  static T *uncompress_block(Index *index, const uint32_t *block_data,
+                  T *out) {
     if (likely(index->key_count() > 1))
       return Codec::uncompress_block(index, block_data, out);
     else
@@ -202,40 +318,40 @@ struct Zint32Codec {
   }
 
   static int find_lower_bound(Index *index, const uint32_t *block_data,
-                  uint32_t key, uint32_t *result) {
+                  T key, T *result) {
     if (Codec::kHasFindLowerBoundApi)
       return Codec::find_lower_bound(index, block_data, key, result);
 
-    uint32_t tmp[Index::kMaxKeysPerBlock];
-    uint32_t *begin = uncompress_block(index, block_data, &tmp[0]);
-    uint32_t *end = begin + index->key_count() - 1;
-    uint32_t *it = std::lower_bound(begin, end, key);
+    T tmp[Index::kMaxKeysPerBlock];
+    T *begin = uncompress_block(index, block_data, &tmp[0]);
+    T *end = begin + index->key_count() - 1;
+    T *it = std::lower_bound(begin, end, key);
     *result = *it;
     return it - begin;
   }
 
-  static bool insert(Index *index, BlockCache *block_cache,
-                    uint32_t *block_data, uint32_t key, int *pslot) {
+  static bool insert(Index *index, Cache *block_cache,
+                    uint32_t *block_data, T key, int *pslot) {
     block_cache->is_active = false;
 
     if (Codec::kHasInsertApi)
       return Codec::insert(index, block_data, key, pslot);
 
     // now decode the block
-    uint32_t datap[Index::kMaxKeysPerBlock];
-    uint32_t *data = uncompress_block(index, block_data, datap);
+    T datap[Index::kMaxKeysPerBlock];
+    T *data = uncompress_block(index, block_data, datap);
 
     // swap |key| and |index->value|
     if (key < index->value()) {
-      uint32_t tmp = index->value();
+      T tmp = index->value();
       index->set_value(key);
       key = tmp;
     }
 
     // locate the position of the new key
-    uint32_t *it = data;
-    uint32_t *begin = &data[0];
-    uint32_t *end = &data[index->key_count() - 1];
+    T *it = data;
+    T *begin = &data[0];
+    T *end = &data[index->key_count() - 1];
 
     if (likely(index->key_count() > 1)) {
       it = std::lower_bound(begin, end, key);
@@ -248,7 +364,7 @@ struct Zint32Codec {
 
       // insert the new key
       if (it < end)
-        ::memmove(it + 1, it, (end - it) * sizeof(uint32_t));
+        ::memmove(it + 1, it, (end - it) * sizeof(T));
     }
 
     *it = key;
@@ -261,19 +377,19 @@ struct Zint32Codec {
     return true;
   }
 
-  static bool append(Index *index, BlockCache *block_cache,
-                    uint32_t *block_data, uint32_t key, int *pslot) {
+  static bool append(Index *index, Cache *block_cache,
+                    uint32_t *block_data, T key, int *pslot) {
     block_cache->is_active = false;
 
     if (Codec::kHasAppendApi)
       return Codec::append(index, block_data, key, pslot);
 
     // decode the block
-    uint32_t datap[Index::kMaxKeysPerBlock];
-    uint32_t *data = uncompress_block(index, block_data, datap);
+    T datap[Index::kMaxKeysPerBlock];
+    T *data = uncompress_block(index, block_data, datap);
 
     // append the new key
-    uint32_t *it = &data[index->key_count() - 1];
+    T *it = &data[index->key_count() - 1];
     *it = key;
     *pslot = it - &data[0] + 1;
 
@@ -285,7 +401,7 @@ struct Zint32Codec {
   }
 
   template<typename GrowHandler>
-  static void del(Index *index, BlockCache *block_cache, uint32_t *block_data,
+  static void del(Index *index, Cache *block_cache, uint32_t *block_data,
                     int slot, GrowHandler *grow_handler) {
     block_cache->is_active = false;
 
@@ -293,8 +409,8 @@ struct Zint32Codec {
       return Codec::del(index, block_data, slot, grow_handler);
 
     // uncompress the block and remove the key
-    uint32_t datap[Index::kMaxKeysPerBlock];
-    uint32_t *data = uncompress_block(index, block_data, datap);
+    T datap[Index::kMaxKeysPerBlock];
+    T *data = uncompress_block(index, block_data, datap);
 
     // delete the first value?
     if (slot == 0) {
@@ -304,7 +420,7 @@ struct Zint32Codec {
 
     if (slot < (int)index->key_count() - 1) {
       ::memmove(&data[slot - 1], &data[slot],
-              sizeof(uint32_t) * (index->key_count() - slot - 1));
+              sizeof(T) * (index->key_count() - slot - 1));
     }
 
     // adjust key count
@@ -323,19 +439,26 @@ struct Zint32Codec {
     }
   }
 
-  static uint32_t select(Index *index, BlockCache *block_cache,
+  static T select(Index *index, Cache *block_cache,
                     uint32_t *block_data, int position_in_block) {
     if (unlikely(position_in_block == 0))
       return index->value();
 
     // can we satisfy the request through the block cache?
-    if (likely(block_cache->is_active
-                    && block_cache->index_value == index->value()))
-      return block_cache->data[position_in_block - 1];
+    T *data = block_cache->get(index->value());
+    if (likely(data != 0))
+      return data[position_in_block - 1];
+
+    // if the codec supports random access then only decode the requested
+    // key, unless the block was already accessed by the previous call
+    if (Codec::kHasRandomAccessSelectApi
+          && block_cache->last_miss != index->value()) {
+      block_cache->last_miss = index->value();
+      return Codec::select(index, block_data, position_in_block - 1);
+    }
 
-    block_cache->is_active = true;
-    block_cache->index_value = index->value();
-    uint32_t *data = uncompress_block(index, block_data, block_cache->data);
+    data = uncompress_block(index, block_data,
+                    block_cache->put(index->value()));
     return data[position_in_block - 1];
   }
 };
@@ -343,6 +466,7 @@ struct Zint32Codec {
 template<typename Zint32Codec>
 struct BlockKeyList : BaseKeyList {
   typedef typename Zint32Codec::Index Index;
+  typedef typename Index::value_type T;
 
   enum {
     // A flag whether this KeyList supports the scan() call
@@ -504,7 +628,7 @@ struct BlockKeyList : BaseKeyList {
   // but never called
   size_t key_size(int slot) const {
     assert(!"shouldn't be here");
-    return sizeof(uint32_t);
+    return sizeof(T);
   }
 
   // Returns a pointer to the key's data; only required to appease the
@@ -539,6 +663,10 @@ struct BlockKeyList : BaseKeyList {
   void erase(Context *, size_t node_count, int slot) {
     assert(check_integrity(0, node_count));
 
+    // the block can be removed, therefore invalidate the cached blocks
+    // and the cached index
+    block_cache.is_active = false;
+
     // get the block and the position of the key inside the block
     int position_in_block;
     Index *index;
@@ -585,7 +713,7 @@ struct BlockKeyList : BaseKeyList {
 
     *pcmp = 0;
 
-    uint32_t key = *(uint32_t *)hkey->data;
+    T key = *(T *)hkey->data;
     int slot = 0;
 
     // first perform a linear search through the index
@@ -602,12 +730,16 @@ struct BlockKeyList : BaseKeyList {
       return slot;
 
     // increment result by 1 because index 0 is index->value()
-    uint32_t result;
+    T result;
     int s = Zint32Codec::find_lower_bound(index,
                     (uint32_t *)block_data(index), key, &result);
-    if (result != key || s == (int)index->key_count())
-      *pcmp = +1;
-    return slot + s + 1;
+    if (result == key)
+      return slot + s + 1;
+
+    // no exact match: like the other KeyLists, return the slot of the
+    // largest key which is smaller than |key|
+    *pcmp = +1;
+    return slot + s;
   }
 
   // Inserts a key
@@ -616,9 +748,9 @@ struct BlockKeyList : BaseKeyList {
                   const ups_key_t *hkey, uint32_t flags, Cmp &comparator,
                   int /* unused */ slot) {
     assert(check_integrity(0, node_count));
-    assert(hkey->size == sizeof(uint32_t));
+    assert(hkey->size == sizeof(T));
 
-    uint32_t key = *(uint32_t *)hkey->data;
+    T key = *(T *)hkey->data;
 
     // if a split is required: vacuumize the node, then retry
     try {
@@ -701,7 +833,7 @@ struct BlockKeyList : BaseKeyList {
                               (uint32_t *)block_data(index),
                               position_in_block);
 
-    dest->size = sizeof(uint32_t);
+    dest->size = sizeof(T);
     if (deep_copy == false) {
       dest->data = (uint8_t *)&dummy;
       return;
@@ -713,7 +845,7 @@ struct BlockKeyList : BaseKeyList {
       dest->data = arena->data();
     }
 
-    *(uint32_t *)dest->data = dummy;
+    *(T *)dest->data = dummy;
   }
 
   // Prints a key to |out| (for debugging)
@@ -729,12 +861,12 @@ struct BlockKeyList : BaseKeyList {
 
   // Scans all keys; used for the UQI APIs.
   ScanResult scan(ByteArray *arena, size_t node_count, uint32_t start) {
-    arena->resize((block_count() * (Index::kMaxKeysPerBlock + 1)) * 4);
+    arena->resize((block_count() * (Index::kMaxKeysPerBlock + 1)) * sizeof(T));
 
     Index *it = block_index(0);
     Index *end = block_index(block_count());
 
-    uint32_t *out = (uint32_t *)arena->data();
+    T *out = (T *)arena->data();
 
     for (; it < end; it++) {
       if (start > it->key_count()) {
@@ -747,7 +879,7 @@ struct BlockKeyList : BaseKeyList {
       out += it->key_count();
     }
 
-    out = (uint32_t *)arena->data();
+    out = (T *)arena->data();
     return std::make_pair(out + start, node_count - start);
   }
 
@@ -780,12 +912,12 @@ struct BlockKeyList : BaseKeyList {
     // If start offset or destination offset > 0: uncompress both blocks,
     // merge them
     if (src_position_in_block > 0 || dst_position_in_block > 0) {
-      uint32_t sdata_buf[Index::kMaxKeysPerBlock];
-      uint32_t ddata_buf[Index::kMaxKeysPerBlock];
-      uint32_t *sdata = uncompress_block(srci, &sdata_buf[0]);
-      uint32_t *ddata = dest.uncompress_block(dsti, &ddata_buf[0]);
+      T sdata_buf[Index::kMaxKeysPerBlock];
+      T ddata_buf[Index::kMaxKeysPerBlock];
+      T *sdata = uncompress_block(srci, &sdata_buf[0]);
+      T *ddata = dest.uncompress_block(dsti, &ddata_buf[0]);
 
-      uint32_t *d = &ddata[srci->key_count()];
+      T *d = &ddata[srci->key_count()];
 
       if (src_position_in_block == 0) {
         assert(dst_position_in_block != 0);
@@ -865,7 +997,8 @@ struct BlockKeyList : BaseKeyList {
     set_used_size(kSizeofOverhead);
     add_block(0, Index::kInitialBlockSize);
     block_cache.is_active = false;
-    assert(sizeof(block_cache.data) >= 4 * (Index::kMaxKeysPerBlock - 1));
+    assert(sizeof(block_cache.data[0])
+                    >= sizeof(T) * (Index::kMaxKeysPerBlock - 1));
   }
 
   // Calculates the used size and updates the stored value
@@ -883,7 +1016,7 @@ struct BlockKeyList : BaseKeyList {
 
   // Implementation for insert()
   virtual PBtreeNode::InsertResult insert_impl(size_t node_count,
-                  uint32_t key, uint32_t flags) {
+                  T key, uint32_t flags) {
     int slot = 0;
 
     // perform a linear search through the index and get the block
@@ -905,8 +1038,8 @@ struct BlockKeyList : BaseKeyList {
       return (PBtreeNode::InsertResult(UPS_DUPLICATE_KEY,
                   slot + index->key_count() - 1));
 
-    uint32_t new_data[Index::kMaxKeysPerBlock];
-    uint32_t datap[Index::kMaxKeysPerBlock];
+    T new_data[Index::kMaxKeysPerBlock];
+    T datap[Index::kMaxKeysPerBlock];
 
     // A split is required if the block overflows
     bool requires_split = index->key_count() + 1 >= Index::kMaxKeysPerBlock;
@@ -952,11 +1085,11 @@ struct BlockKeyList : BaseKeyList {
       // to the new block.
       //
       // The pivot position is aligned to 4.
-      uint32_t *data = uncompress_block(index, datap);
+      T *data = uncompress_block(index, datap);
       uint32_t to_copy = (index->key_count() / 2) & ~0x03;
       assert(to_copy > 0);
       uint32_t new_key_count = index->key_count() - to_copy - 1;
-      uint32_t new_value = data[to_copy];
+      T new_value = data[to_copy];
 
       // once more check if the key already exists
       if (unlikely(new_value == key))
@@ -964,7 +1097,7 @@ struct BlockKeyList : BaseKeyList {
 
       to_copy++;
       ::memmove(&new_data[0], &data[to_copy],
-                  sizeof(int32_t) * (index->key_count() - to_copy));
+                  sizeof(T) * (index->key_count() - to_copy));
 
       // Now create a new block. This can throw, but so far we have not
       // modified existing data.
@@ -975,7 +1108,7 @@ struct BlockKeyList : BaseKeyList {
 
       // add_block() can invalid the data pointer, therefore fetch it again
       if (Zint32Codec::Codec::kCompressInPlace)
-        data = (uint32_t *)block_data(index);
+        data = (T *)block_data(index);
 
       // Adjust the size of the old block
       index->set_key_count(index->key_count() - new_key_count);
@@ -998,7 +1131,7 @@ struct BlockKeyList : BaseKeyList {
         // hack for BlockIndex: fetch data pointer once more because
         // it was invalidated when the new block was added
         if (Zint32Codec::Codec::kCompressInPlace)
-          data = (uint32_t *)block_data(index);
+          data = (T *)block_data(index);
       }
 
       // the block was modified and needs to be compressed again, even if
@@ -1031,8 +1164,8 @@ struct BlockKeyList : BaseKeyList {
   void print_block(Index *index) const {
     std::cout << "0: " << index->value() << std::endl;
 
-    uint32_t datap[Index::kMaxKeysPerBlock];
-    uint32_t *data = uncompress_block(index, datap);
+    T datap[Index::kMaxKeysPerBlock];
+    T *data = uncompress_block(index, datap);
 
     for (uint32_t i = 1; i < index->key_count(); i++)
       std::cout << i << ": " << data[i - 1] << std::endl;
@@ -1059,7 +1192,7 @@ struct BlockKeyList : BaseKeyList {
 
   // Performs a linear search through the index; returns the index
   // and the slot of the first key in this block in |*pslot|.
-  Index *find_index(uint32_t key, int *pslot) {
+  Index *find_index(T key, int *pslot) {
     Index *index = block_index(0);
     Index *iend = block_index(block_count());
 
@@ -1195,9 +1328,9 @@ struct BlockKeyList : BaseKeyList {
   }
 
   // Performs a lower bound search
-  int lower_bound_search(uint32_t *begin, uint32_t *end, uint32_t key,
+  int lower_bound_search(T *begin, T *end, T key,
                   int *pcmp) const {
-    uint32_t *it = std::lower_bound(begin, end, key);
+    T *it = std::lower_bound(begin, end, key);
     if (likely(it != end))
       *pcmp = (*it == key) ? 0 : +1;
     else // not found
@@ -1238,13 +1371,13 @@ struct BlockKeyList : BaseKeyList {
   }
 
   // Compresses a block of data
-  uint32_t compress_block(Index *index, uint32_t *in) {
+  uint32_t compress_block(Index *index, T *in) {
     return Zint32Codec::compress_block(index, &block_cache,
                             in, (uint32_t *)block_data(index));
   }
 
   // Uncompresses a block of data
-  uint32_t *uncompress_block(Index *index, uint32_t *out) const {
+  T *uncompress_block(Index *index, T *out) const {
     return Zint32Codec::uncompress_block(index,
                             (uint32_t *)block_data(index), out);
   }
@@ -1253,10 +1386,10 @@ struct BlockKeyList : BaseKeyList {
   uint8_t *data_;
 
   // helper variable to avoid returning pointers to local memory
-  uint32_t dummy;
+  T dummy;
 
   // Cache for speeding up the select() operation
-  BlockCache block_cache;
+  typename Zint32Codec::Cache block_cache;
 
   // Cached pointer to the last index used in get_key()
   Index *cached_index;
@@ -185,6 +185,7 @@ struct ForCodecImpl : BlockCodecBase<ForIndex> {
     kHasCompressApi = 1,
     kHasFindLowerBoundApi = 1,
     kHasSelectApi = 1,
+    kHasRandomAccessSelectApi = 1,
     kHasAppendApi = 1,
   };
 
@@ -217,12 +218,20 @@ struct ForCodecImpl : BlockCodecBase<ForIndex> {
   static int find_lower_bound(ForIndex *index, const uint32_t *block_data,
                   uint32_t key, uint32_t *result) {
     if (likely(index->key_count() > 1)) {
-      return (int)for_lower_bound_search((const uint8_t *)block_data,
-                           index->key_count() - 1, key, result);
+      uint32_t length = index->key_count() - 1;
+      int s = (int)for_lower_bound_search((const uint8_t *)block_data,
+                           length, key, result);
+      // for_lower_bound_search() returns the last key if all keys are
+      // smaller than |key|
+      if (unlikely(*result < key)) {
+        *result = key + 1;
+        return (int)length;
+      }
+      return s;
     }
     else {
       *result = key + 1;
-      return 1;
+      return 0;
     }
   }
 
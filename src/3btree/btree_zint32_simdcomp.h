@@ -35,6 +35,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "3btree/btree_zint32_block.h"
+#include "3btree/btree_zint32_avx2.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -144,12 +145,19 @@ struct SimdCompCodecImpl : BlockCodecBase<SimdCompIndex> {
 
   static uint32_t *uncompress_block(SimdCompIndex *index,
                   const uint32_t *block_data, uint32_t *out) {
-    simdunpackd1(index->value(), (__m128i *)block_data, out, index->bits());
+    if (os_has_avx2())
+      avx2_unpackd1(index->value(), block_data, out, index->bits());
+    else
+      simdunpackd1(index->value(), (__m128i *)block_data, out, index->bits());
     return out;
   }
 
   static int find_lower_bound(SimdCompIndex *index, const uint32_t *block_data,
                   uint32_t key, uint32_t *presult) {
+    if (os_has_avx2())
+      return avx2_searchd1(index->value(), block_data, index->bits(),
+                                    (int)index->key_count() - 1,
+                                    key, presult);
     return simdsearchwithlengthd1(index->value(), (const __m128i *)block_data,
                                     index->bits(), (int)index->key_count() - 1,
                                     key, presult);
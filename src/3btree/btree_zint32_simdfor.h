@@ -34,6 +34,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "3btree/btree_zint32_block.h"
 #include "3btree/btree_zint32_for.h"
+#include "3btree/btree_zint32_avx2.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -151,12 +152,16 @@ struct SimdForCodecImpl : BlockCodecBase<SimdForIndex> {
     kHasCompressApi = 1,
     kHasFindLowerBoundApi = 1,
     kHasSelectApi = 1,
+    kHasRandomAccessSelectApi = 1,
     kHasAppendApi = 1,
   };
 
   static uint32_t *uncompress_block(SimdForIndex *index,
                   const uint32_t *in, uint32_t *out) {
-    SimdFor::simd_uncompress_length(in, out, index->key_count() - 1);
+    if (os_has_avx2())
+      avx2_for_uncompress(in, out, index->key_count() - 1);
+    else
+      SimdFor::simd_uncompress_length(in, out, index->key_count() - 1);
     return out;
   }
 
@@ -171,11 +176,14 @@ struct SimdForCodecImpl : BlockCodecBase<SimdForIndex> {
 
   static int find_lower_bound(SimdForIndex *index, const uint32_t *in,
                   uint32_t key, uint32_t *result) {
-    if (likely(index->key_count() > 1))
+    if (likely(index->key_count() > 1)) {
+      if (os_has_avx2())
+        return avx2_for_search(in, index->key_count() - 1, key, result);
       return (int)SimdFor::simd_findLowerBound(in, index->key_count() - 1,
                         key, result);
+    }
     *result = key + 1;
-    return 1;
+    return 0;
   }
 
   // Returns a decompressed value
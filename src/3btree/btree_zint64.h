@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Compressed 64bit integer keys
+ *
+ * Uses the same block framework as the 32bit codecs (see
+ * btree_zint32_block.h), but with 64bit block indices.
+ *
+ * Varbyte64 stores the deltas as variable-length integers (libvbyte).
+ * For64 uses Frame Of Reference: each key is stored as the difference to
+ * the first key of the block, bit-packed with the minimum number of bits.
+ */
+
+#ifndef UPS_BTREE_KEYS_ZINT64_H
+#define UPS_BTREE_KEYS_ZINT64_H
+
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include "3rdparty/libvbyte/vbyte.h"
+
+#include "0root/root.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "3btree/btree_zint32_block.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+//
+// The template classes in this file are wrapped in a separate namespace
+// to avoid naming clashes with other KeyLists
+//
+namespace Zint32 {
+
+// The index of a 64bit block; the block sizes are limited to 11 bits
+#include "1base/packstart.h"
+UPS_PACK_0 struct UPS_PACK_1 Index64 : IndexBase64 {
+  enum {
+    // Initial size of a new block
+    kInitialBlockSize = 16,
+
+    // Maximum keys per block; a compressed 64bit key requires up to
+    // 10 bytes (varbyte) or 8 bytes (for), therefore a full block fits
+    // into 11 bits
+    kMaxKeysPerBlock = 128 + 1,
+  };
+
+  // initialize this block index
+  void initialize(uint32_t offset, uint8_t *block_data, size_t block_size) {
+    IndexBase64::initialize(offset, block_data, block_size);
+    _block_size = block_size;
+    _used_size = 0;
+    _key_count = 0;
+  }
+
+  // returns the used size of the block
+  uint32_t used_size() const {
+    return _used_size;
+  }
+
+  // sets the used size of the block
+  void set_used_size(uint32_t size) {
+    _used_size = size;
+  }
+
+  // returns the total block size
+  uint32_t block_size() const {
+    return _block_size;
+  }
+
+  // sets the total block size
+  void set_block_size(uint32_t size) {
+    _block_size = size;
+  }
+
+  // returns the key count
+  uint32_t key_count() const {
+    return _key_count;
+  }
+
+  // sets the key count
+  void set_key_count(uint32_t key_count) {
+    _key_count = key_count;
+  }
+
+  // copies this block to the |dest| block
+  void copy_to(const uint8_t *block_data, Index64 *dest,
+                  uint8_t *dest_data) {
+    dest->set_value(value());
+    dest->set_key_count(key_count());
+    dest->set_used_size(used_size());
+    dest->set_highest(highest());
+    ::memcpy(dest_data, block_data, block_size());
+  }
+
+  // the total size of this block
+  unsigned int _block_size : 11;
+
+  // used size of this block
+  unsigned int _used_size : 11;
+
+  // the number of keys in this block; max 511 (kMaxKeysPerBlock)
+  unsigned int _key_count : 9;
+} UPS_PACK_2;
+#include "1base/packstop.h"
+
+struct Varbyte64CodecImpl : BlockCodecBase<Index64> {
+  enum {
+    kHasCompressApi = 1,
+    kHasFindLowerBoundApi = 1,
+    kHasAppendApi = 1,
+  };
+
+  static uint64_t *uncompress_block(Index64 *index,
+                  const uint32_t *block_data, uint64_t *out) {
+    const uint8_t *in = (const uint8_t *)block_data;
+    vbyte_uncompress_sorted64(in, out, index->value(),
+                    index->key_count() - 1);
+    return out;
+  }
+
+  static uint32_t compress_block(Index64 *index, const uint64_t *in,
+                  uint32_t *out32) {
+    if (unlikely(index->key_count() <= 1))
+      return 0;
+    uint8_t *out = (uint8_t *)out32;
+    return vbyte_compress_sorted64(in, out, index->value(),
+                    index->key_count() - 1);
+  }
+
+  static int find_lower_bound(Index64 *index, const uint32_t *block_data,
+                  uint64_t key, uint64_t *result) {
+    const uint8_t *in = (const uint8_t *)block_data;
+    size_t length = index->key_count() - 1;
+    size_t s = vbyte_search_lower_bound_sorted64(in, length, key,
+                    index->value(), result);
+    if (s == length)
+      *result = key + 1;
+    return (int)s;
+  }
+
+  static bool append(Index64 *index, uint32_t *block_data32,
+                  uint64_t key, int *pslot) {
+    uint8_t *end = (uint8_t *)block_data32 + index->used_size();
+    size_t space = vbyte_append_sorted64(end, index->highest(), key);
+
+    index->set_key_count(index->key_count() + 1);
+    index->set_used_size(index->used_size() + space);
+    *pslot += index->key_count() - 1;
+    return true;
+  }
+
+  // Inserting a key between two others splits a delta in two smaller
+  // deltas; the growth is therefore bounded by the size of the new delta
+  static uint32_t estimate_required_size(Index64 *index,
+                        uint8_t *block_data, uint64_t key) {
+    uint64_t delta = key > index->value()
+                        ? key - index->value()
+                        : index->value() - key;
+    return index->used_size() + calculate_delta_size(delta);
+  }
+
+  // returns the compressed size of |value|
+  static int calculate_delta_size(uint64_t value) {
+    int size = 1;
+    while (value >= 128) {
+      value >>= 7;
+      size++;
+    }
+    return size;
+  }
+};
+
+typedef Zint32Codec<Index64, Varbyte64CodecImpl> Varbyte64Codec;
+
+struct Varbyte64KeyList : BlockKeyList<Varbyte64Codec> {
+  // Constructor
+  Varbyte64KeyList(LocalDb *db, PBtreeNode *node)
+    : BlockKeyList<Varbyte64Codec>(db, node) {
+  }
+};
+
+// The layout of a For64 block is a single byte with the number of bits,
+// followed by the bit-packed differences to |index->value()|, stored in
+// little-endian 64bit words.
+struct For64CodecImpl : BlockCodecBase<Index64> {
+  enum {
+    kHasCompressApi = 1,
+    kHasFindLowerBoundApi = 1,
+    kHasSelectApi = 1,
+    kHasRandomAccessSelectApi = 1,
+  };
+
+  static uint64_t *uncompress_block(Index64 *index,
+                  const uint32_t *block_data, uint64_t *out) {
+    const uint8_t *in = (const uint8_t *)block_data;
+    uint32_t length = index->key_count() - 1;
+    uint32_t b = in[0];
+    for (uint32_t i = 0; i < length; i++)
+      out[i] = index->value() + unpack(in + 1, b, i);
+    return out;
+  }
+
+  static uint32_t compress_block(Index64 *index, const uint64_t *in,
+                  uint32_t *out32) {
+    if (unlikely(index->key_count() <= 1))
+      return 0;
+
+    uint8_t *out = (uint8_t *)out32;
+    uint32_t length = index->key_count() - 1;
+    uint32_t b = bits(in[length - 1] - index->value());
+    uint32_t size = compressed_size(length, b);
+    ::memset(out, 0, size);
+    out[0] = (uint8_t)b;
+    for (uint32_t i = 0; i < length; i++)
+      pack(out + 1, b, i, in[i] - index->value());
+    return size;
+  }
+
+  static int find_lower_bound(Index64 *index, const uint32_t *block_data,
+                  uint64_t key, uint64_t *result) {
+    const uint8_t *in = (const uint8_t *)block_data;
+    uint32_t b = in[0];
+    uint64_t delta = key - index->value();
+
+    // binary search; the packed values are sorted
+    int low = 0;
+    int high = (int)index->key_count() - 1;
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (unpack(in + 1, b, mid) < delta)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+    if (low == (int)index->key_count() - 1)
+      *result = key + 1;
+    else
+      *result = index->value() + unpack(in + 1, b, low);
+    return low;
+  }
+
+  // Returns a decompressed value
+  static uint64_t select(Index64 *index, uint32_t *block_data,
+                        int position_in_block) {
+    const uint8_t *in = (const uint8_t *)block_data;
+    return index->value() + unpack(in + 1, in[0], position_in_block);
+  }
+
+  // Returns the exact size of the block after |key| was inserted
+  static uint32_t estimate_required_size(Index64 *index,
+                        uint8_t *block_data, uint64_t key) {
+    uint64_t low = std::min(key, index->value());
+    uint64_t high = std::max(key, index->highest());
+    return compressed_size(index->key_count(), bits(high - low));
+  }
+
+  // Returns the size of |length| packed values with |b| bits each
+  static uint32_t compressed_size(uint32_t length, uint32_t b) {
+    return 1 + (uint32_t)(((uint64_t)length * b + 63) / 64) * 8;
+  }
+
+  // Returns the number of bits which are required to store |v|
+  static uint32_t bits(uint64_t v) {
+    uint32_t b = 0;
+    while (v) {
+      v >>= 1;
+      b++;
+    }
+    return b;
+  }
+
+  // Stores |value| at position |i|
+  static void pack(uint8_t *words, uint32_t b, uint32_t i, uint64_t value) {
+    if (b == 0)
+      return;
+    uint64_t offset = (uint64_t)i * b;
+    uint8_t *p = words + (offset / 64) * 8;
+    uint32_t shift = offset % 64;
+
+    write_word(p, read_word(p) | (value << shift));
+    if (shift + b > 64)
+      write_word(p + 8, read_word(p + 8) | (value >> (64 - shift)));
+  }
+
+  // Returns the value at position |i|
+  static uint64_t unpack(const uint8_t *words, uint32_t b, uint32_t i) {
+    if (b == 0)
+      return 0;
+    uint64_t offset = (uint64_t)i * b;
+    const uint8_t *p = words + (offset / 64) * 8;
+    uint32_t shift = offset % 64;
+
+    uint64_t v = read_word(p) >> shift;
+    if (shift + b > 64)
+      v |= read_word(p + 8) << (64 - shift);
+    return b == 64 ? v : v & ((1ull << b) - 1);
+  }
+
+  // The words are not aligned
+  static uint64_t read_word(const uint8_t *p) {
+    uint64_t v;
+    ::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static void write_word(uint8_t *p, uint64_t v) {
+    ::memcpy(p, &v, sizeof(v));
+  }
+};
+
+typedef Zint32Codec<Index64, For64CodecImpl> For64Codec;
+
+struct For64KeyList : BlockKeyList<For64Codec> {
+  // Constructor
+  For64KeyList(LocalDb *db, PBtreeNode *node)
+    : BlockKeyList<For64Codec>(db, node) {
+  }
+};
+
+} // namespace Zint32
+
+} // namespace upscaledb
+
+#endif // UPS_BTREE_KEYS_ZINT64_H
@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Zone maps: per-leaf summaries of the numeric keys and records
+ *
+ * A zone stores the minimum and maximum key and record of a leaf page.
+ * Scans with a value range skip all leaves whose zone does not intersect
+ * with the range, without fetching them.
+ *
+ * The zones are not persisted. A zone is calculated when its leaf is
+ * scanned with a range, and discarded when keys or records are inserted
+ * or updated in the leaf, or when the leaf is split or merged. Erasing
+ * keys does not invalidate the zone because its bounds remain valid.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_BTREE_ZONE_MAP_H
+#define UPS_BTREE_ZONE_MAP_H
+
+#include "0root/root.h"
+
+#include <map>
+
+#include "ups/upscaledb.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// A numeric key or record; unsigned integers are stored in |u|, floating
+// point values in |r|
+union NumericValue {
+  uint64_t u;
+  double r;
+};
+
+// Returns true if |type| is a numeric type
+static inline bool
+is_numeric_type(int type)
+{
+  switch (type) {
+    case UPS_TYPE_UINT8:
+    case UPS_TYPE_UINT16:
+    case UPS_TYPE_UINT32:
+    case UPS_TYPE_UINT64:
+    case UPS_TYPE_REAL32:
+    case UPS_TYPE_REAL64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Converts the key or record |data| of |type| to a NumericValue
+static inline NumericValue
+to_numeric_value(int type, const void *data)
+{
+  NumericValue v;
+  switch (type) {
+    case UPS_TYPE_UINT8:
+      v.u = *(const uint8_t *)data;
+      break;
+    case UPS_TYPE_UINT16:
+      v.u = *(const uint16_t *)data;
+      break;
+    case UPS_TYPE_UINT32:
+      v.u = *(const uint32_t *)data;
+      break;
+    case UPS_TYPE_UINT64:
+      v.u = *(const uint64_t *)data;
+      break;
+    case UPS_TYPE_REAL32:
+      v.r = *(const float *)data;
+      break;
+    case UPS_TYPE_REAL64:
+      v.r = *(const double *)data;
+      break;
+    default:
+      assert(!"shouldn't be here");
+      v.u = 0;
+  }
+  return v;
+}
+
+// Converts the NumericValue |v| to a key or record of |type|, and stores
+// it in |data|. Returns the size of the converted value, or 0 if the value
+// cannot be represented in |type|
+static inline size_t
+from_numeric_value(int type, NumericValue v, void *data)
+{
+  switch (type) {
+    case UPS_TYPE_UINT8:
+      if (v.u > 0xffu)
+        return 0;
+      *(uint8_t *)data = (uint8_t)v.u;
+      return sizeof(uint8_t);
+    case UPS_TYPE_UINT16:
+      if (v.u > 0xffffu)
+        return 0;
+      *(uint16_t *)data = (uint16_t)v.u;
+      return sizeof(uint16_t);
+    case UPS_TYPE_UINT32:
+      if (v.u > 0xffffffffu)
+        return 0;
+      *(uint32_t *)data = (uint32_t)v.u;
+      return sizeof(uint32_t);
+    case UPS_TYPE_UINT64:
+      *(uint64_t *)data = v.u;
+      return sizeof(uint64_t);
+    case UPS_TYPE_REAL32:
+      *(float *)data = (float)v.r;
+      return sizeof(float);
+    case UPS_TYPE_REAL64:
+      *(double *)data = v.r;
+      return sizeof(double);
+    default:
+      assert(!"shouldn't be here");
+      return 0;
+  }
+}
+
+// Compares two NumericValues of |type|
+static inline int
+compare_numeric_values(int type, NumericValue lhs, NumericValue rhs)
+{
+  if (type == UPS_TYPE_REAL32 || type == UPS_TYPE_REAL64)
+    return lhs.r < rhs.r ? -1 : (lhs.r > rhs.r ? +1 : 0);
+  return lhs.u < rhs.u ? -1 : (lhs.u > rhs.u ? +1 : 0);
+}
+
+// A range of numeric values, i.e. [lower, upper]. Both bounds are
+// optional, and can be exclusive.
+struct ValueRange {
+  ValueRange()
+    : has_lower(false), has_upper(false), lower_inclusive(true),
+      upper_inclusive(true) {
+    lower.u = 0;
+    upper.u = 0;
+  }
+
+  // Returns true if at least one bound is set
+  bool is_set() const {
+    return has_lower || has_upper;
+  }
+
+  // Sets the lower bound
+  void set_lower(NumericValue value, bool inclusive) {
+    has_lower = true;
+    lower = value;
+    lower_inclusive = inclusive;
+  }
+
+  // Sets the upper bound
+  void set_upper(NumericValue value, bool inclusive) {
+    has_upper = true;
+    upper = value;
+    upper_inclusive = inclusive;
+  }
+
+  // Sets the lower bound, unless the current lower bound is more
+  // restrictive
+  void restrict_lower(int type, NumericValue value, bool inclusive) {
+    if (has_lower) {
+      int cmp = compare_numeric_values(type, value, lower);
+      if (cmp < 0 || (cmp == 0 && inclusive))
+        return;
+    }
+    set_lower(value, inclusive);
+  }
+
+  // Sets the upper bound, unless the current upper bound is more
+  // restrictive
+  void restrict_upper(int type, NumericValue value, bool inclusive) {
+    if (has_upper) {
+      int cmp = compare_numeric_values(type, value, upper);
+      if (cmp > 0 || (cmp == 0 && inclusive))
+        return;
+    }
+    set_upper(value, inclusive);
+  }
+
+  // Makes the range empty; only for unsigned integer types
+  void set_empty() {
+    NumericValue zero, one;
+    zero.u = 0;
+    one.u = 1;
+    set_lower(one, true);
+    set_upper(zero, true);
+  }
+
+  // Returns true if the value |v| of |type| is in the range; NaN is
+  // never in the range
+  bool contains(int type, NumericValue v) const {
+    if (v.r != v.r && (type == UPS_TYPE_REAL32 || type == UPS_TYPE_REAL64))
+      return false;
+    if (has_lower) {
+      int cmp = compare_numeric_values(type, v, lower);
+      if (cmp < 0 || (cmp == 0 && !lower_inclusive))
+        return false;
+    }
+    if (has_upper) {
+      int cmp = compare_numeric_values(type, v, upper);
+      if (cmp > 0 || (cmp == 0 && !upper_inclusive))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns true if the range intersects with [min, max]
+  bool intersects(int type, NumericValue min, NumericValue max) const {
+    if (has_lower) {
+      int cmp = compare_numeric_values(type, max, lower);
+      if (cmp < 0 || (cmp == 0 && !lower_inclusive))
+        return false;
+    }
+    if (has_upper) {
+      int cmp = compare_numeric_values(type, min, upper);
+      if (cmp > 0 || (cmp == 0 && !upper_inclusive))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns true if the range can never match
+  bool is_empty(int type) const {
+    if (!has_lower || !has_upper)
+      return false;
+    int cmp = compare_numeric_values(type, lower, upper);
+    return cmp > 0 || (cmp == 0 && !(lower_inclusive && upper_inclusive));
+  }
+
+  // The lower bound
+  bool has_lower;
+  NumericValue lower;
+
+  // The upper bound
+  bool has_upper;
+  NumericValue upper;
+
+  // Whether the bounds are included in the range
+  bool lower_inclusive;
+  bool upper_inclusive;
+};
+
+// The summary of a single leaf
+struct BtreeZone {
+  BtreeZone()
+    : is_empty(true), has_key_bounds(false), has_record_bounds(false) {
+    min_key.u = max_key.u = 0;
+    min_record.u = max_record.u = 0;
+  }
+
+  // Calculates the minimum and maximum of |length| values of |type|
+  static void calc_bounds(int type, const void *data, size_t length,
+                  NumericValue *pmin, NumericValue *pmax) {
+    switch (type) {
+      case UPS_TYPE_UINT8:
+        calc_bounds_impl((const uint8_t *)data, length, &pmin->u, &pmax->u);
+        break;
+      case UPS_TYPE_UINT16:
+        calc_bounds_impl((const uint16_t *)data, length, &pmin->u, &pmax->u);
+        break;
+      case UPS_TYPE_UINT32:
+        calc_bounds_impl((const uint32_t *)data, length, &pmin->u, &pmax->u);
+        break;
+      case UPS_TYPE_UINT64:
+        calc_bounds_impl((const uint64_t *)data, length, &pmin->u, &pmax->u);
+        break;
+      case UPS_TYPE_REAL32:
+        calc_bounds_impl((const float *)data, length, &pmin->r, &pmax->r);
+        break;
+      case UPS_TYPE_REAL64:
+        calc_bounds_impl((const double *)data, length, &pmin->r, &pmax->r);
+        break;
+      default:
+        assert(!"shouldn't be here");
+    }
+  }
+
+  // NaNs are skipped (unless all values are NaN)
+  template<typename T, typename R>
+  static void calc_bounds_impl(const T *data, size_t length, R *pmin,
+                  R *pmax) {
+    assert(length > 0);
+    T min = data[0];
+    T max = data[0];
+    for (size_t i = 1; i < length; i++) {
+      if (data[i] < min || min != min)
+        min = data[i];
+      if (data[i] > max || max != max)
+        max = data[i];
+    }
+    *pmin = min;
+    *pmax = max;
+  }
+
+  // True if the leaf has no keys
+  bool is_empty;
+
+  // The minimum and maximum key (only for numeric keys)
+  bool has_key_bounds;
+  NumericValue min_key;
+  NumericValue max_key;
+
+  // The minimum and maximum record (only for numeric records which are
+  // not stored in duplicate tables)
+  bool has_record_bounds;
+  NumericValue min_record;
+  NumericValue max_record;
+};
+
+// The zones of all leaves of a Btree, indexed by page address
+struct BtreeZoneMap {
+  // Retrieves the zone of the leaf at |address|; returns false if it
+  // is unknown
+  bool get(uint64_t address, BtreeZone *zone) {
+    ScopedLock lock(mutex);
+    std::map<uint64_t, BtreeZone>::iterator it = zones.find(address);
+    if (it == zones.end())
+      return false;
+    *zone = it->second;
+    return true;
+  }
+
+  // Stores the zone of the leaf at |address|
+  void put(uint64_t address, const BtreeZone &zone) {
+    ScopedLock lock(mutex);
+    zones[address] = zone;
+  }
+
+  // Discards the zone of the leaf at |address|. Called whenever a leaf
+  // is modified; modifications never run concurrently to scans, therefore
+  // the map can be checked without locking
+  void invalidate(uint64_t address) {
+    if (zones.empty())
+      return;
+    ScopedLock lock(mutex);
+    zones.erase(address);
+  }
+
+  // Discards all zones
+  void clear() {
+    ScopedLock lock(mutex);
+    zones.clear();
+  }
+
+  // Returns the number of stored zones
+  size_t size() {
+    ScopedLock lock(mutex);
+    return zones.size();
+  }
+
+  // Protects |zones|; leaves are scanned by several threads if the
+  // parallel scan is enabled
+  Mutex mutex;
+
+  // The zones
+  std::map<uint64_t, BtreeZone> zones;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_BTREE_ZONE_MAP_H
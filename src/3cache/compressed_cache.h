@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * The compressed secondary cache
+ *
+ * Clean pages which are evicted from the Cache are compressed and stored
+ * in this tier (within a separate byte budget). When a page is fetched
+ * again it is decompressed instead of being read from disk.
+ *
+ * The tier is exclusive: a page is removed when it is fetched, because it
+ * is then owned by the Cache and can be modified. The pages are stored in
+ * an LRU list; if the budget is exceeded then the least recently stored
+ * pages are dropped.
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef UPS_COMPRESSED_CACHE_H
+#define UPS_COMPRESSED_CACHE_H
+
+#include "0root/root.h"
+
+#include <list>
+#include <map>
+
+#include "ups/upscaledb_int.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/scoped_ptr.h"
+#include "1mem/mem.h"
+#include "2page/page.h"
+#include "2config/env_config.h"
+#include "2compressor/compressor_factory.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct CompressedCache
+{
+  // A compressed page image
+  struct Entry {
+    // the address of the page
+    uint64_t address;
+
+    // the size of the compressed image
+    uint32_t size;
+
+    // the on-disk size of the page (see Page::disk_size())
+    uint32_t disk_size;
+
+    // the compressed image, allocated with Memory::allocate
+    uint8_t *data;
+  };
+
+  typedef std::list<Entry> EntryList;
+  typedef std::map<uint64_t, EntryList::iterator> EntryIndex;
+
+  // Constructor; the tier is disabled if the budget is 0
+  CompressedCache(const EnvConfig &config)
+    : capacity_bytes(config.compressed_cache_size_bytes),
+      page_size_bytes(config.page_size_bytes), current_bytes(0),
+      hits(0), misses(0) {
+    // LZ4 is preferred because it decompresses fastest; LZF is always
+    // available
+    if (capacity_bytes > 0)
+      compressor.reset(CompressorFactory::create(
+                    CompressorFactory::is_available(UPS_COMPRESSOR_LZ4)
+                        ? UPS_COMPRESSOR_LZ4
+                        : UPS_COMPRESSOR_LZF));
+  }
+
+  // Destructor; releases all images
+  ~CompressedCache() {
+    clear();
+  }
+
+  // Returns true if the tier is enabled
+  bool is_enabled() const {
+    return capacity_bytes > 0;
+  }
+
+  // Fills in the current metrics
+  void fill_metrics(ups_env_metrics_t *metrics) const {
+    metrics->compressed_cache_hits = hits;
+    metrics->compressed_cache_misses = misses;
+    metrics->compressed_cache_bytes = current_bytes;
+  }
+
+  // Compresses and stores a clean |page| which is removed from the Cache.
+  // Pages which do not compress well are not stored.
+  void put(Page *page) {
+    if (!is_enabled() || !page->is_allocated())
+      return;
+    assert(!page->is_dirty());
+
+    del(page->address());
+
+    uint32_t size = compressor->compress(page->raw_payload(),
+                    page_size_bytes);
+    if (size > page_size_bytes - page_size_bytes / 8 || size > capacity_bytes)
+      return;
+
+    while (current_bytes + size > capacity_bytes)
+      erase(--entries.end());
+
+    Entry entry;
+    entry.address = page->address();
+    entry.size = size;
+    entry.disk_size = page->disk_size();
+    entry.data = Memory::allocate<uint8_t>(size);
+    ::memcpy(entry.data, compressor->arena.data(), size);
+
+    entries.push_front(entry);
+    index[entry.address] = entries.begin();
+    current_bytes += size;
+  }
+
+  // Decompresses the image of the page at |address| into |page| and
+  // removes it from the tier. Returns false if the page is not stored.
+  bool get(uint64_t address, Page *page) {
+    if (!is_enabled())
+      return false;
+
+    EntryIndex::iterator it = index.find(address);
+    if (it == index.end()) {
+      misses++;
+      return false;
+    }
+
+    Entry &entry = *it->second;
+    uint8_t *buffer = Memory::allocate<uint8_t>(page_size_bytes);
+    try {
+      compressor->decompress(entry.data, entry.size, page_size_bytes, buffer);
+    }
+    catch (Exception &) {
+      Memory::release(buffer);
+      erase(it->second);
+      misses++;
+      return false;
+    }
+
+    page->assign_allocated_buffer(buffer, address);
+    page->set_disk_size(entry.disk_size);
+    erase(it->second);
+    hits++;
+    return true;
+  }
+
+  // Removes the image of the page at |address|, if it is stored
+  void del(uint64_t address) {
+    EntryIndex::iterator it = index.find(address);
+    if (it != index.end())
+      erase(it->second);
+  }
+
+  // Removes the images of all pages at or after |address|; used when the
+  // file is truncated
+  void truncate(uint64_t address) {
+    while (true) {
+      EntryIndex::iterator it = index.lower_bound(address);
+      if (it == index.end())
+        return;
+      erase(it->second);
+    }
+  }
+
+  // Removes all images
+  void clear() {
+    while (!entries.empty())
+      erase(entries.begin());
+  }
+
+  // Removes an entry from the list and the index
+  void erase(EntryList::iterator it) {
+    index.erase(it->address);
+    current_bytes -= it->size;
+    Memory::release(it->data);
+    entries.erase(it);
+  }
+
+  // The maximum number of bytes for the compressed images
+  uint64_t capacity_bytes;
+
+  // The page size
+  uint32_t page_size_bytes;
+
+  // The number of bytes currently used by the compressed images
+  uint64_t current_bytes;
+
+  // The compressed images; the most recently stored image is at the front
+  EntryList entries;
+
+  // Maps the page address to the entry in |entries|
+  EntryIndex index;
+
+  // The compressor
+  ScopedPtr<Compressor> compressor;
+
+  // Number of pages which were decompressed instead of read from disk
+  uint64_t hits;
+
+  // Number of pages which were not found in the tier
+  uint64_t misses;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_COMPRESSED_CACHE_H */
@@ -65,8 +65,12 @@ struct FlushChangesetVisitor {
 
 static void
 flush_changeset_to_file(std::vector<Page *> list, Device *device,
-                Journal *journal, uint64_t lsn, bool enable_fsync)
+                Journal *journal, uint64_t journal_position, uint64_t lsn,
+                bool enable_fsync)
 {
+  // the changeset must be durable before the file is modified
+  journal->wait_until_durable(journal_position);
+
   std::vector<Page *>::iterator it = list.begin();
   for (; it != list.end(); it++) {
     Page *page = *it;
@@ -90,6 +94,9 @@ flush_changeset_to_file(std::vector<Page *> list, Device *device,
     device->flush();
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
+
+  // the journal segment of this changeset can now be recycled
+  journal->on_changeset_written(journal_position, lsn);
 }
 
 void
@@ -118,21 +125,24 @@ Changeset::flush(uint64_t lsn)
 
   // Append all changes to the journal. This operation basically
   // "write-ahead logs" all changes.
-  env->journal->append_changeset(visitor.list,
+  uint64_t journal_position = env->journal->append_changeset(visitor.list,
                   env->page_manager->last_blob_page_id(), lsn);
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
   // execute a post-log hook; this hook is set by the unittest framework
   // and can be used to make a backup copy of the logfile
-  if (unlikely(g_CHANGESET_POST_LOG_HOOK != 0))
+  if (unlikely(g_CHANGESET_POST_LOG_HOOK != 0)) {
+    env->journal->wait_until_durable(journal_position);
     g_CHANGESET_POST_LOG_HOOK();
+  }
 
   // The modified pages are now flushed (and unlocked) asynchronously
   // to the database file
   env->page_manager->run_async(boost::bind(&flush_changeset_to_file,
                           visitor.list, env->device.get(), env->journal.get(),
-                          lsn, ISSET(env->config.flags, UPS_ENABLE_FSYNC)));
+                          journal_position, lsn,
+                          ISSET(env->config.flags, UPS_ENABLE_FSYNC)));
 }
 
 } // namespace upscaledb
@@ -19,6 +19,9 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <sstream>
+#include <limits>
+#include <algorithm>
 #ifndef WIN32
 #  include <libgen.h>
 #endif
@@ -29,6 +32,7 @@
 #include "2device/device.h"
 #include "2compressor/compressor_factory.h"
 #include "3journal/journal.h"
+#include "3journal/journal_redo.h"
 #include "3page_manager/page_manager.h"
 #include "4db/db.h"
 #include "4txn/txn_local.h"
@@ -44,24 +48,29 @@
 namespace upscaledb {
 
 enum {
-  // switch log file after |kSwitchTxnThreshold| transactions
-  kSwitchTxnThreshold = 32,
+  // the default size of a segment file
+  kDefaultSegmentSize = 4 * 1024 * 1024, // 4 mb
+
+  // the default number of preallocated segment files
+  kDefaultSegments = 2,
+
+  // the default number of bytes between two checkpoints
+  kDefaultCheckpointInterval = 1024 * 1024, // 1 mb
 
   // flush buffers if this limit is exceeded
   kBufferLimit = 1024 * 1024, // 1 mb
+
+  // modified ranges of a page delta are merged if they are separated by
+  // less than |kDeltaMergeGap| unmodified words
+  kDeltaMergeGap = 2,
 };
 
+// Blocks till the writer thread wrote all flushed buffers
 static inline void
-clear_file(JournalState &state, int idx)
+drain_writer(JournalState &state)
 {
-  if (state.files[idx].is_open()) {
-    state.files[idx].truncate(0);
-
-    // after truncate, the file pointer is far beyond the new end of file;
-    // reset the file pointer, or the next write will resize the file to
-    // the original size
-    state.files[idx].seek(0, File::kSeekSet);
-  }
+  if (state.writer.get())
+    state.writer->drain();
 }
 
 static inline std::string
@@ -86,26 +95,359 @@ log_file_path(JournalState &state, int i)
     path += ::basename((char *)state.env->config.filename.c_str());
 #endif
   }
-  if (i == 0)
-    path += ".jrn0";
-  else if (i == 1)
-    path += ".jrn1";
-  else
-    assert(!"invalid index");
-  return (path);
+
+  std::stringstream ss;
+  ss << path << ".jrn" << i;
+  return ss.str();
 }
 
+// Writes the header of segment |idx|. If |terminate| is true then the
+// header is followed by an empty entry, which marks the end of the
+// segment's entries.
 static inline void
-flush_buffer(JournalState &state, int idx, bool fsync = false)
+write_segment_header(JournalState &state, int idx, bool terminate)
 {
-  if (likely(state.buffer.size() > 0)) {
-    state.files[idx].write(state.buffer.data(), state.buffer.size());
-    state.count_bytes_flushed += state.buffer.size();
+  JournalSegment *segment = state.segments[idx];
+  PJournalSegmentHeader header(segment->sequence,
+                  (uint32_t)state.segments.size());
+  PJournalEntry terminator;
+
+  uint8_t buffer[sizeof(header) + sizeof(terminator)];
+  ::memcpy(&buffer[0], &header, sizeof(header));
+  ::memcpy(&buffer[sizeof(header)], &terminator, sizeof(terminator));
+  segment->file.pwrite(0, buffer,
+                  terminate ? sizeof(buffer) : sizeof(header));
+}
 
-    state.buffer.clear();
-    if (unlikely(fsync))
-      state.files[idx].flush();
+// Marks segment |idx| as unused. The file keeps its size; the stale
+// entries are overwritten when the segment is recycled.
+static inline void
+clear_segment(JournalState &state, int idx)
+{
+  JournalSegment *segment = state.segments[idx];
+  segment->sequence = 0;
+  segment->offset = sizeof(PJournalSegmentHeader);
+  segment->end_position = 0;
+  segment->changeset_position = 0;
+  write_segment_header(state, idx, true);
+}
+
+// Starts writing to segment |idx|
+static inline void
+activate_segment(JournalState &state, int idx)
+{
+  JournalSegment *segment = state.segments[idx];
+  segment->sequence = state.next_sequence++;
+  segment->offset = sizeof(PJournalSegmentHeader);
+  segment->end_position = state.writer->submitted_position;
+  segment->changeset_position = 0;
+  write_segment_header(state, idx, true);
+
+  state.current_fd = idx;
+  state.num_transactions = 0;
+}
+
+// Creates a new segment file and preallocates its storage; returns the
+// index of the new segment
+static inline int
+create_segment(JournalState &state)
+{
+  int idx = (int)state.segments.size();
+  std::string path = log_file_path(state, idx);
+
+  JournalSegment *segment = new JournalSegment;
+  state.segments.push_back(segment);
+  segment->file.create(path.c_str(), 0644);
+  segment->file.truncate(state.segment_size);
+  clear_segment(state, idx);
+  return idx;
+}
+
+// Opens segment file |idx| and reads its header. Returns the number of
+// segments stored in the header, or 0 if the file was empty.
+static inline uint32_t
+open_segment(JournalState &state, int idx)
+{
+  std::string path = log_file_path(state, idx);
+
+  JournalSegment *segment = new JournalSegment;
+  state.segments.push_back(segment);
+  segment->file.open(path.c_str(), false);
+
+  // an empty file is initialized
+  uint64_t file_size = segment->file.file_size();
+  if (file_size == 0) {
+    segment->file.truncate(state.segment_size);
+    clear_segment(state, idx);
+    return 0;
   }
+
+  PJournalSegmentHeader header;
+  if (file_size >= sizeof(header))
+    segment->file.pread(0, &header, sizeof(header));
+  if (file_size < sizeof(header) || !header.verify_magic()) {
+    ups_log(("invalid journal segment header in %s", path.c_str()));
+    throw Exception(UPS_LOG_INV_FILE_HEADER);
+  }
+
+  segment->sequence = header.sequence;
+  segment->offset = sizeof(header);
+  if (header.sequence >= state.next_sequence)
+    state.next_sequence = header.sequence + 1;
+  return header.num_segments;
+}
+
+// Joins the writer thread and closes all segment files
+static inline void
+close_segments(JournalState &state)
+{
+  state.writer.reset(0);
+
+  for (std::vector<JournalSegment *>::iterator it = state.segments.begin();
+                  it != state.segments.end(); it++)
+    delete *it;
+  state.segments.clear();
+  state.current_fd = 0;
+}
+
+// Returns the index of the segment with the lowest sequence number which
+// is greater than |sequence|, or -1 if there is none
+static inline int
+next_segment(JournalState &state, uint64_t sequence)
+{
+  int next = -1;
+  for (int i = 0; i < (int)state.segments.size(); i++) {
+    uint64_t s = state.segments[i]->sequence;
+    if (s > sequence && (next == -1 || s < state.segments[next]->sequence))
+      next = i;
+  }
+  return next;
+}
+
+// Returns the lowest journal position of all Txns whose entries are still
+// required for recovery
+static inline uint64_t
+oldest_required_position(JournalState &state)
+{
+  uint64_t position = state.flushed_txn_position;
+
+  Txn *txn = state.env->txn_manager.get()
+                ? state.env->txn_manager->oldest_txn()
+                : 0;
+  for (; txn != 0; txn = txn->next())
+    position = std::min(position, ((LocalTxn *)txn)->journal_position);
+  return position;
+}
+
+// Switches to another segment. The oldest segment which is no longer
+// required for recovery is recycled; if there is none then a new segment
+// file is created.
+static inline void
+switch_segment(JournalState &state)
+{
+  // all flushed entries (i.e. the newest changeset) have to be durable
+  // before an older segment is overwritten
+  drain_writer(state);
+
+  uint64_t txn_position = oldest_required_position(state);
+  uint64_t changeset_position;
+  {
+    ScopedLock lock(state.changeset_mutex);
+    changeset_position = state.changesets_written;
+  }
+
+  // the segments of the attached readers, and all newer ones, are pinned
+  uint64_t tail_sequence = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 0; i < state.tails.size(); i++)
+    tail_sequence = std::min(tail_sequence, state.tails[i]->iter.sequence);
+
+  // A segment can be recycled if the entries of all active Txns are
+  // stored in newer segments, if the pages of all its changesets
+  // were written to the database file, and if it is not read by a tail
+  int next = -1;
+  for (int i = 0; i < (int)state.segments.size(); i++) {
+    JournalSegment *segment = state.segments[i];
+    if (i == (int)state.current_fd)
+      continue;
+    if (segment->sequence != 0
+          && (segment->end_position > txn_position
+              || segment->changeset_position > changeset_position
+              || segment->sequence >= tail_sequence))
+      continue;
+    if (next == -1 || segment->sequence < state.segments[next]->sequence)
+      next = i;
+  }
+
+  if (next == -1) {
+    next = create_segment(state);
+    // the header of the first segment stores the number of segments
+    write_segment_header(state, 0, false);
+  }
+  else if (state.segments[next]->sequence != 0)
+    state.count_segments_recycled++;
+
+  activate_segment(state, next);
+}
+
+// Stores the segment's tag in all entries of the buffer
+static inline void
+tag_entries(JournalState &state, JournalSegment *segment)
+{
+  uint8_t *p = state.buffer.data();
+  uint8_t *end = p + state.buffer.size();
+  while (p + sizeof(PJournalEntry) <= end) {
+    PJournalEntry *entry = (PJournalEntry *)p;
+    entry->segment_tag = (uint16_t)segment->sequence;
+    p += sizeof(PJournalEntry) + entry->followup_size;
+  }
+}
+
+// Runs in the PageManager's worker thread. All changesets which were
+// queued before were already written, because the worker processes its
+// messages in order. Flushes the database file, then stores the lsn of
+// the newest written changeset for the next checkpoint.
+static void
+prepare_checkpoint(JournalState *state, Device *device)
+{
+  uint64_t lsn, written;
+  {
+    ScopedLock lock(state->changeset_mutex);
+    lsn = state->changeset_lsn_written;
+    written = state->count_changesets_written;
+  }
+
+  try {
+    device->flush();
+  }
+  catch (Exception &) {
+    lsn = 0; // the checkpoint is skipped
+  }
+
+  ScopedLock lock(state->changeset_mutex);
+  state->checkpoint_lsn = lsn;
+  state->checkpoint_written = written;
+  state->checkpoint_ready = true;
+}
+
+// Appends a checkpoint to the buffer if the worker thread prepared one
+static inline void
+append_checkpoint_maybe(JournalState &state)
+{
+  PJournalEntryCheckpoint checkpoint;
+  uint64_t written;
+  {
+    ScopedLock lock(state.changeset_mutex);
+    if (!state.checkpoint_ready)
+      return;
+    state.checkpoint_ready = false;
+    checkpoint.redo_lsn = state.checkpoint_lsn;
+    written = state.checkpoint_written;
+  }
+
+  state.checkpoint_pending = false;
+  if (checkpoint.redo_lsn == 0)
+    return;
+
+  checkpoint.num_pending_changesets = (uint32_t)(state.count_changesets_appended
+                  - written);
+  Txn *txn = state.env->txn_manager.get()
+                ? state.env->txn_manager->oldest_txn()
+                : 0;
+  for (; txn != 0; txn = txn->next())
+    checkpoint.num_active_txns++;
+
+  PJournalEntry entry;
+  entry.lsn = state.env->lsn_manager.next();
+  entry.type = Journal::kEntryTypeCheckpoint;
+  entry.followup_size = sizeof(checkpoint);
+  state.buffer.append((uint8_t *)&entry, sizeof(entry));
+  state.buffer.append((uint8_t *)&checkpoint, sizeof(checkpoint));
+
+  state.count_checkpoints++;
+  state.checkpoint_changesets = written;
+}
+
+// Asks the worker thread to prepare a checkpoint if enough bytes were
+// flushed since the last one
+static inline void
+request_checkpoint_maybe(JournalState &state, size_t size)
+{
+  state.bytes_since_checkpoint += size;
+  if (state.checkpoint_pending
+        || state.bytes_since_checkpoint < state.checkpoint_interval)
+    return;
+
+  state.bytes_since_checkpoint = 0;
+  state.checkpoint_pending = true;
+  state.env->page_manager->run_async(boost::bind(&prepare_checkpoint,
+                          &state, state.env->device.get()));
+}
+
+// Hands the buffer over to the writer thread; switches to another segment
+// if the current one is full. Returns the position of the last flushed
+// byte; use wait_for_writer() to wait till it is durable.
+static inline uint64_t
+flush_buffer(JournalState &state, bool fsync = false)
+{
+  if (unlikely(state.buffer.size() == 0))
+    return state.writer->submitted_position;
+
+  if (unlikely(state.checkpoint_pending))
+    append_checkpoint_maybe(state);
+
+  size_t size = state.buffer.size();
+
+  // an oversized buffer is written to an empty segment nevertheless,
+  // and the segment file grows
+  JournalSegment *segment = state.segments[state.current_fd];
+  if (unlikely(segment->sequence == 0))
+    activate_segment(state, state.current_fd);
+  else if (segment->offset > sizeof(PJournalSegmentHeader)
+          && segment->offset + size + sizeof(PJournalEntry)
+                > state.segment_size)
+    switch_segment(state);
+  segment = state.segments[state.current_fd];
+
+  tag_entries(state, segment);
+
+  // the empty entry marks the end of the segment; it is overwritten
+  // by the next flush
+  PJournalEntry terminator;
+  state.buffer.append((uint8_t *)&terminator, sizeof(terminator));
+
+  state.count_bytes_flushed += size;
+  uint64_t position = state.writer->submit(state.buffer, &segment->file,
+                  segment->offset, fsync);
+  segment->offset += size;
+  segment->end_position = position;
+
+  request_checkpoint_maybe(state, size);
+  return position;
+}
+
+// Blocks till the writer thread wrote all bytes up to |position|
+static inline void
+wait_for_writer(JournalState &state, uint64_t position)
+{
+  state.writer->wait(position);
+}
+
+// Reads the entry at |offset| of segment |idx|. Returns false if the
+// segment has no further entries.
+static inline bool
+read_segment_entry(JournalState &state, int idx, uint64_t offset,
+                PJournalEntry *entry)
+{
+  JournalSegment *segment = state.segments[idx];
+  if (offset + sizeof(*entry) > segment->file.file_size())
+    return false;
+
+  segment->file.pread(offset, entry, sizeof(*entry));
+
+  // a stale entry of a recycled segment (after a torn write) has a
+  // different tag
+  return entry->lsn != 0
+          && entry->segment_tag == (uint16_t)segment->sequence;
 }
 
 // Sequentially returns the next journal entry, starting with
@@ -121,44 +463,32 @@ read_entry(JournalState &state, Journal::Iterator *iter, PJournalEntry *entry,
                 ByteArray *auxbuffer)
 {
   auxbuffer->clear();
+  entry->lsn = 0;
 
-  // if iter->offset is 0, then the iterator was created from scratch
-  // and we start reading from the first (oldest) entry.
-  //
-  // The oldest of the two logfiles is always the "other" one (the one
-  // NOT in current_fd).
-  if (iter->offset == 0) {
-    iter->fdstart = iter->fdidx =
-                        state.current_fd == 0
-                            ? 1
-                            : 0;
-  }
-
-  // get the size of the journal file
-  uint64_t filesize = state.files[iter->fdidx].file_size();
-
-  // reached EOF? then either skip to the next file or we're done
-  if (filesize == iter->offset) {
-    if (iter->fdstart == iter->fdidx) {
-      iter->fdidx = iter->fdidx == 1 ? 0 : 1;
-      iter->offset = 0;
-      filesize = state.files[iter->fdidx].file_size();
-    }
-    else {
-      entry->lsn = 0;
+  // if iter->sequence is 0, then the iterator was created from scratch
+  // and we start reading from the oldest segment
+  if (iter->sequence == 0) {
+    int idx = next_segment(state, 0);
+    if (idx == -1)
       return;
-    }
-  }
-
-  // second file is also empty? then return
-  if (filesize == iter->offset) {
-    entry->lsn = 0;
-    return;
+    iter->fdidx = idx;
+    iter->sequence = state.segments[idx]->sequence;
+    iter->offset = sizeof(PJournalSegmentHeader);
   }
 
   // now try to read the next entry
   try {
-    state.files[iter->fdidx].pread(iter->offset, entry, sizeof(*entry));
+    // reached the end of the segment? then continue with the next one
+    while (!read_segment_entry(state, iter->fdidx, iter->offset, entry)) {
+      int idx = next_segment(state, iter->sequence);
+      if (idx == -1) {
+        entry->lsn = 0;
+        return;
+      }
+      iter->fdidx = idx;
+      iter->sequence = state.segments[idx]->sequence;
+      iter->offset = sizeof(PJournalSegmentHeader);
+    }
 
     iter->offset += sizeof(*entry);
 
@@ -166,8 +496,8 @@ read_entry(JournalState &state, Journal::Iterator *iter, PJournalEntry *entry,
     if (entry->followup_size) {
       auxbuffer->resize((uint32_t)entry->followup_size);
 
-      state.files[iter->fdidx].pread(iter->offset, auxbuffer->data(),
-                      (size_t)entry->followup_size);
+      state.segments[iter->fdidx]->file.pread(iter->offset,
+                      auxbuffer->data(), (size_t)entry->followup_size);
       iter->offset += entry->followup_size;
     }
   }
@@ -177,10 +507,110 @@ read_entry(JournalState &state, Journal::Iterator *iter, PJournalEntry *entry,
   }
 }
 
+// Reads the next entry of a tail and its auxiliary data. Returns false if
+// there are no further entries; the iterator then keeps its position and
+// continues there when new entries were written.
+static inline bool
+read_tail_entry(JournalState &state, Journal::Iterator *iter,
+                PJournalEntry *entry, ByteArray *auxbuffer)
+{
+  while (true) {
+    if (iter->sequence != 0) {
+      JournalSegment *segment = state.segments[iter->fdidx];
+      if (segment->sequence == iter->sequence
+            && iter->offset + sizeof(*entry) <= segment->offset
+            && read_segment_entry(state, iter->fdidx, iter->offset, entry))
+        break;
+    }
+
+    // if there is a newer segment then the current one is complete
+    // (or was cleared)
+    int idx = next_segment(state, iter->sequence);
+    if (idx == -1)
+      return false;
+    iter->fdidx = idx;
+    iter->sequence = state.segments[idx]->sequence;
+    iter->offset = sizeof(PJournalSegmentHeader);
+  }
+
+  iter->offset += sizeof(*entry);
+
+  auxbuffer->resize((size_t)entry->followup_size);
+  if (entry->followup_size) {
+    state.segments[iter->fdidx]->file.pread(iter->offset,
+                    auxbuffer->data(), (size_t)entry->followup_size);
+    iter->offset += entry->followup_size;
+  }
+  return true;
+}
+
+// Appends |entry| and its auxiliary data |aux| to |out|. The keys and
+// records of inserts and erases are decompressed, therefore the entry
+// can be applied to an Environment without journal compression.
+static inline void
+append_tail_entry(JournalState &state, PJournalEntry entry,
+                ByteArray &aux, ByteArray *out)
+{
+  entry.segment_tag = 0;
+
+  if (entry.type == Journal::kEntryTypeInsert
+        && state.compressor.get()) {
+    PJournalEntryInsert *ins = (PJournalEntryInsert *)aux.data();
+    PJournalEntryInsert header = *ins;
+    header.compressed_key_size = 0;
+    header.compressed_record_size = 0;
+    entry.followup_size = sizeof(PJournalEntryInsert) - 1
+            + ins->key_size + ins->record_size;
+    out->append((uint8_t *)&entry, sizeof(entry));
+    out->append((uint8_t *)&header, sizeof(PJournalEntryInsert) - 1);
+
+    uint8_t *payload = ins->key_data();
+    if (ins->compressed_key_size != 0) {
+      state.compressor->decompress(payload, ins->compressed_key_size,
+                      ins->key_size);
+      out->append(state.compressor->arena.data(), ins->key_size);
+      payload += ins->compressed_key_size;
+    }
+    else {
+      out->append(payload, ins->key_size);
+      payload += ins->key_size;
+    }
+    if (ins->compressed_record_size != 0) {
+      state.compressor->decompress(payload, ins->compressed_record_size,
+                      ins->record_size);
+      out->append(state.compressor->arena.data(), ins->record_size);
+    }
+    else
+      out->append(payload, ins->record_size);
+    return;
+  }
+
+  if (entry.type == Journal::kEntryTypeErase
+        && state.compressor.get()) {
+    PJournalEntryErase *e = (PJournalEntryErase *)aux.data();
+    PJournalEntryErase header = *e;
+    header.compressed_key_size = 0;
+    entry.followup_size = sizeof(PJournalEntryErase) - 1 + e->key_size;
+    out->append((uint8_t *)&entry, sizeof(entry));
+    out->append((uint8_t *)&header, sizeof(PJournalEntryErase) - 1);
+
+    if (e->compressed_key_size != 0) {
+      state.compressor->decompress(e->key_data(), e->compressed_key_size,
+                      e->key_size);
+      out->append(state.compressor->arena.data(), e->key_size);
+    }
+    else
+      out->append(e->key_data(), e->key_size);
+    return;
+  }
+
+  out->append((uint8_t *)&entry, sizeof(entry));
+  out->append(aux.data(), (size_t)entry.followup_size);
+}
 
 // Appends an entry to the journal
 static inline void
-append_entry(JournalState &state, int idx,
+append_entry(JournalState &state,
             const uint8_t *ptr1 = 0, size_t ptr1_size = 0,
             const uint8_t *ptr2 = 0, size_t ptr2_size = 0,
             const uint8_t *ptr3 = 0, size_t ptr3_size = 0,
@@ -199,24 +629,11 @@ append_entry(JournalState &state, int idx,
     state.buffer.append(ptr5, ptr5_size);
 }
 
-// Switches the log file if necessary; returns the new log descriptor in the
-// transaction
-static inline int
-switch_files_maybe(JournalState &state)
+// Returns the journal position of the next appended entry
+static inline uint64_t
+append_position(JournalState &state)
 {
-  int other = state.current_fd ? 0 : 1;
-
-  // determine the journal file which is used for this transaction 
-  // if the "current" file is not yet full, continue to write to this file
-  //
-  // otherwise delete the other file and use the other file as the current file
-  if (unlikely(state.num_transactions > state.threshold)) {
-    clear_file(state, other);
-    state.current_fd = other;
-    state.num_transactions = 0;
-  }
-
-  return state.current_fd;
+  return state.writer->submitted_position + state.buffer.size();
 }
 
 // Returns a pointer to database. If the database was not yet opened then
@@ -295,149 +712,248 @@ append_changeset_page(JournalState &state, Page *page, uint32_t page_size)
     state.count_bytes_before_compression += page_size;
     header.compressed_size = state.compressor->compress((uint8_t *)page->data(),
                     page_size);
-    append_entry(state, state.current_fd, (uint8_t *)&header, sizeof(header),
+    append_entry(state, (uint8_t *)&header, sizeof(header),
                     state.compressor->arena.data(),
                     header.compressed_size);
     state.count_bytes_after_compression += header.compressed_size;
     return header.compressed_size + sizeof(header);
   }
 
-  append_entry(state, state.current_fd, (uint8_t *)&header, sizeof(header),
+  append_entry(state, (uint8_t *)&header, sizeof(header),
                 (uint8_t *)page->data(), page_size);
   return page_size + sizeof(header);
 }
 
-// Scans a file for the oldest changeset. Returns the lsn of this
-// changeset.
-static inline uint64_t
-scan_for_oldest_changeset(JournalState &state, File *file)
+// Appends the ranges of |data| which differ from the persisted page |base|
+// to |payload|. Pages are compared word by word. Returns false if the delta
+// does not save at least 1/8th of the page.
+static inline bool
+diff_page(const uint8_t *base, const uint8_t *data, uint32_t page_size,
+                ByteArray *payload)
 {
-  Journal::Iterator it;
-  PJournalEntry entry;
-  ByteArray buffer;
+  const uint64_t *b = (const uint64_t *)base;
+  const uint64_t *d = (const uint64_t *)data;
+  size_t words = page_size / sizeof(uint64_t);
+  size_t limit = page_size - page_size / 8;
+  uint8_t *out = payload->resize(page_size);
+  size_t used = 0;
+
+  size_t i = 0;
+  while (i < words) {
+    if (b[i] == d[i]) {
+      i++;
+      continue;
+    }
 
-  // get the next entry
-  try {
-    uint64_t filesize = file->file_size();
+    // extend the range till the next gap of unmodified words
+    size_t end = i + 1;
+    for (size_t j = end; j < words && j - end < kDeltaMergeGap; j++) {
+      if (b[j] != d[j])
+        end = j + 1;
+    }
 
-    while (it.offset < filesize) {
-      file->pread(it.offset, &entry, sizeof(entry));
+    PJournalEntryPageRange range;
+    range.offset = (uint32_t)(i * sizeof(uint64_t));
+    range.size = (uint32_t)((end - i) * sizeof(uint64_t));
+    if (used + sizeof(range) + range.size > limit)
+      return false;
+    ::memcpy(out + used, &range, sizeof(range));
+    ::memcpy(out + used + sizeof(range), data + range.offset, range.size);
+    used += sizeof(range) + range.size;
 
-      if (entry.lsn == 0)
-        break;
+    i = end;
+  }
 
-      if (entry.type == Journal::kEntryTypeChangeset) {
-        return entry.lsn;
-      }
+  payload->set_size(used);
+  return true;
+}
 
-      // increment the offset
-      it.offset += sizeof(entry) + entry.followup_size;
+// Helper function which adds a single page from the changeset to the
+// Journal, either as a delta or as a full page image; returns the number
+// of bytes that were appended
+static inline uint32_t
+append_changeset_delta_page(JournalState &state, Page *page,
+                uint32_t page_size)
+{
+  PJournalEntryPageDelta header(page->address());
+  header.flags = PJournalEntryPageDelta::kFullImage;
+  header.payload_size = page_size;
+  const uint8_t *payload = (const uint8_t *)page->data();
+
+  // the delta is calculated against the persisted page, because this is
+  // the page which is patched during recovery. New pages (at the end of
+  // the file) are logged as full images, and so are all pages if page
+  // compression is enabled (their persisted image is compressed)
+  if (state.env->config.page_compressor == 0
+        && page->address() + page_size <= state.env->device->file_size()) {
+    uint8_t *base = state.delta_base.resize(page_size);
+    state.env->device->read(page->address(), base, page_size);
+    if (diff_page(base, payload, page_size, &state.delta_payload)) {
+      header.flags = 0;
+      header.payload_size = (uint32_t)state.delta_payload.size();
+      payload = state.delta_payload.data();
+    }
+  }
+
+  // the payload is compressed if this saves space
+  uint32_t size = header.payload_size;
+  if (state.compressor.get() && size > 0) {
+    state.count_bytes_before_compression += size;
+    uint32_t len = state.compressor->compress(payload, size);
+    if (len < size) {
+      header.compressed_size = len;
+      payload = state.compressor->arena.data();
+      size = len;
+    }
+    state.count_bytes_after_compression += size;
+  }
+
+  append_entry(state, (uint8_t *)&header, sizeof(header),
+                payload, size);
+  return size + sizeof(header);
+}
+
+// Returns the redo lsn of the newest checkpoint, or 0 if the journal
+// does not contain a checkpoint
+static inline uint64_t
+find_newest_checkpoint(JournalState &state)
+{
+  uint64_t redo_lsn = 0;
+
+  try {
+    for (int idx = next_segment(state, 0); idx != -1;
+                    idx = next_segment(state, state.segments[idx]->sequence)) {
+      PJournalEntry entry;
+      uint64_t offset = sizeof(PJournalSegmentHeader);
+      while (read_segment_entry(state, idx, offset, &entry)) {
+        if (entry.type == Journal::kEntryTypeCheckpoint) {
+          PJournalEntryCheckpoint checkpoint;
+          state.segments[idx]->file.pread(offset + sizeof(entry),
+                          &checkpoint, sizeof(checkpoint));
+          redo_lsn = std::max(redo_lsn, checkpoint.redo_lsn);
+        }
+        offset += sizeof(entry) + entry.followup_size;
+      }
     }
   }
   catch (Exception &ex) {
     ups_log(("exception (error %d) while reading journal", ex.code));
   }
 
-  return 0;
+  return redo_lsn;
 }
 
-// Redo all Changesets of a log file, in chronological order
-// Returns the highest lsn of the last changeset applied
+// Redo all Changesets of a segment, in chronological order; changesets
+// up to |redo_lsn| were already written to the database file and are
+// skipped. The pages are applied by |redo|. Returns the highest lsn of
+// the last changeset
 static inline uint64_t
-redo_all_changesets(JournalState &state, int fdidx)
+redo_all_changesets(JournalState &state, int fdidx, uint64_t redo_lsn,
+                JournalRedo &redo)
 {
   Journal::Iterator it;
   PJournalEntry entry;
-  ByteArray buffer;
   uint64_t max_lsn = 0;
+  JournalSegment *segment = state.segments[fdidx];
+  uint32_t page_size = state.env->config.page_size_bytes;
+  std::vector<JournalRedoPage *> pages;
 
   // for each entry...
   try {
-    uint64_t log_file_size = state.files[fdidx].file_size();
-
-    while (it.offset < log_file_size) {
-      state.files[fdidx].pread(it.offset, &entry, sizeof(entry));
+    it.offset = sizeof(PJournalSegmentHeader);
 
+    while (read_segment_entry(state, fdidx, it.offset, &entry)) {
       // Skip all log entries which are NOT from a changeset
-      if (entry.type != Journal::kEntryTypeChangeset) {
+      if (entry.type != Journal::kEntryTypeChangeset
+            && entry.type != Journal::kEntryTypeChangesetDelta) {
         it.offset += sizeof(entry) + entry.followup_size;
         continue;
       }
 
+      bool is_delta = entry.type == Journal::kEntryTypeChangesetDelta;
+
       max_lsn = entry.lsn;
 
       it.offset += sizeof(entry);
 
       // Read the Changeset header
       PJournalEntryChangeset changeset;
-      state.files[fdidx].pread(it.offset, &changeset, sizeof(changeset));
-      it.offset += sizeof(changeset);
+      segment->file.pread(it.offset, &changeset, sizeof(changeset));
 
-      uint32_t page_size = state.env->config.page_size_bytes;
-      ByteArray arena(page_size);
-      ByteArray tmp;
+      state.env->page_manager->set_last_blob_page_id(changeset.last_blob_page);
 
-      uint64_t file_size = state.env->device->file_size();
+      // Skip the changeset if it was written before the checkpoint
+      if (entry.lsn <= redo_lsn) {
+        state.count_changesets_skipped++;
+        it.offset += entry.followup_size;
+        continue;
+      }
 
-      state.env->page_manager->set_last_blob_page_id(changeset.last_blob_page);
+      it.offset += sizeof(changeset);
+
+      uint64_t file_size = state.env->device->file_size();
+      uint64_t new_file_size = file_size;
 
-      // for each page in this changeset...
+      // read all pages of this changeset; they are decompressed and
+      // applied by |redo|
       for (uint32_t i = 0; i < changeset.num_pages; i++) {
-        PJournalEntryPageHeader page_header;
-        state.files[fdidx].pread(it.offset, &page_header,
-                        sizeof(page_header));
-        it.offset += sizeof(page_header);
-        if (page_header.compressed_size > 0) {
-          tmp.resize(page_size);
-          state.files[fdidx].pread(it.offset, tmp.data(),
-                        page_header.compressed_size);
-          it.offset += page_header.compressed_size;
-          state.compressor->decompress(tmp.data(),
-                        page_header.compressed_size, page_size, &arena);
+        JournalRedoPage *rp = new JournalRedoPage;
+        pages.push_back(rp);
+        rp->payload_size = page_size;
+
+        if (is_delta) {
+          PJournalEntryPageDelta delta_header;
+          segment->file.pread(it.offset, &delta_header,
+                          sizeof(delta_header));
+          it.offset += sizeof(delta_header);
+          rp->address = delta_header.address;
+          rp->compressed_size = delta_header.compressed_size;
+          rp->payload_size = delta_header.payload_size;
+          rp->is_full_image = ISSET(delta_header.flags,
+                          PJournalEntryPageDelta::kFullImage);
+          if (unlikely(rp->payload_size > page_size)) {
+            ups_log(("invalid page delta in journal"));
+            throw Exception(UPS_INTEGRITY_VIOLATED);
+          }
         }
         else {
-          state.files[fdidx].pread(it.offset, arena.data(), page_size);
-          it.offset += page_size;
-        }
-
-        Page *page;
-
-        // now write the page to disk
-        if (page_header.address == file_size) {
-          file_size += page_size;
-
-          page = new Page(state.env->device.get());
-          page->alloc(0);
+          PJournalEntryPageHeader page_header;
+          segment->file.pread(it.offset, &page_header,
+                          sizeof(page_header));
+          it.offset += sizeof(page_header);
+          rp->address = page_header.address;
+          rp->compressed_size = page_header.compressed_size;
         }
-        else if (page_header.address > file_size) {
-          file_size = (size_t)page_header.address + page_size;
-          state.env->device->truncate(file_size);
 
-          page = new Page(state.env->device.get());
-          page->fetch(page_header.address);
+        uint32_t size = rp->compressed_size > 0
+                            ? rp->compressed_size
+                            : rp->payload_size;
+        if (size > 0) {
+          rp->data.resize(size);
+          segment->file.pread(it.offset, rp->data.data(), size);
+          it.offset += size;
         }
-        else {
-          if (page_header.address == 0)
-            page = state.env->header->header_page;
-          else
-            page = new Page(state.env->device.get());
-          page->fetch(page_header.address);
-        }
-        assert(page->address() == page_header.address);
 
-        // overwrite the page data
-        ::memcpy(page->data(), arena.data(), page_size);
+        if (rp->address + page_size > new_file_size)
+          new_file_size = rp->address + page_size;
+      }
 
-        // flush the modified page to disk
-        page->set_dirty(true);
-        page->flush();
+      // grow the file before the pages are applied; the new pages are
+      // initialized with zeroes
+      if (new_file_size > file_size)
+        state.env->device->truncate(new_file_size);
 
-        if (page_header.address != 0)
-          delete page;
+      for (size_t i = 0; i < pages.size(); i++) {
+        JournalRedoPage *rp = pages[i];
+        pages[i] = 0;
+        redo.apply(rp);
       }
+      pages.clear();
     }
   }
   catch (Exception &) {
+    for (size_t i = 0; i < pages.size(); i++)
+      delete pages[i];
     ups_trace(("Exception when applying changeset"));
     // propagate error
     throw;
@@ -446,27 +962,29 @@ redo_all_changesets(JournalState &state, int fdidx)
   return max_lsn;
 }
 
-// Recovers (re-applies) the physical changelog; returns the lsn of the
-// Changelog
+// Recovers (re-applies) the physical changelog; the segments are
+// replayed in the order of their sequence numbers, starting after the
+// newest checkpoint. The pages are applied by |recovery_threads|
+// threads. Returns the lsn of the newest changeset
 static inline uint64_t
 recover_changeset(JournalState &state)
 {
-  // scan through both files, look for the file with the oldest changeset.
-  uint64_t lsn1 = scan_for_oldest_changeset(state, &state.files[0]);
-  uint64_t lsn2 = scan_for_oldest_changeset(state, &state.files[1]);
-
-  // both files are empty or do not contain a changeset?
-  if (lsn1 == 0 && lsn2 == 0)
-    return 0;
+  uint64_t max_lsn = 0;
+  uint64_t redo_lsn = find_newest_checkpoint(state);
 
-  // now redo all changesets chronologically
-  state.current_fd = lsn1 < lsn2 ? 0 : 1;
+  JournalRedo redo(state.env->device.get(), state.env->header->header_page,
+                  state.env->config.journal_compressor,
+                  state.env->config.compression_level,
+                  state.env->config.recovery_threads);
 
-  uint64_t max_lsn1 = redo_all_changesets(state, state.current_fd);
-  uint64_t max_lsn2 = redo_all_changesets(state, state.current_fd == 0 ? 1 : 0);
+  for (int idx = next_segment(state, 0); idx != -1;
+                  idx = next_segment(state, state.segments[idx]->sequence))
+    max_lsn = std::max(max_lsn, redo_all_changesets(state, idx, redo_lsn,
+                            redo));
 
-  // return the lsn of the newest changeset
-  return std::max(max_lsn1, max_lsn2);
+  // wait till all pages were written
+  redo.wait();
+  return max_lsn;
 }
 
 // Recovers the logical journal
@@ -626,10 +1144,15 @@ recover_journal(JournalState &state, Context *context,
           st = 0;
         break;
       }
-      case Journal::kEntryTypeChangeset: {
+      case Journal::kEntryTypeChangeset:
+      case Journal::kEntryTypeChangesetDelta: {
         // skip this; the changeset was already applied
         break;
       }
+      case Journal::kEntryTypeCheckpoint: {
+        // skip this; only used by recover_changeset()
+        break;
+      }
       default:
         ups_log(("invalid journal entry type or journal is corrupt"));
         st = UPS_IO_ERROR;
@@ -659,13 +1182,28 @@ bail:
 
 
 JournalState::JournalState(LocalEnv *env_)
-  : env(env_), current_fd(0), num_transactions(0),
-    threshold(env_->config.journal_switch_threshold),
-    disable_logging(false), count_bytes_flushed(0),
-    count_bytes_before_compression(0), count_bytes_after_compression(0)
+  : env(env_), current_fd(0), segment_size(env_->config.journal_segment_size),
+    next_sequence(1), num_transactions(0), disable_logging(false),
+    count_bytes_flushed(0), count_bytes_before_compression(0),
+    count_bytes_after_compression(0), count_segments_recycled(0),
+    checkpoint_interval(env_->config.journal_checkpoint_interval),
+    bytes_since_checkpoint(0), checkpoint_pending(false),
+    count_checkpoints(0), count_changesets_appended(0),
+    checkpoint_changesets(0), count_changesets_skipped(0),
+    flushed_txn_position(std::numeric_limits<uint64_t>::max()),
+    changesets_written(0), changeset_lsn_written(0),
+    count_changesets_written(0), checkpoint_ready(false), checkpoint_lsn(0),
+    checkpoint_written(0)
+{
+  if (segment_size == 0)
+    segment_size = kDefaultSegmentSize;
+  if (checkpoint_interval == 0)
+    checkpoint_interval = kDefaultCheckpointInterval;
+}
+
+JournalState::~JournalState()
 {
-  if (threshold == 0)
-    threshold = kSwitchTxnThreshold;
+  close_segments(*this);
 }
 
 Journal::Journal(LocalEnv *env)
@@ -673,34 +1211,66 @@ Journal::Journal(LocalEnv *env)
 {
   int algo = env->config.journal_compressor;
   if (algo)
-    state.compressor.reset(CompressorFactory::create(algo));
+    state.compressor.reset(CompressorFactory::create(algo,
+                                env->config.compression_level));
 }
 
 void
 Journal::create()
 {
-  // create the two files
-  for (int i = 0; i < 2; i++) {
-    std::string path = log_file_path(state, i);
-    state.files[i].create(path.c_str(), 0644);
+  uint32_t num_segments = state.env->config.journal_segments;
+  if (num_segments == 0)
+    num_segments = kDefaultSegments;
+
+  // create and preallocate the segment files
+  try {
+    for (uint32_t i = 0; i < num_segments; i++)
+      create_segment(state);
   }
+  catch (Exception &) {
+    close_segments(state);
+    throw;
+  }
+
+  state.writer.reset(new JournalWriter);
 }
 
 void
 Journal::open()
 {
-  // open the two files
+  // open the segment files; the first segment stores the number of
+  // segments. The first segment which is written to is activated when
+  // the buffer is flushed
   try {
-    std::string path = log_file_path(state, 0);
-    state.files[0].open(path.c_str(), false);
-    path = log_file_path(state, 1);
-    state.files[1].open(path.c_str(), 0);
+    uint32_t num_segments = open_segment(state, 0);
+    if (num_segments == 0)
+      num_segments = std::max(state.env->config.journal_segments,
+                      (uint32_t)kDefaultSegments);
+    for (uint32_t i = 1; i < num_segments; i++)
+      num_segments = std::max(num_segments, open_segment(state, i));
   }
-  catch (Exception &ex) {
-    state.files[1].close();
-    state.files[0].close();
-    throw ex;
+  catch (Exception &) {
+    close_segments(state);
+    throw;
+  }
+
+  state.writer.reset(new JournalWriter);
+}
+
+bool
+Journal::is_empty()
+{
+  drain_writer(state);
+
+  for (int i = 0; i < (int)state.segments.size(); i++) {
+    PJournalEntry entry;
+    if (state.segments[i]->sequence != 0
+          && read_segment_entry(state, i, sizeof(PJournalSegmentHeader),
+                  &entry))
+      return false;
   }
+
+  return true;
 }
 
 void
@@ -718,13 +1288,13 @@ Journal::append_txn_begin(LocalTxn *txn, const char *name, uint64_t lsn)
   if (name)
     entry.followup_size = ::strlen(name) + 1;
 
-  int cur = txn->log_descriptor = switch_files_maybe(state);
+  txn->journal_position = append_position(state);
 
   if (unlikely(txn->name.size()))
-    append_entry(state, cur, (uint8_t *)&entry, (uint32_t)sizeof(entry),
+    append_entry(state, (uint8_t *)&entry, (uint32_t)sizeof(entry),
                 (uint8_t *)txn->name.c_str(), (uint32_t)txn->name.size() + 1);
   else
-    append_entry(state, cur, (uint8_t *)&entry, (uint32_t)sizeof(entry));
+    append_entry(state, (uint8_t *)&entry, (uint32_t)sizeof(entry));
 
   state.num_transactions++;
 }
@@ -742,11 +1312,11 @@ Journal::append_txn_commit(LocalTxn *txn, uint64_t lsn)
   entry.txn_id = txn->id;
   entry.type = Journal::kEntryTypeTxnCommit;
 
-  append_entry(state, txn->log_descriptor, (uint8_t *)&entry, sizeof(entry));
+  append_entry(state, (uint8_t *)&entry, sizeof(entry));
 
-  // flush after commit
-  flush_buffer(state, state.current_fd,
-                  ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+  // flush after commit, and wait till the commit is durable
+  wait_for_writer(state, flush_buffer(state,
+                          ISSET(state.env->flags(), UPS_ENABLE_FSYNC)));
 }
 
 void
@@ -768,16 +1338,13 @@ Journal::append_insert(Db *db, LocalTxn *txn,
   // compression is used
   entry.followup_size = sizeof(PJournalEntryInsert) - 1;
 
-  int idx;
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY)) {
     entry.txn_id = 0;
-    idx = switch_files_maybe(state);
+    txn->journal_position = append_position(state);
     state.num_transactions++;
   }
-  else {
+  else
     entry.txn_id = txn->id;
-    idx = txn->log_descriptor;
-  }
 
   PJournalEntryInsert insert;
   insert.key_size = key->size;
@@ -790,7 +1357,7 @@ Journal::append_insert(Db *db, LocalTxn *txn,
   uint32_t entry_position = state.buffer.size();
 
   // write the header information
-  append_entry(state, idx, (uint8_t *)&entry, sizeof(entry),
+  append_entry(state, (uint8_t *)&entry, sizeof(entry),
               (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1);
 
   // try to compress the payload; if the compressed result is smaller than
@@ -807,7 +1374,7 @@ Journal::append_insert(Db *db, LocalTxn *txn,
     }
     state.count_bytes_after_compression += key_size;
   }
-  append_entry(state, idx, (uint8_t *)key_data, key_size);
+  append_entry(state, (uint8_t *)key_data, key_size);
   entry.followup_size += key_size;
 
   // and now the same for the record data
@@ -824,7 +1391,7 @@ Journal::append_insert(Db *db, LocalTxn *txn,
     }
     state.count_bytes_after_compression += record_size;
   }
-  append_entry(state, idx, (uint8_t *)record_data, record_size);
+  append_entry(state, (uint8_t *)record_data, record_size);
   entry.followup_size += record_size;
 
   // now overwrite the patched entry
@@ -834,8 +1401,8 @@ Journal::append_insert(Db *db, LocalTxn *txn,
                   (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1);
 
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY))
-    flush_buffer(state, state.current_fd,
-                    ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+    wait_for_writer(state, flush_buffer(state,
+                            ISSET(state.env->flags(), UPS_ENABLE_FSYNC)));
 }
 
 void
@@ -871,43 +1438,44 @@ Journal::append_erase(Db *db, LocalTxn *txn, ups_key_t *key,
   erase.erase_flags = flags;
   erase.duplicate = duplicate_index;
 
-  int idx;
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY)) {
     entry.txn_id = 0;
-    idx = switch_files_maybe(state);
+    txn->journal_position = append_position(state);
     state.num_transactions++;
   }
-  else {
+  else
     entry.txn_id = txn->id;
-    idx = txn->log_descriptor;
-  }
 
   // append the entry to the logfile
-  append_entry(state, idx, (uint8_t *)&entry, sizeof(entry),
+  append_entry(state, (uint8_t *)&entry, sizeof(entry),
                 (uint8_t *)&erase, sizeof(PJournalEntryErase) - 1,
                 (uint8_t *)payload_data, payload_size);
 
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY))
-    flush_buffer(state, state.current_fd,
-                    ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+    wait_for_writer(state, flush_buffer(state,
+                            ISSET(state.env->flags(), UPS_ENABLE_FSYNC)));
 }
 
-int
+uint64_t
 Journal::append_changeset(std::vector<Page *> &pages,
                 uint64_t last_blob_page, uint64_t lsn)
 {
   assert(pages.size() > 0);
 
   if (unlikely(state.disable_logging))
-    return -1;
+    return 0;
 
   PJournalEntry entry;
   PJournalEntryChangeset changeset;
   
+  bool use_deltas = state.env->config.journal_deltas;
+
   entry.lsn = lsn;
   entry.dbname = 0;
   entry.txn_id = 0;
-  entry.type = Journal::kEntryTypeChangeset;
+  entry.type = use_deltas
+                  ? Journal::kEntryTypeChangesetDelta
+                  : Journal::kEntryTypeChangeset;
   // followup_size is incomplete - the actual page sizes are added later
   entry.followup_size = sizeof(PJournalEntryChangeset);
   changeset.num_pages = pages.size();
@@ -919,14 +1487,18 @@ Journal::append_changeset(std::vector<Page *> &pages,
   uint32_t entry_position = state.buffer.size();
 
   // write the data to the file
-  append_entry(state, state.current_fd, (uint8_t *)&entry, sizeof(entry),
+  append_entry(state, (uint8_t *)&entry, sizeof(entry),
                 (uint8_t *)&changeset, sizeof(PJournalEntryChangeset));
 
   size_t page_size = state.env->config.page_size_bytes;
   for (std::vector<Page *>::iterator it = pages.begin();
                   it != pages.end();
                   ++it) {
-    entry.followup_size += append_changeset_page(state, *it, page_size);
+    if (use_deltas)
+      entry.followup_size += append_changeset_delta_page(state, *it,
+                      page_size);
+    else
+      entry.followup_size += append_changeset_page(state, *it, page_size);
   }
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
@@ -936,13 +1508,43 @@ Journal::append_changeset(std::vector<Page *> &pages,
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
-  // and flush the file
-  flush_buffer(state, state.current_fd,
+  // and flush the file; the caller waits till the changeset is durable
+  // before the pages are written to the database file
+  uint64_t position = flush_buffer(state,
                   ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+  state.segments[state.current_fd]->changeset_position = position;
+  state.count_changesets_appended++;
+
+  // the flushed Txns no longer pin their segments as soon as this
+  // changeset is durable
+  state.flushed_txn_position = std::numeric_limits<uint64_t>::max();
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
-  return state.current_fd;
+  return position;
+}
+
+void
+Journal::wait_until_durable(uint64_t position)
+{
+  wait_for_writer(state, position);
+}
+
+void
+Journal::on_txn_flushed(LocalTxn *txn)
+{
+  state.flushed_txn_position = std::min(state.flushed_txn_position,
+                  txn->journal_position);
+}
+
+void
+Journal::on_changeset_written(uint64_t position, uint64_t lsn)
+{
+  ScopedLock lock(state.changeset_mutex);
+  if (position > state.changesets_written)
+    state.changesets_written = position;
+  state.changeset_lsn_written = lsn;
+  state.count_changesets_written++;
 }
 
 void
@@ -951,14 +1553,15 @@ Journal::close(bool noclear)
   // the noclear flag is set during testing, for checking whether the files
   // contain the correct data. Flush the buffers, otherwise the tests will
   // fail because data is missing
-  if (unlikely(noclear))
-    flush_buffer(state, 0);
+  if (unlikely(noclear && state.writer.get() != 0))
+    flush_buffer(state);
 
   if (likely(!noclear))
     clear();
 
-  for (int i = 0; i < 2; i++)
-    state.files[i].close();
+  // join the writer thread (this also writes the last flushed buffer),
+  // then close the files
+  close_segments(state);
 
   state.buffer.clear();
 }
@@ -986,24 +1589,127 @@ Journal::recover(LocalTxnManager *txn_manager)
   clear();
 }
 
+void
+Journal::attach_tail(JournalTail *tail)
+{
+  // start with the oldest segment
+  int idx = next_segment(state, 0);
+  if (idx != -1) {
+    tail->iter.fdidx = idx;
+    tail->iter.sequence = state.segments[idx]->sequence;
+    tail->iter.offset = sizeof(PJournalSegmentHeader);
+  }
+  state.tails.push_back(tail);
+}
+
+void
+Journal::detach_tail(JournalTail *tail)
+{
+  std::vector<JournalTail *>::iterator it = std::find(state.tails.begin(),
+                  state.tails.end(), tail);
+  if (it != state.tails.end())
+    state.tails.erase(it);
+}
+
+bool
+Journal::read_tail(JournalTail *tail, const uint8_t **data, uint32_t *size)
+{
+  if (tail->ready_offset >= tail->ready.size()) {
+    tail->ready.set_size(0);
+    tail->ready_offset = 0;
+
+    // only read entries which were written
+    if (state.writer.get())
+      drain_writer(state);
+
+    // The entries of a Txn are returned when its commit entry is read.
+    // Entries of a Txn whose begin entry is no longer stored in the
+    // journal are skipped
+    PJournalEntry entry;
+    while (tail->ready.size() < kBufferLimit
+            && read_tail_entry(state, &tail->iter, &entry, &tail->buffer)) {
+      switch (entry.type) {
+        case kEntryTypeTxnBegin:
+          tail->pending.set_size(0);
+          tail->pending_txn_id = entry.txn_id;
+          append_tail_entry(state, entry, tail->buffer, &tail->pending);
+          break;
+        case kEntryTypeTxnCommit:
+          if (entry.txn_id == tail->pending_txn_id) {
+            append_tail_entry(state, entry, tail->buffer, &tail->pending);
+            if (entry.lsn > tail->start_lsn)
+              tail->ready.append(tail->pending.data(), tail->pending.size());
+          }
+          tail->pending.set_size(0);
+          tail->pending_txn_id = 0;
+          break;
+        case kEntryTypeTxnAbort:
+          tail->pending.set_size(0);
+          tail->pending_txn_id = 0;
+          break;
+        case kEntryTypeInsert:
+        case kEntryTypeErase:
+          if (entry.txn_id == 0) {
+            if (entry.lsn > tail->start_lsn)
+              append_tail_entry(state, entry, tail->buffer, &tail->ready);
+          }
+          else if (entry.txn_id == tail->pending_txn_id)
+            append_tail_entry(state, entry, tail->buffer, &tail->pending);
+          break;
+        case kEntryTypeChangeset:
+        case kEntryTypeChangesetDelta:
+          if (ISSET(tail->flags, JournalTail::kIncludeChangesets)
+                && entry.lsn > tail->start_lsn)
+            append_tail_entry(state, entry, tail->buffer, &tail->ready);
+          break;
+        default:
+          // checkpoints are not returned
+          break;
+      }
+    }
+
+    if (tail->ready.size() == 0)
+      return false;
+  }
+
+  PJournalEntry *entry = (PJournalEntry *)(tail->ready.data()
+                  + tail->ready_offset);
+  *data = (const uint8_t *)entry;
+  *size = (uint32_t)(sizeof(PJournalEntry) + entry->followup_size);
+  tail->ready_offset += *size;
+  return true;
+}
+
 void
 Journal::clear()
 {
-  for (int i = 0; i < 2; i++)
-    clear_file(state, i);
+  // the writer could still be writing to a segment
+  drain_writer(state);
+
+  for (int i = 0; i < (int)state.segments.size(); i++)
+    clear_segment(state, i);
+
+  state.current_fd = 0;
+  state.num_transactions = 0;
+  state.flushed_txn_position = std::numeric_limits<uint64_t>::max();
+
+  // a recovery would not re-apply any of the older changesets
+  state.checkpoint_changesets = state.count_changesets_appended;
+  state.bytes_since_checkpoint = 0;
 }
 
 void
 Journal::test_flush_buffers()
 {
-  flush_buffer(state, 0);
-  flush_buffer(state, 1);
+  flush_buffer(state);
+  drain_writer(state);
 }
 
 void
 Journal::test_read_entry(Journal::Iterator *iter, PJournalEntry *entry,
                 ByteArray *auxbuffer)
 {
+  drain_writer(state);
   return upscaledb::read_entry(state, iter, entry, auxbuffer);
 }
 
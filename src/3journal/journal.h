@@ -27,16 +27,27 @@
  * "Undo" information is not required because aborted Txns are never
  * written to disk. The journal only can "redo" operations.
  *
- * The journal is organized in two files. If one of the files grows too large
- * then all new Txns are stored in the other file
- * ("Log file switching"). When all Txns from file #0 are committed,
- * and file #1 exceeds a limit, then the files are switched back again.
+ * The journal is organized in segment files of a fixed size, which are
+ * preallocated when the journal is created. Each segment starts with a
+ * header (PJournalSegmentHeader) which stores its sequence number; recovery
+ * reads the segments in the order of their sequence numbers. If the current
+ * segment is full then the journal switches to the oldest segment which
+ * is no longer required for recovery (all its Txns were flushed, and the
+ * pages of all its changesets were written to the database file). If
+ * there is no such segment (i.e. because a long-running Txn prevents
+ * newer Txns from being flushed) then a new segment file is created.
  *
  * For writing, files are buffered. The buffers are flushed when they
  * exceed a certain threshold, when a Txn is committed or a Changeset
  * was written. In case of a commit or a changeset there will also be an
  * fsync, if UPS_ENABLE_FSYNC is enabled.
  *
+ * Flushed buffers are written by a background thread (see
+ * journal_writer.h), while new entries are appended to a second buffer.
+ * A commit waits till its entries are durable. A changeset does not wait;
+ * instead, the thread which writes the changeset's pages to the database
+ * file waits till the changeset is durable (see wait_until_durable()).
+ *
  * The physical information is a collection of pages which are modified in
  * one or more database operations (i.e. ups_db_erase). This collection is
  * called a "changeset" and implemented in changeset.h/.cc. As soon as the
@@ -64,6 +75,28 @@
  * already applied, and we know that all older changesets
  * have already been written successfully to the database file.
  *
+ * Whenever UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL bytes were flushed, the
+ * PageManager's worker thread flushes the database file and records the lsn
+ * of the newest changeset it has written. This "fuzzy" checkpoint is then
+ * appended to the journal (kEntryTypeCheckpoint) without blocking the
+ * writers. Recovery does not re-apply changesets up to the lsn of the
+ * newest checkpoint. (The worker thread writes the changesets in the order
+ * of their lsns, therefore the lsn replaces a table of dirty pages.)
+ *
+ * If UPS_PARAM_JOURNAL_DELTAS is enabled then a changeset does not store
+ * the full page images, but only the byte ranges which differ from the
+ * persisted page (kEntryTypeChangesetDelta). When replayed in order,
+ * the deltas restore the same page images as the full images, because
+ * every byte either has the value of the newest delta that modified it,
+ * or its persisted value. New pages and compressed pages are still logged
+ * as full images.
+ *
+ * The committed entries can be read as a stream (ups_journal_cursor_t,
+ * see JournalTail), i.e. to replay them on a second Environment. The
+ * entries of a Txn are appended when it is committed, therefore they are
+ * stored back to back, and aborted Txns are never written. The segments
+ * of an attached reader are not recycled.
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -103,6 +136,7 @@ struct Txn;
 struct LocalEnv;
 struct LocalTxn;
 struct LocalTxnManager;
+struct JournalTail;
 
 #include "1base/packstart.h"
 
@@ -128,22 +162,29 @@ struct Journal
     kEntryTypeErase      = 5,
 
     // marks a whole changeset operation (writes modified pages)
-    kEntryTypeChangeset  = 6
+    kEntryTypeChangeset  = 6,
+
+    // marks a changeset operation which writes page deltas
+    kEntryTypeChangesetDelta = 7,
+
+    // marks a checkpoint
+    kEntryTypeCheckpoint = 8
   };
 
   //
-  // An "iterator" structure for traversing the journal files
+  // An "iterator" structure for traversing the journal segments
   //
   struct Iterator {
     Iterator()
-      : fdidx(0), fdstart(0), offset(0) {
+      : fdidx(0), sequence(0), offset(0) {
     }
 
-    // selects the file descriptor [0..1]
+    // the index of the current segment
     int fdidx;
 
-    // which file descriptor did we start with? [0..1]
-    int fdstart;
+    // the sequence number of the current segment; 0 if the iteration
+    // did not yet start
+    uint64_t sequence;
 
     // the offset in the file of the NEXT entry
     uint64_t offset;
@@ -159,18 +200,7 @@ struct Journal
   void open();
 
   // Returns true if the journal is empty
-  bool is_empty() const {
-    if (!state.files[0].is_open() && !state.files[1].is_open())
-      return true;
-
-    for (int i = 0; i < 2; i++) {
-      uint64_t size = state.files[i].file_size();
-      if (size > 0)
-        return false;
-    }
-
-    return true;
-  }
+  bool is_empty();
 
   // Appends a journal entry for ups_txn_begin/kEntryTypeTxnBegin
   void append_txn_begin(LocalTxn *txn, const char *name,
@@ -190,11 +220,23 @@ struct Journal
                   uint64_t lsn);
 
   // Appends a journal entry for a whole changeset/kEntryTypeChangeset
-  // Returns the current file descriptor, which is the parameter for
-  // on_changeset_flush()
-  int append_changeset(std::vector<Page *> &pages, uint64_t last_blob_page,
+  // (or kEntryTypeChangesetDelta if deltas are enabled).
+  // Returns the journal position which has to be durable before the
+  // pages are written to the database file (see wait_until_durable())
+  uint64_t append_changeset(std::vector<Page *> &pages, uint64_t last_blob_page,
                   uint64_t lsn);
 
+  // Blocks till the journal was written up to |position|
+  void wait_until_durable(uint64_t position);
+
+  // Called when a committed Txn was flushed to the Btree. Its segment
+  // is not recycled till the next changeset was appended and is durable
+  void on_txn_flushed(LocalTxn *txn);
+
+  // Called by the PageManager's worker thread when the pages of the
+  // changeset at |position| were written to the database file
+  void on_changeset_written(uint64_t position, uint64_t lsn);
+
   // Empties the journal, removes all entries
   void clear();
 
@@ -205,6 +247,17 @@ struct Journal
   // all others are automatically aborted
   void recover(LocalTxnManager *txn_manager);
 
+  // Attaches a reader; its segments are no longer recycled
+  void attach_tail(JournalTail *tail);
+
+  // Detaches a reader
+  void detach_tail(JournalTail *tail);
+
+  // Returns the next committed entry of |tail| (a PJournalEntry, followed
+  // by its uncompressed payload). Returns false if there are no further
+  // durable entries; new entries are returned by the next call.
+  bool read_tail(JournalTail *tail, const uint8_t **data, uint32_t *size);
+
   // Fills the metrics
   void fill_metrics(ups_env_metrics_t *metrics) {
     metrics->journal_bytes_flushed = state.count_bytes_flushed;
@@ -212,6 +265,19 @@ struct Journal
             = state.count_bytes_before_compression;
     metrics->journal_bytes_after_compression
             = state.count_bytes_after_compression;
+    metrics->journal_segments = state.segments.size();
+    metrics->journal_segments_recycled = state.count_segments_recycled;
+    metrics->journal_checkpoints = state.count_checkpoints;
+    metrics->journal_recovery_changesets = state.count_changesets_appended
+            - state.checkpoint_changesets;
+    metrics->journal_recovery_bytes = 0;
+    for (size_t i = 0; i < state.segments.size(); i++) {
+      if (state.segments[i]->sequence != 0)
+        metrics->journal_recovery_bytes += state.segments[i]->offset
+                - sizeof(PJournalSegmentHeader);
+    }
+    if (state.writer.get())
+      state.writer->fill_metrics(metrics);
   }
 
   // Flushes all buffers to disk. Used for testing.
@@ -226,6 +292,50 @@ struct Journal
 
 #include "1base/packstop.h"
 
+//
+// A reader which follows the committed entries of the journal
+// (ups_journal_cursor_t)
+//
+struct JournalTail {
+  enum {
+    // return the changesets as well
+    kIncludeChangesets = 1
+  };
+
+  JournalTail(Journal *journal_, uint64_t start_lsn_, uint32_t flags_)
+    : journal(journal_), start_lsn(start_lsn_), flags(flags_),
+      pending_txn_id(0), ready_offset(0) {
+  }
+
+  // The journal
+  Journal *journal;
+
+  // The position of the next entry
+  Journal::Iterator iter;
+
+  // Entries up to this lsn are skipped; for a Txn, the lsn of its
+  // commit entry is relevant
+  uint64_t start_lsn;
+
+  // The flags (kIncludeChangesets)
+  uint32_t flags;
+
+  // The id of the Txn whose entries are collected in |pending|
+  uint64_t pending_txn_id;
+
+  // The entries of a Txn which was not yet committed
+  ByteArray pending;
+
+  // The entries which are returned by the next calls
+  ByteArray ready;
+
+  // The offset of the next entry in |ready|
+  size_t ready_offset;
+
+  // Storage for the entry which is read
+  ByteArray buffer;
+};
+
 } // namespace upscaledb
 
 #endif /* UPS_JOURNAL_H */
@@ -36,6 +36,43 @@
 
 namespace upscaledb {
 
+#include "1base/packstart.h"
+
+/*
+ * The header of a journal segment file. The entries of the segment
+ * follow the header; the end of the entries is marked by an (empty)
+ * PJournalEntry with lsn 0.
+ */
+UPS_PACK_0 struct UPS_PACK_1 PJournalSegmentHeader {
+  // Constructor - sets the magic
+  PJournalSegmentHeader(uint64_t sequence_ = 0, uint32_t num_segments_ = 0)
+    : num_segments(num_segments_), sequence(sequence_) {
+    magic[0] = 'u';
+    magic[1] = 'p';
+    magic[2] = 'j';
+    magic[3] = '1';
+  }
+
+  // Returns true if the magic matches
+  bool verify_magic() const {
+    return magic[0] == 'u' && magic[1] == 'p'
+            && magic[2] == 'j' && magic[3] == '1';
+  }
+
+  // magic cookie - always "upj1"
+  uint8_t magic[4];
+
+  // the number of segment files when this header was written
+  uint32_t num_segments;
+
+  // the segments are read in the order of their sequence numbers;
+  // 0 if the segment is not in use
+  uint64_t sequence;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
 #include "1base/packstart.h"
 
 /*
@@ -49,7 +86,7 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntry {
   // Constructor - sets all fields to 0
   PJournalEntry()
     : lsn(0), followup_size(0), txn_id(0), type(0),
-        dbname(0), _reserved(0) {
+        dbname(0), segment_tag(0) {
   }
 
   // the lsn of this entry
@@ -67,8 +104,9 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntry {
   // the name of the database which is modified by this entry
   uint16_t dbname;
 
-  // a reserved value - reqd for padding
-  uint16_t _reserved;
+  // the lower 16 bits of the segment's sequence number; used to detect
+  // stale entries of a recycled segment after a torn write
+  uint16_t segment_tag;
 } UPS_PACK_2;
 
 #include "1base/packstop.h"
@@ -160,6 +198,31 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntryErase {
 #include "1base/packstop.h"
 
 
+#include "1base/packstart.h"
+
+//
+// a Journal entry for a checkpoint
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryCheckpoint {
+  // Constructor - sets all fields to 0
+  PJournalEntryCheckpoint()
+    : redo_lsn(0), num_pending_changesets(0), num_active_txns(0) {
+  }
+
+  // all changesets up to this lsn were written to the database file
+  // (and flushed) before the checkpoint was appended
+  uint64_t redo_lsn;
+
+  // number of changesets which were appended, but not yet written
+  uint32_t num_pending_changesets;
+
+  // number of active Txns
+  uint32_t num_active_txns;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
 #include "1base/packstart.h"
 
 //
@@ -201,6 +264,63 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageHeader {
 
 #include "1base/packstop.h"
 
+
+#include "1base/packstart.h"
+
+//
+// a Journal entry for a single page of a 'changeset' group with deltas
+// (kEntryTypeChangesetDelta). It is followed by |payload_size| bytes
+// (or |compressed_size| bytes, if the payload is compressed). The payload
+// is either the full page image, or a sequence of PJournalEntryPageRange
+// structures, each followed by the modified bytes.
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageDelta {
+  enum {
+    // the payload is the full page image
+    kFullImage = 1
+  };
+
+  // Constructor - sets all fields to 0
+  PJournalEntryPageDelta(uint64_t _address = 0)
+    : address(_address), compressed_size(0), payload_size(0), flags(0) {
+  }
+
+  // the page address
+  uint64_t address;
+
+  // the compressed size of the payload, or 0 if it is not compressed
+  uint32_t compressed_size;
+
+  // the (uncompressed) size of the payload
+  uint32_t payload_size;
+
+  // flags - kFullImage
+  uint32_t flags;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
+#include "1base/packstart.h"
+
+//
+// a range of modified bytes in a page delta; followed by the bytes
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageRange {
+  // Constructor - sets all fields to 0
+  PJournalEntryPageRange()
+    : offset(0), size(0) {
+  }
+
+  // the offset of the range in the page
+  uint32_t offset;
+
+  // the number of modified bytes
+  uint32_t size;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
 } // namespace upscaledb
 
 #endif /* UPS_JOURNAL_ENTRIES_H */
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * The parallel redo of the journal's changesets.
+ *
+ * During recovery the changesets are read by a single thread. Their
+ * pages are handed over to a pool of threads, partitioned by the page
+ * address. All images of a page are therefore applied by the same thread,
+ * in the order of the journal. The threads decompress the page images,
+ * apply the deltas and write the pages to the database file.
+ *
+ * The file is only grown by the reading thread, before the pages of a
+ * changeset are handed over.
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef UPS_JOURNAL_REDO_H
+#define UPS_JOURNAL_REDO_H
+
+#include "0root/root.h"
+
+#include <deque>
+#include <vector>
+#include <boost/bind.hpp>
+
+#include "1base/dynamic_array.h"
+#include "1base/error.h"
+#include "1base/mutex.h"
+#include "1base/scoped_ptr.h"
+#include "2compressor/compressor_factory.h"
+#include "2device/device.h"
+#include "2page/page.h"
+#include "3journal/journal_entries.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// Applies a page delta (a sequence of PJournalEntryPageRange structures,
+// each followed by the modified bytes) to |page|
+static inline void
+apply_page_delta(Page *page, const uint8_t *payload, uint32_t payload_size,
+                uint32_t page_size)
+{
+  const uint8_t *p = payload;
+  const uint8_t *end = payload + payload_size;
+  while (p < end) {
+    PJournalEntryPageRange range;
+    ::memcpy(&range, p, sizeof(range));
+    p += sizeof(range);
+    if (unlikely(range.offset + range.size > page_size
+                || p + range.size > end)) {
+      ups_log(("invalid page delta in journal"));
+      throw Exception(UPS_INTEGRITY_VIOLATED);
+    }
+    ::memcpy((uint8_t *)page->data() + range.offset, p, range.size);
+    p += range.size;
+  }
+}
+
+// A page image (or delta) of a changeset, as it was read from the journal
+struct JournalRedoPage {
+  JournalRedoPage()
+    : address(0), payload_size(0), compressed_size(0), is_full_image(true) {
+  }
+
+  // The address of the page
+  uint64_t address;
+
+  // The size of the (uncompressed) image or delta
+  uint32_t payload_size;
+
+  // The size of the compressed |data|; 0 if |data| is not compressed
+  uint32_t compressed_size;
+
+  // True if |data| is a full page image, false if it is a delta
+  bool is_full_image;
+
+  // The image or delta
+  ByteArray data;
+};
+
+// A thread applying the pages of a single partition
+struct JournalRedoWorker {
+  JournalRedoWorker(Device *device_, Page *header_page_, int algo, int level)
+    : device(device_), header_page(header_page_), stop(false), error(0) {
+    if (algo)
+      compressor.reset(CompressorFactory::create(algo, level));
+  }
+
+  // Discards pending pages; the thread is joined by the caller
+  ~JournalRedoWorker() {
+    for (size_t i = 0; i < queue.size(); i++)
+      delete queue[i];
+  }
+
+  // Writes the page of |rp| to the database file
+  void redo(JournalRedoPage *rp) {
+    uint32_t page_size = device->page_size();
+    const uint8_t *payload = rp->data.data();
+    if (rp->compressed_size > 0) {
+      compressor->decompress(rp->data.data(), rp->compressed_size,
+                      rp->payload_size, &arena);
+      payload = arena.data();
+    }
+
+    // the header page is owned by the Environment
+    ScopedPtr<Page> guard;
+    Page *page = header_page;
+    if (rp->address != 0) {
+      page = new Page(device);
+      guard.reset(page);
+    }
+
+    // a delta is applied to the persisted page; new pages were appended
+    // to the file and are therefore initialized with zeroes
+    page->fetch(rp->address);
+    if (rp->is_full_image)
+      ::memcpy(page->data(), payload, page_size);
+    else
+      apply_page_delta(page, payload, rp->payload_size, page_size);
+
+    page->set_dirty(true);
+    page->flush();
+  }
+
+  // The thread's main loop
+  void run() {
+    ScopedLock lock(mutex);
+    while (true) {
+      while (queue.empty() && !stop)
+        cond.wait(lock);
+      if (queue.empty())
+        break;
+
+      // the page stays in the |queue| till it was applied
+      JournalRedoPage *rp = queue.front();
+      bool discard = error != 0;
+      lock.unlock();
+      ups_status_t st = 0;
+      try {
+        if (!discard)
+          redo(rp);
+      }
+      catch (Exception &ex) {
+        st = ex.code;
+      }
+      lock.lock();
+
+      queue.pop_front();
+      delete rp;
+      if (unlikely(st != 0) && error == 0)
+        error = st;
+      cond.notify_all();
+    }
+  }
+
+  // The device of the database file
+  Device *device;
+
+  // The header page, which is not allocated by the worker
+  Page *header_page;
+
+  // The compressor of the journal; can be null
+  ScopedPtr<Compressor> compressor;
+
+  // Storage for decompressed pages
+  ByteArray arena;
+
+  // Protects the members below
+  Mutex mutex;
+
+  // Signals changes of |queue| and |stop|
+  Condition cond;
+
+  // The pages which are not yet applied
+  std::deque<JournalRedoPage *> queue;
+
+  // Set to true to stop the thread
+  bool stop;
+
+  // The error of a failed page; the remaining pages are discarded
+  ups_status_t error;
+
+  // The thread; null if the pages are applied by the caller
+  ScopedPtr<Thread> thread;
+};
+
+struct JournalRedo {
+  enum {
+    // the maximum number of pending pages per thread
+    kMaxQueuedPages = 64
+  };
+
+  // Starts |num_threads| threads; if |num_threads| is <= 1 then the
+  // pages are applied by the calling thread
+  JournalRedo(Device *device, Page *header_page, int algo, int level,
+                  uint32_t num_threads) {
+    if (num_threads == 0)
+      num_threads = 1;
+    for (uint32_t i = 0; i < num_threads; i++) {
+      JournalRedoWorker *w = new JournalRedoWorker(device, header_page,
+                      algo, level);
+      workers.push_back(w);
+      if (num_threads > 1)
+        w->thread.reset(new Thread(boost::bind(&JournalRedoWorker::run, w)));
+    }
+  }
+
+  // Stops and joins all threads; pending pages are discarded if the
+  // recovery failed
+  ~JournalRedo() {
+    for (size_t i = 0; i < workers.size(); i++) {
+      JournalRedoWorker *w = workers[i];
+      if (w->thread.get()) {
+        {
+          ScopedLock lock(w->mutex);
+          w->stop = true;
+          if (w->error == 0)
+            w->error = UPS_INTERNAL_ERROR; // discard remaining pages
+        }
+        w->cond.notify_all();
+        w->thread->join();
+      }
+      delete w;
+    }
+  }
+
+  // Hands |rp| over to the thread of its partition, which takes ownership.
+  // Blocks if the thread has too many pending pages. Throws the error of
+  // a failed page.
+  void apply(JournalRedoPage *rp) {
+    uint32_t page_size = workers[0]->device->page_size();
+    JournalRedoWorker *w = workers[(rp->address / page_size) % workers.size()];
+
+    if (!w->thread.get()) {
+      ScopedPtr<JournalRedoPage> guard(rp);
+      w->redo(rp);
+      return;
+    }
+
+    ScopedLock lock(w->mutex);
+    while (w->queue.size() >= kMaxQueuedPages && w->error == 0)
+      w->cond.wait(lock);
+    if (unlikely(w->error != 0)) {
+      delete rp;
+      throw Exception(w->error);
+    }
+    w->queue.push_back(rp);
+    w->cond.notify_all();
+  }
+
+  // Blocks till all pages were applied; throws the error of a failed page
+  void wait() {
+    for (size_t i = 0; i < workers.size(); i++) {
+      JournalRedoWorker *w = workers[i];
+      ScopedLock lock(w->mutex);
+      while (!w->queue.empty() && w->error == 0)
+        w->cond.wait(lock);
+      if (unlikely(w->error != 0))
+        throw Exception(w->error);
+    }
+  }
+
+  // The threads, one per partition
+  std::vector<JournalRedoWorker *> workers;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_JOURNAL_REDO_H */
@@ -27,10 +27,12 @@
 #include "ups/types.h" // for metrics
 
 #include "1base/dynamic_array.h"
+#include "1base/mutex.h"
 #include "1base/scoped_ptr.h"
 #include "1os/file.h"
 #include "2page/page_collection.h"
 #include "2compressor/compressor.h"
+#include "3journal/journal_writer.h"
 
 // Always verify that a file of level N does not include headers > N!
 
@@ -42,29 +44,59 @@ namespace upscaledb {
 
 struct Db;
 struct LocalEnv;
+struct JournalTail;
+
+// A journal segment file
+struct JournalSegment {
+  JournalSegment()
+    : sequence(0), offset(0), end_position(0), changeset_position(0) {
+  }
+
+  // The file
+  File file;
+
+  // The sequence number of the segment (see PJournalSegmentHeader);
+  // 0 if the segment is not in use
+  uint64_t sequence;
+
+  // The offset of the next write
+  uint64_t offset;
+
+  // The journal position of the last byte written to this segment
+  uint64_t end_position;
+
+  // The journal position of the last changeset in this segment
+  uint64_t changeset_position;
+};
 
 struct JournalState {
   JournalState(LocalEnv *env_);
 
+  // Joins the writer and closes the segments
+  ~JournalState();
+
   // References the Environment this journal file is for
   LocalEnv *env;
 
-  // The index of the file descriptor we are currently writing to (0 or 1)
+  // The index of the segment we are currently writing to
   uint32_t current_fd;
 
-  // The two file descriptors
-  File files[2];
+  // The segment files
+  std::vector<JournalSegment *> segments;
 
-  // Buffer for writing data to the files
+  // The size of a segment file
+  uint64_t segment_size;
+
+  // The sequence number of the next segment that is started
+  uint64_t next_sequence;
+
+  // Buffer for appending entries; handed over to the |writer| when it
+  // is flushed
   ByteArray buffer;
 
-  // Counts all transactions in the current file
+  // Counts all transactions in the current segment
   uint32_t num_transactions;
 
-  // When having more than these Txns in one file, we
-  // swap the files
-  uint32_t threshold;
-
   // Set to false to disable logging; used during recovery
   bool disable_logging;
 
@@ -77,12 +109,76 @@ struct JournalState {
   // Counting the bytes after compression (for ups_env_get_metrics)
   uint64_t count_bytes_after_compression;
 
+  // Counting the recycled segments (for ups_env_get_metrics)
+  uint64_t count_segments_recycled;
+
+  // The number of journal bytes between two checkpoints
+  uint64_t checkpoint_interval;
+
+  // The number of bytes flushed since the last checkpoint was requested
+  uint64_t bytes_since_checkpoint;
+
+  // True while the PageManager's worker thread prepares a checkpoint
+  bool checkpoint_pending;
+
+  // Counting the appended checkpoints (for ups_env_get_metrics)
+  uint64_t count_checkpoints;
+
+  // Counting the appended changesets
+  uint64_t count_changesets_appended;
+
+  // The number of changesets covered by the newest checkpoint, i.e.
+  // which are not re-applied by a recovery
+  uint64_t checkpoint_changesets;
+
+  // Counting the changesets which were skipped by the last recovery
+  uint64_t count_changesets_skipped;
+
+  // The attached readers (ups_journal_cursor_t); their segments are
+  // not recycled
+  std::vector<JournalTail *> tails;
+
   // A map of all opened databases
   typedef std::map<uint16_t, Db *> DatabaseMap;
   DatabaseMap database_map;
 
   // The compressor; can be null
   ScopedPtr<Compressor> compressor;
+
+  // Buffers for the persisted page image and the page delta
+  ByteArray delta_base;
+  ByteArray delta_payload;
+
+  // The lowest journal position of all Txns which were flushed to the
+  // Btree, but whose changeset was not yet appended to the journal
+  uint64_t flushed_txn_position;
+
+  // Protects the members below, which are updated by the PageManager's
+  // worker thread
+  Mutex changeset_mutex;
+
+  // The journal position of the last changeset whose pages were written
+  // to the database file
+  uint64_t changesets_written;
+
+  // The lsn of the last changeset whose pages were written
+  uint64_t changeset_lsn_written;
+
+  // Counting the changesets whose pages were written
+  uint64_t count_changesets_written;
+
+  // True if the worker thread prepared a checkpoint
+  bool checkpoint_ready;
+
+  // The redo lsn of the prepared checkpoint; 0 if it failed
+  uint64_t checkpoint_lsn;
+
+  // The number of changesets covered by the prepared checkpoint
+  uint64_t checkpoint_written;
+
+  // The background thread writing the flushed buffers to the files;
+  // created when the files are created or opened
+  ScopedPtr<JournalWriter> writer;
 };
 
 } // namespace upscaledb
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * The background writer of the journal.
+ *
+ * The journal appends its entries to a "front" buffer. When the buffer is
+ * flushed it is swapped with the (empty) "back" buffer, which is then
+ * written (and fsync'ed) by a dedicated thread. The appending thread
+ * therefore never blocks on write(2) unless the previous buffer is still
+ * in flight.
+ *
+ * Every flushed byte has a position in the stream of journal bytes.
+ * Threads which require durability (i.e. committing Txns or the thread
+ * writing a changeset's pages to the database file) wait till the
+ * position of their last entry is durable.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_JOURNAL_WRITER_H
+#define UPS_JOURNAL_WRITER_H
+
+#include "0root/root.h"
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "ups/upscaledb_int.h" // for metrics
+
+#include "1base/dynamic_array.h"
+#include "1base/error.h"
+#include "1base/mutex.h"
+#include "1base/scoped_ptr.h"
+#include "1os/file.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct JournalWriter {
+  JournalWriter()
+    : file(0), offset(0), fsync(false), busy(false), stop(false), error(0),
+      submitted_position(0), durable_position(0), count_writes(0),
+      write_latency_us(0), max_write_latency_us(0) {
+    thread.reset(new Thread(boost::bind(&JournalWriter::run, this)));
+  }
+
+  // Writes the pending buffer, then joins the thread
+  ~JournalWriter() {
+    {
+      ScopedLock lock(mutex);
+      stop = true;
+    }
+    cond.notify_all();
+    thread->join();
+  }
+
+  // Hands |buffer| over to the writer thread, which writes it to |file_|
+  // at |offset_|, and returns an empty buffer in its place. Blocks only if
+  // the previously submitted buffer was not yet written. Returns the
+  // position of the last submitted byte.
+  uint64_t submit(ByteArray &buffer, File *file_, uint64_t offset_,
+                  bool fsync_) {
+    ScopedLock lock(mutex);
+    while (busy)
+      cond.wait(lock);
+    throw_if_failed();
+
+    back.swap(buffer);
+    buffer.set_size(0);
+    file = file_;
+    offset = offset_;
+    fsync = fsync_;
+    submitted_position += back.size();
+    busy = true;
+    cond.notify_all();
+    return submitted_position;
+  }
+
+  // Blocks till all bytes up to |position| were written
+  void wait(uint64_t position) {
+    ScopedLock lock(mutex);
+    while (durable_position < position && error == 0)
+      cond.wait(lock);
+    throw_if_failed();
+  }
+
+  // Blocks till all submitted buffers were written
+  void drain() {
+    ScopedLock lock(mutex);
+    while (busy)
+      cond.wait(lock);
+    throw_if_failed();
+  }
+
+  // Fills the metrics
+  void fill_metrics(ups_env_metrics_t *metrics) {
+    ScopedLock lock(mutex);
+    metrics->journal_queued_bytes = submitted_position - durable_position;
+    metrics->journal_writes = count_writes;
+    metrics->journal_write_latency_us = write_latency_us;
+    metrics->journal_max_write_latency_us = max_write_latency_us;
+  }
+
+  // Throws the error of a failed write; the caller must hold the mutex
+  void throw_if_failed() {
+    if (unlikely(error != 0))
+      throw Exception(error);
+  }
+
+  // The thread's main loop
+  void run() {
+    ScopedLock lock(mutex);
+    while (true) {
+      while (!busy && !stop)
+        cond.wait(lock);
+      if (!busy)
+        break;
+
+      // the buffer is not modified by other threads while |busy| is set
+      lock.unlock();
+      boost::posix_time::ptime start
+              = boost::posix_time::microsec_clock::universal_time();
+      ups_status_t st = 0;
+      try {
+        file->pwrite(offset, back.data(), back.size());
+        if (fsync)
+          file->flush();
+      }
+      catch (Exception &ex) {
+        st = ex.code;
+      }
+      uint64_t latency = (boost::posix_time::microsec_clock::universal_time()
+                          - start).total_microseconds();
+      lock.lock();
+
+      count_writes++;
+      write_latency_us += latency;
+      if (latency > max_write_latency_us)
+        max_write_latency_us = latency;
+      if (unlikely(st != 0))
+        error = st;
+      else
+        durable_position = submitted_position;
+      back.set_size(0);
+      busy = false;
+      cond.notify_all();
+    }
+  }
+
+  // Protects the members below
+  Mutex mutex;
+
+  // Signals changes of |busy| and |stop|
+  Condition cond;
+
+  // The buffer which is currently written
+  ByteArray back;
+
+  // The file which |back| is written to
+  File *file;
+
+  // The file offset of |back|
+  uint64_t offset;
+
+  // True if the file is fsync'ed after writing |back|
+  bool fsync;
+
+  // True while |back| is written
+  bool busy;
+
+  // Set to true to stop the thread
+  bool stop;
+
+  // The error of a failed write; the writer does not write any further
+  // data after an error
+  ups_status_t error;
+
+  // Position of the last byte that was submitted
+  uint64_t submitted_position;
+
+  // Position of the last byte that was written
+  uint64_t durable_position;
+
+  // Number of writes (for ups_env_get_metrics)
+  uint64_t count_writes;
+
+  // Accumulated latency of all writes, in microseconds
+  uint64_t write_latency_us;
+
+  // Maximum latency of a single write, in microseconds
+  uint64_t max_write_latency_us;
+
+  // The thread
+  ScopedPtr<Thread> thread;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_JOURNAL_WRITER_H */
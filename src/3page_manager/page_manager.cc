@@ -120,6 +120,63 @@ add_to_changeset(Changeset *changeset, Page *page)
   return page;
 }
 
+static inline bool
+has_slab_pages(PageManagerState *state)
+{
+  for (int i = 0; i < PageManagerState::kSlabIndexLength; i++)
+    if (state->slab_index[i])
+      return true;
+  return false;
+}
+
+// Remembers the on-disk size of a compressed page before it is removed
+// from the cache
+static inline void
+store_disk_size(PageManagerState *state, Page *page)
+{
+  if (!state->config.page_compressor)
+    return;
+
+  uint64_t index = page->address() / state->config.page_size_bytes;
+  uint32_t units = (page->disk_size() + PageManagerState::kDiskSizeUnit - 1)
+                        / PageManagerState::kDiskSizeUnit;
+  if (units > 0xffff)
+    units = 0;
+
+  if (index >= state->disk_sizes.size()) {
+    if (units == 0)
+      return;
+    state->disk_sizes.resize(index + 1);
+  }
+  state->disk_sizes[index] = (uint16_t)units;
+}
+
+// Creates a new Page object and fetches it from the compressed cache or
+// from disk; if the page is compressed on disk and its size is known then
+// only the compressed data is read
+static inline Page *
+fetch_from_disk(PageManagerState *state, Context *context, uint64_t address,
+                uint32_t flags)
+{
+  Page *page = new Page(state->device, context->db);
+  page->set_without_header(ISSET(flags, PageManager::kNoHeader));
+
+  uint64_t index = address / state->config.page_size_bytes;
+  if (index < state->disk_sizes.size())
+    page->set_disk_size(state->disk_sizes[index]
+                            * PageManagerState::kDiskSizeUnit);
+
+  try {
+    if (!state->compressed_cache.get(address, page))
+      page->fetch(address);
+  }
+  catch (Exception &ex) {
+    delete page;
+    throw ex;
+  }
+  return page;
+}
+
 static inline uint64_t
 store_state_impl(PageManagerState *state, Context *context)
 {
@@ -130,7 +187,8 @@ store_state_impl(PageManagerState *state, Context *context)
   state->needs_flush = false;
 
   // no freelist pages, no freelist state? then don't store anything
-  if (!state->state_page && state->freelist.empty())
+  if (!state->state_page && state->freelist.empty()
+          && !has_slab_pages(state))
     return 0;
 
   // otherwise allocate a new page, if required
@@ -153,6 +211,10 @@ store_state_impl(PageManagerState *state, Context *context)
   *(uint64_t *)p = state->last_blob_page_id;
   p += sizeof(uint64_t);
 
+  // store the index of the slab pages
+  ::memcpy(p, &state->slab_index[0], sizeof(state->slab_index));
+  p += sizeof(state->slab_index);
+
   // reset the overflow pointer and the counter
   // TODO here we lose a whole chain of overflow pointers if there was such
   // a chain. We only save the first. That's not critical but also not nice.
@@ -175,7 +237,7 @@ store_state_impl(PageManagerState *state, Context *context)
   continuation.second = state->freelist.free_pages.end();
   do {
     int offset = page == state->state_page
-                      ? sizeof(uint64_t)
+                      ? PageManagerState::kStateHeaderSize
                       : 0;
     continuation = state->freelist.encode_state(continuation,
                             page->payload() + offset,
@@ -248,15 +310,7 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
           || ISSET(state->config.flags, UPS_IN_MEMORY))
     return 0;
 
-  page = new Page(state->device, context->db);
-  try {
-    page->fetch(address);
-  }
-  catch (Exception &ex) {
-    delete page;
-    throw ex;
-  }
-
+  page = fetch_from_disk(state, context, address, flags);
   assert(page->data());
 
   /* store the page in the list */
@@ -299,8 +353,7 @@ alloc_unlocked(PageManagerState *state, Context *context, uint32_t page_type,
       if (page)
         goto done;
       /* otherwise fetch the page from disk */
-      page = new Page(state->device, context->db);
-      page->fetch(address);
+      page = fetch_from_disk(state, context, address, 0);
       goto done;
     }
   }
@@ -369,12 +422,13 @@ done:
 PageManagerState::PageManagerState(LocalEnv *_env)
   : env(_env), config(_env->config), header(_env->header.get()),
     device(_env->device.get()), lsn_manager(&_env->lsn_manager),
-    cache(_env->config), freelist(config), needs_flush(false),
+    cache(_env->config), compressed_cache(_env->config), freelist(config), needs_flush(false),
     state_page(0), last_blob_page(0), last_blob_page_id(0),
     page_count_fetched(0), page_count_index(0), page_count_blob(0),
     page_count_page_manager(0), cache_hits(0), cache_misses(0), message(0),
     worker(new WorkerPool(1))
 {
+  ::memset(slab_index, 0, sizeof(slab_index));
 }
 
 PageManagerState::~PageManagerState()
@@ -403,15 +457,18 @@ PageManager::initialize(uint64_t pageid)
 
   Page *page = state->state_page;
 
-  // the first page stores the page ID of the last blob
+  // the first page stores the page ID of the last blob, followed by the
+  // index of the slab pages
   state->last_blob_page_id = *(uint64_t *)page->payload();
+  ::memcpy(&state->slab_index[0], page->payload() + sizeof(uint64_t),
+                  sizeof(state->slab_index));
 
   while (1) {
     assert(page->type() == Page::kTypePageManager);
     uint8_t *p = page->payload();
-    // skip state->last_blob_page_id?
+    // skip state->last_blob_page_id and state->slab_index?
     if (page == state->state_page)
-      p += sizeof(uint64_t);
+      p += PageManagerState::kStateHeaderSize;
 
     // get the overflow address
     uint64_t overflow = *(uint64_t *)p;
@@ -502,7 +559,15 @@ PageManager::fill_metrics(ups_env_metrics_t *metrics) const
   metrics->page_count_type_page_manager = state->page_count_page_manager;
   metrics->freelist_hits = state->freelist.freelist_hits;
   metrics->freelist_misses = state->freelist.freelist_misses;
+  for (int i = 0; i < PageManagerState::kSlabIndexLength; i++)
+    if (state->slab_index[i])
+      metrics->blob_slab_pages_with_free_space++;
+  metrics->page_bytes_before_compression =
+          state->device->page_bytes_before_compression;
+  metrics->page_bytes_after_compression =
+          state->device->page_bytes_after_compression;
   state->cache.fill_metrics(metrics);
+  state->compressed_cache.fill_metrics(metrics);
 }
 
 struct FlushAllPagesVisitor
@@ -584,7 +649,9 @@ PageManager::purge_cache(Context *context)
     Page *page = *it;
     if (likely(page->mutex().try_lock())) {
       assert(page->cursor_list.is_empty());
+      store_disk_size(state.get(), page);
       state->cache.del(page);
+      state->compressed_cache.put(page);
       page->mutex().unlock();
       delete page;
     }
@@ -620,6 +687,10 @@ PageManager::reclaim_space(Context *context)
 
     do_truncate = true;
     file_size = address;
+
+    if (state->disk_sizes.size() > file_size / page_size)
+      state->disk_sizes.resize(file_size / page_size);
+    state->compressed_cache.truncate(file_size);
   }
 
   if (do_truncate) {
@@ -684,7 +755,9 @@ PageManager::close_database(Context *context, LocalDb *db)
   for (std::vector<Page *>::iterator it = visitor.pages.begin();
           it != visitor.pages.end();
           it++) {
+    store_disk_size(state.get(), *it);
     state->cache.del(*it);
+    state->compressed_cache.del((*it)->address());
     // TODO Journal/recoverFromRecoveryTest fails because pages are still
     // locked; make sure that they're unlocked before they are deleted
     (*it)->mutex().try_lock();
@@ -713,6 +786,11 @@ PageManager::del(Context *context, Page *page, size_t page_count)
     }
   }
 
+  // the pages will be overwritten; drop their compressed images
+  for (size_t i = 0; i < page_count; i++)
+    state->compressed_cache.del(page->address()
+                    + i * state->config.page_size_bytes);
+
   state->needs_flush = true;
   state->freelist.put(page->address(), page_count);
   assert(page->address() % state->config.page_size_bytes == 0);
@@ -811,6 +889,61 @@ PageManager::set_last_blob_page_id(uint64_t id)
   state->last_blob_page = 0;
 }
 
+uint64_t
+PageManager::slab_page_id(int size_class)
+{
+  ScopedSpinlock lock(state->mutex);
+  for (int i = 0; i < PageManagerState::kSlabIndexLength; i++) {
+    uint64_t entry = state->slab_index[i];
+    if (entry && (int)(entry & PageManagerState::kSlabClassMask) == size_class)
+      return entry & ~(uint64_t)PageManagerState::kSlabClassMask;
+  }
+  return 0;
+}
+
+void
+PageManager::add_slab_page(uint64_t page_id, int size_class)
+{
+  assert(page_id % state->config.page_size_bytes == 0);
+  assert(size_class > 0 && size_class <= PageManagerState::kSlabClassMask);
+
+  ScopedSpinlock lock(state->mutex);
+  int slot = -1;
+  for (int i = 0; i < PageManagerState::kSlabIndexLength; i++) {
+    uint64_t entry = state->slab_index[i];
+    if (entry == 0) {
+      if (slot == -1)
+        slot = i;
+      continue;
+    }
+    if ((entry & ~(uint64_t)PageManagerState::kSlabClassMask) == page_id)
+      return;
+  }
+
+  // index is full? then this page is not tracked; it will be re-added as
+  // soon as another blob is erased from it
+  if (slot == -1)
+    return;
+
+  state->slab_index[slot] = page_id | size_class;
+  state->needs_flush = true;
+}
+
+void
+PageManager::remove_slab_page(uint64_t page_id)
+{
+  ScopedSpinlock lock(state->mutex);
+  for (int i = 0; i < PageManagerState::kSlabIndexLength; i++) {
+    uint64_t entry = state->slab_index[i];
+    if (entry
+        && (entry & ~(uint64_t)PageManagerState::kSlabClassMask) == page_id) {
+      state->slab_index[i] = 0;
+      state->needs_flush = true;
+      return;
+    }
+  }
+}
+
 Page *
 PageManager::try_lock_purge_candidate(uint64_t address)
 {
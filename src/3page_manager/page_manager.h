@@ -137,6 +137,17 @@ struct PageManager
   // Required by the BlobManager.
   void set_last_blob_page_id(uint64_t id);
 
+  // Returns the id of a blob page of |size_class| with free slots, or 0.
+  // Required by the BlobManager
+  uint64_t slab_page_id(int size_class);
+
+  // Adds a blob page with free slots to the index of slab pages. Does
+  // nothing if the page is already indexed or if the index is full.
+  void add_slab_page(uint64_t page_id, int size_class);
+
+  // Removes a blob page from the index of slab pages
+  void remove_slab_page(uint64_t page_id);
+
   // Fetches a page from the cache, locks it, then returns it.
   // This method is used by the worker thread to fetch purge candidates.
   // Returns NULL if the page cannot be purged (i.e. because it cannot
@@ -30,12 +30,14 @@
 
 #include "0root/root.h"
 
+#include <vector>
 #include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/spinlock.h"
 #include "2config/env_config.h"
 #include "3cache/cache.h"
+#include "3cache/compressed_cache.h"
 #include "3page_manager/freelist.h"
 
 #ifndef UPS_ROOT_H
@@ -56,6 +58,22 @@ struct WorkerPool;
  * The internal state of the PageManager
  */
 struct PageManagerState {
+  enum {
+    // Capacity of the index of slab pages with free space
+    kSlabIndexLength = 32,
+
+    // Size of the persisted header at the beginning of the state page
+    // (|last_blob_page_id| and |slab_index|)
+    kStateHeaderSize = sizeof(uint64_t) * (1 + kSlabIndexLength),
+
+    // Mask for the size class in a |slab_index| entry; the page ids are
+    // always aligned to the page size, therefore the lower bits are unused
+    kSlabClassMask = 0xff,
+
+    // Granularity of the entries in |disk_sizes|
+    kDiskSizeUnit = 16
+  };
+
   // constructor
   PageManagerState(LocalEnv *env);
 
@@ -83,6 +101,9 @@ struct PageManagerState {
   // The cache
   Cache cache;
 
+  // The compressed secondary cache for evicted pages
+  CompressedCache compressed_cache;
+
   // The freelist
   Freelist freelist;
 
@@ -99,6 +120,16 @@ struct PageManagerState {
   // Page where to add more blobs - if |m_last_blob_page| was flushed
   uint64_t last_blob_page_id;
 
+  // Blob pages of a size class with free slots; each entry is the page id,
+  // OR'd with the size class in the lower bits. 0 is an unused entry.
+  uint64_t slab_index[kSlabIndexLength];
+
+  // The on-disk sizes of compressed pages which were removed from the
+  // cache, in units of kDiskSizeUnit bytes, indexed by page number. 0 if
+  // the page is not compressed or if the size is unknown. When fetching
+  // the page, only this many bytes are read from disk.
+  std::vector<uint16_t> disk_sizes;
+
   // tracks number of fetched pages
   uint64_t page_count_fetched;
 
@@ -21,6 +21,7 @@
 
 #include "0root/root.h"
 
+#include "1base/dynamic_array.h"
 #include "3changeset/changeset.h"
 
 namespace upscaledb {
@@ -32,7 +33,8 @@ struct LocalEnv;
 
 struct Context {
   Context(LocalEnv *env, LocalTxn *txn = 0, LocalDb *db = 0)
-    : txn(txn), db(db), changeset(env) {
+    : txn(txn), db(db), changeset(env), scan_key_arena(0),
+      scan_record_arena(0) {
   }
 
   ~Context() {
@@ -44,6 +46,12 @@ struct Context {
 
   // Each operation has its own changeset which stores all locked pages
   Changeset changeset;
+
+  // Optional memory for the Btree scans; if null then the arenas of the
+  // Database are used. Required by parallel scans, which run on
+  // several threads.
+  ByteArray *scan_key_arena;
+  ByteArray *scan_record_arena;
 };
 
 } // namespace upscaledb
@@ -950,6 +950,10 @@ LocalCursor::move(Context *context, ups_key_t *key, ups_record_t *record,
 {
   ups_status_t st = 0;
 
+  // UPS_PARTIAL only affects the retrieval of the record, not the movement
+  uint32_t record_flags = flags & UPS_PARTIAL;
+  flags &= ~UPS_PARTIAL;
+
   // no movement requested? directly retrieve key/record
   if (unlikely(!flags))
     goto retrieve_key_and_record;
@@ -958,7 +962,7 @@ LocalCursor::move(Context *context, ups_key_t *key, ups_record_t *record,
   if (NOTSET(ldb(this)->flags(), UPS_ENABLE_TRANSACTIONS)) {
     st = btree_cursor.move(context, key, &ldb(this)->key_arena(context->txn),
                            record, &ldb(this)->record_arena(context->txn),
-                           flags);
+                           flags | record_flags);
     if (likely(st == 0))
       activate_btree();
     return st;
@@ -1020,12 +1024,12 @@ retrieve_key_and_record:
     if (likely(key != 0))
       txn_cursor.copy_coupled_key(key);
     if (likely(record != 0))
-      txn_cursor.copy_coupled_record(record);
+      txn_cursor.copy_coupled_record(record, record_flags);
     return 0;
   }
 
   return btree_cursor.move(context, key, &db->key_arena(txn),
-                  record, &db->record_arena(txn), 0);
+                  record, &db->record_arena(txn), record_flags);
 }
 
 ups_status_t
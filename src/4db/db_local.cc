@@ -18,7 +18,12 @@
 
 #include "0root/root.h"
 
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+
 // Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+#include "1base/record_window.h"
 #include "1globals/callbacks.h"
 #include "3page_manager/page_manager.h"
 #include "3journal/journal.h"
@@ -42,7 +47,17 @@ namespace upscaledb {
 
 enum {
   // The default threshold for inline records
-  kInlineRecordThreshold = 32
+  kInlineRecordThreshold = 32,
+
+  // The default number of samples for training a dictionary
+  kDefaultDictionarySamples = 1000,
+
+  // The default size of a trained dictionary
+  kDefaultDictionarySize = 16 * 1024,
+
+  // The number of partitions per thread for parallel scans; smaller
+  // partitions balance the load if some ranges are more expensive
+  kScanPartitionsPerThread = 4
 };
 
 // Returns the LocalEnv instance
@@ -53,18 +68,21 @@ lenv(LocalDb *db)
 }
 
 static inline void
-copy_record(LocalDb *db, Txn *txn, TxnOperation *op, ups_record_t *record)
+copy_record(LocalDb *db, Txn *txn, TxnOperation *op, ups_record_t *record,
+                uint32_t flags)
 {
   ByteArray *arena = &db->record_arena(txn);
+  RecordWindow window(record, op->record.size, flags);
 
-  record->size = op->record.size;
+  record->size = window.size;
 
   if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
     arena->resize(record->size);
     record->data = arena->data();
   }
   if (likely(op->record.data != 0))
-    ::memcpy(record->data, op->record.data, record->size);
+    ::memcpy(record->data, (uint8_t *)op->record.data + window.offset,
+                    record->size);
 }
 
 static inline void
@@ -353,7 +371,7 @@ retry:
           break;
         // otherwise copy the record and return
         if (likely(record != 0))
-          copy_record(db, context->txn, op, record);
+          copy_record(db, context->txn, op, record, flags);
         return 0;
       }
 
@@ -448,7 +466,7 @@ retry:
         cursor->activate_txn(op);
       copy_key(db, context->txn, &copy, key);
       if (likely(record != 0))
-        copy_record(db, context->txn, op, record);
+        copy_record(db, context->txn, op, record, flags);
       return 0;
     }
 
@@ -491,7 +509,7 @@ retry:
         cursor->activate_txn(op);
       copy_key(db, context->txn, &copy, key);
       if (likely(record != 0))
-        copy_record(db, context->txn, op, record);
+        copy_record(db, context->txn, op, record, flags);
       return 0;
     }
   }
@@ -576,7 +594,7 @@ erase_txn(LocalDb *db, Context *context, ups_key_t *key, uint32_t flags,
     if (unlikely(st)) {
       if (node_created) {
         db->txn_index->remove(node);
-        delete node;
+        db->txn_index->release(node);
       }
       return st;
     }
@@ -726,7 +744,8 @@ LocalDb::create(Context *context, PBtreeHeader *btree_header)
 
   if (config.record_compressor) {
     record_compressor.reset(CompressorFactory::create(
-                                    config.record_compressor));
+                                    config.record_compressor,
+                                    config.compression_level));
   }
 
   // load the custom compare function?
@@ -762,6 +781,42 @@ fetch_record_number(Context *context, LocalDb *db)
   return 0;
 }
 
+// Creates a record compressor for the dictionary |data| and appends it
+// to the database's dictionary compressors
+static inline void
+add_dictionary(LocalDb *db, const uint8_t *data, uint32_t size)
+{
+  Compressor *compressor = CompressorFactory::create(
+                                    db->config.record_compressor,
+                                    db->config.compression_level);
+  // the destructor of LocalDb releases the compressor
+  db->record_dictionaries.push_back(compressor);
+  compressor->set_dictionary(data, size);
+}
+
+// Loads the database's dictionaries from the Environment's catalog
+static inline void
+load_dictionaries(Context *context, LocalDb *db)
+{
+  ByteArray catalog;
+  lenv(db)->read_dictionary_catalog(context, &catalog);
+
+  size_t offset = 0;
+  while (offset < catalog.size()) {
+    PDictionaryEntry *entry = (PDictionaryEntry *)(catalog.data() + offset);
+    if (entry->db_name == db->name()) {
+      // dictionaries are stored in the order of their ids
+      if (unlikely(entry->id != db->record_dictionaries.size() + 1)) {
+        ups_trace(("dictionary catalog is corrupt"));
+        throw Exception(UPS_INTEGRITY_VIOLATED);
+      }
+      add_dictionary(db, catalog.data() + offset + sizeof(PDictionaryEntry),
+                      entry->size);
+    }
+    offset += sizeof(PDictionaryEntry) + entry->size;
+  }
+}
+
 ups_status_t
 LocalDb::open(Context *context, PBtreeHeader *btree_header)
 {
@@ -790,7 +845,12 @@ LocalDb::open(Context *context, PBtreeHeader *btree_header)
   // is record compression enabled?
   if (config.record_compressor) {
     record_compressor.reset(CompressorFactory::create(
-                                    config.record_compressor));
+                                    config.record_compressor,
+                                    config.compression_level));
+
+    // load the trained dictionaries
+    if (lenv(this)->header->dictionary_blobid())
+      load_dictionaries(context, this);
   }
 
   // fetch the current record number
@@ -1008,7 +1068,7 @@ insert_txn(LocalDb *db, Context *context, ups_key_t *key, ups_record_t *record,
   if (unlikely(st)) {
     if (node_created) {
       db->txn_index->remove(node);
-      delete node;
+      db->txn_index->release(node);
     }
     return st;
   }
@@ -1236,11 +1296,11 @@ LocalDb::find(Cursor *hcursor, Txn *txn, ups_key_t *key,
       cursor->couple_to_duplicate(1); // 1-based index!
       if (likely(record != 0)) {
         if (cursor->is_txn_active())
-          cursor->txn_cursor.copy_coupled_record(record);
+          cursor->txn_cursor.copy_coupled_record(record, flags & UPS_PARTIAL);
         else {
           Txn *txn = cursor->txn;
           st = cursor->btree_cursor.move(&context, 0, 0, record,
-                        &record_arena(txn), 0);
+                        &record_arena(txn), flags & UPS_PARTIAL);
         }
       }
     }
@@ -1441,18 +1501,231 @@ are_cursors_identical(LocalCursor *c1, LocalCursor *c2)
   return k1 == k2;
 }
 
+// Returns true if a full scan of |db| can be performed by several threads.
+// The scan must not read blobs (which are not thread-safe) and must not
+// merge transactional keys
+static bool
+is_parallel_scan_possible(LocalDb *db, SelectStatement *stmt,
+                ScanVisitor *visitor)
+{
+  if (lenv(db)->config.uqi_threads <= 1 || !visitor->supports_merge())
+    return false;
+  if (ISSET(db->config.flags, UPS_ENABLE_DUPLICATES))
+    return false;
+  if (stmt->requires_keys && db->config.key_size == UPS_KEY_SIZE_UNLIMITED)
+    return false;
+  if (stmt->requires_records
+        && NOTSET(db->config.flags, UPS_FORCE_RECORDS_INLINE))
+    return false;
+  if (db->txn_index.get() && db->txn_index->first() != 0)
+    return false;
+  return true;
+}
+
+// Collects the addresses of the leaf pages (from left to right) by
+// reading the internal nodes. Returns false if the root page is a leaf.
+static bool
+collect_leaf_pages(LocalDb *db, std::vector<uint64_t> *leaves)
+{
+  // the pages are unlocked when |context| goes out of scope; otherwise
+  // the threads would block when fetching them
+  Context context(lenv(db), 0, db);
+  BtreeIndex *btree = db->btree_index.get();
+  PageManager *page_manager = lenv(db)->page_manager.get();
+
+  Page *page = btree->root_page(&context);
+  if (btree->get_node_from_page(page)->is_leaf())
+    return false;
+
+  std::vector<uint64_t> nodes(1, page->address());
+  while (true) {
+    std::vector<uint64_t> children;
+    for (std::vector<uint64_t>::iterator it = nodes.begin();
+                    it != nodes.end(); it++) {
+      page = page_manager->fetch(&context, *it, PageManager::kReadOnly);
+      BtreeNodeProxy *node = btree->get_node_from_page(page);
+      children.push_back(node->left_child());
+      for (int i = 0; i < (int)node->length(); i++)
+        children.push_back(node->record_id(&context, i));
+    }
+
+    nodes.swap(children);
+
+    // all leaves are on the same level
+    page = page_manager->fetch(&context, nodes[0], PageManager::kReadOnly);
+    if (btree->get_node_from_page(page)->is_leaf())
+      break;
+  }
+
+  leaves->swap(nodes);
+  return true;
+}
+
+// Returns true if the statement filters keys or records by value ranges
+static inline bool
+has_ranges(SelectStatement *stmt)
+{
+  return stmt->key_range.is_set() || stmt->record_range.is_set();
+}
+
+// Returns true if the leaf with the |zone| can store keys or records
+// which are in the ranges of |stmt|
+static inline bool
+is_zone_selected(LocalDb *db, SelectStatement *stmt, const BtreeZone &zone)
+{
+  if (zone.is_empty)
+    return false;
+  if (zone.has_key_bounds
+        && !stmt->key_range.intersects(db->config.key_type,
+                    zone.min_key, zone.max_key))
+    return false;
+  if (zone.has_record_bounds
+        && !stmt->record_range.intersects(db->config.record_type,
+                    zone.min_record, zone.max_record))
+    return false;
+  return true;
+}
+
+// Returns true if the (already fetched) leaf |page| can store keys or
+// records which are in the ranges of |stmt|. Calculates the zone of the
+// leaf if it is unknown.
+static bool
+is_leaf_selected(Context *context, LocalDb *db, SelectStatement *stmt,
+                Page *page)
+{
+  if (!has_ranges(stmt))
+    return true;
+
+  BtreeZoneMap *zone_map = db->btree_index->zone_map();
+  BtreeZone zone;
+  if (!zone_map->get(page->address(), &zone)) {
+    db->btree_index->get_node_from_page(page)->calc_zone(context, &zone);
+    zone_map->put(page->address(), zone);
+  }
+  return is_zone_selected(db, stmt, zone);
+}
+
+// Fetches the leaf at |address|. Returns null if the leaf does not store
+// any key or record in the ranges of |stmt|; if its zone is known then the
+// leaf is not fetched at all
+static Page *
+fetch_leaf(Context *context, LocalDb *db, SelectStatement *stmt,
+                uint64_t address)
+{
+  BtreeZone zone;
+  if (has_ranges(stmt)
+        && db->btree_index->zone_map()->get(address, &zone)
+        && !is_zone_selected(db, stmt, zone))
+    return 0;
+
+  Page *page = lenv(db)->page_manager->fetch(context, address,
+                  PageManager::kReadOnly);
+  return is_leaf_selected(context, db, stmt, page) ? page : 0;
+}
+
+// A parallel scan over all leaf pages. The leaves are split in
+// partitions, and each partition is scanned by a separate ScanVisitor.
+// The threads pick the next unprocessed partition.
+struct ParallelScan {
+  ParallelScan(LocalDb *db_, SelectStatement *stmt_,
+                  std::vector<uint64_t> &leaves_, size_t num_partitions)
+    : db(db_), stmt(stmt_), leaves(leaves_), next(0), status(0) {
+    for (size_t i = 0; i < num_partitions; i++)
+      visitors.push_back(ScanVisitorFactory::from_select(stmt, db));
+  }
+
+  ~ParallelScan() {
+    for (size_t i = 0; i < visitors.size(); i++)
+      delete visitors[i];
+  }
+
+  // The thread function
+  void run() {
+    Context context(lenv(db), 0, db);
+    ByteArray key_arena;
+    ByteArray record_arena;
+    context.scan_key_arena = &key_arena;
+    context.scan_record_arena = &record_arena;
+
+    BtreeIndex *btree = db->btree_index.get();
+    size_t num_partitions = visitors.size();
+
+    try {
+      size_t p;
+      while ((p = next++) < num_partitions && status == 0) {
+        size_t begin = p * leaves.size() / num_partitions;
+        size_t end = (p + 1) * leaves.size() / num_partitions;
+        for (size_t i = begin; i < end; i++) {
+          Page *page = fetch_leaf(&context, db, stmt, leaves[i]);
+          if (page) {
+            BtreeNodeProxy *node = btree->get_node_from_page(page);
+            if (node->length() > 0)
+              node->scan(&context, visitors[p], stmt, 0, stmt->distinct);
+          }
+          context.changeset.clear();
+        }
+      }
+    }
+    catch (Exception &ex) {
+      ScopedLock lock(mutex);
+      if (status == 0)
+        status = ex.code;
+    }
+  }
+
+  // Scans the partitions with |num_threads| threads (including the
+  // calling thread), then merges the partial results into |visitor|
+  ups_status_t execute(size_t num_threads, ScanVisitor *visitor) {
+    for (size_t i = 0; i < visitors.size(); i++) {
+      if (!visitors[i])
+        return UPS_PARSER_ERROR;
+    }
+
+    std::vector<Thread *> threads;
+    for (size_t i = 1; i < num_threads; i++)
+      threads.push_back(new Thread(boost::bind(&ParallelScan::run, this)));
+    run();
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+
+    if (status)
+      return status;
+
+    // merge in the order of the keys
+    for (size_t i = 0; i < visitors.size(); i++)
+      visitor->merge(visitors[i]);
+    return 0;
+  }
+
+  // The database
+  LocalDb *db;
+
+  // The select statement
+  SelectStatement *stmt;
+
+  // The addresses of all leaf pages
+  std::vector<uint64_t> &leaves;
+
+  // One visitor per partition
+  std::vector<ScanVisitor *> visitors;
+
+  // The next partition which is scanned
+  boost::atomic<size_t> next;
+
+  // The first error of a thread
+  boost::atomic<ups_status_t> status;
+
+  // Protects |status|
+  Mutex mutex;
+};
+
 ups_status_t
 LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
                 LocalCursor *end, Result **presult)
 {
-  Page *page = 0;
-  int slot;
-  ups_key_t key = {0};
-  ups_record_t record = {0};
-  ScopedPtr<LocalCursor> tmpcursor;
- 
-  LocalCursor *cursor = begin;
-  if (unlikely(cursor && cursor->is_nil()))
+  if (unlikely(begin && begin->is_nil()))
     return UPS_CURSOR_IS_NIL;
 
   if (unlikely(end && end->is_nil()))
@@ -1464,17 +1737,131 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
 
   Context context(lenv(this), 0, this);
 
-  Result *result = new Result;
-
   // purge cache if necessary
   lenv(this)->page_manager->purge_cache(&context);
 
+  ups_status_t st = scan(&context, stmt, visitor.get(), begin, end, 0);
+  if (unlikely(st && st != UPS_KEY_NOT_FOUND))
+    return st;
+
+  // now fetch the results
+  Result *result = new Result;
+  visitor->assign_result((uqi_result_t *)result);
+
+  *presult = result;
+  return 0;
+}
+
+ups_status_t
+LocalDb::scan(Context *context, SelectStatement *stmt, ScanVisitor *visitor,
+                LocalCursor *begin, LocalCursor *end, size_t max_leaves)
+{
+  Page *page = 0;
+  int slot;
+  size_t leaves = 0;
+  ups_key_t key = {0};
+  ups_record_t record = {0};
+  ScopedPtr<LocalCursor> tmpcursor;
+  ScopedPtr<LocalCursor> tmpend;
+  uint8_t lower_key[sizeof(uint64_t)];
+
+  // a nil |begin| cursor is positioned on the first key of the scan
+  LocalCursor *cursor = begin && !begin->is_nil() ? begin : 0;
+
+  ups_status_t st = UPS_KEY_NOT_FOUND;
+
+  // a range which can never match? then there's nothing to do
+  if (stmt->key_range.is_empty(config.key_type)
+        || stmt->record_range.is_empty(config.record_type))
+    goto bail;
+
+  // if the keys are limited by a range then seek to its bounds (unless
+  // cursors were specified). The bounds are conservative; keys outside of
+  // the range are removed by the RangeFilterScanVisitor.
+  // The end is positioned first because both lookups use the same arenas.
+  if (!end && stmt->key_range.has_upper) {
+    uint8_t buffer[sizeof(uint64_t)];
+    ups_key_t upper = ups_make_key(buffer,
+                    (uint16_t)from_numeric_value(config.key_type,
+                            stmt->key_range.upper, buffer));
+    // otherwise the bound exceeds the key type
+    if (upper.size > 0) {
+      ups_record_t unused = {0};
+      tmpend.reset(new LocalCursor(this, 0));
+      st = find(tmpend.get(), 0, &upper, &unused, UPS_FIND_GT_MATCH);
+      if (st == 0)
+        end = tmpend.get();
+      else if (st != UPS_KEY_NOT_FOUND)
+        goto bail;
+      st = UPS_KEY_NOT_FOUND;
+    }
+  }
+
+  if (!cursor && stmt->key_range.has_lower) {
+    key = ups_make_key(lower_key,
+                    (uint16_t)from_numeric_value(config.key_type,
+                            stmt->key_range.lower, lower_key));
+    // the bound exceeds the key type? then no key is in the range
+    if (key.size == 0)
+      goto bail;
+    if (!begin)
+      tmpcursor.reset(new LocalCursor(this, 0));
+    cursor = begin ? begin : tmpcursor.get();
+    st = find(cursor, 0, &key, &record, UPS_FIND_GEQ_MATCH);
+    if (unlikely(st))
+      goto bail;
+  }
+  // otherwise retrieve the current key and record of the caller's cursor;
+  // they're processed if the cursor is coupled to a transactional key
+  else if (cursor) {
+    st = cursor->move(context, &key, &record, 0);
+    if (unlikely(st))
+      goto bail;
+  }
+
+  // scan the whole database with several threads?
+  if (!begin && !end
+        && is_parallel_scan_possible(this, stmt, visitor)) {
+    std::vector<uint64_t> leaves;
+    if (collect_leaf_pages(this, &leaves)) {
+      size_t num_threads = std::min(leaves.size(),
+                      (size_t)lenv(this)->config.uqi_threads);
+      size_t num_partitions = std::min(leaves.size(),
+                      num_threads * kScanPartitionsPerThread);
+      ParallelScan scan(this, stmt, leaves, num_partitions);
+      st = scan.execute(num_threads, visitor);
+      if (st == 0)
+        st = UPS_KEY_NOT_FOUND;
+      goto bail;
+    }
+  }
+
+  // scan the whole database with value ranges? then walk the leaves and
+  // skip those which are not in the ranges
+  if (!begin && !end && has_ranges(stmt)
+        && !(txn_index.get() && txn_index->first() != 0)) {
+    std::vector<uint64_t> leaves;
+    if (collect_leaf_pages(this, &leaves)) {
+      for (std::vector<uint64_t>::iterator it = leaves.begin();
+                      it != leaves.end(); it++) {
+        page = fetch_leaf(context, this, stmt, *it);
+        if (page) {
+          BtreeNodeProxy *node = btree_index->get_node_from_page(page);
+          node->scan(context, visitor, stmt, 0, stmt->distinct);
+        }
+        context->changeset.clear();
+      }
+      st = UPS_KEY_NOT_FOUND;
+      goto bail;
+    }
+  }
+
   // create a cursor, move it to the first key
-  ups_status_t st = 0;
   if (!cursor) {
-    tmpcursor.reset(new LocalCursor(this, 0));
-    cursor = tmpcursor.get();
-    st = cursor->move(&context, &key, &record, UPS_CURSOR_FIRST);
+    if (!begin)
+      tmpcursor.reset(new LocalCursor(this, 0));
+    cursor = begin ? begin : tmpcursor.get();
+    st = cursor->move(context, &key, &record, UPS_CURSOR_FIRST);
     if (unlikely(st))
       goto bail;
   }
@@ -1482,11 +1869,13 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
   // process transactional keys at the beginning
   while (!cursor->is_btree_active()) {
     // check if we reached the 'end' cursor
-    if (unlikely(end && are_cursors_identical(cursor, end)))
+    if (unlikely(end && are_cursors_identical(cursor, end))) {
+      st = UPS_KEY_NOT_FOUND;
       goto bail;
+    }
     // now process the key
     (*visitor)(key.data, key.size, record.data, record.size);
-    st = cursor->move(&context, &key, 0, UPS_CURSOR_NEXT);
+    st = cursor->move(context, &key, 0, UPS_CURSOR_NEXT);
     if (unlikely(st))
       goto bail;
   }
@@ -1528,8 +1917,8 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
       }
       else {
         ups_key_t *k = end->txn_cursor.get_coupled_op()->node->key();
-        if (node->compare(&context, k, 0) >= 0
-            && node->compare(&context, k, node->length() - 1) <= 0)
+        if (node->compare(context, k, 0) >= 0
+            && node->compare(context, k, node->length() - 1) <= 0)
           use_cursors = true;
       }
     }
@@ -1547,8 +1936,8 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
         ups_key_t *txnkey = 0;
         if (tc.get_coupled_op())
           txnkey = tc.get_coupled_op()->node->key();
-        if (node->compare(&context, txnkey, 0) >= 0
-            && node->compare(&context, txnkey, node->length() - 1) <= 0)
+        if (node->compare(context, txnkey, 0) >= 0
+            && node->compare(context, txnkey, node->length() - 1) <= 0)
           use_cursors = true;
       }
     }
@@ -1556,21 +1945,32 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
     // no transactional data: the Btree will do the work. This is the
     // fastest code path
     if (use_cursors == false) {
-      node->scan(&context, visitor.get(), stmt, slot, stmt->distinct);
-      st = cursor->btree_cursor.move_to_next_page(&context);
+      if (is_leaf_selected(context, this, stmt, page))
+        node->scan(context, visitor, stmt, slot, stmt->distinct);
+      st = cursor->btree_cursor.move_to_next_page(context);
       if (unlikely(st == UPS_KEY_NOT_FOUND))
         break;
       if (unlikely(st))
         goto bail;
+      // interrupt the scan? then |cursor| points to the next leaf
+      if (unlikely(max_leaves && ++leaves >= max_leaves))
+        return 0;
     }
     // mixed txn/btree load? if there are leafs which are NOT modified
     // in a transaction then move the scan to the btree node. Otherwise use
     // a regular cursor
     else {
+      // the cursor might have been moved to this page without retrieving
+      // the key and record
+      st = cursor->move(context, &key, &record, 0);
+      if (unlikely(st))
+        goto bail;
       do {
         // check if we reached the 'end' cursor
-        if (unlikely(end && are_cursors_identical(cursor, end)))
+        if (unlikely(end && are_cursors_identical(cursor, end))) {
+          st = UPS_KEY_NOT_FOUND;
           goto bail;
+        }
 
         Page *new_page = 0;
         if (cursor->is_btree_active())
@@ -1582,32 +1982,155 @@ LocalDb::select_range(SelectStatement *stmt, LocalCursor *begin,
         }
         // process the key
         (*visitor)(key.data, key.size, record.data, record.size);
-        st = cursor->move(&context, &key, &record, UPS_CURSOR_NEXT);
+        st = cursor->move(context, &key, &record, UPS_CURSOR_NEXT);
       } while (st == 0);
+
+      // interrupt the scan? then |cursor| points to the next leaf
+      if (st == 0 && unlikely(max_leaves && ++leaves >= max_leaves))
+        return 0;
     }
 
-    if (unlikely(st == UPS_KEY_NOT_FOUND))
-      goto bail;
     if (unlikely(st))
-      return st;
+      goto bail;
   }
 
   // pick up the remaining transactional keys
-  while ((st = cursor->move(&context, &key, &record, UPS_CURSOR_NEXT)) == 0) {
+  while ((st = cursor->move(context, &key, &record, UPS_CURSOR_NEXT)) == 0) {
     // check if we reached the 'end' cursor
-    if (end && are_cursors_identical(cursor, end))
+    if (end && are_cursors_identical(cursor, end)) {
+      st = UPS_KEY_NOT_FOUND;
       goto bail;
+    }
 
     (*visitor)(key.data, key.size, record.data, record.size);
   }
 
 bail:
-  // now fetch the results
-  visitor->assign_result((uqi_result_t *)result);
+  return st;
+}
 
-  *presult = result;
+LocalSelectCursor::LocalSelectCursor(LocalDb *db_,
+                const SelectStatement &stmt, bool close_db_)
+  : SelectCursor(db_->env), db(db_), close_db(close_db_), is_done(false),
+    statement(stmt)
+{
+}
+
+LocalSelectCursor::~LocalSelectCursor()
+{
+  if (cursor.get()) {
+    db->remove_cursor(cursor.get());
+    if (cursor->txn)
+      cursor->txn->release();
+  }
+  if (end.get())
+    db->remove_cursor(end.get());
+  cursor.reset();
+  end.reset();
+
+  // Don't leak the database handle if it was opened for this cursor
+  if (close_db)
+    (void)ups_db_close((ups_db_t *)db, UPS_DONT_LOCK);
+}
+
+ups_status_t
+LocalSelectCursor::initialize(LocalCursor *begin, LocalCursor *end_)
+{
+  if (unlikely(begin && begin->is_nil()))
+    return UPS_CURSOR_IS_NIL;
+
+  if (unlikely(end_ && end_->is_nil()))
+    return UPS_CURSOR_IS_NIL;
+
+  visitor.reset(ScanVisitorFactory::from_select(&statement, db));
+  if (unlikely(!visitor.get()))
+    return UPS_PARSER_ERROR;
+
+  // the cursors are attached to the database, therefore they're updated
+  // if the database is modified between two chunks
+  cursor.reset(begin ? new LocalCursor(*begin) : new LocalCursor(db, 0));
+  cursor->previous = 0;
+  db->add_cursor(cursor.get());
+  if (cursor->txn)
+    cursor->txn->add_ref();
+  if (end_) {
+    end.reset(new LocalCursor(*end_));
+    end->previous = 0;
+    db->add_cursor(end.get());
+  }
+  return 0;
+}
+
+ups_status_t
+LocalSelectCursor::next(Result **presult)
+{
+  if (is_done)
+    return UPS_KEY_NOT_FOUND;
+
+  Result result;
+
+  while (true) {
+    // transactions which were committed since the previous chunk are not
+    // yet known to the cursor; look up its key again to pick them up
+    if (ISSET(db->flags(), UPS_ENABLE_TRANSACTIONS) && !cursor->is_nil()) {
+      ups_status_t st = resync();
+      if (st == UPS_KEY_NOT_FOUND) {
+        is_done = true;
+        visitor->assign_result((uqi_result_t *)&result);
+        if (result.row_count == 0)
+          return UPS_KEY_NOT_FOUND;
+        break;
+      }
+      if (unlikely(st))
+        return st;
+    }
 
-  return st == UPS_KEY_NOT_FOUND ? 0 : st;
+    Context context(lenv(db), 0, db);
+
+    // purge cache if necessary
+    lenv(db)->page_manager->purge_cache(&context);
+
+    ups_status_t st = db->scan(&context, &statement, visitor.get(),
+                    cursor.get(), end.get(), kLeavesPerChunk);
+
+    // the scan is complete; fetch the remaining rows (or the final result
+    // of an aggregation)
+    if (st == UPS_KEY_NOT_FOUND) {
+      is_done = true;
+      visitor->assign_result((uqi_result_t *)&result);
+      if (result.row_count == 0)
+        return UPS_KEY_NOT_FOUND;
+      break;
+    }
+    if (unlikely(st))
+      return st;
+
+    // otherwise return the rows of this chunk. Aggregating visitors
+    // only have a result when the scan is complete.
+    if (visitor->flush_rows((uqi_result_t *)&result) && result.row_count > 0)
+      break;
+  }
+
+  *presult = new Result;
+  (*presult)->move_from(result);
+  return 0;
+}
+
+ups_status_t
+LocalSelectCursor::resync()
+{
+  ups_key_t key = {0};
+  ups_status_t st = db->cursor_move(cursor.get(), &key, 0, 0);
+  if (unlikely(st))
+    return st;
+
+  // the key is copied because find() reuses the arena
+  ByteArray arena;
+  arena.append((uint8_t *)key.data, key.size);
+  key.data = arena.data();
+
+  ups_record_t record = {0};
+  return db->find(cursor.get(), 0, &key, &record, UPS_FIND_GEQ_MATCH);
 }
 
 ups_status_t
@@ -1684,4 +2207,104 @@ LocalDb::drop(Context *context)
   return 0;
 }
 
+LocalDb::~LocalDb()
+{
+  for (std::vector<Compressor *>::iterator it = record_dictionaries.begin();
+          it != record_dictionaries.end(); ++it)
+    delete *it;
+}
+
+ups_status_t
+LocalDb::train_dictionary(uint32_t sample_count, uint32_t dictionary_size)
+{
+  if (unlikely(!CompressorFactory::supports_dictionary(
+                            config.record_compressor))) {
+    ups_trace(("record compressor does not support dictionaries"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(ISSET(flags(), UPS_READ_ONLY))) {
+    ups_trace(("cannot train a dictionary in a read-only database"));
+    return UPS_WRITE_PROTECTED;
+  }
+  if (unlikely(record_dictionaries.size() == 0xffff)) {
+    ups_trace(("too many dictionaries"));
+    return UPS_LIMITS_REACHED;
+  }
+
+  if (sample_count == 0)
+    sample_count = kDefaultDictionarySamples;
+  if (dictionary_size == 0)
+    dictionary_size = kDefaultDictionarySize;
+
+  Context context(lenv(this), 0, this);
+
+  // purge cache if necessary
+  lenv(this)->page_manager->purge_cache(&context);
+
+  // pick every n'th record to spread the samples over the whole database
+  uint64_t total = count(0, false);
+  uint64_t stride = std::max(total / sample_count, (uint64_t)1);
+
+  ByteArray samples;
+  std::vector<size_t> sample_sizes;
+  ScopedPtr<LocalCursor> cursor(new LocalCursor(this, 0));
+  ups_record_t record = {0};
+  uint32_t move_flags = UPS_CURSOR_FIRST;
+  uint64_t skip = 0;
+
+  while (sample_sizes.size() < sample_count) {
+    ups_status_t st = cursor->move(&context, 0, skip ? 0 : &record,
+                            move_flags);
+    if (st == UPS_KEY_NOT_FOUND)
+      break;
+    if (unlikely(st))
+      return st;
+    move_flags = UPS_CURSOR_NEXT;
+
+    if (skip > 0) {
+      skip--;
+      continue;
+    }
+    skip = stride - 1;
+
+    if (record.size > 0) {
+      samples.append((uint8_t *)record.data, record.size);
+      sample_sizes.push_back(record.size);
+    }
+  }
+
+  if (unlikely(sample_sizes.empty())) {
+    ups_trace(("no records available for training a dictionary"));
+    return UPS_KEY_NOT_FOUND;
+  }
+
+  ByteArray dictionary;
+  CompressorFactory::train_dictionary(config.record_compressor, samples,
+                  sample_sizes, dictionary_size, &dictionary);
+
+  // persist the dictionary; in-memory databases only keep it in memory
+  if (NOTSET(env->flags(), UPS_IN_MEMORY)) {
+    ByteArray catalog;
+    lenv(this)->read_dictionary_catalog(&context, &catalog);
+
+    PDictionaryEntry entry;
+    entry.db_name = name();
+    entry.id = (uint16_t)(record_dictionaries.size() + 1);
+    entry.size = (uint32_t)dictionary.size();
+    catalog.append((uint8_t *)&entry, sizeof(entry));
+    catalog.append(dictionary.data(), dictionary.size());
+    lenv(this)->write_dictionary_catalog(&context, &catalog);
+  }
+
+  // from now on, all new records are compressed with this dictionary;
+  // existing records still use the dictionary they were compressed with
+  add_dictionary(this, dictionary.data(), (uint32_t)dictionary.size());
+
+  // force-flush the changeset
+  if (lenv(this)->journal)
+    context.changeset.flush(lenv(this)->lsn_manager.next());
+
+  return 0;
+}
+
 } // namespace upscaledb
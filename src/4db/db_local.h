@@ -22,6 +22,7 @@
 #include "0root/root.h"
 
 #include <limits>
+#include <vector>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/scoped_ptr.h"
@@ -33,6 +34,8 @@
 #include "4txn/txn_local.h"
 #include "4db/db.h"
 #include "4db/histogram.h"
+#include "4uqi/select_cursor.h"
+#include "4uqi/statements.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -46,7 +49,7 @@ struct TxnCursor;
 struct TxnOperation;
 struct LocalEnv;
 struct LocalTxn;
-struct SelectStatement;
+struct ScanVisitor;
 struct Result;
 
 //
@@ -59,6 +62,9 @@ struct LocalDb : public Db {
       histogram(this) {
   }
 
+  // Destructor; releases the dictionary compressors
+  ~LocalDb();
+
   // Creates a new database
   ups_status_t create(Context *context, PBtreeHeader *btree_header);
 
@@ -113,10 +119,48 @@ struct LocalDb : public Db {
   ups_status_t select_range(SelectStatement *stmt, LocalCursor *begin,
                   LocalCursor *end, Result **result);
 
+  // (Non-virtual) Passes the keys and records from |begin| till |end|
+  // to the |visitor|. If |begin| is nil then the scan starts with the first
+  // key, and |begin| is positioned there. If |max_leaves| is not 0 then
+  // the scan is interrupted after |max_leaves| leaf pages; it returns 0,
+  // and |begin| points to the first key which was not yet visited.
+  // Returns UPS_KEY_NOT_FOUND if the scan is complete.
+  ups_status_t scan(Context *context, SelectStatement *stmt,
+                  ScanVisitor *visitor, LocalCursor *begin, LocalCursor *end,
+                  size_t max_leaves);
+
   // Flushes a TxnOperation to the btree
   ups_status_t flush_txn_operation(Context *context, LocalTxn *txn,
                   TxnOperation *op);
 
+  // Samples up to |sample_count| records and trains a new dictionary
+  // for the record compressor (ups_db_train_dictionary)
+  ups_status_t train_dictionary(uint32_t sample_count,
+                  uint32_t dictionary_size);
+
+  // Returns the compressor for new records; it uses the most recently
+  // trained dictionary (if there is one). Can return null.
+  Compressor *current_record_compressor() {
+    return record_dictionaries.empty()
+              ? record_compressor.get()
+              : record_dictionaries.back();
+  }
+
+  // Returns the id of the dictionary used by current_record_compressor()
+  uint16_t current_dictionary_id() const {
+    return (uint16_t)record_dictionaries.size();
+  }
+
+  // Returns the compressor for records which were compressed with
+  // dictionary |id| (0: without dictionary)
+  Compressor *record_compressor_for(uint16_t id) {
+    if (likely(id == 0))
+      return record_compressor.get();
+    if (unlikely(id > record_dictionaries.size()))
+      throw Exception(UPS_INTEGRITY_VIOLATED);
+    return record_dictionaries[id - 1];
+  }
+
   // the btree index
   ScopedPtr<BtreeIndex> btree_index;
 
@@ -129,6 +173,10 @@ struct LocalDb : public Db {
   // The record compressor; can be null
   ScopedPtr<Compressor> record_compressor;
 
+  // Record compressors with trained dictionaries; the compressor at
+  // index i uses the dictionary with id i + 1
+  std::vector<Compressor *> record_dictionaries;
+
   // the current record number
   uint64_t _current_record_number;
 
@@ -136,6 +184,59 @@ struct LocalDb : public Db {
   Histogram histogram;
 };
 
+//
+// A UQI cursor for a local database (uqi_cursor_t). Each chunk scans a few
+// leaf pages; the scan position and the visitor are kept between the
+// chunks.
+//
+struct LocalSelectCursor : public SelectCursor {
+  enum {
+    // The number of leaf pages which are scanned for a chunk
+    kLeavesPerChunk = 8
+  };
+
+  // Constructor; if |close_db_| is true then the database is closed
+  // when the cursor is closed
+  LocalSelectCursor(LocalDb *db_, const SelectStatement &stmt,
+                  bool close_db_);
+
+  // Destructor
+  virtual ~LocalSelectCursor();
+
+  // Creates the visitor and the cursors; |begin| and |end| are optional
+  // and are cloned
+  ups_status_t initialize(LocalCursor *begin, LocalCursor *end);
+
+  // Retrieves the next chunk of rows
+  virtual ups_status_t next(Result **result);
+
+  // Positions the cursor on its current key (or the next one, if the key
+  // was erased) to couple it to transactional keys which were inserted
+  // since the previous chunk
+  ups_status_t resync();
+
+  // The database
+  LocalDb *db;
+
+  // True if the database is closed with the cursor
+  bool close_db;
+
+  // True if the scan is complete
+  bool is_done;
+
+  // The query; the visitor stores a pointer to it
+  SelectStatement statement;
+
+  // The visitor; it is kept alive for all chunks
+  ScopedPtr<ScanVisitor> visitor;
+
+  // The current position of the scan; nil before the first chunk
+  ScopedPtr<LocalCursor> cursor;
+
+  // The end of the scan (optional)
+  ScopedPtr<LocalCursor> end;
+};
+
 } // namespace upscaledb
 
 #endif /* UPS_DB_LOCAL_H */
@@ -284,6 +284,11 @@ RemoteDb::find(Cursor *hcursor, Txn *htxn, ups_key_t *key,
 {
   RemoteCursor *cursor = (RemoteCursor *)hcursor;
 
+  if (unlikely(ISSET(flags, UPS_PARTIAL))) {
+    ups_trace(("flag UPS_PARTIAL is not supported by remote databases"));
+    return UPS_NOT_IMPLEMENTED;
+  }
+
   if (cursor && !htxn)
     htxn = cursor->txn;
 
@@ -516,6 +521,11 @@ RemoteDb::cursor_move(Cursor *hcursor, ups_key_t *key,
 {
   RemoteCursor *cursor = (RemoteCursor *)hcursor;
 
+  if (unlikely(ISSET(flags, UPS_PARTIAL))) {
+    ups_trace(("flag UPS_PARTIAL is not supported by remote databases"));
+    return UPS_NOT_IMPLEMENTED;
+  }
+
   RemoteTxn *txn = dynamic_cast<RemoteTxn *>(cursor->txn);
   ByteArray *pkey_arena = &key_arena(txn);
   ByteArray *prec_arena = &record_arena(txn);
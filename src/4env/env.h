@@ -52,6 +52,8 @@ struct Cursor;
 struct Db;
 struct Txn;
 struct Result;
+struct PreparedStatement;
+struct SelectCursor;
 
 //
 // The Environment is the "root" of all upscaledb objects. It's a container
@@ -123,6 +125,19 @@ struct Env
   virtual ups_status_t select_range(const char *query, Cursor *begin,
                           const Cursor *end, Result **result) = 0;
 
+  // Prepares a UQI select for repeated execution (uqi_prepare)
+  virtual ups_status_t prepare_select(PreparedStatement *stmt) = 0;
+
+  // Performs a prepared UQI select (uqi_execute)
+  virtual ups_status_t select_range(const PreparedStatement *stmt,
+                          Cursor *begin, const Cursor *end,
+                          Result **result) = 0;
+
+  // Opens a cursor which returns the rows of a UQI select in chunks
+  // (uqi_cursor_open)
+  virtual ups_status_t select_cursor(const char *query, Cursor *begin,
+                          const Cursor *end, SelectCursor **cursor) = 0;
+
   // Creates a new database in the environment (ups_env_create_db)
   virtual Db *do_create_db(DbConfig &config, const ups_parameter_t *param) = 0;
 
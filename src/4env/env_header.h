@@ -49,8 +49,8 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // version information - major, minor, rev, file
   uint8_t version[4];
 
-  // reserved
-  uint64_t _reserved1;
+  // blob id of the catalog of record compression dictionaries
+  uint64_t dictionary_blobid;
 
   // size of the page
   uint32_t page_size;
@@ -61,8 +61,8 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // for storing journal compression algorithm
   uint8_t journal_compression;
 
-  // reserved
-  uint8_t _reserved2;
+  // for storing the compression algorithm of B+tree leaf pages
+  uint8_t page_compression;
 
   // blob id of the PageManager's state
   uint64_t page_manager_blobid;
@@ -75,6 +75,23 @@ typedef UPS_PACK_0 struct UPS_PACK_1
    */
 } UPS_PACK_2 PEnvironmentHeader;
 
+/*
+ * An entry in the catalog of record compression dictionaries; it is
+ * followed by |size| bytes of dictionary data. The catalog is a single
+ * blob which stores the entries of all databases back to back.
+ */
+typedef UPS_PACK_0 struct UPS_PACK_1
+{
+  // the name of the database
+  uint16_t db_name;
+
+  // the id of the dictionary (starting at 1)
+  uint16_t id;
+
+  // the size of the dictionary data
+  uint32_t size;
+} UPS_PACK_2 PDictionaryEntry;
+
 #include "1base/packstop.h"
 
 struct EnvHeader
@@ -149,6 +166,26 @@ struct EnvHeader
     header()->page_manager_blobid = blobid;
   }
 
+  // Returns the blob id of the dictionary catalog
+  uint64_t dictionary_blobid() {
+    return header()->dictionary_blobid;
+  }
+
+  // Sets the blob id of the dictionary catalog
+  void set_dictionary_blobid(uint64_t blobid) {
+    header()->dictionary_blobid = blobid;
+  }
+
+  // Returns the compression algorithm of B+tree leaf pages
+  int page_compression() {
+    return header()->page_compression;
+  }
+
+  // Sets the compression algorithm of B+tree leaf pages
+  void set_page_compression(int algorithm) {
+    header()->page_compression = (uint8_t)algorithm;
+  }
+
   // Returns the Journal compression configuration
   int journal_compression() {
     return header()->journal_compression >> 4;
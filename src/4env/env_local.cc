@@ -60,6 +60,7 @@ recover(LocalEnv *env, uint32_t flags)
       env->journal->create();
       return;
     }
+    throw;
   }
 
   /* success - check if we need recovery */
@@ -162,6 +163,8 @@ LocalEnv::create()
    * information */
   if (config.journal_compressor)
     header->set_journal_compression(config.journal_compressor);
+  if (config.page_compressor)
+    header->set_page_compression(config.page_compressor);
 
   /* flush the header page - this will write through disk if logging is
    * enabled */
@@ -267,6 +270,13 @@ fail_with_fake_cleansing:
   /* Now that the header page was fetched we can retrieve the compression
    * information */
   config.journal_compressor = header->journal_compression();
+  config.page_compressor = header->page_compression();
+  if (unlikely(config.page_compressor
+            && !CompressorFactory::is_available(config.page_compressor))) {
+    ups_log(("page compression algorithm %d is not available",
+                config.page_compressor));
+    return UPS_NOT_IMPLEMENTED;
+  }
 
   /* load page manager after setting up the blobmanager and the device! */
   page_manager.reset(new PageManager(this));
@@ -344,6 +354,30 @@ LocalEnv::get_parameters(ups_parameter_t *param)
       case UPS_PARAM_JOURNAL_COMPRESSION:
         p->value = config.journal_compressor;
         break;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        p->value = config.page_compressor;
+        break;
+      case UPS_PARAM_COMPRESSED_CACHE_SIZE:
+        p->value = config.compressed_cache_size_bytes;
+        break;
+      case UPS_PARAM_JOURNAL_DELTAS:
+        p->value = config.journal_deltas ? 1 : 0;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENT_SIZE:
+        p->value = config.journal_segment_size;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENTS:
+        p->value = config.journal_segments;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        p->value = config.journal_checkpoint_interval;
+        break;
+      case UPS_PARAM_RECOVERY_THREADS:
+        p->value = config.recovery_threads;
+        break;
+      case UPS_PARAM_UQI_THREADS:
+        p->value = config.uqi_threads;
+        break;
       case UPS_PARAM_POSIX_FADVISE:
         p->value = config.posix_advice;
         break;
@@ -379,6 +413,40 @@ LocalEnv::flush(uint32_t flags)
   return 0;
 }
 
+static ups_status_t
+select_statement(LocalEnv *env, SelectStatement *stmt, Cursor *begin,
+                const Cursor *end, Result **result)
+{
+  // load (or open) the database
+  bool is_opened = false;
+  LocalDb *db = get_or_open_database(env, stmt->dbid, &is_opened);
+
+  // if Cursors are passed: check if they belong to this database
+  if (begin && begin->db->name() != stmt->dbid) {
+    ups_log(("cursor 'begin' uses wrong database"));
+    return UPS_INV_PARAMETER;
+  }
+  if (end && end->db->name() != stmt->dbid) {
+    ups_log(("cursor 'begin' uses wrong database"));
+    return UPS_INV_PARAMETER;
+  }
+
+  // optimization: if duplicates are disabled then the query is always
+  // non-distinct
+  if (NOTSET(db->flags(), UPS_ENABLE_DUPLICATE_KEYS))
+    stmt->distinct = true;
+
+  // The Database object will do the remaining work
+  ups_status_t st = db->select_range(stmt, (LocalCursor *)begin,
+                    (LocalCursor *)end, result);
+
+  // Don't leak the database handle if it was opened above
+  if (is_opened)
+    (void)ups_db_close((ups_db_t *)db, UPS_DONT_LOCK);
+
+  return st;
+}
+
 ups_status_t
 LocalEnv::select_range(const char *query, Cursor *begin,
                             const Cursor *end, Result **result)
@@ -389,17 +457,44 @@ LocalEnv::select_range(const char *query, Cursor *begin,
   if (unlikely(st))
     return st;
 
+  return select_statement(this, &stmt, begin, end, result);
+}
+
+ups_status_t
+LocalEnv::prepare_select(PreparedStatement *stmt)
+{
+  return Parser::parse_select(stmt->query.c_str(), stmt->stmt);
+}
+
+ups_status_t
+LocalEnv::select_range(const PreparedStatement *prepared, Cursor *begin,
+                            const Cursor *end, Result **result)
+{
+  // the scan modifies the statement, therefore work on a copy
+  SelectStatement stmt(prepared->stmt);
+  return select_statement(this, &stmt, begin, end, result);
+}
+
+ups_status_t
+LocalEnv::select_cursor(const char *query, Cursor *begin, const Cursor *end,
+                            SelectCursor **pcursor)
+{
+  // Parse the string into a SelectStatement object
+  SelectStatement stmt;
+  ups_status_t st = Parser::parse_select(query, stmt);
+  if (unlikely(st))
+    return st;
+
   // load (or open) the database
   bool is_opened = false;
   LocalDb *db = get_or_open_database(this, stmt.dbid, &is_opened);
 
   // if Cursors are passed: check if they belong to this database
-  if (begin && begin->db->name() != stmt.dbid) {
-    ups_log(("cursor 'begin' uses wrong database"));
-    return UPS_INV_PARAMETER;
-  }
-  if (end && end->db->name() != stmt.dbid) {
-    ups_log(("cursor 'begin' uses wrong database"));
+  if ((begin && begin->db->name() != stmt.dbid)
+        || (end && end->db->name() != stmt.dbid)) {
+    ups_log(("cursor 'begin' or 'end' uses wrong database"));
+    if (is_opened)
+      (void)ups_db_close((ups_db_t *)db, UPS_DONT_LOCK);
     return UPS_INV_PARAMETER;
   }
 
@@ -408,20 +503,232 @@ LocalEnv::select_range(const char *query, Cursor *begin,
   if (NOTSET(db->flags(), UPS_ENABLE_DUPLICATE_KEYS))
     stmt.distinct = true;
 
-  // The Database object will do the remaining work
-  st = db->select_range(&stmt, (LocalCursor *)begin,
-                    (LocalCursor *)end, result);
+  // the cursor closes the database if it was opened above
+  LocalSelectCursor *cursor = new LocalSelectCursor(db, stmt, is_opened);
+  st = cursor->initialize((LocalCursor *)begin, (LocalCursor *)end);
+  if (unlikely(st)) {
+    delete cursor;
+    return st;
+  }
 
-  // Don't leak the database handle if it was opened above
-  if (is_opened)
-    (void)ups_db_close((ups_db_t *)db, UPS_DONT_LOCK);
+  *pcursor = cursor;
+  return 0;
+}
+
+ups_status_t
+LocalEnv::apply_journal_entry(const uint8_t *data, uint32_t size)
+{
+  PJournalEntry entry;
+  if (unlikely(size < sizeof(entry))) {
+    ups_trace(("journal entry is too small"));
+    return UPS_INV_PARAMETER;
+  }
+  ::memcpy(&entry, data, sizeof(entry));
+  if (unlikely(size != sizeof(entry) + entry.followup_size)) {
+    ups_trace(("journal entry has an invalid size"));
+    return UPS_INV_PARAMETER;
+  }
+  const uint8_t *payload = data + sizeof(entry);
+
+  // without Transactions, the operations are applied one by one
+  bool use_txns = ISSET(flags(), UPS_ENABLE_TRANSACTIONS);
+  Txn *txn = 0;
+  if (use_txns && entry.txn_id != 0) {
+    ReplicaTxnMap::iterator it = replica_txns.find(entry.txn_id);
+    if (it != replica_txns.end())
+      txn = it->second;
+  }
+
+  ups_status_t st = 0;
+  switch (entry.type) {
+    case Journal::kEntryTypeTxnBegin: {
+      if (!use_txns)
+        break;
+      // a Txn which was not committed is started again
+      if (txn) {
+        replica_txns.erase(entry.txn_id);
+        (void)txn_abort(txn, 0);
+      }
+      // the name is stored with its terminating zero byte
+      const char *name = entry.followup_size > 0
+                            ? (const char *)payload
+                            : 0;
+      if (unlikely(name && payload[entry.followup_size - 1] != 0)) {
+        ups_trace(("invalid txn begin entry"));
+        return UPS_INV_PARAMETER;
+      }
+      replica_txns[entry.txn_id] = txn_begin(name, 0);
+      break;
+    }
+    case Journal::kEntryTypeTxnCommit: {
+      if (!txn)
+        break;
+      replica_txns.erase(entry.txn_id);
+      st = txn_commit(txn, 0);
+      break;
+    }
+    case Journal::kEntryTypeTxnAbort: {
+      if (!txn)
+        break;
+      replica_txns.erase(entry.txn_id);
+      st = txn_abort(txn, 0);
+      break;
+    }
+    case Journal::kEntryTypeInsert: {
+      PJournalEntryInsert *ins = (PJournalEntryInsert *)payload;
+      if (unlikely(entry.followup_size < sizeof(PJournalEntryInsert) - 1
+            || ins->compressed_key_size != 0
+            || ins->compressed_record_size != 0
+            || entry.followup_size < sizeof(PJournalEntryInsert) - 1
+                        + ins->key_size + ins->record_size)) {
+        ups_trace(("invalid insert entry"));
+        return UPS_INV_PARAMETER;
+      }
+
+      bool is_opened;
+      Db *db = get_or_open_database(this, entry.dbname, &is_opened);
+      ups_key_t key = ups_make_key(ins->key_data(), ins->key_size);
+      ups_record_t record = ups_make_record(ins->record_data(),
+                      ins->record_size);
+
+      // always use a cursor; otherwise flags like UPS_DUPLICATE_INSERT_FIRST
+      // will cause errors. The Environment is already locked by the caller,
+      // therefore the cursor is not created through the public API
+      uint32_t insert_flags = ins->insert_flags & ~UPS_DONT_LOCK;
+      if (ISSETANY(insert_flags, UPS_DUPLICATE_INSERT_AFTER
+                                | UPS_DUPLICATE_INSERT_BEFORE
+                                | UPS_DUPLICATE_INSERT_LAST
+                                | UPS_DUPLICATE_INSERT_FIRST))
+        insert_flags |= UPS_DUPLICATE;
+      Cursor *cursor = db->cursor_create(txn, 0);
+      db->add_cursor(cursor);
+      if (txn)
+        txn->add_ref();
+      try {
+        st = db->insert(cursor, txn, &key, &record, insert_flags);
+      }
+      catch (Exception &ex) {
+        st = ex.code;
+      }
+      cursor->close();
+      if (txn)
+        txn->release();
+      db->remove_cursor(cursor);
+      delete cursor;
+      if (st == UPS_DUPLICATE_KEY) // ok if key already exists
+        st = 0;
+      break;
+    }
+    case Journal::kEntryTypeErase: {
+      PJournalEntryErase *e = (PJournalEntryErase *)payload;
+      if (unlikely(entry.followup_size < sizeof(PJournalEntryErase) - 1
+            || e->compressed_key_size != 0
+            || entry.followup_size < sizeof(PJournalEntryErase) - 1
+                        + e->key_size)) {
+        ups_trace(("invalid erase entry"));
+        return UPS_INV_PARAMETER;
+      }
+
+      bool is_opened;
+      Db *db = get_or_open_database(this, entry.dbname, &is_opened);
+      ups_key_t key = ups_make_key(e->key_data(), e->key_size);
+      st = db->erase(0, txn, &key, e->erase_flags & ~UPS_DONT_LOCK);
+      // ok if the key was already erased
+      if (st == UPS_KEY_NOT_FOUND)
+        st = 0;
+      break;
+    }
+    case Journal::kEntryTypeChangeset:
+    case Journal::kEntryTypeChangesetDelta:
+    case Journal::kEntryTypeCheckpoint:
+      // this Environment maintains its own file
+      break;
+    default:
+      ups_trace(("invalid journal entry type %u", entry.type));
+      return UPS_INV_PARAMETER;
+  }
 
   return st;
 }
 
+void
+LocalEnv::read_dictionary_catalog(Context *context, ByteArray *catalog)
+{
+  catalog->set_size(0);
+
+  uint64_t blobid = header->dictionary_blobid();
+  if (!blobid)
+    return;
+
+  ByteArray arena;
+  ups_record_t record = {0};
+  blob_manager->read(context, blobid, &record, 0, &arena);
+  catalog->copy((uint8_t *)record.data, record.size);
+}
+
+void
+LocalEnv::write_dictionary_catalog(Context *context, ByteArray *catalog)
+{
+  uint64_t blobid = header->dictionary_blobid();
+  uint32_t flags = BlobManager::kDisableCompression
+                    | BlobManager::kDisableDeduplication;
+
+  if (catalog->size() == 0) {
+    if (blobid)
+      blob_manager->erase(context, blobid);
+    blobid = 0;
+  }
+  else {
+    ups_record_t record = ups_make_record(catalog->data(),
+                    (uint32_t)catalog->size());
+    if (blobid)
+      blobid = blob_manager->overwrite(context, blobid, &record, flags);
+    else
+      blobid = blob_manager->allocate(context, &record, flags);
+  }
+
+  header->set_dictionary_blobid(blobid);
+  mark_header_page_dirty(this, context);
+}
+
+// Renames the compression dictionaries of database |oldname| to |newname|,
+// or deletes them if |newname| is 0
+static void
+rename_dictionaries(LocalEnv *env, Context *context, uint16_t oldname,
+                uint16_t newname)
+{
+  if (!env->header->dictionary_blobid())
+    return;
+
+  ByteArray catalog;
+  env->read_dictionary_catalog(context, &catalog);
+
+  ByteArray result;
+  bool modified = false;
+  size_t offset = 0;
+  while (offset < catalog.size()) {
+    PDictionaryEntry *entry = (PDictionaryEntry *)(catalog.data() + offset);
+    size_t entry_size = sizeof(PDictionaryEntry) + entry->size;
+    if (entry->db_name == oldname) {
+      modified = true;
+      entry->db_name = newname;
+    }
+    if (entry->db_name != 0)
+      result.append(catalog.data() + offset, entry_size);
+    offset += entry_size;
+  }
+
+  if (modified)
+    env->write_dictionary_catalog(context, &result);
+}
+
 Db *
 LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
 {
+  // the database inherits the environment's compression level unless
+  // it is overwritten with UPS_PARAM_COMPRESSION_LEVEL
+  dbconfig.compression_level = config.compression_level;
+
   if (param) {
     for (; param->name; param++) {
       switch (param->name) {
@@ -439,6 +746,13 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
           }
           dbconfig.key_compressor = (int)param->value;
           break;
+        case UPS_PARAM_COMPRESSION_LEVEL:
+          if (unlikely(param->value > 22)) {
+            ups_trace(("invalid compression level %u", (int)param->value));
+            throw Exception(UPS_INV_PARAMETER);
+          }
+          dbconfig.compression_level = (int)param->value;
+          break;
         case UPS_PARAM_KEY_TYPE:
           dbconfig.key_type = (uint16_t)param->value;
           break;
@@ -533,11 +847,36 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
     }
   }
 
+  // uint64 compression is only allowed for uint64-keys
+  if (dbconfig.key_compressor == UPS_COMPRESSOR_UINT64_VARBYTE
+      || dbconfig.key_compressor == UPS_COMPRESSOR_UINT64_FOR) {
+    if (unlikely(dbconfig.key_type != UPS_TYPE_UINT64)) {
+      ups_trace(("Uint64 compression only allowed for uint64 keys "
+                 "(UPS_TYPE_UINT64)"));
+      throw Exception(UPS_INV_PARAMETER);
+    }
+    if (unlikely(config.page_size_bytes != 16 * 1024)) {
+      ups_trace(("Uint64 compression only allowed for page size of 16k"));
+      throw Exception(UPS_INV_PARAMETER);
+    }
+  }
+
+  // zlib only supports levels 1 - 9; check early because the key
+  // compressor is only created when the first page is loaded
+  if (unlikely(dbconfig.compression_level > 9
+        && (dbconfig.key_compressor == UPS_COMPRESSOR_ZLIB
+            || dbconfig.record_compressor == UPS_COMPRESSOR_ZLIB))) {
+    ups_trace(("zlib compression level must be <= 9"));
+    throw Exception(UPS_INV_PARAMETER);
+  }
+
   // all heavy-weight compressors are only allowed for
   // variable-length binary keys
   if (dbconfig.key_compressor == UPS_COMPRESSOR_LZF
         || dbconfig.key_compressor == UPS_COMPRESSOR_SNAPPY
-        || dbconfig.key_compressor == UPS_COMPRESSOR_ZLIB) {
+        || dbconfig.key_compressor == UPS_COMPRESSOR_ZLIB
+        || dbconfig.key_compressor == UPS_COMPRESSOR_LZ4
+        || dbconfig.key_compressor == UPS_COMPRESSOR_ZSTD) {
     if (unlikely(dbconfig.key_type != UPS_TYPE_BINARY
           || dbconfig.key_size != UPS_KEY_SIZE_UNLIMITED)) {
       ups_trace(("Key compression only allowed for unlimited binary keys "
@@ -548,6 +887,7 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
 
   uint32_t mask = UPS_FORCE_RECORDS_INLINE
                     | UPS_ENABLE_DUPLICATE_KEYS
+                    | UPS_ENABLE_RECORD_DEDUPLICATION
                     | UPS_IGNORE_MISSING_CALLBACK
                     | UPS_RECORD_NUMBER32
                     | UPS_RECORD_NUMBER64;
@@ -556,6 +896,14 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
     throw Exception(UPS_INV_PARAMETER);
   }
 
+  // only the disk-based BlobManager deduplicates records
+  if (unlikely(ISSET(dbconfig.flags, UPS_ENABLE_RECORD_DEDUPLICATION)
+        && ISSET(flags(), UPS_IN_MEMORY))) {
+    ups_trace(("UPS_ENABLE_RECORD_DEDUPLICATION is not allowed in "
+               "In-Memory Environments"));
+    throw Exception(UPS_INV_PARAMETER);
+  }
+
   /* create a new Database object */
   LocalDb *db = new LocalDb(this, dbconfig);
 
@@ -603,6 +951,10 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
 Db *
 LocalEnv::do_open_db(DbConfig &dbconfig, const ups_parameter_t *param)
 {
+  // the database inherits the environment's compression level unless
+  // it is overwritten with UPS_PARAM_COMPRESSION_LEVEL
+  dbconfig.compression_level = config.compression_level;
+
   uint32_t mask = UPS_FORCE_RECORDS_INLINE
                     | UPS_PARAM_JOURNAL_COMPRESSION
                     | UPS_IGNORE_MISSING_CALLBACK
@@ -623,6 +975,13 @@ LocalEnv::do_open_db(DbConfig &dbconfig, const ups_parameter_t *param)
           ups_trace(("Key compression parameters are only allowed in "
                      "ups_env_create_db"));
           throw Exception(UPS_INV_PARAMETER);
+        case UPS_PARAM_COMPRESSION_LEVEL:
+          if (unlikely(param->value > 22)) {
+            ups_trace(("invalid compression level %u", (int)param->value));
+            throw Exception(UPS_INV_PARAMETER);
+          }
+          dbconfig.compression_level = (int)param->value;
+          break;
         default:
           ups_trace(("invalid parameter 0x%x (%d)", param->name, param->name));
           throw Exception(UPS_INV_PARAMETER);
@@ -688,6 +1047,9 @@ LocalEnv::rename_db(uint16_t oldname, uint16_t newname, uint32_t flags)
   btree_header(header.get(), slot)->dbname = newname;
   mark_header_page_dirty(this, &context);
 
+  /* the compression dictionaries are stored by name */
+  rename_dictionaries(this, &context, oldname, newname);
+
   /* if the database with the old name is currently open: notify it */
   Env::DatabaseMap::iterator it = _database_map.find(oldname);
   if (unlikely(it != _database_map.end())) {
@@ -740,6 +1102,9 @@ LocalEnv::erase_db(uint16_t name, uint32_t flags)
   if (unlikely(st))
     return st;
 
+  /* delete the compression dictionaries */
+  rename_dictionaries(this, &context, name, 0);
+
   /* now set database name to 0 and set the header page to dirty */
   for (uint16_t dbi = 0; dbi < header->max_databases(); dbi++) {
     PBtreeHeader *desc = btree_header(header.get(), dbi);
@@ -97,6 +97,30 @@ struct LocalEnv : public Env
   virtual ups_status_t select_range(const char *query, Cursor *begin,
                           const Cursor *end, Result **result);
 
+  // Prepares a UQI select for repeated execution (uqi_prepare)
+  virtual ups_status_t prepare_select(PreparedStatement *stmt);
+
+  // Performs a prepared UQI select (uqi_execute)
+  virtual ups_status_t select_range(const PreparedStatement *stmt,
+                          Cursor *begin, const Cursor *end,
+                          Result **result);
+
+  // Opens a cursor which returns the rows of a UQI select in chunks
+  // (uqi_cursor_open)
+  virtual ups_status_t select_cursor(const char *query, Cursor *begin,
+                          const Cursor *end, SelectCursor **cursor);
+
+  // Reads the catalog of the record compression dictionaries (a sequence
+  // of PDictionaryEntry structures, each followed by the dictionary data)
+  void read_dictionary_catalog(Context *context, ByteArray *catalog);
+
+  // Replaces the catalog of the record compression dictionaries
+  void write_dictionary_catalog(Context *context, ByteArray *catalog);
+
+  // Applies an entry of another Environment's journal
+  // (ups_env_apply_journal_entry)
+  ups_status_t apply_journal_entry(const uint8_t *data, uint32_t size);
+
   // Closes the Environment (ups_env_close)
   virtual ups_status_t do_close(uint32_t flags);
 
@@ -117,6 +141,11 @@ struct LocalEnv : public Env
 
   // The lsn manager
   LsnManager lsn_manager;
+
+  // The Txns which were started by apply_journal_entry(), indexed by
+  // their ids in the other Environment
+  typedef std::map<uint64_t, Txn *> ReplicaTxnMap;
+  ReplicaTxnMap replica_txns;
 };
 
 } // namespace upscaledb
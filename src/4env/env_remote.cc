@@ -30,6 +30,7 @@
 #include "4env/env_remote.h"
 #include "4txn/txn_remote.h"
 #include "4uqi/result.h"
+#include "4uqi/statements.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -134,6 +135,19 @@ add_result_records(Result *r, const upscaledb::SelectRangeReply *reply)
   }
 }
 
+static Result *
+copy_result(const upscaledb::SelectRangeReply *reply)
+{
+  Result *r = new Result;
+  r->row_count = reply->row_count();
+  r->key_type = reply->key_type();
+  add_result_keys(r, reply);
+
+  r->record_type = reply->record_type();
+  add_result_records(r, reply);
+  return r;
+}
+
 ups_status_t
 RemoteEnv::select_range(const char *query, Cursor *begin, const Cursor *end,
                 Result **presult)
@@ -161,16 +175,103 @@ RemoteEnv::select_range(const char *query, Cursor *begin, const Cursor *end,
   if (unlikely(st))
     return st;
 
-  /* copy the result */
-  Result *r = new Result;
-  r->row_count = reply->select_range_reply().row_count();
-  r->key_type = reply->select_range_reply().key_type();
-  add_result_keys(r, &reply->select_range_reply());
+  *presult = copy_result(&reply->select_range_reply());
+  return 0;
+}
+
+// The query is parsed by the server; only the query string is stored
+ups_status_t
+RemoteEnv::prepare_select(PreparedStatement *)
+{
+  return 0;
+}
+
+ups_status_t
+RemoteEnv::select_range(const PreparedStatement *stmt, Cursor *begin,
+                const Cursor *end, Result **presult)
+{
+  return select_range(stmt->query.c_str(), begin, end, presult);
+}
+
+ups_status_t
+RemoteEnv::select_cursor(const char *query, Cursor *begin, const Cursor *end,
+                SelectCursor **pcursor)
+{
+  Protocol request(Protocol::SELECT_RANGE_REQUEST);
+  request.mutable_select_range_request();
+  request.mutable_select_range_request()->set_env_handle(remote_handle);
+  request.mutable_select_range_request()->set_query(query);
+  request.mutable_select_range_request()->set_open_cursor(true);
+  if (begin) {
+    RemoteCursor *c = (RemoteCursor *)begin;
+    request.mutable_select_range_request()->set_begin_cursor_handle(
+                    c->remote_handle);
+  }
+  if (end) {
+    RemoteCursor *c = (RemoteCursor *)end;
+    request.mutable_select_range_request()->set_end_cursor_handle(
+                    c->remote_handle);
+  }
+
+  ScopedPtr<Protocol> reply(perform_request(&request));
+
+  assert(reply->has_select_range_reply());
+
+  ups_status_t st = reply->select_range_reply().status();
+  if (unlikely(st))
+    return st;
+
+  *pcursor = new RemoteSelectCursor(this,
+                  reply->select_range_reply().select_cursor_handle());
+  return 0;
+}
+
+RemoteSelectCursor::~RemoteSelectCursor()
+{
+  if (!remote_handle)
+    return;
 
-  r->record_type = reply->select_range_reply().record_type();
-  add_result_records(r, &reply->select_range_reply());
+  RemoteEnv *renv = (RemoteEnv *)env;
+  Protocol request(Protocol::SELECT_RANGE_REQUEST);
+  request.mutable_select_range_request()->set_env_handle(renv->remote_handle);
+  request.mutable_select_range_request()->set_query("");
+  request.mutable_select_range_request()->set_select_cursor_handle(
+                  remote_handle);
+  request.mutable_select_range_request()->set_close_cursor(true);
+
+  try {
+    ScopedPtr<Protocol> reply(renv->perform_request(&request));
+  }
+  catch (Exception &) {
+    // nop; the server closes the cursor when the Environment is closed
+  }
+}
+
+ups_status_t
+RemoteSelectCursor::next(Result **presult)
+{
+  if (!remote_handle)
+    return UPS_KEY_NOT_FOUND;
+
+  RemoteEnv *renv = (RemoteEnv *)env;
+  Protocol request(Protocol::SELECT_RANGE_REQUEST);
+  request.mutable_select_range_request()->set_env_handle(renv->remote_handle);
+  request.mutable_select_range_request()->set_query("");
+  request.mutable_select_range_request()->set_select_cursor_handle(
+                  remote_handle);
+
+  ScopedPtr<Protocol> reply(renv->perform_request(&request));
+
+  assert(reply->has_select_range_reply());
+
+  ups_status_t st = reply->select_range_reply().status();
+  // the server closes the cursor after the last chunk
+  if (st == UPS_KEY_NOT_FOUND)
+    remote_handle = 0;
+  if (unlikely(st))
+    return st;
 
-  *presult = r;
+  *presult = copy_result(&reply->select_range_reply());
   return 0;
 }
 
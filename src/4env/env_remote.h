@@ -31,6 +31,7 @@
 #include "2protobuf/protocol.h"
 #include "2protoserde/messages.h"
 #include "4env/env.h"
+#include "4uqi/select_cursor.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -92,6 +93,19 @@ struct RemoteEnv : public Env
   virtual ups_status_t select_range(const char *query, Cursor *begin,
                           const Cursor *end, Result **result);
 
+  // Prepares a UQI select for repeated execution (uqi_prepare)
+  virtual ups_status_t prepare_select(PreparedStatement *stmt);
+
+  // Performs a prepared UQI select (uqi_execute)
+  virtual ups_status_t select_range(const PreparedStatement *stmt,
+                          Cursor *begin, const Cursor *end,
+                          Result **result);
+
+  // Opens a cursor which returns the rows of a UQI select in chunks
+  // (uqi_cursor_open)
+  virtual ups_status_t select_cursor(const char *query, Cursor *begin,
+                          const Cursor *end, SelectCursor **cursor);
+
   // Creates a new database in the environment (ups_env_create_db)
   virtual Db *do_create_db(DbConfig &config, const ups_parameter_t *param);
 
@@ -111,6 +125,27 @@ struct RemoteEnv : public Env
   ByteArray _buffer;
 };
 
+//
+// A UQI cursor of a remote Environment; the server scans the database and
+// returns the rows in chunks
+//
+struct RemoteSelectCursor : public SelectCursor
+{
+  // Constructor
+  RemoteSelectCursor(RemoteEnv *env, uint64_t remote_handle_)
+    : SelectCursor(env), remote_handle(remote_handle_) {
+  }
+
+  // Destructor; closes the cursor on the server
+  virtual ~RemoteSelectCursor();
+
+  // Retrieves the next chunk of rows
+  virtual ups_status_t next(Result **result);
+
+  // the remote handle; 0 if the server already closed the cursor
+  uint64_t remote_handle;
+};
+
 } // namespace upscaledb
 
 #endif // UPS_ENABLE_REMOTE
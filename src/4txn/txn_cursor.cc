@@ -19,6 +19,7 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/record_window.h"
 #include "3btree/btree_cursor.h"
 #include "4db/db_local.h"
 #include "4txn/txn.h"
@@ -291,7 +292,7 @@ TxnCursor::copy_coupled_key(ups_key_t *key)
 }
 
 void
-TxnCursor::copy_coupled_record(ups_record_t *record)
+TxnCursor::copy_coupled_record(ups_record_t *record, uint32_t flags)
 {
   Txn *txn = state_.parent->txn;
   ups_record_t *source = 0;
@@ -303,14 +304,16 @@ TxnCursor::copy_coupled_record(ups_record_t *record)
 
   // coupled cursor? get record from the txn_op structure
   source = &state_.coupled_op->record;
-  record->size = source->size;
+  RecordWindow window(record, source->size, flags);
+  record->size = window.size;
 
-  if (likely(source->data && source->size)) {
+  if (likely(source->data && window.size)) {
     if (NOTSET(record->flags, UPS_RECORD_USER_ALLOC)) {
-      arena->resize(source->size);
+      arena->resize(window.size);
       record->data = arena->data();
     }
-    ::memcpy(record->data, source->data, source->size);
+    ::memcpy(record->data, (uint8_t *)source->data + window.offset,
+                    window.size);
   }
   else
     record->data = 0;
@@ -128,7 +128,8 @@ struct TxnCursor {
   // If the cursor is uncoupled, UPS_CURSOR_IS_NIL will be returned. this
   // means that the item was already flushed to the btree, and the caller has
   // to use the btree lookup function to retrieve the record.
-  void copy_coupled_record(ups_record_t *record);
+  // |flags| can be UPS_PARTIAL to copy only a window of the record.
+  void copy_coupled_record(ups_record_t *record, uint32_t flags = 0);
 
   // Moves the cursor to first, last, previous or next
   ups_status_t move(uint32_t flags);
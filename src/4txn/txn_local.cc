@@ -18,6 +18,8 @@
 
 #include "0root/root.h"
 
+#include <limits>
+
 // Always verify that a file of level N does not include headers > N!
 #include "3btree/btree_index.h"
 #include "3journal/journal.h"
@@ -102,6 +104,8 @@ flush_committed_txns_impl(LocalTxnManager *tm, Context *context)
       uint64_t lsn = tm->flush_txn_to_changeset(context, (LocalTxn *)oldest);
       if (lsn > highest_lsn)
         highest_lsn = lsn;
+      if (tm->lenv()->journal.get())
+        tm->lenv()->journal->on_txn_flushed(oldest);
     }
     else if (oldest->is_aborted()) {
       ; // nop
@@ -187,9 +191,7 @@ TxnOperation::destroy()
     previous_in_txn->next_in_txn = next_in_txn;
 
   if (delete_node)
-    delete node;
-
-  Memory::release(this);
+    node->db->txn_index->release(node);
 }
 
 TxnNode *
@@ -255,7 +257,7 @@ TxnIndex::store(ups_key_t *key, bool *node_created)
   *node_created = false;
   TxnNode *node = get(key, 0);
   if (!node) {
-    node = new TxnNode(db, key);
+    node = new (node_pool.allocate()) TxnNode(db, key);
     *node_created = true;
     rbt_insert(this, node);
   }
@@ -269,6 +271,13 @@ TxnIndex::remove(TxnNode *node)
   rbt_remove(this, node);
 }
 
+void
+TxnIndex::release(TxnNode *node)
+{
+  node->~TxnNode();
+  node_pool.release(node);
+}
+
 static inline void
 flush_transaction_to_journal(LocalTxn *txn)
 {
@@ -317,7 +326,9 @@ flush_transaction_to_journal(LocalTxn *txn)
 }
 
 LocalTxn::LocalTxn(LocalEnv *env, const char *name, uint32_t flags)
-  : Txn(env, name, flags), log_descriptor(0), oldest_op(0), newest_op(0)
+  : Txn(env, name, flags),
+    journal_position(std::numeric_limits<uint64_t>::max()), oldest_op(0),
+    newest_op(0)
 {
   LocalTxnManager *ltm = (LocalTxnManager *)env->txn_manager.get();
   id = ltm->incremented_txn_id();
@@ -371,6 +382,7 @@ LocalTxn::free_operations()
 
   oldest_op = 0;
   newest_op = 0;
+  arena.clear();
 }
 
 TxnIndex::TxnIndex(LocalDb *db)
@@ -385,7 +397,7 @@ TxnIndex::~TxnIndex()
 
   while ((node = rbt_last(this))) {
     remove(node);
-    delete node;
+    release(node);
   }
 
   // re-initialize the tree
@@ -22,6 +22,7 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1mem/arena.h"
 #include "1rb/rb.h"
 #include "4txn/txn.h"
 
@@ -76,7 +77,8 @@ struct TxnOperation {
                   uint32_t flags, uint32_t orig_flags, uint64_t lsn,
                   ups_key_t *key, ups_record_t *record);
 
-  // Destructor
+  // Removes the operation from its node and its Txn. The memory is owned
+  // by the Txn's arena and released with the other operations of the Txn.
   void destroy();
 
   // the Txn of this operation
@@ -209,6 +211,9 @@ struct TxnIndex {
   // Removes a TxnNode from the index
   void remove(TxnNode *node);
 
+  // Releases the memory of a TxnNode which was removed from the index
+  void release(TxnNode *node);
+
   // Visits every node in the TxnTree
   void enumerate(Context *context, Visitor *visitor);
 
@@ -235,6 +240,9 @@ struct TxnIndex {
   // stuff for rb.h
   TxnNode *rbt_root;
   TxnNode rbt_nil;
+
+  // Recycles the memory of the nodes
+  ObjectPool<TxnNode> node_pool;
 };
 
 
@@ -261,8 +269,9 @@ struct LocalTxn : Txn {
   // (before it's deleted by the Environment).
   void free_operations();
 
-  // index of the log file descriptor for this transaction [0..1]
-  int log_descriptor;
+  // the journal position of this transaction's first entry; pins the
+  // journal segment till the transaction was flushed
+  uint64_t journal_position;
 
   // the lsn of the "txn begin" operation
   uint64_t lsn;
@@ -272,6 +281,10 @@ struct LocalTxn : Txn {
 
   // the linked list of operations - tail is newest operation
   TxnOperation *newest_op;
+
+  // the memory of the operations; released in bulk when the Txn is
+  // aborted or flushed
+  Arena arena;
 };
 
 
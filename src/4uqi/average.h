@@ -21,6 +21,7 @@
 #include "1base/error.h"
 #include "2config/db_config.h"
 #include "4uqi/scanvisitor.h"
+#include "4uqi/kernels.h"
 #include "4uqi/plugin_wrapper.h"
 #include "4uqi/result.h"
 #include "4uqi/statements.h"
@@ -64,18 +65,10 @@ struct AverageScanVisitor : public NumericalScanVisitor
   // Operates on an array of keys
   virtual void operator()(const void *key_data, const void *record_data,
                   size_t length) {
-    if (ISSET(statement->function.flags, UQI_STREAM_KEY)) {
-      Sequence<Key> keys(key_data, length);
-      for (typename Sequence<Key>::iterator it = keys.begin();
-                      it != keys.end(); it++)
-        sum += it->value;
-    }
-    else {
-      Sequence<Record> records(record_data, length);
-      for (typename Sequence<Record>::iterator it = records.begin();
-                      it != records.end(); it++)
-        sum += it->value;
-    }
+    if (ISSET(statement->function.flags, UQI_STREAM_KEY))
+      sum += Kernels::sum((const typename Key::type *)key_data, length);
+    else
+      sum += Kernels::sum((const typename Record::type *)record_data, length);
 
     count += length;
   }
@@ -88,6 +81,18 @@ struct AverageScanVisitor : public NumericalScanVisitor
     uqi_result_add_row(result, "AVERAGE", 8, &avg, sizeof(avg));
   }
 
+  // The sum and the counter are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Adds the sum and the counter of |other|
+  virtual void merge(ScanVisitor *other) {
+    AverageScanVisitor *o = static_cast<AverageScanVisitor *>(other);
+    sum += o->sum;
+    count += o->count;
+  }
+
   // The aggregated sum
   double sum;
 
@@ -133,27 +138,18 @@ struct AverageIfScanVisitor : public NumericalScanVisitor
   // Operates on an array of keys
   virtual void operator()(const void *key_data, const void *record_data,
                   size_t length) {
-    Sequence<Key> keys(key_data, length);
-    Sequence<Record> records(record_data, length);
-    typename Sequence<Key>::iterator kit = keys.begin();
-    typename Sequence<Record>::iterator rit = records.begin();
-
-    if (ISSET(statement->function.flags, UQI_STREAM_KEY)) {
-      for (; kit != keys.end(); kit++, rit++) {
-        if (plugin.pred(kit, kit->size(), rit, rit->size())) {
-          sum += kit->value;
-          count++;
-        }
-      }
-    }
-    else {
-      for (; kit != keys.end(); kit++, rit++) {
-        if (plugin.pred(kit, kit->size(), rit, rit->size())) {
-          sum += rit->value;
-          count++;
-        }
-      }
-    }
+    size_t matches;
+    const uint8_t *mask = plugin.evaluate<Key, Record>(key_data, record_data,
+                    length, &matches);
+    if (matches == 0)
+      return;
+
+    if (ISSET(statement->function.flags, UQI_STREAM_KEY))
+      sum += Kernels::sum((const typename Key::type *)key_data, length, mask);
+    else
+      sum += Kernels::sum((const typename Record::type *)record_data,
+                      length, mask);
+    count += matches;
   }
 
   // Assigns the result to |result|
@@ -164,6 +160,18 @@ struct AverageIfScanVisitor : public NumericalScanVisitor
     uqi_result_add_row(result, "AVERAGE", 8, &avg, sizeof(avg));
   }
 
+  // The sum and the counter are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Adds the sum and the counter of |other|
+  virtual void merge(ScanVisitor *other) {
+    AverageIfScanVisitor *o = static_cast<AverageIfScanVisitor *>(other);
+    sum += o->sum;
+    count += o->count;
+  }
+
   // The aggreated sum
   double sum;
 
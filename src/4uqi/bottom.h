@@ -101,6 +101,25 @@ struct BottomScanVisitorBase : public NumericalScanVisitor {
     }
   }
 
+  // Partial results are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Feeds the values stored in |other| into this visitor
+  virtual void merge(ScanVisitor *other) {
+    BottomScanVisitorBase *o = static_cast<BottomScanVisitorBase *>(other);
+
+    for (typename KeyMap::iterator it = o->stored_keys.begin();
+                    it != o->stored_keys.end(); it++)
+      max_key = store_max_value(it->first, max_key, it->second.data(),
+                      it->second.size(), stored_keys, statement->limit);
+    for (typename RecordMap::iterator it = o->stored_records.begin();
+                    it != o->stored_records.end(); it++)
+      max_record = store_max_value(it->first, max_record, it->second.data(),
+                      it->second.size(), stored_records, statement->limit);
+  }
+
   // The maximum value currently stored in |keys|
   Key max_key;
 
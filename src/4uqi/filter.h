@@ -0,0 +1,420 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A ScanVisitor which filters keys and records by their value ranges
+ * (see SelectStatement::key_range and SelectStatement::record_range)
+ * before they are passed to the actual visitor.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: no
+ */
+
+#ifndef UPS_UQI_FILTER_H
+#define UPS_UQI_FILTER_H
+
+#include "0root/root.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits>
+
+#include "1base/dynamic_array.h"
+#include "1base/scoped_ptr.h"
+#include "2config/db_config.h"
+#include "3btree/btree_zone_map.h"
+#include "4uqi/kernels.h"
+#include "4uqi/scanvisitor.h"
+#include "4uqi/statements.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// A ValueRange for values of type |T|; the bounds are converted to
+// inclusive bounds of type |T|, which are then used by the kernels
+template<typename T, bool IsInteger = std::numeric_limits<T>::is_integer>
+struct TypedRange;
+
+// The integer version; bounds which exceed the range of |T| are clamped
+template<typename T>
+struct TypedRange<T, true> {
+  TypedRange(const ValueRange &range)
+    : empty(false), lower(0), upper(std::numeric_limits<T>::max()) {
+    const uint64_t max = std::numeric_limits<T>::max();
+    if (range.has_lower) {
+      uint64_t l = range.lower.u;
+      if (!range.lower_inclusive) {
+        if (l >= max)
+          empty = true;
+        l++;
+      }
+      if (l > max)
+        empty = true;
+      else
+        lower = (T)l;
+    }
+    if (range.has_upper) {
+      uint64_t u = range.upper.u;
+      if (!range.upper_inclusive) {
+        if (u == 0)
+          empty = true;
+        u--;
+      }
+      if (u < max)
+        upper = (T)u;
+    }
+    if (lower > upper)
+      empty = true;
+  }
+
+  bool empty;
+  T lower;
+  T upper;
+};
+
+// The floating point version; the bounds are rounded "inwards" if they
+// cannot be represented in |T|
+template<typename T>
+struct TypedRange<T, false> {
+  TypedRange(const ValueRange &range)
+    : empty(false), lower(-std::numeric_limits<T>::infinity()),
+      upper(std::numeric_limits<T>::infinity()) {
+    const T inf = std::numeric_limits<T>::infinity();
+    if (range.has_lower) {
+      double l = range.lower.r;
+      T t = (T)l;
+      if ((double)t < l)
+        t = next_after(t, inf);
+      if (!range.lower_inclusive && (double)t == l) {
+        if (t == inf)
+          empty = true;
+        t = next_after(t, inf);
+      }
+      lower = t;
+    }
+    if (range.has_upper) {
+      double u = range.upper.r;
+      T t = (T)u;
+      if ((double)t > u)
+        t = next_after(t, -inf);
+      if (!range.upper_inclusive && (double)t == u) {
+        if (t == -inf)
+          empty = true;
+        t = next_after(t, -inf);
+      }
+      upper = t;
+    }
+    // also true if a bound is NaN
+    if (!(lower <= upper))
+      empty = true;
+  }
+
+  static float next_after(float f, float to) {
+    return ::nextafterf(f, to);
+  }
+
+  static double next_after(double d, double to) {
+    return ::nextafter(d, to);
+  }
+
+  bool empty;
+  T lower;
+  T upper;
+};
+
+struct RangeFilterScanVisitor : public ScanVisitor
+{
+  // Takes ownership of |visitor_|
+  RangeFilterScanVisitor(const DbConfig *dbconf, SelectStatement *stmt,
+                  ScanVisitor *visitor_)
+    : ScanVisitor(stmt), visitor(visitor_) {
+    key_type = dbconf->key_type;
+    key_size = dbconf->key_size;
+    record_type = dbconf->record_type;
+    record_size = dbconf->record_size;
+  }
+
+  // Operates on a single key
+  virtual void operator()(const void *key_data, uint16_t key_size,
+                  const void *record_data, uint32_t record_size) {
+    if (statement->key_range.is_set()
+          && !statement->key_range.contains(key_type,
+                    to_numeric_value(key_type, key_data)))
+      return;
+    if (statement->record_range.is_set()
+          && !statement->record_range.contains(record_type,
+                    to_numeric_value(record_type, record_data)))
+      return;
+    (*visitor)(key_data, key_size, record_data, record_size);
+  }
+
+  // Operates on an array of keys; only the matching elements are
+  // passed to the visitor
+  virtual void operator()(const void *key_array, const void *record_array,
+                  size_t length) {
+    uint8_t *mask = selection.resize(length, 1);
+    if (statement->key_range.is_set())
+      apply(key_type, key_array, length, statement->key_range, mask);
+    if (statement->record_range.is_set())
+      apply(record_type, record_array, length, statement->record_range,
+                      mask);
+
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++)
+      count += mask[i];
+
+    if (count == length) {
+      (*visitor)(key_array, record_array, length);
+      return;
+    }
+    if (count == 0)
+      return;
+
+    (*visitor)(compact(key_array, key_size, mask, length, count, &keys),
+               compact(record_array, record_size, mask, length, count,
+                        &records),
+               count);
+  }
+
+  // Assigns the result to |result|
+  virtual void assign_result(uqi_result_t *result) {
+    visitor->assign_result(result);
+  }
+
+  // Moves the rows of the visitor to |result|
+  virtual bool flush_rows(uqi_result_t *result) {
+    return visitor->flush_rows(result);
+  }
+
+  // Filtered results are mergeable if the visitor's results are
+  virtual bool supports_merge() const {
+    return visitor->supports_merge();
+  }
+
+  // Merges the visitor of |other|
+  virtual void merge(ScanVisitor *other) {
+    visitor->merge(static_cast<RangeFilterScanVisitor *>(other)->visitor.get());
+  }
+
+  // Clears the |mask| of all values of |type| which are not in |range|
+  static void apply(int type, const void *data, size_t length,
+                  const ValueRange &range, uint8_t *mask) {
+    switch (type) {
+      case UPS_TYPE_UINT8:
+        apply((const uint8_t *)data, length, range, mask);
+        break;
+      case UPS_TYPE_UINT16:
+        apply((const uint16_t *)data, length, range, mask);
+        break;
+      case UPS_TYPE_UINT32:
+        apply((const uint32_t *)data, length, range, mask);
+        break;
+      case UPS_TYPE_UINT64:
+        apply((const uint64_t *)data, length, range, mask);
+        break;
+      case UPS_TYPE_REAL32:
+        apply((const float *)data, length, range, mask);
+        break;
+      case UPS_TYPE_REAL64:
+        apply((const double *)data, length, range, mask);
+        break;
+      default:
+        assert(!"shouldn't be here");
+    }
+  }
+
+  template<typename T>
+  static void apply(const T *data, size_t length, const ValueRange &range,
+                  uint8_t *mask) {
+    TypedRange<T> typed(range);
+    if (typed.empty)
+      ::memset(mask, 0, length);
+    else
+      Kernels::select_range(data, length, typed.lower, typed.upper, mask);
+  }
+
+  // Copies the selected elements of |data| to |buffer|
+  static const void *compact(const void *data, size_t size,
+                  const uint8_t *mask, size_t length, size_t count,
+                  ByteArray *buffer) {
+    if (!data)
+      return 0;
+    const uint8_t *src = (const uint8_t *)data;
+    uint8_t *dst = buffer->resize(count * size);
+    for (size_t i = 0; i < length; i++, src += size) {
+      if (mask[i]) {
+        ::memcpy(dst, src, size);
+        dst += size;
+      }
+    }
+    return buffer->data();
+  }
+
+  // The actual visitor
+  ScopedPtr<ScanVisitor> visitor;
+
+  // The key type and size
+  int key_type;
+  size_t key_size;
+
+  // The record type and size
+  int record_type;
+  size_t record_size;
+
+  // One byte per element; non-zero if the element is selected
+  ByteArray selection;
+
+  // The selected keys
+  ByteArray keys;
+
+  // The selected records
+  ByteArray records;
+};
+
+struct RangeFilterScanVisitorFactory
+{
+  // Converts the comparisons of the WHERE clause to key and record
+  // ranges. Returns false if a comparison cannot be applied to the
+  // database.
+  static bool resolve(const DbConfig *cfg, SelectStatement *stmt) {
+    for (std::vector<Comparison>::iterator it = stmt->comparisons.begin();
+                    it != stmt->comparisons.end(); it++) {
+      bool is_key = it->stream == UQI_STREAM_KEY;
+      int type = is_key ? cfg->key_type : cfg->record_type;
+      if (!is_numeric_type(type)) {
+        ups_trace(("comparison requires numeric %s",
+                    is_key ? "keys" : "records"));
+        return false;
+      }
+      restrict(is_key ? &stmt->key_range : &stmt->record_range, type,
+                      it->op, it->constant);
+    }
+    stmt->comparisons.clear();
+    return true;
+  }
+
+  // Restricts |range| by comparing with the |constant|
+  static void restrict(ValueRange *range, int type, int op,
+                  const std::string &constant) {
+    NumericValue v;
+    if (type == UPS_TYPE_REAL32 || type == UPS_TYPE_REAL64) {
+      v.r = ::strtod(constant.c_str(), 0);
+      restrict(range, type, op, v);
+      return;
+    }
+
+    // an integer in the range of uint64_t?
+    const double kTwoPow64 = 18446744073709551616.0;
+    double d = ::strtod(constant.c_str(), 0);
+    if (constant.find_first_of(".eE-") == std::string::npos) {
+      errno = 0;
+      v.u = ::strtoull(constant.c_str(), 0, 10);
+      if (errno != ERANGE) {
+        restrict(range, type, op, v);
+        return;
+      }
+    }
+    else if (d >= 0 && d < kTwoPow64 && d == ::floor(d)) {
+      v.u = (uint64_t)d;
+      restrict(range, type, op, v);
+      return;
+    }
+
+    // otherwise the constant is negative, has a fraction or is too large
+    switch (op) {
+      case Comparison::kEqual:
+        range->set_empty();
+        break;
+      case Comparison::kGreater:
+      case Comparison::kGreaterEqual:
+        if (d >= kTwoPow64)
+          range->set_empty();
+        else if (d > 0) {
+          v.u = (uint64_t)::ceil(d);
+          range->restrict_lower(type, v, true);
+        }
+        break;
+      case Comparison::kLess:
+      case Comparison::kLessEqual:
+        if (d < 0)
+          range->set_empty();
+        else if (d < kTwoPow64) {
+          v.u = (uint64_t)::floor(d);
+          range->restrict_upper(type, v, true);
+        }
+        break;
+    }
+  }
+
+  static void restrict(ValueRange *range, int type, int op, NumericValue v) {
+    switch (op) {
+      case Comparison::kEqual:
+        range->restrict_lower(type, v, true);
+        range->restrict_upper(type, v, true);
+        break;
+      case Comparison::kLess:
+        range->restrict_upper(type, v, false);
+        break;
+      case Comparison::kLessEqual:
+        range->restrict_upper(type, v, true);
+        break;
+      case Comparison::kGreater:
+        range->restrict_lower(type, v, false);
+        break;
+      case Comparison::kGreaterEqual:
+        range->restrict_lower(type, v, true);
+        break;
+    }
+  }
+
+  // Wraps |visitor| in a RangeFilterScanVisitor; returns 0 (and deletes
+  // |visitor|) if the ranges cannot be applied to the database
+  static ScanVisitor *create(const DbConfig *cfg, SelectStatement *stmt,
+                  ScanVisitor *visitor) {
+    if (stmt->key_range.is_set()) {
+      if (!is_numeric_type(cfg->key_type)) {
+        ups_trace(("key range requires numeric keys"));
+        delete visitor;
+        return 0;
+      }
+      stmt->requires_keys = true;
+    }
+
+    if (stmt->record_range.is_set()) {
+      if (!is_numeric_type(cfg->record_type)) {
+        ups_trace(("record range requires numeric records"));
+        delete visitor;
+        return 0;
+      }
+      stmt->requires_records = true;
+    }
+
+    return new RangeFilterScanVisitor(cfg, stmt, visitor);
+  }
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_UQI_FILTER_H */
@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "0root/root.h"
+
+#include <string.h>
+#ifdef HAVE_SSE2
+#  include <immintrin.h>
+#endif
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/error.h"
+#include "1os/os.h"
+#include "4uqi/kernels.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+// The kernels are compiled for AVX2 even if the remaining library is not;
+// they are only called if os_has_avx2() returns true
+#if defined(HAVE_SSE2) && defined(__GNUC__) && !defined(__AVX2__)
+#  define UPS_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#  define UPS_AVX2_TARGET
+#endif
+
+namespace upscaledb {
+
+namespace Kernels {
+
+#ifdef HAVE_SSE2
+
+// Returns the sum of the four 64bit lanes
+UPS_AVX2_TARGET static inline uint64_t
+horizontal_sum(__m256i v)
+{
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+UPS_AVX2_TARGET static inline double
+horizontal_sum(__m256d v)
+{
+  double lanes[4];
+  _mm256_storeu_pd(lanes, v);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// Expands |mask| to lanes of 8, 16, 32 or 64 bits; the lanes of the
+// elements which are NOT selected are set to all-ones
+UPS_AVX2_TARGET static inline __m256i
+unselected8(const uint8_t *mask)
+{
+  return _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)mask),
+                  _mm256_setzero_si256());
+}
+
+UPS_AVX2_TARGET static inline __m256i
+unselected16(const uint8_t *mask)
+{
+  __m128i m = _mm_loadu_si128((const __m128i *)mask);
+  return _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(m), _mm256_setzero_si256());
+}
+
+UPS_AVX2_TARGET static inline __m256i
+unselected32(const uint8_t *mask)
+{
+  __m128i m = _mm_loadl_epi64((const __m128i *)mask);
+  return _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(m), _mm256_setzero_si256());
+}
+
+UPS_AVX2_TARGET static inline __m256i
+unselected64(const uint8_t *mask)
+{
+  int32_t bytes;
+  ::memcpy(&bytes, mask, sizeof(bytes));
+  __m128i m = _mm_cvtsi32_si128(bytes);
+  return _mm256_cmpeq_epi64(_mm256_cvtepu8_epi64(m), _mm256_setzero_si256());
+}
+
+// _mm256_sad_epu8 adds up 8 bytes each into four 64bit lanes
+UPS_AVX2_TARGET static uint64_t
+avx2_sum(const uint8_t *data, size_t length, const uint8_t *mask)
+{
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+    if (mask)
+      v = _mm256_andnot_si256(unselected8(mask + i), v);
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256()));
+  }
+  return horizontal_sum(acc) + scalar_sum(data + i, length - i,
+                  mask ? mask + i : 0);
+}
+
+// Adjacent 16bit integers are added to 32bit integers, then widened to
+// 64bit
+UPS_AVX2_TARGET static uint64_t
+avx2_sum(const uint16_t *data, size_t length, const uint8_t *mask)
+{
+  const __m256i low16 = _mm256_set1_epi32(0xffff);
+  const __m256i low32 = _mm256_set1_epi64x(0xffffffff);
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+    if (mask)
+      v = _mm256_andnot_si256(unselected16(mask + i), v);
+    __m256i s = _mm256_add_epi32(_mm256_and_si256(v, low16),
+                    _mm256_srli_epi32(v, 16));
+    acc = _mm256_add_epi64(acc, _mm256_and_si256(s, low32));
+    acc = _mm256_add_epi64(acc, _mm256_srli_epi64(s, 32));
+  }
+  return horizontal_sum(acc) + scalar_sum(data + i, length - i,
+                  mask ? mask + i : 0);
+}
+
+UPS_AVX2_TARGET static uint64_t
+avx2_sum(const uint32_t *data, size_t length, const uint8_t *mask)
+{
+  const __m256i low32 = _mm256_set1_epi64x(0xffffffff);
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+    if (mask)
+      v = _mm256_andnot_si256(unselected32(mask + i), v);
+    acc = _mm256_add_epi64(acc, _mm256_and_si256(v, low32));
+    acc = _mm256_add_epi64(acc, _mm256_srli_epi64(v, 32));
+  }
+  return horizontal_sum(acc) + scalar_sum(data + i, length - i,
+                  mask ? mask + i : 0);
+}
+
+UPS_AVX2_TARGET static uint64_t
+avx2_sum(const uint64_t *data, size_t length, const uint8_t *mask)
+{
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+    if (mask)
+      v = _mm256_andnot_si256(unselected64(mask + i), v);
+    acc = _mm256_add_epi64(acc, v);
+  }
+  return horizontal_sum(acc) + scalar_sum(data + i, length - i,
+                  mask ? mask + i : 0);
+}
+
+// The floats are converted to double before they are added
+UPS_AVX2_TARGET static double
+avx2_sum(const float *data, size_t length, const uint8_t *mask)
+{
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m256 v = _mm256_loadu_ps(data + i);
+    if (mask)
+      v = _mm256_andnot_ps(_mm256_castsi256_ps(unselected32(mask + i)), v);
+    acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+  }
+  return horizontal_sum(_mm256_add_pd(acc0, acc1))
+            + scalar_sum(data + i, length - i, mask ? mask + i : 0);
+}
+
+UPS_AVX2_TARGET static double
+avx2_sum(const double *data, size_t length, const uint8_t *mask)
+{
+  __m256d acc = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    __m256d v = _mm256_loadu_pd(data + i);
+    if (mask)
+      v = _mm256_andnot_pd(_mm256_castsi256_pd(unselected64(mask + i)), v);
+    acc = _mm256_add_pd(acc, v);
+  }
+  return horizontal_sum(acc) + scalar_sum(data + i, length - i,
+                  mask ? mask + i : 0);
+}
+
+// The vector operations of the MIN/MAX kernels for each type. |min()| and
+// |max()| return the second argument if the first one is NaN, therefore
+// NaNs are ignored (like in the scalar code).
+struct Uint8Ops {
+  typedef uint8_t T;
+  typedef __m256i V;
+  enum { kLanes = 32 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_si256((const V *)p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_si256((V *)p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_epi8((char)t);
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_min_epu8(a, b);
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_max_epu8(a, b);
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_epi8(v, other, unselected8(mask));
+  }
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_and_si256(_mm256_cmpeq_epi8(max(v, lower), v),
+                    _mm256_cmpeq_epi8(min(v, upper), v));
+    return (uint32_t)_mm256_movemask_epi8(r);
+  }
+};
+
+struct Uint16Ops {
+  typedef uint16_t T;
+  typedef __m256i V;
+  enum { kLanes = 16 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_si256((const V *)p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_si256((V *)p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_epi16((short)t);
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_min_epu16(a, b);
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_max_epu16(a, b);
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_epi8(v, other, unselected16(mask));
+  }
+  // the 16bit lanes are packed to bytes; packs_epi16 works per 128bit
+  // half, therefore the 64bit blocks are reordered afterwards
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_and_si256(_mm256_cmpeq_epi16(max(v, lower), v),
+                    _mm256_cmpeq_epi16(min(v, upper), v));
+    r = _mm256_permute4x64_epi64(_mm256_packs_epi16(r, r), 0xd8);
+    return (uint32_t)_mm256_movemask_epi8(r) & 0xffff;
+  }
+};
+
+struct Uint32Ops {
+  typedef uint32_t T;
+  typedef __m256i V;
+  enum { kLanes = 8 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_si256((const V *)p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_si256((V *)p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_epi32((int)t);
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_min_epu32(a, b);
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_max_epu32(a, b);
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_epi8(v, other, unselected32(mask));
+  }
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_and_si256(_mm256_cmpeq_epi32(max(v, lower), v),
+                    _mm256_cmpeq_epi32(min(v, upper), v));
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(r));
+  }
+};
+
+// AVX2 has no unsigned 64bit comparison; the sign bits are flipped, then
+// the signed comparison is used
+struct Uint64Ops {
+  typedef uint64_t T;
+  typedef __m256i V;
+  enum { kLanes = 4 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_si256((const V *)p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_si256((V *)p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_epi64x((long long)t);
+  }
+  UPS_AVX2_TARGET static V greater(V a, V b) {
+    const V sign = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign),
+                    _mm256_xor_si256(b, sign));
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_blendv_epi8(a, b, greater(a, b));
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_blendv_epi8(b, a, greater(a, b));
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_epi8(v, other, unselected64(mask));
+  }
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_or_si256(greater(lower, v), greater(v, upper));
+    return ~(uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(r)) & 0xf;
+  }
+};
+
+struct FloatOps {
+  typedef float T;
+  typedef __m256 V;
+  enum { kLanes = 8 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_ps(p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_ps(p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_ps(t);
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_min_ps(a, b);
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_max_ps(a, b);
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_ps(v, other, _mm256_castsi256_ps(unselected32(mask)));
+  }
+  // the ordered comparisons are false for NaN
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_and_ps(_mm256_cmp_ps(v, lower, _CMP_GE_OQ),
+                    _mm256_cmp_ps(v, upper, _CMP_LE_OQ));
+    return (uint32_t)_mm256_movemask_ps(r);
+  }
+};
+
+struct DoubleOps {
+  typedef double T;
+  typedef __m256d V;
+  enum { kLanes = 4 };
+
+  UPS_AVX2_TARGET static V load(const T *p) {
+    return _mm256_loadu_pd(p);
+  }
+  UPS_AVX2_TARGET static void store(T *p, V v) {
+    _mm256_storeu_pd(p, v);
+  }
+  UPS_AVX2_TARGET static V broadcast(T t) {
+    return _mm256_set1_pd(t);
+  }
+  UPS_AVX2_TARGET static V min(V a, V b) {
+    return _mm256_min_pd(a, b);
+  }
+  UPS_AVX2_TARGET static V max(V a, V b) {
+    return _mm256_max_pd(a, b);
+  }
+  UPS_AVX2_TARGET static V select(V v, V other, const uint8_t *mask) {
+    return _mm256_blendv_pd(v, other, _mm256_castsi256_pd(unselected64(mask)));
+  }
+  UPS_AVX2_TARGET static uint32_t in_range(V v, V lower, V upper) {
+    V r = _mm256_and_pd(_mm256_cmp_pd(v, lower, _CMP_GE_OQ),
+                    _mm256_cmp_pd(v, upper, _CMP_LE_OQ));
+    return (uint32_t)_mm256_movemask_pd(r);
+  }
+};
+
+// Calculates the minimum (or maximum) of the array with vector
+// operations. Only if it is "better" than |current| then the position of
+// its first occurrence is searched.
+template<typename Ops, template<typename T> class Compare>
+UPS_AVX2_TARGET static int
+avx2_find(const typename Ops::T *data, size_t length, const uint8_t *mask,
+                typename Ops::T current)
+{
+  typedef typename Ops::T T;
+  typedef typename Ops::V V;
+  Compare<T> cmp;
+  bool is_min = cmp(0, 1);
+
+  // the lanes of the unselected elements are replaced with the
+  // accumulator, and therefore do not modify it
+  V acc = Ops::broadcast(current);
+  size_t i = 0;
+  for (; i + Ops::kLanes <= length; i += Ops::kLanes) {
+    V v = Ops::load(data + i);
+    if (mask)
+      v = Ops::select(v, acc, mask + i);
+    acc = is_min ? Ops::min(v, acc) : Ops::max(v, acc);
+  }
+
+  T lanes[Ops::kLanes];
+  Ops::store(lanes, acc);
+  T best = current;
+  for (int l = 0; l < Ops::kLanes; l++) {
+    if (cmp(lanes[l], best))
+      best = lanes[l];
+  }
+  for (; i < length; i++) {
+    if ((!mask || mask[i]) && cmp(data[i], best))
+      best = data[i];
+  }
+
+  if (!cmp(best, current))
+    return -1;
+
+  for (i = 0; i < length; i++) {
+    if ((!mask || mask[i]) && data[i] == best)
+      return (int)i;
+  }
+  assert(!"shouldn't be here");
+  return -1;
+}
+
+// Clears the |mask| of all elements which are not in [lower, upper].
+// |Ops::in_range()| returns one bit per lane.
+template<typename Ops>
+UPS_AVX2_TARGET static void
+avx2_select_range(const typename Ops::T *data, size_t length,
+                typename Ops::T lower, typename Ops::T upper, uint8_t *mask)
+{
+  typedef typename Ops::V V;
+  const uint32_t all = (uint32_t)((1ull << Ops::kLanes) - 1);
+  V lo = Ops::broadcast(lower);
+  V hi = Ops::broadcast(upper);
+  size_t i = 0;
+  for (; i + Ops::kLanes <= length; i += Ops::kLanes) {
+    uint32_t bits = Ops::in_range(Ops::load(data + i), lo, hi);
+    if (bits == all)
+      continue;
+    for (int l = 0; l < Ops::kLanes; l++)
+      mask[i + l] &= (bits >> l) & 1;
+  }
+  scalar_select_range(data + i, length - i, lower, upper, mask + i);
+}
+
+#endif // HAVE_SSE2
+
+#ifdef HAVE_SSE2
+#  define DISPATCH(avx2_call, scalar_call)                      \
+    if (os_has_avx2())                                          \
+      return avx2_call;                                         \
+    return scalar_call
+#else
+#  define DISPATCH(avx2_call, scalar_call)                      \
+    return scalar_call
+#endif
+
+uint64_t
+sum(const uint8_t *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+uint64_t
+sum(const uint16_t *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+uint64_t
+sum(const uint32_t *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+uint64_t
+sum(const uint64_t *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+double
+sum(const float *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+double
+sum(const double *data, size_t length, const uint8_t *mask)
+{
+  DISPATCH(avx2_sum(data, length, mask), scalar_sum(data, length, mask));
+}
+
+#define FIND(Name, Compare, Type, Ops)                                  \
+  int                                                                   \
+  Name(const Type *data, size_t length, const uint8_t *mask,            \
+                  Type current)                                         \
+  {                                                                     \
+    DISPATCH((avx2_find<Ops, Compare>(data, length, mask, current)),    \
+            (scalar_find<Compare>(data, length, mask, current)));       \
+  }
+
+FIND(find_min, std::less, uint8_t, Uint8Ops)
+FIND(find_min, std::less, uint16_t, Uint16Ops)
+FIND(find_min, std::less, uint32_t, Uint32Ops)
+FIND(find_min, std::less, uint64_t, Uint64Ops)
+FIND(find_min, std::less, float, FloatOps)
+FIND(find_min, std::less, double, DoubleOps)
+
+FIND(find_max, std::greater, uint8_t, Uint8Ops)
+FIND(find_max, std::greater, uint16_t, Uint16Ops)
+FIND(find_max, std::greater, uint32_t, Uint32Ops)
+FIND(find_max, std::greater, uint64_t, Uint64Ops)
+FIND(find_max, std::greater, float, FloatOps)
+FIND(find_max, std::greater, double, DoubleOps)
+
+#define SELECT_RANGE(Type, Ops)                                         \
+  void                                                                  \
+  select_range(const Type *data, size_t length, Type lower, Type upper, \
+                  uint8_t *mask)                                        \
+  {                                                                     \
+    DISPATCH((avx2_select_range<Ops>(data, length, lower, upper, mask)), \
+            (scalar_select_range(data, length, lower, upper, mask)));   \
+  }
+
+SELECT_RANGE(uint8_t, Uint8Ops)
+SELECT_RANGE(uint16_t, Uint16Ops)
+SELECT_RANGE(uint32_t, Uint32Ops)
+SELECT_RANGE(uint64_t, Uint64Ops)
+SELECT_RANGE(float, FloatOps)
+SELECT_RANGE(double, DoubleOps)
+
+} // namespace Kernels
+
+} // namespace upscaledb
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Aggregation kernels for the builtin UQI functions
+ *
+ * The kernels operate on arrays of numeric keys or records. The optional
+ * |mask| stores one byte per element; elements with a zero byte are not
+ * selected (i.e. they did not match the predicate) and are skipped.
+ * |select_range()| creates such a mask for a range of values.
+ *
+ * The unsigned integer types and the floating point types have AVX2
+ * implementations which are selected at runtime (see |os_has_avx2()|);
+ * all other types use the scalar templates.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_UQI_KERNELS_H
+#define UPS_UQI_KERNELS_H
+
+#include "0root/root.h"
+
+#include <functional>
+
+#include "ups/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+namespace Kernels {
+
+// The type of a sum; integers are summed up as uint64_t, floating point
+// values as double
+template<typename T>
+struct SumType {
+  typedef uint64_t type;
+};
+
+template<>
+struct SumType<float> {
+  typedef double type;
+};
+
+template<>
+struct SumType<double> {
+  typedef double type;
+};
+
+// Returns the sum of the selected elements
+template<typename T>
+inline typename SumType<T>::type
+scalar_sum(const T *data, size_t length, const uint8_t *mask)
+{
+  typename SumType<T>::type sum = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (!mask || mask[i])
+      sum += data[i];
+  }
+  return sum;
+}
+
+// Returns the position of the first selected element which is the
+// minimum (or maximum, depending on |Compare|) of the array, if it is
+// "better" than |current|. Otherwise returns -1.
+template<template<typename T> class Compare, typename T>
+inline int
+scalar_find(const T *data, size_t length, const uint8_t *mask, T current)
+{
+  Compare<T> cmp;
+  int position = -1;
+  for (size_t i = 0; i < length; i++) {
+    if ((!mask || mask[i]) && cmp(data[i], current)) {
+      current = data[i];
+      position = (int)i;
+    }
+  }
+  return position;
+}
+
+// Clears the |mask| of all elements which are not in [lower, upper]. NaN
+// is never in the range.
+template<typename T>
+inline void
+scalar_select_range(const T *data, size_t length, T lower, T upper,
+                uint8_t *mask)
+{
+  for (size_t i = 0; i < length; i++)
+    mask[i] &= (data[i] >= lower && data[i] <= upper) ? 1 : 0;
+}
+
+template<typename T>
+inline typename SumType<T>::type
+sum(const T *data, size_t length, const uint8_t *mask = 0)
+{
+  return scalar_sum(data, length, mask);
+}
+
+template<typename T>
+inline int
+find_min(const T *data, size_t length, const uint8_t *mask, T current)
+{
+  return scalar_find<std::less>(data, length, mask, current);
+}
+
+template<typename T>
+inline int
+find_max(const T *data, size_t length, const uint8_t *mask, T current)
+{
+  return scalar_find<std::greater>(data, length, mask, current);
+}
+
+template<typename T>
+inline void
+select_range(const T *data, size_t length, T lower, T upper, uint8_t *mask)
+{
+  scalar_select_range(data, length, lower, upper, mask);
+}
+
+// Overloads for the types with SIMD implementations
+extern uint64_t
+sum(const uint8_t *data, size_t length, const uint8_t *mask = 0);
+extern uint64_t
+sum(const uint16_t *data, size_t length, const uint8_t *mask = 0);
+extern uint64_t
+sum(const uint32_t *data, size_t length, const uint8_t *mask = 0);
+extern uint64_t
+sum(const uint64_t *data, size_t length, const uint8_t *mask = 0);
+extern double
+sum(const float *data, size_t length, const uint8_t *mask = 0);
+extern double
+sum(const double *data, size_t length, const uint8_t *mask = 0);
+
+extern int
+find_min(const uint8_t *data, size_t length, const uint8_t *mask,
+                uint8_t current);
+extern int
+find_min(const uint16_t *data, size_t length, const uint8_t *mask,
+                uint16_t current);
+extern int
+find_min(const uint32_t *data, size_t length, const uint8_t *mask,
+                uint32_t current);
+extern int
+find_min(const uint64_t *data, size_t length, const uint8_t *mask,
+                uint64_t current);
+extern int
+find_min(const float *data, size_t length, const uint8_t *mask,
+                float current);
+extern int
+find_min(const double *data, size_t length, const uint8_t *mask,
+                double current);
+
+extern int
+find_max(const uint8_t *data, size_t length, const uint8_t *mask,
+                uint8_t current);
+extern int
+find_max(const uint16_t *data, size_t length, const uint8_t *mask,
+                uint16_t current);
+extern int
+find_max(const uint32_t *data, size_t length, const uint8_t *mask,
+                uint32_t current);
+extern int
+find_max(const uint64_t *data, size_t length, const uint8_t *mask,
+                uint64_t current);
+extern int
+find_max(const float *data, size_t length, const uint8_t *mask,
+                float current);
+extern int
+find_max(const double *data, size_t length, const uint8_t *mask,
+                double current);
+
+extern void
+select_range(const uint8_t *data, size_t length, uint8_t lower,
+                uint8_t upper, uint8_t *mask);
+extern void
+select_range(const uint16_t *data, size_t length, uint16_t lower,
+                uint16_t upper, uint8_t *mask);
+extern void
+select_range(const uint32_t *data, size_t length, uint32_t lower,
+                uint32_t upper, uint8_t *mask);
+extern void
+select_range(const uint64_t *data, size_t length, uint64_t lower,
+                uint64_t upper, uint8_t *mask);
+extern void
+select_range(const float *data, size_t length, float lower,
+                float upper, uint8_t *mask);
+extern void
+select_range(const double *data, size_t length, double lower,
+                double upper, uint8_t *mask);
+
+// Maps the comparison functor of the MIN/MAX visitors to the kernels
+template<template<typename T> class Compare>
+struct Extreme;
+
+template<>
+struct Extreme<std::less> {
+  template<typename T>
+  static int find(const T *data, size_t length, const uint8_t *mask,
+                  T current) {
+    return find_min(data, length, mask, current);
+  }
+};
+
+template<>
+struct Extreme<std::greater> {
+  template<typename T>
+  static int find(const T *data, size_t length, const uint8_t *mask,
+                  T current) {
+    return find_max(data, length, mask, current);
+  }
+};
+
+} // namespace Kernels
+
+} // namespace upscaledb
+
+#endif /* UPS_UQI_KERNELS_H */
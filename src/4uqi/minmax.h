@@ -22,6 +22,7 @@
 
 #include "1base/error.h"
 #include "2config/db_config.h"
+#include "4uqi/kernels.h"
 #include "4uqi/plugin_wrapper.h"
 #include "4uqi/statements.h"
 #include "4uqi/scanvisitor.h"
@@ -60,6 +61,26 @@ struct MinMaxScanVisitorBase : public NumericalScanVisitor
     other.copy((const uint8_t *)data, size);
   }
 
+  // Merges the minimum/maximum of |o|; the current value wins if both
+  // are equal, because it was found first
+  template<template<typename T> class Compare>
+  void merge_impl(MinMaxScanVisitorBase *o) {
+    if (ISSET(statement->function.flags, UQI_STREAM_KEY)) {
+      Compare<typename Key::type> cmp;
+      if (cmp(o->key.value, key.value)) {
+        key = o->key;
+        copy_value(o->other.data(), o->other.size());
+      }
+    }
+    else {
+      Compare<typename Record::type> cmp;
+      if (cmp(o->record.value, record.value)) {
+        record = o->record;
+        copy_value(o->other.data(), o->other.size());
+      }
+    }
+  }
+
   // The current minimum/maximum key
   Key key;
 
@@ -85,6 +106,16 @@ struct MinMaxScanVisitor : public MinMaxScanVisitorBase<Key, Record> {
                     initial_key, initial_record) {
   }
 
+  // Partial results are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Merges the minimum/maximum of |other|
+  virtual void merge(ScanVisitor *other) {
+    P::template merge_impl<Compare>(static_cast<P *>(other));
+  }
+
   // Operates on a single key
   virtual void operator()(const void *key_data, uint16_t key_size, 
                   const void *record_data, uint32_t record_size) {
@@ -106,30 +137,31 @@ struct MinMaxScanVisitor : public MinMaxScanVisitorBase<Key, Record> {
     }
   }
 
-  // Operates on an array of keys
+  // Operates on an array of keys; the kernel returns the position of the
+  // new minimum/maximum, if there is one
   virtual void operator()(const void *key_data, const void *record_data,
                   size_t length) {
     Sequence<Key> keys(key_data, length);
     Sequence<Record> records(record_data, length);
-    typename Sequence<Key>::iterator kit = keys.begin();
-    typename Sequence<Record>::iterator rit = records.begin();
 
     if (ISSET(P::statement->function.flags, UQI_STREAM_KEY)) {
-      Compare<typename Key::type> cmp;
-      for (; kit != keys.end(); kit++, rit++) {
-        if (cmp(kit->value, P::key.value)) {
-          P::key = kit->value;
-          P::copy_value(&rit->value, rit->size());
-        }
+      int i = Kernels::Extreme<Compare>::find(
+                      (const typename Key::type *)key_data, length, 0,
+                      P::key.value);
+      if (i >= 0) {
+        typename Sequence<Record>::iterator rit = records.begin() + i;
+        P::key = keys.begin()[i].value;
+        P::copy_value(&rit->value, rit->size());
       }
     }
     else {
-      Compare<typename Record::type> cmp;
-      for (; kit != keys.end(); kit++, rit++) {
-        if (cmp(rit->value, P::record.value)) {
-          P::record = rit->value;
-          P::copy_value(&kit->value, kit->size());
-        }
+      int i = Kernels::Extreme<Compare>::find(
+                      (const typename Record::type *)record_data, length, 0,
+                      P::record.value);
+      if (i >= 0) {
+        typename Sequence<Key>::iterator kit = keys.begin() + i;
+        P::record = records.begin()[i].value;
+        P::copy_value(&kit->value, kit->size());
       }
     }
   }
@@ -180,6 +212,16 @@ struct MinMaxIfScanVisitor : public MinMaxScanVisitorBase<Key, Record> {
         plugin(cfg, stmt) {
   }
 
+  // Partial results are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Merges the minimum/maximum of |other|
+  virtual void merge(ScanVisitor *other) {
+    P::template merge_impl<Compare>(static_cast<P *>(other));
+  }
+
   // Operates on a single key
   virtual void operator()(const void *key_data, uint16_t key_size, 
                   const void *record_data, uint32_t record_size) {
@@ -215,7 +257,7 @@ struct MinMaxIfScanVisitor : public MinMaxScanVisitorBase<Key, Record> {
       Compare<typename Key::type> cmp;
       for (; kit != keys.end(); kit++, rit++) {
         if (cmp(kit->value, P::key.value)
-            && plugin.pred(kit, kit->value, rit, rit->value)) {
+            && plugin.pred(kit, kit->size(), rit, rit->size())) {
           P::key = kit->value;
           P::copy_value(&rit->value, rit->size());
         }
@@ -225,7 +267,7 @@ struct MinMaxIfScanVisitor : public MinMaxScanVisitorBase<Key, Record> {
       Compare<typename Record::type> cmp;
       for (; kit != keys.end(); kit++, rit++) {
         if (cmp(rit->value, P::record.value)
-            && plugin.pred(kit, kit->value, rit, rit->value)) {
+            && plugin.pred(kit, kit->size(), rit, rit->size())) {
           P::record = rit->value;
           P::copy_value(&kit->value, kit->size());
         }
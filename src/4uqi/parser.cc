@@ -43,11 +43,13 @@ static bool initialized = false;
 static qi::rule<const char *, std::string(), ascii::space_type> quoted_string;
 static qi::rule<const char *, std::string(), ascii::space_type> unquoted_string;
 static qi::rule<const char *, std::string(), ascii::space_type> plugin_name;
-static qi::rule<const char *, std::string(), ascii::space_type> where_clause;
+static qi::rule<const char *, std::string(), ascii::space_type> constant;
 static qi::rule<const char *, int(), ascii::space_type> limit_clause;
 static qi::rule<const char *, short(), ascii::space_type> from_clause;
 static qi::rule<const char *, short(), ascii::space_type> number;
 static qi::rule<const char *, int(), ascii::space_type> input_clause;
+static qi::rule<const char *, int(), ascii::space_type> stream_clause;
+static qi::rule<const char *, int(), ascii::space_type> operator_clause;
 
 static void
 initialize_parsers()
@@ -59,12 +61,14 @@ initialize_parsers()
   using qi::lit;
   using qi::_val;
   using ascii::char_;
+  using ascii::digit;
   using ascii::no_case;
 
   quoted_string %= lexeme['"' >> +(char_ - '"') >> '"'][_val];
   unquoted_string %= lexeme[ +(alnum | char_("-_"))][_val];
   plugin_name %= unquoted_string | quoted_string;
-  where_clause = no_case[lit("where")] >> plugin_name;
+  constant %= lexeme[-char_('-') >> +digit >> -(char_('.') >> *digit)
+                  >> -(char_("eE") >> -char_("+-") >> +digit)];
   limit_clause = no_case[lit("limit")] >> int_;
   from_clause = no_case[lit("from")] >> no_case[lit("database")]
                     >> number;
@@ -77,6 +81,38 @@ initialize_parsers()
         | lit("$key")[_val = UQI_STREAM_KEY]
         | lit("$record")[_val = UQI_STREAM_RECORD]
       ;
+  stream_clause =
+        lit("$key")[_val = UQI_STREAM_KEY]
+        | lit("$record")[_val = UQI_STREAM_RECORD]
+      ;
+  operator_clause =
+        lit("<=")[_val = (int)Comparison::kLessEqual]
+        | lit(">=")[_val = (int)Comparison::kGreaterEqual]
+        | lit("==")[_val = (int)Comparison::kEqual]
+        | lit('<')[_val = (int)Comparison::kLess]
+        | lit('>')[_val = (int)Comparison::kGreater]
+        | lit('=')[_val = (int)Comparison::kEqual]
+      ;
+}
+
+// Adds a comparison ("$key > 5") of the WHERE clause
+static void
+add_comparison(SelectStatement &stmt, int stream, int op,
+                const std::string &constant)
+{
+  stmt.comparisons.push_back(Comparison(stream, op, constant));
+}
+
+// Adds a BETWEEN comparison ("$key BETWEEN 5 AND 10"); both bounds are
+// inclusive
+static void
+add_between(SelectStatement &stmt, int stream, const std::string &lower,
+                const std::string &upper)
+{
+  stmt.comparisons.push_back(Comparison(stream, Comparison::kGreaterEqual,
+                          lower));
+  stmt.comparisons.push_back(Comparison(stream, Comparison::kLessEqual,
+                          upper));
 }
 
 ups_status_t
@@ -93,6 +129,8 @@ Parser::parse_select(const char *query, SelectStatement &stmt)
   using boost::spirit::ascii::space;
   using boost::spirit::ascii::string;
   using boost::phoenix::ref;
+  using boost::spirit::qi::_2;
+  using boost::spirit::qi::_3;
 
   if (!initialized) {
     initialized = true;
@@ -103,17 +141,33 @@ Parser::parse_select(const char *query, SelectStatement &stmt)
   const char *last = first + std::strlen(first);
 
   qi::rule<const char *, SelectStatement(), ascii::space_type> parser;
+  qi::rule<const char *, ascii::space_type> condition;
 
   stmt.function.flags = 0;
   stmt.predicate.flags = 0;
+  stmt.comparisons.clear();
+  int predicates = 0;
+
+  // a condition of the WHERE clause is either a predicate plugin or a
+  // builtin comparison
+  condition =
+      (stream_clause >> operator_clause >> constant)
+          [boost::phoenix::bind(&add_comparison, ref(stmt), _1, _2, _3)]
+      | (stream_clause >> no_case[lit("between")] >> constant
+          >> no_case[lit("and")] >> constant)
+          [boost::phoenix::bind(&add_between, ref(stmt), _1, _2, _3)]
+      | (plugin_name[boost::phoenix::ref(stmt.predicate.name) = _1]
+          >> '(' >> input_clause [ref(stmt.predicate.flags) = _1]
+          >> lit(')')[++ref(predicates)])
+      ;
 
   parser %=
       -no_case[lit("distinct")] [ref(stmt.distinct) = true]
       >> plugin_name[boost::phoenix::ref(stmt.function.name) = _1]
         >> '(' >> input_clause [ref(stmt.function.flags) = _1] >> ')'
       >> from_clause [ref(stmt.dbid) = _1]
-      >> -(where_clause[boost::phoenix::ref(stmt.predicate.name) = _1]
-        >> '(' >> input_clause [ref(stmt.predicate.flags) = _1] >> ')')
+      >> -(no_case[lit("where")] >> condition
+        >> *(no_case[lit("and")] >> condition))
       >> -limit_clause [ref(stmt.limit) = _1]
       >> -char_(';')
       ;
@@ -122,6 +176,12 @@ Parser::parse_select(const char *query, SelectStatement &stmt)
   if (!r || first != last)
     return UPS_PARSER_ERROR;
 
+  // only one predicate plugin is supported
+  if (predicates > 1) {
+    ups_trace(("only one predicate function is allowed"));
+    return UPS_PARSER_ERROR;
+  }
+
   ups_status_t st;
 
   // Split |function|; delimiter character is '@' (optional). The function
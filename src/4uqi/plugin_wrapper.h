@@ -28,6 +28,8 @@
 #include "ups/upscaledb_uqi.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/dynamic_array.h"
+#include "4uqi/type_wrapper.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -72,6 +74,30 @@ struct PredicatePluginWrapper : PluginWrapperBase
                   const void *record_data, uint32_t record_size) {
     return plugin->pred(state, key_data, key_size, record_data, record_size);
   }
+
+  // Evaluates the predicate for arrays of fixed-length keys and records.
+  // Returns a mask with one byte per element (1 if the predicate matched,
+  // otherwise 0) and stores the number of matches in |*pcount|.
+  template<typename Key, typename Record>
+  const uint8_t *evaluate(const void *key_data, const void *record_data,
+                  size_t length, size_t *pcount) {
+    Sequence<Key> keys(key_data, length);
+    Sequence<Record> records(record_data, length);
+    typename Sequence<Key>::iterator kit = keys.begin();
+    typename Sequence<Record>::iterator rit = records.begin();
+
+    uint8_t *mask = selection.resize(length);
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++, kit++, rit++) {
+      mask[i] = pred(kit, kit->size(), rit, rit->size()) ? 1 : 0;
+      count += mask[i];
+    }
+    *pcount = count;
+    return mask;
+  }
+
+  // The mask returned by |evaluate()|
+  ByteArray selection;
 };
 
 struct AggregatePluginWrapper : PluginWrapperBase
@@ -58,6 +58,17 @@ struct Result
     add_record(record_data, record_size);
   }
 
+  // Removes all rows; the key and record types are not modified
+  void clear() {
+    row_count = 0;
+    next_key_offset = 0;
+    next_record_offset = 0;
+    key_offsets.clear();
+    record_offsets.clear();
+    key_data.clear();
+    record_data.clear();
+  }
+
   void move_from(Result &other) {
     row_count = other.row_count;
     key_type = other.key_type;
@@ -53,6 +53,10 @@ struct ScanVisitor
     : statement(stmt) {
   }
 
+  // Destructor
+  virtual ~ScanVisitor() {
+  }
+
   // Operates on a single key/value pair
   virtual void operator()(const void *key_data, uint16_t key_size, 
                   const void *record_data, uint32_t record_size) = 0;
@@ -64,6 +68,27 @@ struct ScanVisitor
   // Assigns the internal result to |result|
   virtual void assign_result(uqi_result_t *result) = 0;
 
+  // Moves the rows which were produced so far to |result|; required
+  // by uqi_cursor_t, which returns the rows while the database is scanned.
+  // Returns false if the visitor aggregates its input, and the result is
+  // only available when the scan is complete.
+  virtual bool flush_rows(uqi_result_t *result) {
+    return false;
+  }
+
+  // Returns true if the partial results of several visitors can be
+  // combined with merge(); required for parallel scans
+  virtual bool supports_merge() const {
+    return false;
+  }
+
+  // Merges the partial result of |other| into this visitor. |other| was
+  // created for the same statement and scanned the keys which follow the
+  // keys of this visitor.
+  virtual void merge(ScanVisitor *other) {
+    assert(!"shouldn't be here");
+  }
+
   // The select statement
   SelectStatement *statement;
 };
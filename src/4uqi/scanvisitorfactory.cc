@@ -28,6 +28,7 @@
 #include "4uqi/average.h"
 #include "4uqi/bottom.h"
 #include "4uqi/count.h"
+#include "4uqi/filter.h"
 #include "4uqi/minmax.h"
 #include "4uqi/sum.h"
 #include "4uqi/top.h"
@@ -137,8 +138,8 @@ struct PluginProxyIfScanVisitor : public ScanVisitor {
   PredicatePluginWrapper pred_plugin;
 };
 
-ScanVisitor *
-ScanVisitorFactory::from_select(SelectStatement *stmt, LocalDb *db)
+static ScanVisitor *
+create_visitor(SelectStatement *stmt, LocalDb *db)
 {
   const DbConfig *cfg = &db->config;
 
@@ -226,5 +227,23 @@ ScanVisitorFactory::from_select(SelectStatement *stmt, LocalDb *db)
   return ScanVisitorFactoryHelper::create<PluginProxyIfScanVisitor>(cfg, stmt);
 }
 
+ScanVisitor *
+ScanVisitorFactory::from_select(SelectStatement *stmt, LocalDb *db)
+{
+  // convert the builtin comparisons ("$key > 5") to key and record ranges
+  if (!stmt->comparisons.empty()
+        && !RangeFilterScanVisitorFactory::resolve(&db->config, stmt))
+    return 0;
+
+  ScanVisitor *visitor = create_visitor(stmt, db);
+  if (!visitor)
+    return 0;
+
+  // filter by key or record ranges?
+  if (stmt->key_range.is_set() || stmt->record_range.is_set())
+    return RangeFilterScanVisitorFactory::create(&db->config, stmt, visitor);
+  return visitor;
+}
+
 } // namespace upscaledb
 
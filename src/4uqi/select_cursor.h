@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * UQI cursors; they return the rows of a query in chunks while the
+ * database is scanned, instead of materializing the whole result
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef UPS_UQI_SELECT_CURSOR_H
+#define UPS_UQI_SELECT_CURSOR_H
+
+#include "0root/root.h"
+
+#include "ups/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct Env;
+struct Result;
+
+//
+// The struct SelectCursor is the actual implementation of uqi_cursor_t.
+//
+struct SelectCursor
+{
+  // Constructor
+  SelectCursor(Env *env_)
+    : env(env_) {
+  }
+
+  // Destructor
+  virtual ~SelectCursor() {
+  }
+
+  // Retrieves the next chunk of rows. Returns UPS_KEY_NOT_FOUND if all
+  // rows were returned. (uqi_cursor_next)
+  virtual ups_status_t next(Result **result) = 0;
+
+  // The Environment which executes the query
+  Env *env;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_UQI_SELECT_CURSOR_H */
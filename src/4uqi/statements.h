@@ -26,10 +26,12 @@
 #include "0root/root.h"
 
 #include <string>
+#include <vector>
 
 #include "ups/upscaledb_uqi.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "3btree/btree_zone_map.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -47,6 +49,28 @@ struct FunctionDesc{
   std::string library;
 };
 
+// A comparison of the key or the record with a constant, i.e.
+// "$key >= 100". The constant is converted to the type of the key or
+// record when the statement is executed.
+struct Comparison {
+  enum {
+    kEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual
+  };
+
+  Comparison(int stream_ = 0, int op_ = kEqual,
+                  const std::string &constant_ = "")
+    : stream(stream_), op(op_), constant(constant_) {
+  }
+
+  int stream;           // UQI_STREAM_KEY or UQI_STREAM_RECORD
+  int op;               // kEqual, kLess etc
+  std::string constant; // the constant, as specified in the query
+};
+
 struct SelectStatement {
   // constructor
   SelectStatement()
@@ -81,11 +105,43 @@ struct SelectStatement {
   // the resolved predicate plugin
   uqi_plugin_t *predicate_plg;
 
+  // the builtin comparisons of the WHERE clause; they are converted to
+  // |key_range| and |record_range| before the statement is executed
+  std::vector<Comparison> comparisons;
+
   // internal flag for the Btree scan
   bool requires_keys;
 
   // internal flag for the Btree scan
   bool requires_records;
+
+  // an optional range of the (numeric) keys; keys outside of the range
+  // are skipped
+  ValueRange key_range;
+
+  // an optional range of the (numeric) records; records outside of the
+  // range are skipped
+  ValueRange record_range;
+};
+
+struct Env;
+
+// A prepared statement (uqi_prepare); the query is parsed and its plugins
+// are resolved only once. Each execution works on a copy of |stmt|,
+// because the scan modifies the statement.
+struct PreparedStatement {
+  PreparedStatement(Env *env_, const char *query_)
+    : env(env_), query(query_) {
+  }
+
+  // the Environment which executes the statement
+  Env *env;
+
+  // the original query string
+  std::string query;
+
+  // the parsed statement
+  SelectStatement stmt;
 };
 
 } // namespace upscaledb
@@ -20,6 +20,7 @@
 
 #include "1base/error.h"
 #include "2config/db_config.h"
+#include "4uqi/kernels.h"
 #include "4uqi/plugin_wrapper.h"
 #include "4uqi/type_wrapper.h"
 #include "4uqi/statements.h"
@@ -62,18 +63,10 @@ struct SumScanVisitor : public NumericalScanVisitor {
   // Operates on an array of keys
   virtual void operator()(const void *key_data, const void *record_data,
                   size_t length) {
-    if (ISSET(statement->function.flags, UQI_STREAM_KEY)) {
-      typename Key::type *it = (typename Key::type *)key_data;
-      typename Key::type *end = it + length;
-      for (; it != end; it++)
-        sum += *it;
-    }
-    else {
-      typename Record::type *it = (typename Record::type *)record_data;
-      typename Record::type *end = it + length;
-      for (; it != end; it++)
-        sum += *it;
-    }
+    if (ISSET(statement->function.flags, UQI_STREAM_KEY))
+      sum += Kernels::sum((const typename Key::type *)key_data, length);
+    else
+      sum += Kernels::sum((const typename Record::type *)record_data, length);
   }
 
   // Assigns the result to |result|
@@ -82,6 +75,16 @@ struct SumScanVisitor : public NumericalScanVisitor {
     uqi_result_add_row(result, "SUM", 4, &sum, sizeof(sum));
   }
 
+  // Partial sums are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Adds the sum of |other|
+  virtual void merge(ScanVisitor *other) {
+    sum += static_cast<SumScanVisitor *>(other)->sum;
+  }
+
   // The aggregated sum
   ResultType sum;
 };
@@ -162,25 +165,17 @@ struct SumIfScanVisitor : public NumericalScanVisitor {
   // Operates on an array of keys and records (both with fixed length)
   virtual void operator()(const void *key_data, const void *record_data,
                   size_t length) {
-    Sequence<Key> keys(key_data, length);
-    Sequence<Record> records(record_data, length);
-    typename Sequence<Key>::iterator kit = keys.begin();
-    typename Sequence<Record>::iterator rit = records.begin();
-
-    if (ISSET(statement->function.flags, UQI_STREAM_KEY)) {
-      for (; kit != keys.end(); kit++, rit++) {
-        if (plugin.pred(kit, kit->size(), rit, rit->size())) {
-          sum += kit->value;
-        }
-      }
-    }
-    else {
-      for (; kit != keys.end(); kit++, rit++) {
-        if (plugin.pred(kit, kit->size(), rit, rit->size())) {
-          sum += rit->value;
-        }
-      }
-    }
+    size_t matches;
+    const uint8_t *mask = plugin.evaluate<Key, Record>(key_data, record_data,
+                    length, &matches);
+    if (matches == 0)
+      return;
+
+    if (ISSET(statement->function.flags, UQI_STREAM_KEY))
+      sum += Kernels::sum((const typename Key::type *)key_data, length, mask);
+    else
+      sum += Kernels::sum((const typename Record::type *)record_data,
+                      length, mask);
   }
 
   // Assigns the result to |result|
@@ -189,6 +184,16 @@ struct SumIfScanVisitor : public NumericalScanVisitor {
     uqi_result_add_row(result, "SUM", 4, &sum, sizeof(sum));
   }
 
+  // Partial sums are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Adds the sum of |other|
+  virtual void merge(ScanVisitor *other) {
+    sum += static_cast<SumIfScanVisitor *>(other)->sum;
+  }
+
   // The aggreated sum
   ResultType sum;
 
@@ -101,6 +101,25 @@ struct TopScanVisitorBase : public NumericalScanVisitor {
     }
   }
 
+  // Partial results are mergeable
+  virtual bool supports_merge() const {
+    return true;
+  }
+
+  // Feeds the values stored in |other| into this visitor
+  virtual void merge(ScanVisitor *other) {
+    TopScanVisitorBase *o = static_cast<TopScanVisitorBase *>(other);
+
+    for (typename KeyMap::iterator it = o->stored_keys.begin();
+                    it != o->stored_keys.end(); it++)
+      min_key = store_min_value(it->first, min_key, it->second.data(),
+                      it->second.size(), stored_keys, statement->limit);
+    for (typename RecordMap::iterator it = o->stored_records.begin();
+                    it != o->stored_records.end(); it++)
+      min_record = store_min_value(it->first, min_record, it->second.data(),
+                      it->second.size(), stored_records, statement->limit);
+  }
+
   // The minimum value currently stored in |keys|
   Key min_key;
 
@@ -26,6 +26,8 @@
 #include "4uqi/plugins.h"
 #include "4uqi/result.h"
 #include "4uqi/scanvisitor.h"
+#include "4uqi/select_cursor.h"
+#include "4uqi/statements.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -151,6 +153,144 @@ uqi_select_range(ups_env_t *henv, const char *query, ups_cursor_t *begin,
   }
 }
 
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_prepare(ups_env_t *henv, const char *query, uqi_statement_t **pstatement)
+{
+  if (!henv) {
+    ups_trace(("parameter 'env' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!query) {
+    ups_trace(("parameter 'query' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!pstatement) {
+    ups_trace(("parameter 'statement' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+
+  *pstatement = 0;
+
+  Env *env = (Env *)henv;
+  ScopedLock lock(env->mutex);
+
+  PreparedStatement *stmt = new PreparedStatement(env, query);
+  try {
+    ups_status_t st = env->prepare_select(stmt);
+    if (unlikely(st)) {
+      delete stmt;
+      return st;
+    }
+  }
+  catch (Exception &ex) {
+    delete stmt;
+    return ex.code;
+  }
+
+  *pstatement = (uqi_statement_t *)stmt;
+  return 0;
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_execute(uqi_statement_t *statement, ups_cursor_t *begin,
+                    const ups_cursor_t *end, uqi_result_t **result)
+{
+  if (!statement) {
+    ups_trace(("parameter 'statement' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!result) {
+    ups_trace(("parameter 'result' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+
+  PreparedStatement *stmt = (PreparedStatement *)statement;
+  ScopedLock lock(stmt->env->mutex);
+
+  try {
+    return stmt->env->select_range(stmt,
+                        (upscaledb::Cursor *)begin,
+                        (upscaledb::Cursor *)end,
+                        (upscaledb::Result **)result);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
+UPS_EXPORT void UPS_CALLCONV
+uqi_statement_close(uqi_statement_t *statement)
+{
+  delete ((PreparedStatement *)statement);
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_cursor_open(ups_env_t *henv, const char *query, ups_cursor_t *begin,
+                    const ups_cursor_t *end, uqi_cursor_t **pcursor)
+{
+  if (!henv) {
+    ups_trace(("parameter 'env' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!query) {
+    ups_trace(("parameter 'query' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!pcursor) {
+    ups_trace(("parameter 'cursor' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+
+  *pcursor = 0;
+
+  Env *env = (Env *)henv;
+  ScopedLock lock(env->mutex);
+
+  try {
+    return env->select_cursor(query,
+                        (upscaledb::Cursor *)begin,
+                        (upscaledb::Cursor *)end,
+                        (upscaledb::SelectCursor **)pcursor);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+uqi_cursor_next(uqi_cursor_t *hcursor, uqi_result_t **result)
+{
+  if (!hcursor) {
+    ups_trace(("parameter 'cursor' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+  if (!result) {
+    ups_trace(("parameter 'result' cannot be null"));
+    return UPS_INV_PARAMETER;
+  }
+
+  SelectCursor *cursor = (SelectCursor *)hcursor;
+  ScopedLock lock(cursor->env->mutex);
+
+  try {
+    return cursor->next((upscaledb::Result **)result);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
+UPS_EXPORT void UPS_CALLCONV
+uqi_cursor_close(uqi_cursor_t *hcursor)
+{
+  if (!hcursor)
+    return;
+
+  SelectCursor *cursor = (SelectCursor *)hcursor;
+  ScopedLock lock(cursor->env->mutex);
+  delete cursor;
+}
+
 UPS_EXPORT void UPS_CALLCONV
 uqi_result_initialize(uqi_result_t *result, int key_type, int record_type)
 {
@@ -83,6 +83,13 @@ struct ValueScanVisitor : public ScanVisitor {
     final_result->move_from(aggregator);
   }
 
+  // Moves the rows which were collected so far to |result|
+  virtual bool flush_rows(uqi_result_t *result) {
+    ((Result *)result)->move_from(aggregator);
+    aggregator.clear();
+    return true;
+  }
+
   // The aggregated result
   Result aggregator;
 };
@@ -153,6 +160,13 @@ struct ValueIfScanVisitor : public ScanVisitor {
     final_result->move_from(aggregator);
   }
 
+  // Moves the rows which were collected so far to |result|
+  virtual bool flush_rows(uqi_result_t *result) {
+    ((Result *)result)->move_from(aggregator);
+    aggregator.clear();
+    return true;
+  }
+
   // The aggregated result
   Result aggregator;
 
@@ -1738,31 +1738,15 @@ handle_cursor_close(Session *session, SerializedWrapper *request)
 }
 
 static void
-handle_select_range(Session *session, Protocol *request)
+send_select_range_reply(Session *session, ups_status_t st, Result *r,
+                uint64_t select_cursor_handle)
 {
-  ups_status_t st = 0;
-
-  assert(request != 0);
-  assert(request->has_select_range_request());
-
-  Cursor *begin = 0;
-  if (request->select_range_request().begin_cursor_handle())
-    begin = session->server->cursors.get(request->select_range_request().begin_cursor_handle());
-  Cursor *end = 0;
-  if (request->select_range_request().end_cursor_handle())
-    end = session->server->cursors.get(request->select_range_request().end_cursor_handle());
-
-  Env *env = session->server->environments.get(request->select_range_request().env_handle());
-  const char *query = request->select_range_request().query().c_str();
-
-  uqi_result_t *result = 0;
-  st = uqi_select_range((ups_env_t *)env, query, (ups_cursor_t *)begin,
-                        (ups_cursor_t *)end, &result);
-
-  Result *r = (Result *)result;
   Protocol reply(Protocol::SELECT_RANGE_REPLY);
   reply.mutable_select_range_reply()->set_status(st);
-  if (unlikely(st != 0)) {
+  if (select_cursor_handle)
+    reply.mutable_select_range_reply()->set_select_cursor_handle(
+                    select_cursor_handle);
+  if (unlikely(st != 0 || !r)) {
     reply.mutable_select_range_reply()->set_row_count(0);
     reply.mutable_select_range_reply()->set_key_type(0);
     reply.mutable_select_range_reply()->set_record_type(0);
@@ -1785,11 +1769,83 @@ handle_select_range(Session *session, Protocol *request)
   for (uint32_t i = 0; i < r->row_count; i++)
     reply.mutable_select_range_reply()->add_record_offsets(r->record_offsets[i]);
 
-  uqi_result_close(result);
-
   send_wrapper(session, &reply);
 }
 
+static void
+handle_select_cursor(Session *session, Protocol *request)
+{
+  ups_status_t st = 0;
+  uint64_t handle = request->select_range_request().select_cursor_handle();
+  uqi_cursor_t *cursor = (uqi_cursor_t *)session->server->select_cursors.get(handle);
+  uqi_result_t *result = 0;
+
+  if (!cursor)
+    st = UPS_INV_PARAMETER;
+  else if (request->select_range_request().close_cursor())
+    handle = 0;
+  else
+    st = uqi_cursor_next(cursor, &result);
+
+  // close the cursor after the last chunk
+  if (cursor && (st || handle == 0)) {
+    uqi_cursor_close(cursor);
+    session->server->select_cursors.remove(
+                    request->select_range_request().select_cursor_handle());
+    handle = 0;
+  }
+
+  send_select_range_reply(session, st, (Result *)result, handle);
+  if (result)
+    uqi_result_close(result);
+}
+
+static void
+handle_select_range(Session *session, Protocol *request)
+{
+  ups_status_t st = 0;
+
+  assert(request != 0);
+  assert(request->has_select_range_request());
+
+  // the next chunk of an open cursor?
+  if (request->select_range_request().select_cursor_handle()) {
+    handle_select_cursor(session, request);
+    return;
+  }
+
+  Cursor *begin = 0;
+  if (request->select_range_request().begin_cursor_handle())
+    begin = session->server->cursors.get(request->select_range_request().begin_cursor_handle());
+  Cursor *end = 0;
+  if (request->select_range_request().end_cursor_handle())
+    end = session->server->cursors.get(request->select_range_request().end_cursor_handle());
+
+  Env *env = session->server->environments.get(request->select_range_request().env_handle());
+  const char *query = request->select_range_request().query().c_str();
+
+  // open a cursor; the rows are fetched in subsequent requests
+  if (request->select_range_request().open_cursor()) {
+    uqi_cursor_t *cursor = 0;
+    uint64_t handle = 0;
+    st = uqi_cursor_open((ups_env_t *)env, query, (ups_cursor_t *)begin,
+                        (ups_cursor_t *)end, &cursor);
+    if (st == 0)
+      handle = session->server->select_cursors.allocate(
+                      (SelectCursor *)cursor);
+    send_select_range_reply(session, st, 0, handle);
+    return;
+  }
+
+  uqi_result_t *result = 0;
+  st = uqi_select_range((ups_env_t *)env, query, (ups_cursor_t *)begin,
+                        (ups_cursor_t *)end, &result);
+
+  send_select_range_reply(session, st, (Result *)result, 0);
+  if (result)
+    uqi_result_close(result);
+}
+
 // returns false if client should be closed, otherwise true
 static bool
 dispatch(Session *session, uint32_t magic, uint8_t *data, uint32_t size)
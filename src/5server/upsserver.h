@@ -46,6 +46,7 @@ namespace upscaledb {
 typedef std::map<std::string, Env *> EnvironmentMap;
 
 struct Server;
+struct SelectCursor;
 
 using boost::asio::ip::tcp;
 
@@ -230,6 +231,7 @@ struct Server {
   HandleVector<Db> databases;
   HandleVector<Cursor> cursors;
   HandleVector<Txn> transactions;
+  HandleVector<SelectCursor> select_cursors;
 };
 
 } // namespace upscaledb
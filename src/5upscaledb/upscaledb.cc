@@ -333,6 +333,25 @@ ups_env_create(ups_env_t **henv, const char *filename,
         }
         config.journal_compressor = (int)param->value;
         break;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        if (ISSET(flags, UPS_IN_MEMORY)) {
+          ups_trace(("page compression not allowed in combination with "
+                  "UPS_IN_MEMORY"));
+          return UPS_INV_PARAMETER;
+        }
+        if (!CompressorFactory::is_available((int)param->value)) {
+          ups_trace(("unknown algorithm for page compression"));
+          return UPS_INV_PARAMETER;
+        }
+        config.page_compressor = (int)param->value;
+        break;
+      case UPS_PARAM_COMPRESSION_LEVEL:
+        if (param->value > 22) {
+          ups_trace(("invalid compression level %u", (int)param->value));
+          return UPS_INV_PARAMETER;
+        }
+        config.compression_level = (int)param->value;
+        break;
       case UPS_PARAM_CACHESIZE:
         if (ISSET(flags, UPS_IN_MEMORY) && param->value != 0) {
           ups_trace(("combination of UPS_IN_MEMORY and cache size != 0 "
@@ -348,6 +367,31 @@ ups_env_create(ups_env_t **henv, const char *filename,
         if (param->value > 0)
           config.cache_size_bytes = (size_t)param->value;
         break;
+      case UPS_PARAM_COMPRESSED_CACHE_SIZE:
+        if (ISSET(flags, UPS_IN_MEMORY) && param->value != 0) {
+          ups_trace(("combination of UPS_IN_MEMORY and compressed cache "
+                "size != 0 not allowed"));
+          return UPS_INV_PARAMETER;
+        }
+        config.compressed_cache_size_bytes = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_DELTAS:
+        if (ISSET(flags, UPS_IN_MEMORY) && param->value != 0) {
+          ups_trace(("combination of UPS_IN_MEMORY and journal deltas "
+                "not allowed"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_deltas = param->value != 0;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENT_SIZE:
+        config.journal_segment_size = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENTS:
+        config.journal_segments = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        config.journal_checkpoint_interval = param->value;
+        break;
       case UPS_PARAM_PAGE_SIZE:
         if (param->value != 1024 && param->value % 2048 != 0) {
           ups_trace(("invalid page size - must be 1024 or a multiple of 2048"));
@@ -388,6 +432,9 @@ ups_env_create(ups_env_t **henv, const char *filename,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case UPS_PARAM_UQI_THREADS:
+        config.uqi_threads = (int)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -400,6 +447,13 @@ ups_env_create(ups_env_t **henv, const char *filename,
     return UPS_INV_PARAMETER;
   }
 
+  /* encrypted pages cannot be compressed */
+  if (unlikely(config.page_compressor && config.is_encryption_enabled)) {
+    ups_trace(("combination of UPS_PARAM_PAGE_COMPRESSION and "
+            "UPS_PARAM_ENCRYPTION_KEY not allowed"));
+    return UPS_INV_PARAMETER;
+  }
+
   config.flags = flags;
 
   /*
@@ -498,6 +552,17 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
         ups_trace(("Journal compression parameters are only allowed in "
                     "ups_env_create"));
         return UPS_INV_PARAMETER;
+      case UPS_PARAM_PAGE_COMPRESSION:
+        ups_trace(("Page compression parameters are only allowed in "
+                    "ups_env_create"));
+        return UPS_INV_PARAMETER;
+      case UPS_PARAM_COMPRESSION_LEVEL:
+        if (param->value > 22) {
+          ups_trace(("invalid compression level %u", (int)param->value));
+          return UPS_INV_PARAMETER;
+        }
+        config.compression_level = (int)param->value;
+        break;
       case UPS_PARAM_CACHE_SIZE:
         /* don't allow cache limits with unlimited cache */
         if (ISSET(flags, UPS_CACHE_UNLIMITED) && param->value != 0) {
@@ -508,6 +573,31 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
         if (param->value > 0)
           config.cache_size_bytes = param->value;
         break;
+      case UPS_PARAM_COMPRESSED_CACHE_SIZE:
+        if (ISSET(flags, UPS_IN_MEMORY) && param->value != 0) {
+          ups_trace(("combination of UPS_IN_MEMORY and compressed cache "
+                "size != 0 not allowed"));
+          return UPS_INV_PARAMETER;
+        }
+        config.compressed_cache_size_bytes = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_DELTAS:
+        if (ISSET(flags, UPS_IN_MEMORY) && param->value != 0) {
+          ups_trace(("combination of UPS_IN_MEMORY and journal deltas "
+                "not allowed"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_deltas = param->value != 0;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENT_SIZE:
+        config.journal_segment_size = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_SEGMENTS:
+        config.journal_segments = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        config.journal_checkpoint_interval = param->value;
+        break;
       case UPS_PARAM_FILE_SIZE_LIMIT:
         if (param->value > 0)
           config.file_size_limit_bytes = (size_t)param->value;
@@ -534,6 +624,12 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case UPS_PARAM_UQI_THREADS:
+        config.uqi_threads = (int)param->value;
+        break;
+      case UPS_PARAM_RECOVERY_THREADS:
+        config.recovery_threads = (uint32_t)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -1073,6 +1169,36 @@ ups_db_check_integrity(ups_db_t *hdb, uint32_t flags)
   }
 }
 
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_db_train_dictionary(ups_db_t *hdb, uint32_t sample_count,
+                uint32_t dictionary_size, uint32_t flags)
+{
+  Db *db = (Db *)hdb;
+
+  if (unlikely(!db)) {
+    ups_trace(("parameter 'db' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(flags)) {
+    ups_trace(("unknown flag 0x%u", flags));
+    return UPS_INV_PARAMETER;
+  }
+
+  LocalDb *ldb = dynamic_cast<LocalDb *>(db);
+  if (unlikely(!ldb)) {
+    ups_trace(("operation not possible for remote databases"));
+    return UPS_NOT_IMPLEMENTED;
+  }
+
+  try {
+    ScopedLock lock(db->env->mutex);
+    return ldb->train_dictionary(sample_count, dictionary_size);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
 UPS_EXPORT ups_status_t UPS_CALLCONV
 ups_db_close(ups_db_t *hdb, uint32_t flags)
 {
@@ -1709,3 +1835,130 @@ ups_db_bulk_operations(ups_db_t *hdb, ups_txn_t *txn,
     return ex.code;
   }
 }
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_env_open_journal_cursor(ups_env_t *henv, uint64_t start_lsn,
+                    uint32_t flags, ups_journal_cursor_t **cursor)
+{
+  if (unlikely(henv == 0)) {
+    ups_trace(("parameter 'env' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(cursor == 0)) {
+    ups_trace(("parameter 'cursor' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(flags & ~UPS_JOURNAL_INCLUDE_CHANGESETS)) {
+    ups_trace(("unknown flag 0x%u", flags));
+    return UPS_INV_PARAMETER;
+  }
+
+  *cursor = 0;
+
+  LocalEnv *env = dynamic_cast<LocalEnv *>((Env *)henv);
+  if (unlikely(!env)) {
+    ups_trace(("operation not possible for remote environments"));
+    return UPS_NOT_IMPLEMENTED;
+  }
+
+  try {
+    ScopedLock lock(env->mutex);
+    if (unlikely(!env->journal.get())) {
+      ups_trace(("the environment does not have a journal"));
+      return UPS_INV_PARAMETER;
+    }
+
+    JournalTail *tail = new JournalTail(env->journal.get(), start_lsn,
+                    ISSET(flags, UPS_JOURNAL_INCLUDE_CHANGESETS)
+                        ? JournalTail::kIncludeChangesets
+                        : 0);
+    env->journal->attach_tail(tail);
+    *cursor = (ups_journal_cursor_t *)tail;
+    return 0;
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_journal_cursor_next(ups_journal_cursor_t *cursor,
+                    ups_journal_entry_t *entry)
+{
+  if (unlikely(cursor == 0)) {
+    ups_trace(("parameter 'cursor' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(entry == 0)) {
+    ups_trace(("parameter 'entry' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+
+  JournalTail *tail = (JournalTail *)cursor;
+  LocalEnv *env = tail->journal->state.env;
+
+  try {
+    ScopedLock lock(env->mutex);
+    const uint8_t *data;
+    uint32_t size;
+    if (!tail->journal->read_tail(tail, &data, &size))
+      return UPS_KEY_NOT_FOUND;
+
+    PJournalEntry *p = (PJournalEntry *)data;
+    entry->lsn = p->lsn;
+    entry->txn_id = p->txn_id;
+    entry->type = p->type;
+    entry->dbname = p->dbname;
+    entry->size = size;
+    entry->data = data;
+    return 0;
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_journal_cursor_close(ups_journal_cursor_t *cursor)
+{
+  if (unlikely(cursor == 0)) {
+    ups_trace(("parameter 'cursor' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+
+  JournalTail *tail = (JournalTail *)cursor;
+  LocalEnv *env = tail->journal->state.env;
+
+  ScopedLock lock(env->mutex);
+  tail->journal->detach_tail(tail);
+  delete tail;
+  return 0;
+}
+
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_env_apply_journal_entry(ups_env_t *henv, const ups_journal_entry_t *entry)
+{
+  if (unlikely(henv == 0)) {
+    ups_trace(("parameter 'env' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+  if (unlikely(entry == 0 || entry->data == 0)) {
+    ups_trace(("parameter 'entry' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+
+  LocalEnv *env = dynamic_cast<LocalEnv *>((Env *)henv);
+  if (unlikely(!env)) {
+    ups_trace(("operation not possible for remote environments"));
+    return UPS_NOT_IMPLEMENTED;
+  }
+
+  try {
+    ScopedLock lock(env->mutex);
+    return env->apply_journal_entry((const uint8_t *)entry->data,
+                    entry->size);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
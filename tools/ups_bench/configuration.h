@@ -84,16 +84,18 @@ struct Configuration
       use_remote(false), duplicate(kDuplicateDisabled), overwrite(false),
       transactions_nth(0), use_fsync(false), inmemory(false),
       use_transactions(false), no_mmap(false),
-      cacheunlimited(false), cachesize(0), pagesize(0),
+      cacheunlimited(false), cachesize(0), compressed_cachesize(0), pagesize(0),
       num_threads(1), use_cursors(false),
       use_berkeleydb(false), use_upscaledb(true), fullcheck(kFullcheckDefault),
       fullcheck_frequency(1000), metrics(kMetricsDefault),
       extkey_threshold(0), duptable_threshold(0), bulk_erase(false),
       disable_recovery(false),
-      journal_compression(0), record_compression(0), key_compression(0),
+      journal_compression(0), journal_deltas(false), record_compression(0),
+      key_compression(0), page_compression(0),
       read_only(false), enable_crc32(false), record_number32(false),
       record_number64(false), posix_fadvice(UPS_POSIX_FADVICE_NORMAL),
-      simulate_crashes(false), flush_txn_immediately(false) {
+      simulate_crashes(false), flush_txn_immediately(false),
+      record_deduplication(false), compression_level(0) {
   }
 
   const char *
@@ -126,12 +128,12 @@ struct Configuration
       "zlib",
       "snappy",
       "lzf",
-      "lzo",
+      "lz4",
       "zint32_varbyte",
       "zint32_simdcomp",
       "zint32_groupvarint",
       "zint32_streamvbyte",
-      "zint32_maskedvbyte",
+      "zstd",
       "zint32_for",
       "zint32_simdfor",
     };
@@ -139,12 +141,19 @@ struct Configuration
     if (journal_compression)
       std::cout << "--journal-compression=" << compressors[journal_compression]
           << " ";
+    if (journal_deltas)
+      std::cout << "--journal-deltas ";
     if (record_compression)
       std::cout << "--record-compression=" << compressors[record_compression]
           << " ";
     if (key_compression)
       std::cout << "--key-compression=" << compressors[key_compression]
           << " ";
+    if (page_compression)
+      std::cout << "--page-compression=" << compressors[page_compression]
+          << " ";
+    if (compression_level)
+      std::cout << "--compression-level=" << compression_level << " ";
     if (use_encryption)
       std::cout << "--use-encryption ";
     if (use_remote)
@@ -169,6 +178,8 @@ struct Configuration
       std::cout << "--cache=unlimited ";
     if (cachesize)
       std::cout << "--cache=" << cachesize << " ";
+    if (compressed_cachesize)
+      std::cout << "--compressed-cache=" << compressed_cachesize << " ";
     if (pagesize)
       std::cout << "--pagesize=" << pagesize << " ";
     if (num_threads > 1)
@@ -203,6 +214,8 @@ struct Configuration
       std::cout << "--record-number32 ";
     if (record_number64)
       std::cout << "--record-number64 ";
+    if (record_deduplication)
+      std::cout << "--record-deduplication ";
     if (posix_fadvice)
       std::cout << "--posix-fadvice="
                 << (posix_fadvice == UPS_POSIX_FADVICE_RANDOM
@@ -289,6 +302,7 @@ struct Configuration
   bool no_mmap;
   bool cacheunlimited;
   int cachesize;
+  int compressed_cachesize;
   int pagesize;
   int num_threads;
   bool use_cursors;
@@ -303,8 +317,10 @@ struct Configuration
   bool bulk_erase;
   bool disable_recovery;
   int journal_compression;
+  bool journal_deltas;
   int record_compression;
   int key_compression;
+  int page_compression;
   bool read_only;
   bool enable_crc32;
   bool record_number32;
@@ -312,6 +328,8 @@ struct Configuration
   int posix_fadvice;
   bool simulate_crashes;
   bool flush_txn_immediately;
+  bool record_deduplication;
+  int compression_level;
 };
 
 #endif /* UPS_BENCH_CONFIGURATION_H */
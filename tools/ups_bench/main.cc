@@ -91,6 +91,11 @@
 #define ARG_POSIX_FADVICE                       71
 #define ARG_SIMULATE_CRASHES                    72
 #define ARG_FLUSH_TXN_IMMEDIATELY               73
+#define ARG_RECORD_DEDUPLICATION                74
+#define ARG_COMPRESSION_LEVEL                   75
+#define ARG_PAGE_COMPRESSION                    76
+#define ARG_COMPRESSED_CACHE                    77
+#define ARG_JOURNAL_DELTAS                      78
 
 /*
  * command line parameters
@@ -371,19 +376,22 @@ static option_t opts[] = {
     ARG_JOURNAL_COMPRESSION,
     0,
     "journal-compression",
-    "Pro: Enables journal compression ('none', 'zlib', 'snappy', 'lzf')",
+    "Pro: Enables journal compression ('none', 'zlib', 'snappy', 'lzf', "
+            "'lz4', 'zstd')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_RECORD_COMPRESSION,
     0,
     "record-compression",
-    "Pro: Enables record compression ('none', 'zlib', 'snappy', 'lzf')",
+    "Pro: Enables record compression ('none', 'zlib', 'snappy', 'lzf', "
+            "'lz4', 'zstd')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_KEY_COMPRESSION,
     0,
     "key-compression",
-    "Pro: Enables key compression ('none', 'zlib', 'snappy', 'lzf')",
+    "Pro: Enables key compression ('none', 'zlib', 'snappy', 'lzf', "
+            "'lz4', 'zstd')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_READ_ONLY,
@@ -427,6 +435,37 @@ static option_t opts[] = {
     "flush-txn-immediately",
     "Immediately flushes transactions after they are committed",
     0 },
+  {
+    ARG_RECORD_DEDUPLICATION,
+    0,
+    "record-deduplication",
+    "Stores identical records only once",
+    0 },
+  {
+    ARG_COMPRESSION_LEVEL,
+    0,
+    "compression-level",
+    "Pro: Sets the compression level for zlib (1 - 9) and zstd (1 - 22)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_PAGE_COMPRESSION,
+    0,
+    "page-compression",
+    "Pro: Enables compression of B+tree leaf pages ('none', 'zlib', "
+            "'snappy', 'lzf', 'lz4', 'zstd')",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_COMPRESSED_CACHE,
+    0,
+    "compressed-cache",
+    "Sets the size of the compressed cache for evicted pages",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_DELTAS,
+    0,
+    "journal-deltas",
+    "Logs only the modified bytes of each page in the journal",
+    0 },
   {0, 0}
 };
 
@@ -441,6 +480,10 @@ parse_compression_type(std::string param)
     return (UPS_COMPRESSOR_SNAPPY);
   if (param == "lzf")
     return (UPS_COMPRESSOR_LZF);
+  if (param == "lz4")
+    return (UPS_COMPRESSOR_LZ4);
+  if (param == "zstd")
+    return (UPS_COMPRESSOR_ZSTD);
   if (param == "zint32_varbyte")
     return (UPS_COMPRESSOR_UINT32_VARBYTE);
   if (param == "zint32_simdcomp")
@@ -453,10 +496,15 @@ parse_compression_type(std::string param)
     return (UPS_COMPRESSOR_UINT32_GROUPVARINT);
   if (param == "zint32_streamvbyte")
     return (UPS_COMPRESSOR_UINT32_STREAMVBYTE);
+  if (param == "zint64_varbyte")
+    return (UPS_COMPRESSOR_UINT64_VARBYTE);
+  if (param == "zint64_for")
+    return (UPS_COMPRESSOR_UINT64_FOR);
   ::printf("invalid compression specifier '%s': expecting 'none', 'zlib', "
-              "'snappy', 'lzf', 'zint32_varbyte', 'zint32_simdcomp', "
+              "'snappy', 'lzf', 'lz4', 'zstd', 'zint32_varbyte', 'zint32_simdcomp', "
               "'zint32_groupvarint', 'zint32_streamvbyte', "
-              "'zint32_for', 'zint32_simdfor'\n",
+              "'zint32_for', 'zint32_simdfor', 'zint64_varbyte', "
+              "'zint64_for'\n",
               param.c_str());
   ::exit(-1);
 }
@@ -786,6 +834,15 @@ parse_config(int argc, char **argv, Configuration *c)
     else if (opt == ARG_KEY_COMPRESSION) {
       c->key_compression = parse_compression_type(param);
     }
+    else if (opt == ARG_PAGE_COMPRESSION) {
+      c->page_compression = parse_compression_type(param);
+    }
+    else if (opt == ARG_COMPRESSED_CACHE) {
+      c->compressed_cachesize = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_JOURNAL_DELTAS) {
+      c->journal_deltas = true;
+    }
     else if (opt == ARG_POSIX_FADVICE) {
       if (!strcmp(param, "normal"))
         c->posix_fadvice = UPS_POSIX_FADVICE_NORMAL;
@@ -821,6 +878,16 @@ parse_config(int argc, char **argv, Configuration *c)
     else if (opt == ARG_FLUSH_TXN_IMMEDIATELY) {
       c->flush_txn_immediately = true;
     }
+    else if (opt == ARG_RECORD_DEDUPLICATION) {
+      c->record_deduplication = true;
+    }
+    else if (opt == ARG_COMPRESSION_LEVEL) {
+      c->compression_level = param ? strtoul(param, 0, 0) : 0;
+      if (c->compression_level <= 0 || c->compression_level > 22) {
+        printf("[FAIL] invalid parameter for --compression-level\n");
+        exit(-1);
+      }
+    }
     else if (opt == ARG_READ_ONLY) {
       c->read_only = true;
     }
@@ -939,6 +1006,25 @@ print_metrics(Metrics *metrics, Configuration *conf)
     printf("\t%s key_compression                %.3f\n", name, ratio);
   }
 
+  // print page compression ratio
+  if (conf->page_compression && !strcmp(name, "upscaledb")) {
+    float ratio;
+    if (metrics->upscaledb_metrics.page_bytes_before_compression == 0)
+      ratio = 1.f;
+    else
+      ratio = (float)metrics->upscaledb_metrics.page_bytes_after_compression
+                  / metrics->upscaledb_metrics.page_bytes_before_compression;
+    printf("\t%s page_compression               %.3f\n", name, ratio);
+  }
+
+  // print the hits of the compressed cache
+  if (conf->compressed_cachesize && !strcmp(name, "upscaledb")) {
+    printf("\t%s compressed_cache_hits          %lu\n", name,
+        (long unsigned int)metrics->upscaledb_metrics.compressed_cache_hits);
+    printf("\t%s compressed_cache_misses        %lu\n", name,
+        (long unsigned int)metrics->upscaledb_metrics.compressed_cache_misses);
+  }
+
   if (conf->metrics != Configuration::kMetricsAll || strcmp(name, "upscaledb"))
     return;
 
@@ -970,6 +1056,28 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->upscaledb_metrics.blob_total_allocated);
   printf("\tupscaledb blob_total_read             %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.blob_total_read);
+  printf("\tupscaledb blob_slab_allocated         %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_slab_allocated);
+  printf("\tupscaledb blob_slab_reused            %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_slab_reused);
+  printf("\tupscaledb blob_slab_padding           %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_slab_padding);
+  printf("\tupscaledb blob_slab_pages_free        %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_slab_pages_with_free_space);
+  printf("\tupscaledb blob_partial_read           %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_partial_read);
+  printf("\tupscaledb blob_partial_read_bytes     %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_partial_read_bytes);
+  printf("\tupscaledb blob_dedup_hits             %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_dedup_hits);
+  printf("\tupscaledb blob_dedup_logical_bytes    %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_dedup_logical_bytes);
+  printf("\tupscaledb blob_dedup_stored_bytes     %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.blob_dedup_stored_bytes);
+  if (metrics->upscaledb_metrics.blob_dedup_stored_bytes)
+    printf("\tupscaledb blob_dedup_ratio            %f\n",
+          (double)metrics->upscaledb_metrics.blob_dedup_logical_bytes
+              / metrics->upscaledb_metrics.blob_dedup_stored_bytes);
   printf("\tupscaledb btree_smo_split             %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.btree_smo_split);
   printf("\tupscaledb btree_smo_merge             %lu\n",
@@ -980,6 +1088,27 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->upscaledb_metrics.extended_duptables);
   printf("\tupscaledb journal_bytes_flushed       %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.journal_bytes_flushed);
+  printf("\tupscaledb journal_writes              %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_writes);
+  if (metrics->upscaledb_metrics.journal_writes > 0)
+    printf("\tupscaledb journal_avg_write_latency   %.1f us\n",
+          (double)metrics->upscaledb_metrics.journal_write_latency_us
+              / metrics->upscaledb_metrics.journal_writes);
+  printf("\tupscaledb journal_max_write_latency   %lu us\n",
+          (long unsigned int)
+              metrics->upscaledb_metrics.journal_max_write_latency_us);
+  printf("\tupscaledb journal_segments            %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_segments);
+  printf("\tupscaledb journal_segments_recycled   %lu\n",
+          (long unsigned int)
+              metrics->upscaledb_metrics.journal_segments_recycled);
+  printf("\tupscaledb journal_checkpoints         %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_checkpoints);
+  printf("\tupscaledb journal_recovery_changesets %lu\n",
+          (long unsigned int)
+              metrics->upscaledb_metrics.journal_recovery_changesets);
+  printf("\tupscaledb journal_recovery_bytes      %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_bytes);
 }
 
 struct Callable {
@@ -1267,6 +1396,24 @@ bail:
   return (true);
 }
 
+// Copies the journal segments (test-ham.db.jrn0, test-ham.db.jrn1, ...)
+// to their backup files, or restores them from the backup files
+static void
+copy_journal_segments(bool restore)
+{
+  for (int i = 0; ; i++) {
+    char name[64];
+    ::snprintf(name, sizeof(name), "test-ham.db.jrn%d", i);
+    std::string backup = std::string(name) + ".bak";
+    if (!os::file_exists(restore ? backup.c_str() : name))
+      break;
+    if (restore)
+      os::copy(backup.c_str(), name);
+    else
+      os::copy(name, backup.c_str());
+  }
+}
+
 template<typename GeneratorType>
 static bool
 simulate_crash(Configuration *conf, GeneratorType *upscaledb,
@@ -1276,8 +1423,7 @@ simulate_crash(Configuration *conf, GeneratorType *upscaledb,
 
   // backup the database files; this is for upscaledb only!
   os::copy("test-ham.db", "test-ham.db.bak"); 
-  os::copy("test-ham.db.jrn0", "test-ham.db.jrn0.bak"); 
-  os::copy("test-ham.db.jrn1", "test-ham.db.jrn1.bak"); 
+  copy_journal_segments(false);
 
   // close both environments
   berkeleydb->close();
@@ -1289,8 +1435,7 @@ simulate_crash(Configuration *conf, GeneratorType *upscaledb,
 
   // restore the database file and the journals
   os::copy("test-ham.db.bak", "test-ham.db"); 
-  os::copy("test-ham.db.jrn0.bak", "test-ham.db.jrn0"); 
-  os::copy("test-ham.db.jrn1.bak", "test-ham.db.jrn1"); 
+  copy_journal_segments(true);
 
   // open both Environments
   berkeleydb->open();
@@ -73,7 +73,7 @@ UpscaleDatabase::do_create_env()
 {
   ups_status_t st = 0;
   uint32_t flags = 0;
-  ups_parameter_t params[6] = {{0, 0}};
+  ups_parameter_t params[10] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -87,6 +87,16 @@ UpscaleDatabase::do_create_env()
     params[p].name = UPS_PARAM_CACHE_SIZE;
     params[p].value = m_config->cachesize;
     p++;
+    if (m_config->compressed_cachesize) {
+      params[p].name = UPS_PARAM_COMPRESSED_CACHE_SIZE;
+      params[p].value = m_config->compressed_cachesize;
+      p++;
+    }
+    if (m_config->journal_deltas) {
+      params[p].name = UPS_PARAM_JOURNAL_DELTAS;
+      params[p].value = 1;
+      p++;
+    }
     params[p].name = UPS_PARAM_PAGE_SIZE;
     params[p].value = m_config->pagesize;
     p++;
@@ -103,6 +113,16 @@ UpscaleDatabase::do_create_env()
       params[p].value = m_config->journal_compression;
       p++;
     }
+    if (m_config->page_compression) {
+      params[p].name = UPS_PARAM_PAGE_COMPRESSION;
+      params[p].value = m_config->page_compression;
+      p++;
+    }
+    if (m_config->compression_level) {
+      params[p].name = UPS_PARAM_COMPRESSION_LEVEL;
+      params[p].value = m_config->compression_level;
+      p++;
+    }
 
     flags |= m_config->inmemory ? UPS_IN_MEMORY : 0; 
     flags |= m_config->no_mmap ? UPS_DISABLE_MMAP : 0; 
@@ -156,7 +176,7 @@ UpscaleDatabase::do_open_env()
 {
   ups_status_t st = 0;
   uint32_t flags = 0;
-  ups_parameter_t params[6] = {{0, 0}};
+  ups_parameter_t params[8] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -171,6 +191,16 @@ UpscaleDatabase::do_open_env()
     params[p].name = UPS_PARAM_CACHE_SIZE;
     params[p].value = m_config->cachesize;
     p++;
+    if (m_config->compressed_cachesize) {
+      params[p].name = UPS_PARAM_COMPRESSED_CACHE_SIZE;
+      params[p].value = m_config->compressed_cachesize;
+      p++;
+    }
+    if (m_config->journal_deltas) {
+      params[p].name = UPS_PARAM_JOURNAL_DELTAS;
+      params[p].value = 1;
+      p++;
+    }
     params[p].name = UPS_PARAM_POSIX_FADVISE;
     params[p].value = m_config->posix_fadvice;
     p++;
@@ -179,6 +209,11 @@ UpscaleDatabase::do_open_env()
       params[p].value = (uint64_t)"1234567890123456";
       p++;
     }
+    if (m_config->compression_level) {
+      params[p].name = UPS_PARAM_COMPRESSION_LEVEL;
+      params[p].value = m_config->compression_level;
+      p++;
+    }
 
     flags |= m_config->no_mmap ? UPS_DISABLE_MMAP : 0; 
     flags |= m_config->cacheunlimited ? UPS_CACHE_UNLIMITED : 0;
@@ -385,6 +420,9 @@ UpscaleDatabase::do_create_db(int id)
   flags |= m_config->duplicate ? UPS_ENABLE_DUPLICATES : 0;
   flags |= m_config->record_number32 ? UPS_RECORD_NUMBER32 : 0;
   flags |= m_config->record_number64 ? UPS_RECORD_NUMBER64 : 0;
+  flags |= m_config->record_deduplication
+                ? UPS_ENABLE_RECORD_DEDUPLICATION
+                : 0;
   if (m_config->force_records_inline)
     flags |= UPS_FORCE_RECORDS_INLINE;
 
@@ -85,6 +85,10 @@ get_compressor_name(int library) {
       return ("snappy");
     case UPS_COMPRESSOR_LZF:
       return ("lzf");
+    case UPS_COMPRESSOR_LZ4:
+      return ("lz4");
+    case UPS_COMPRESSOR_ZSTD:
+      return ("zstd");
     case UPS_COMPRESSOR_UINT32_VARBYTE:
       return ("varbyte");
     case UPS_COMPRESSOR_UINT32_SIMDCOMP:
@@ -95,6 +99,10 @@ get_compressor_name(int library) {
       return ("streamvbyte");
     case UPS_COMPRESSOR_UINT32_FOR:
       return ("for");
+    case UPS_COMPRESSOR_UINT64_VARBYTE:
+      return ("varbyte64");
+    case UPS_COMPRESSOR_UINT64_FOR:
+      return ("for64");
     default:
       return ("???");
   }
@@ -128,6 +136,7 @@ print_environment(ups_env_t *env) {
     {UPS_PARAM_PAGE_SIZE, 0},
     {UPS_PARAM_MAX_DATABASES, 0},
     {UPS_PARAM_JOURNAL_COMPRESSION, 0},
+    {UPS_PARAM_PAGE_COMPRESSION, 0},
     {0, 0}
   };
 
@@ -147,9 +156,30 @@ print_environment(ups_env_t *env) {
     if (params[2].value)
       printf("  journal compression:  %s\n",
                       get_compressor_name((int)params[2].value));
+    if (params[3].value)
+      printf("  page compression:     %s\n",
+                      get_compressor_name((int)params[3].value));
   }
 }
 
+static void
+print_blob_information(ups_env_t *env) {
+  ups_env_metrics_t metrics;
+
+  ups_status_t st = ups_env_get_metrics(env, &metrics);
+  if (st != UPS_SUCCESS)
+    error("ups_env_get_metrics", st);
+
+  printf("  slab pages w/ space:  %u\n",
+                  (unsigned)metrics.blob_slab_pages_with_free_space);
+  printf("  blobs in slab pages:  %u\n",
+                  (unsigned)metrics.blob_slab_allocated);
+  printf("  slab reuse:           %u\n",
+                  (unsigned)metrics.blob_slab_reused);
+  printf("  slab padding (bytes): %u\n",
+                  (unsigned)metrics.blob_slab_padding);
+}
+
 static void
 print_full_information(ups_db_t *db) {
   ups_cursor_t *cursor;
@@ -406,6 +436,8 @@ main(int argc, char **argv) {
 
   /* print information about the environment */
   print_environment(env);
+  if (btree && !quiet)
+    print_blob_information(env);
 
   /* get a list of all databases */
   st = ups_env_get_database_names(env, names, &names_count);
@@ -26,6 +26,7 @@
 #include "common.h"
 
 #define ARG_HELP      1
+#define ARG_THREADS   2
 
 /*
  * command line parameters
@@ -37,6 +38,12 @@ static option_t opts[] = {
     "help",         // long option
     "this help screen",   // help string
     0 },          // no flags
+  {
+    ARG_THREADS,
+    "t",
+    "threads",
+    "number of threads writing the recovered pages",
+    GETOPTS_NEED_ARGUMENT },
   { 0, 0, 0, 0, 0 } /* terminating element */
 };
 
@@ -50,6 +57,8 @@ int
 main(int argc, char **argv) {
   unsigned opt;
   const char *param, *filename = 0;
+  char *endptr = 0;
+  uint32_t threads = 0;
 
   ups_status_t st;
   ups_env_t *env;
@@ -66,12 +75,26 @@ main(int argc, char **argv) {
         }
         filename = param;
         break;
+      case ARG_THREADS:
+        if (!param) {
+          printf("Parameter `threads' is missing.\n");
+          return (-1);
+        }
+        threads = (uint32_t)strtoul(param, &endptr, 0);
+        if (endptr && *endptr) {
+          printf("Invalid parameter `threads'; numerical value "
+             "expected.\n");
+          return (-1);
+        }
+        break;
       case ARG_HELP:
         print_banner("ups_recover");
 
-        printf("usage: ups_recover file\n");
+        printf("usage: ups_recover [-t N] file\n");
         printf("usage: ups_recover -h\n");
         printf("     -h:     this help screen (alias: --help)\n");
+        printf("     -t N:   write the recovered pages with N threads "
+           "(alias: --threads=<arg>)\n");
         return (0);
       default:
         printf("Invalid or unknown parameter `%s'. "
@@ -99,8 +122,12 @@ main(int argc, char **argv) {
     error("ups_env_open", st);
 
   /* now start the recovery */
+  ups_parameter_t params[] = {
+    { UPS_PARAM_RECOVERY_THREADS, threads },
+    { 0, 0 }
+  };
   st = ups_env_open(&env, filename,
-        UPS_AUTO_RECOVERY | UPS_ENABLE_TRANSACTIONS, 0);
+        UPS_AUTO_RECOVERY | UPS_ENABLE_TRANSACTIONS, &params[0]);
   if (st)
     error("ups_env_open", st);
 
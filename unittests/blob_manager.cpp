@@ -21,6 +21,7 @@
 #include "os.hpp"
 #include "fixture.hpp"
 
+#include "2device/device_disk.h"
 #include "3page_manager/page_manager.h"
 #include "3btree/btree_flags.h"
 #include "3blob_manager/blob_manager_disk.h"
@@ -77,14 +78,14 @@ struct BlobManagerFixture : BaseFixture {
   ScopedPtr<Context> context;
 
   BlobManagerFixture(uint32_t flags = 0, uint32_t cache_size = 0,
-                  uint32_t page_size = 0) {
+                  uint32_t page_size = 0, uint32_t db_flags = 0) {
     ups_parameter_t params[3] = {
       { UPS_PARAM_CACHESIZE, cache_size },
       { UPS_PARAM_PAGESIZE, (page_size ? page_size : 4096) },
       { 0, 0 }
     };
 
-    require_create(flags, params);
+    require_create(flags, params, db_flags, 0);
 
     context.reset(new Context(lenv(), 0, ldb()));
   }
@@ -100,6 +101,15 @@ struct BlobManagerFixture : BaseFixture {
     return PBlobPageHeader::from_page(page);
   }
 
+  PBlobDedupHeader *blob_dedup_header(uint64_t blobid) {
+    Page *page = lenv()->page_manager->fetch(context.get(),
+                    (blobid / lenv()->config.page_size_bytes)
+                          * lenv()->config.page_size_bytes);
+    PBlobHeader *blob_header = PBlobHeader::fropage(page, blobid);
+    REQUIRE(ISSET(blob_header->flags, PBlobHeader::kIsDeduplicated));
+    return PBlobDedupHeader::from_blob_header(blob_header);
+  }
+
   void overwriteMappedBlob() {
     std::vector<uint8_t> buffer(128);
     std::fill(buffer.begin(), buffer.end(), 0x12);
@@ -180,11 +190,17 @@ struct BlobManagerFixture : BaseFixture {
   }
 
   void replaceWithSmallTest() {
-    std::vector<uint8_t> buffer1(128);
+    // use blobs which are too large for the slab pages
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    std::vector<uint8_t> buffer1(page_size / 2);
     std::fill(buffer1.begin(), buffer1.end(), 0x12);
-    std::vector<uint8_t> buffer2(64);
+    std::vector<uint8_t> buffer2(page_size / 2 - 64);
     std::fill(buffer2.begin(), buffer2.end(), 0x13);
 
+    uint32_t alloc_size = sizeof(PBlobHeader) + (uint32_t)buffer1.size();
+    uint32_t free_bytes = page_size - DiskBlobManager::kPageOverhead
+                            - alloc_size;
+
     BlobManagerProxy bmp(lenv());
     uint64_t blobid = bmp.allocate(context.get(), buffer1);
 
@@ -194,11 +210,11 @@ struct BlobManagerFixture : BaseFixture {
     // verify the freelist information
     if (!is_in_memory()) {
       PBlobPageHeader *header = blob_page_header(blobid);
-      if (lenv()->config.page_size_bytes == 1024 * 16) {
-        REQUIRE(header->free_bytes == 3666);
-        REQUIRE(header->freelist[0].size == 3666);
-      }
-      REQUIRE(header->freelist[0].offset == 428);
+      REQUIRE(header->size_class == 0);
+      REQUIRE(header->free_bytes == free_bytes);
+      REQUIRE(header->freelist[0].size == free_bytes);
+      REQUIRE(header->freelist[0].offset
+                      == DiskBlobManager::kPageOverhead + alloc_size);
     }
 
     // overwrite the blob
@@ -206,25 +222,364 @@ struct BlobManagerFixture : BaseFixture {
     bmp.require_read(context.get(), blobid, buffer2, arena);
 
     // verify the freelist information - free area must have increased
-    // by 64 bytes (the size difference between both records)
+    // by 64 bytes (the size difference between both records), and the
+    // free space was merged with the existing freelist entry
     if (!is_in_memory()) {
       PBlobPageHeader *header = blob_page_header(blobid);
-      if (lenv()->config.page_size_bytes == 1024 * 16) {
-        REQUIRE(header->free_bytes == 3666 - 64);
-        REQUIRE(header->freelist[0].size == 3666);
-      }
+      REQUIRE(header->free_bytes == free_bytes + 64);
+      REQUIRE(header->freelist[0].size == free_bytes + 64);
+      REQUIRE(header->freelist[0].offset
+                      == DiskBlobManager::kPageOverhead + alloc_size - 64);
     }
 
     bmp.require_erase(context.get(), blobid);
 
-    // once more check the freelist
+    // the page is now empty and was moved to the freelist
     if (!is_in_memory()) {
-      PBlobPageHeader *header = blob_page_header(blobid);
-      if (lenv()->config.page_size_bytes == 1024 * 16) {
-        REQUIRE(header->free_bytes == 3758);
-        REQUIRE(header->freelist[0].size == 3666);
+      uint64_t page_id = (blobid / page_size) * page_size;
+      REQUIRE(lenv()->page_manager->state->freelist.has(page_id) == true);
+    }
+  }
+
+  void slabTest() {
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    PageManager *page_manager = lenv()->page_manager.get();
+    std::vector<uint8_t> buffer(100);
+    std::fill(buffer.begin(), buffer.end(), 0x12);
+
+    // 100 bytes + blob header are stored in the 128 byte size class
+    int size_class = DiskBlobManager::size_class(page_size,
+                    sizeof(PBlobHeader) + (uint32_t)buffer.size());
+    REQUIRE(size_class > 0);
+    REQUIRE(DiskBlobManager::slot_size(size_class) == 128);
+
+    BlobManagerProxy bmp(lenv());
+    ByteArray *arena = &ldb()->record_arena(0);
+
+    // all blobs are packed densely in the same page
+    std::vector<uint64_t> blobids;
+    for (int i = 0; i < 8; i++)
+      blobids.push_back(bmp.allocate(context.get(), buffer));
+    uint64_t page_id = (blobids[0] / page_size) * page_size;
+    for (int i = 0; i < 8; i++) {
+      REQUIRE(blobids[i] == page_id + DiskBlobManager::kPageOverhead
+                          + i * 128);
+      bmp.require_read(context.get(), blobids[i], buffer, arena);
+    }
+
+    PBlobPageHeader *header = blob_page_header(blobids[0]);
+    REQUIRE(header->size_class == (uint32_t)size_class);
+    REQUIRE(page_manager->slab_page_id(size_class) == page_id);
+
+    // the slot of an erased blob is immediately reused
+    bmp.require_erase(context.get(), blobids[3]);
+    REQUIRE(bmp.allocate(context.get(), buffer) == blobids[3]);
+
+    // overwriting a blob of the same size class happens in place
+    std::vector<uint8_t> buffer2(buffer.size() + 8);
+    std::fill(buffer2.begin(), buffer2.end(), 0x13);
+    REQUIRE(bmp.overwrite(context.get(), blobids[2], buffer2) == blobids[2]);
+    bmp.require_read(context.get(), blobids[2], buffer2, arena);
+
+    // a blob of a different size class is moved to another page
+    std::vector<uint8_t> buffer3(40);
+    std::fill(buffer3.begin(), buffer3.end(), 0x14);
+    uint64_t blobid = bmp.overwrite(context.get(), blobids[2], buffer3);
+    REQUIRE((blobid / page_size) * page_size != page_id);
+    bmp.require_read(context.get(), blobid, buffer3, arena);
+    bmp.require_erase(context.get(), blobid);
+    blobids.erase(blobids.begin() + 2);
+
+    // the index of slab pages is persisted
+    context->changeset.clear();
+    close();
+    require_open();
+    context.reset(new Context(lenv(), 0, ldb()));
+    page_manager = lenv()->page_manager.get();
+    REQUIRE(page_manager->slab_page_id(size_class) == page_id);
+
+    BlobManagerProxy bmp2(lenv());
+    REQUIRE(bmp2.allocate(context.get(), buffer) == page_id
+                    + DiskBlobManager::kPageOverhead + 2 * 128);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.blob_slab_allocated == 1);
+    REQUIRE(metrics.blob_slab_reused == 1);
+    REQUIRE(metrics.blob_slab_padding == 128 - sizeof(PBlobHeader) - 100);
+    REQUIRE(metrics.blob_slab_pages_with_free_space >= 1);
+
+    // once all blobs are erased, the page is moved to the freelist
+    blobids.push_back(page_id + DiskBlobManager::kPageOverhead + 2 * 128);
+    for (size_t i = 0; i < blobids.size(); i++)
+      bmp2.require_erase(context.get(), blobids[i]);
+    REQUIRE(page_manager->slab_page_id(size_class) == 0);
+    REQUIRE(page_manager->state->freelist.has(page_id) == true);
+  }
+
+  void partialReadTest() {
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    uint32_t size = page_size * 5 + 123;
+    std::vector<uint8_t> buffer(size);
+    for (uint32_t i = 0; i < size; i++)
+      buffer[i] = (uint8_t)(i % 251);
+
+    BlobManagerProxy bmp(lenv());
+    uint64_t blobid = bmp.allocate(context.get(), buffer);
+    ByteArray *arena = &ldb()->record_arena(0);
+
+    // offset, size of the window, expected size
+    uint32_t windows[][3] = {
+      { 0, 16, 16 },
+      { page_size - 10, 100, 100 },
+      { page_size * 3 + 5, page_size * 2, page_size * 2 },
+      { size - 10, 100, 10 },
+      { size + 5, 10, 0 }
+    };
+
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+      ups_record_t record = {0};
+      record.partial_offset = windows[i][0];
+      record.partial_size = windows[i][1];
+      bmp.blob_manager->read(context.get(), blobid, &record, UPS_PARTIAL,
+                      arena);
+      REQUIRE(record.size == windows[i][2]);
+      if (record.size)
+        REQUIRE(0 == ::memcmp(&buffer[windows[i][0]], record.data,
+                                record.size));
+
+      // same with a buffer which is allocated by the caller
+      std::vector<uint8_t> user(windows[i][1]);
+      ups_record_t user_record = {0};
+      user_record.data = user.data();
+      user_record.flags = UPS_RECORD_USER_ALLOC;
+      user_record.partial_offset = windows[i][0];
+      user_record.partial_size = windows[i][1];
+      bmp.blob_manager->read(context.get(), blobid, &user_record,
+                      UPS_PARTIAL, arena);
+      REQUIRE(user_record.size == windows[i][2]);
+      if (user_record.size) {
+        REQUIRE(user_record.data == user.data());
+        REQUIRE(0 == ::memcmp(&buffer[windows[i][0]], user.data(),
+                                user_record.size));
       }
     }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.blob_partial_read == 10);
+    REQUIRE(metrics.blob_partial_read_bytes
+                    == 2 * (16 + 100 + page_size * 2 + 10));
+
+    // a full read is still possible
+    bmp.require_read(context.get(), blobid, buffer, arena)
+       .require_erase(context.get(), blobid);
+  }
+
+  void partialFindTest() {
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    std::vector<uint8_t> big(page_size * 3);
+    for (size_t i = 0; i < big.size(); i++)
+      big[i] = (uint8_t)(i % 253);
+    std::vector<uint8_t> tiny(5);
+    for (size_t i = 0; i < tiny.size(); i++)
+      tiny[i] = (uint8_t)(i + 1);
+
+    DbProxy dbp(db);
+    dbp.require_insert(1, big)
+       .require_insert(2, tiny);
+
+    // the window of a blob
+    uint32_t k = 1;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t record = {0};
+    record.partial_offset = page_size - 2;
+    record.partial_size = 64;
+    REQUIRE(0 == ups_db_find(db, 0, &key, &record, UPS_PARTIAL));
+    REQUIRE(record.size == 64);
+    REQUIRE(0 == ::memcmp(&big[page_size - 2], record.data, 64));
+
+    // the window of a tiny record which is stored in the btree leaf
+    k = 2;
+    record.partial_offset = 3;
+    record.partial_size = 64;
+    REQUIRE(0 == ups_db_find(db, 0, &key, &record, UPS_PARTIAL));
+    REQUIRE(record.size == 2);
+    REQUIRE(0 == ::memcmp(&tiny[3], record.data, 2));
+
+    // a cursor only reads the window, too
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    record.partial_offset = 10;
+    record.partial_size = 20;
+    REQUIRE(0 == ups_cursor_move(cursor, 0, &record,
+                            UPS_CURSOR_FIRST | UPS_PARTIAL));
+    REQUIRE(record.size == 20);
+    REQUIRE(0 == ::memcmp(&big[10], record.data, 20));
+    record.partial_offset = page_size * 2;
+    record.partial_size = page_size;
+    REQUIRE(0 == ups_cursor_move(cursor, 0, &record, UPS_PARTIAL));
+    REQUIRE(record.size == page_size);
+    REQUIRE(0 == ::memcmp(&big[page_size * 2], record.data, page_size));
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    if (is_in_memory())
+      return;
+
+    // reopen the file; now the blob is memory mapped, and the returned
+    // pointer points directly into the mapping
+    context->changeset.clear();
+    close();
+    require_open();
+    context.reset(new Context(lenv(), 0, ldb()));
+
+    k = 1;
+    record.partial_offset = page_size + 1;
+    record.partial_size = 128;
+    REQUIRE(0 == ups_db_find(db, 0, &key, &record, UPS_PARTIAL));
+    REQUIRE(record.size == 128);
+    REQUIRE(0 == ::memcmp(&big[page_size + 1], record.data, 128));
+
+    DiskDevice *device = (DiskDevice *)lenv()->device.get();
+    if (device->is_mapped(0, page_size * 4)) {
+      REQUIRE((uint8_t *)record.data > device->mapped_pointer(0));
+      REQUIRE((uint8_t *)record.data < device->mapped_pointer(0)
+                                          + device->file_size());
+    }
+  }
+
+  void partialTxnFindTest() {
+    std::vector<uint8_t> buffer(100);
+    for (size_t i = 0; i < buffer.size(); i++)
+      buffer[i] = (uint8_t)i;
+
+    ups_txn_t *txn;
+    REQUIRE(0 == ups_txn_begin(&txn, env, 0, 0, 0));
+    DbProxy dbp(db);
+    dbp.require_insert(txn, 1, buffer);
+
+    // the record is still in the transaction index
+    uint32_t k = 1;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t record = {0};
+    record.partial_offset = 90;
+    record.partial_size = 20;
+    REQUIRE(0 == ups_db_find(db, txn, &key, &record, UPS_PARTIAL));
+    REQUIRE(record.size == 10);
+    REQUIRE(0 == ::memcmp(&buffer[90], record.data, 10));
+
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, txn, 0));
+    record.partial_offset = 1;
+    record.partial_size = 2;
+    REQUIRE(0 == ups_cursor_move(cursor, 0, &record,
+                            UPS_CURSOR_FIRST | UPS_PARTIAL));
+    REQUIRE(record.size == 2);
+    REQUIRE(0 == ::memcmp(&buffer[1], record.data, 2));
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    REQUIRE(0 == ups_txn_commit(txn, 0));
+  }
+
+  void dedupTest() {
+    uint32_t page_size = lenv()->config.page_size_bytes;
+    std::vector<uint8_t> buffer1(200, 0x11);
+    std::vector<uint8_t> buffer2(200, 0x22);
+    std::vector<uint8_t> huge(page_size * 2, 0x33);
+    ByteArray *arena = &ldb()->record_arena(0);
+
+    // identical records share the same blob
+    BlobManagerProxy bmp(lenv());
+    uint64_t blobid1 = bmp.allocate(context.get(), buffer1);
+    REQUIRE(bmp.allocate(context.get(), buffer1) == blobid1);
+    REQUIRE(bmp.allocate(context.get(), buffer1) == blobid1);
+    REQUIRE(blob_dedup_header(blobid1)->refcount == 3);
+    bmp.require_read(context.get(), blobid1, buffer1, arena);
+
+    uint64_t blobid2 = bmp.allocate(context.get(), buffer2);
+    REQUIRE(blobid2 != blobid1);
+    REQUIRE(blob_dedup_header(blobid2)->refcount == 1);
+
+    // multi-page blobs are deduplicated as well
+    uint64_t blobid3 = bmp.allocate(context.get(), huge);
+    REQUIRE(bmp.allocate(context.get(), huge) == blobid3);
+    bmp.require_read(context.get(), blobid3, huge, arena);
+
+    // an overwrite does not modify the shared blob
+    REQUIRE(bmp.overwrite(context.get(), blobid1, buffer2) == blobid2);
+    REQUIRE(blob_dedup_header(blobid1)->refcount == 2);
+    REQUIRE(blob_dedup_header(blobid2)->refcount == 2);
+    bmp.require_read(context.get(), blobid1, buffer1, arena);
+
+    // the blob is released when the last reference is gone
+    bmp.require_erase(context.get(), blobid1);
+    REQUIRE(blob_dedup_header(blobid1)->refcount == 1);
+    bmp.require_read(context.get(), blobid1, buffer1, arena)
+       .require_erase(context.get(), blobid1);
+    REQUIRE(blob_dedup_header(blobid1)->refcount == 0);
+
+    // ... and then it is no longer shared
+    uint64_t blobid4 = bmp.allocate(context.get(), buffer1);
+    REQUIRE(blob_dedup_header(blobid4)->refcount == 1);
+
+    // blobs which are modified in place are never shared
+    ups_record_t rec = ups_make_record(buffer2.data(),
+                    (uint32_t)buffer2.size());
+    uint64_t blobid5 = bmp.blob_manager->allocate(context.get(), &rec,
+                    BlobManager::kDisableDeduplication);
+    REQUIRE(blobid5 != blobid2);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.blob_dedup_hits == 4);
+    REQUIRE(metrics.blob_dedup_logical_bytes
+                    == 200 * 6 + huge.size() * 2);
+    REQUIRE(metrics.blob_dedup_stored_bytes == 200 * 3 + huge.size());
+  }
+
+  void dedupFindTest() {
+    std::vector<uint8_t> buffer1(1000, 0x11);
+    std::vector<uint8_t> buffer2(1000, 0x22);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 10; i++)
+      dbp.require_insert(i, i < 8 ? buffer1 : buffer2);
+    for (uint32_t i = 0; i < 10; i++)
+      dbp.require_find(i, i < 8 ? buffer1 : buffer2);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.blob_dedup_hits == 8);
+    REQUIRE(metrics.blob_dedup_stored_bytes == 2000);
+
+    // overwrite and erase some of the shared records
+    uint32_t k = 0;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    dbp.require_overwrite(&key, buffer2)
+       .require_erase(1)
+       .require_find((uint32_t)0, buffer2)
+       .require_find(2, buffer1)
+       .require_check_integrity();
+
+    // reopen the file; the flag is persistent, and the index is rebuilt
+    // while the blobs are read
+    context->changeset.clear();
+    close();
+    require_open();
+    context.reset(new Context(lenv(), 0, ldb()));
+
+    REQUIRE(ISSET(ldb()->flags(), UPS_ENABLE_RECORD_DEDUPLICATION));
+
+    dbp = DbProxy(db);
+    dbp.require_find(2, buffer1)
+       .require_insert(20, buffer1);
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.blob_dedup_hits == 1);
+
+    for (uint32_t i = 2; i < 10; i++)
+      dbp.require_erase(i);
+    dbp.require_find(20, buffer1)
+       .require_check_integrity();
   }
 
   void replaceBiggerAndBiggerTest() {
@@ -337,6 +692,66 @@ TEST_CASE("BlobManager/replaceWithSmallTest", "")
   f.replaceWithSmallTest();
 }
 
+TEST_CASE("BlobManager/slabTest", "")
+{
+  BlobManagerFixture f(0, 1024);
+  f.slabTest();
+}
+
+TEST_CASE("BlobManager/64k/slabTest", "")
+{
+  BlobManagerFixture f(0, 1024 * 64, 1024 * 64);
+  f.slabTest();
+}
+
+TEST_CASE("BlobManager/partialReadTest", "")
+{
+  BlobManagerFixture f(0, 1024);
+  f.partialReadTest();
+}
+
+TEST_CASE("BlobManager/partialFindTest", "")
+{
+  BlobManagerFixture f(0, 1024);
+  f.partialFindTest();
+}
+
+TEST_CASE("BlobManager/partialTxnFindTest", "")
+{
+  BlobManagerFixture f(UPS_ENABLE_TRANSACTIONS, 1024);
+  f.partialTxnFindTest();
+}
+
+TEST_CASE("BlobManager/dedupTest", "")
+{
+  BlobManagerFixture f(0, 1024, 0, UPS_ENABLE_RECORD_DEDUPLICATION);
+  f.dedupTest();
+}
+
+TEST_CASE("BlobManager/dedupFindTest", "")
+{
+  BlobManagerFixture f(0, 1024, 0, UPS_ENABLE_RECORD_DEDUPLICATION);
+  f.dedupFindTest();
+}
+
+TEST_CASE("BlobManager/dedupTxnFindTest", "")
+{
+  BlobManagerFixture f(UPS_ENABLE_TRANSACTIONS
+                        | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, 1024, 0,
+                  UPS_ENABLE_RECORD_DEDUPLICATION);
+  f.dedupFindTest();
+}
+
+TEST_CASE("BlobManager/dedupInMemoryTest", "")
+{
+  ups_env_t *env;
+  ups_db_t *db;
+  REQUIRE(0 == ups_env_create(&env, 0, UPS_IN_MEMORY, 0, 0));
+  REQUIRE(UPS_INV_PARAMETER == ups_env_create_db(env, &db, 1,
+                          UPS_ENABLE_RECORD_DEDUPLICATION, 0));
+  REQUIRE(0 == ups_env_close(env, 0));
+}
+
 TEST_CASE("BlobManager/replaceBiggerAndBiggerTest", "")
 {
   BlobManagerFixture f(UPS_ENABLE_TRANSACTIONS, 1024);
@@ -631,6 +1046,18 @@ TEST_CASE("BlobManager/inmem/replaceWithSmallTest", "")
   f.replaceWithSmallTest();
 }
 
+TEST_CASE("BlobManager/inmem/partialReadTest", "")
+{
+  BlobManagerFixture f(UPS_IN_MEMORY);
+  f.partialReadTest();
+}
+
+TEST_CASE("BlobManager/inmem/partialFindTest", "")
+{
+  BlobManagerFixture f(UPS_IN_MEMORY);
+  f.partialFindTest();
+}
+
 TEST_CASE("BlobManager/inmem/replaceBiggerAndBiggerTest", "")
 {
   BlobManagerFixture f(UPS_IN_MEMORY);
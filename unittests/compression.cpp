@@ -41,12 +41,22 @@ TEST_CASE("Compression/factory", "")
 
   c.reset(CompressorFactory::create(UPS_COMPRESSOR_LZF));
   REQUIRE(c.get() != nullptr);
+
+#ifdef HAVE_LZ4_H
+  c.reset(CompressorFactory::create(UPS_COMPRESSOR_LZ4));
+  REQUIRE(c.get() != nullptr);
+#endif
+
+#ifdef HAVE_ZSTD_H
+  c.reset(CompressorFactory::create(UPS_COMPRESSOR_ZSTD, 19));
+  REQUIRE(c.get() != nullptr);
+#endif
 }
 
 static void
-simple_compressor_test(int library)
+simple_compressor_test(int library, int level = 0)
 {
-  ScopedPtr<Compressor> c(CompressorFactory::create(library));
+  ScopedPtr<Compressor> c(CompressorFactory::create(library, level));
   REQUIRE(c.get() != nullptr);
   uint32_t len = c->compress((uint8_t *)"hello", 6);
   const uint8_t *ptr = c->arena.data();
@@ -76,6 +86,32 @@ TEST_CASE("Compression/lzf", "")
   simple_compressor_test(UPS_COMPRESSOR_LZF);
 }
 
+TEST_CASE("Compression/lz4", "")
+{
+#ifdef HAVE_LZ4_H
+  simple_compressor_test(UPS_COMPRESSOR_LZ4);
+#endif
+}
+
+TEST_CASE("Compression/zstd", "")
+{
+#ifdef HAVE_ZSTD_H
+  simple_compressor_test(UPS_COMPRESSOR_ZSTD);
+  simple_compressor_test(UPS_COMPRESSOR_ZSTD, 1);
+  simple_compressor_test(UPS_COMPRESSOR_ZSTD, 22);
+#endif
+}
+
+TEST_CASE("Compression/zlibLevel", "")
+{
+#ifdef HAVE_ZLIB_H
+  simple_compressor_test(UPS_COMPRESSOR_ZLIB, 1);
+  simple_compressor_test(UPS_COMPRESSOR_ZLIB, 9);
+  REQUIRE_CATCH(CompressorFactory::create(UPS_COMPRESSOR_ZLIB, 10),
+                  UPS_INV_PARAMETER);
+#endif
+}
+
 static void
 complex_journal_test(int library)
 {
@@ -134,6 +170,20 @@ TEST_CASE("Compression/LzfJournal", "")
   complex_journal_test(UPS_COMPRESSOR_LZF);
 }
 
+TEST_CASE("Compression/Lz4Journal", "")
+{
+#ifdef HAVE_LZ4_H
+  complex_journal_test(UPS_COMPRESSOR_LZ4);
+#endif
+}
+
+TEST_CASE("Compression/ZstdJournal", "")
+{
+#ifdef HAVE_ZSTD_H
+  complex_journal_test(UPS_COMPRESSOR_ZSTD);
+#endif
+}
+
 static void
 simple_record_test(int library)
 {
@@ -195,6 +245,61 @@ TEST_CASE("Compression/LzfRecord", "")
   simple_record_test(UPS_COMPRESSOR_LZF);
 }
 
+TEST_CASE("Compression/Lz4Record", "")
+{
+#ifdef HAVE_LZ4_H
+  simple_record_test(UPS_COMPRESSOR_LZ4);
+#endif
+}
+
+TEST_CASE("Compression/ZstdRecord", "")
+{
+#ifdef HAVE_ZSTD_H
+  simple_record_test(UPS_COMPRESSOR_ZSTD);
+#endif
+}
+
+TEST_CASE("Compression/levelRecord", "")
+{
+#ifdef HAVE_ZLIB_H
+  ups_parameter_t params[] = {
+      { UPS_PARAM_RECORD_COMPRESSION, UPS_COMPRESSOR_ZLIB },
+      { UPS_PARAM_COMPRESSION_LEVEL, 9 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, 0, 0, params);
+
+  std::vector<uint8_t> kvec(16, 'k');
+  std::vector<uint8_t> rvec(4096, 'r');
+  DbProxy db(f.db);
+  db.require_insert(kvec, rvec);
+
+  // the level is not persisted; a different level still decompresses
+  ups_parameter_t env_params[] = {
+      { UPS_PARAM_COMPRESSION_LEVEL, 1 },
+      { 0, 0 }
+  };
+  f.close()
+   .require_open(0, env_params);
+  db = DbProxy(f.db);
+  db.require_find(kvec, rvec);
+#endif
+}
+
+TEST_CASE("Compression/negativeLevel", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_COMPRESSION_LEVEL, 23 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, params, UPS_INV_PARAMETER);
+  f.require_create(0, 0, 0, params, UPS_INV_PARAMETER);
+}
+
 TEST_CASE("Compression/negativeOpen", "")
 {
   ups_parameter_t p[] = {
@@ -386,3 +491,391 @@ TEST_CASE("Compression/unknownCompressor", "")
   BaseFixture f;
   f.require_create(UPS_IN_MEMORY, 0, 0, params, UPS_INV_PARAMETER);
 }
+
+TEST_CASE("Compression/dictionaryFactory", "")
+{
+  ScopedPtr<Compressor> c(CompressorFactory::create(UPS_COMPRESSOR_LZF));
+  REQUIRE(false == c->set_dictionary((const uint8_t *)"hello", 5));
+  REQUIRE(false == CompressorFactory::supports_dictionary(UPS_COMPRESSOR_LZF));
+
+#ifdef HAVE_ZLIB_H
+  REQUIRE(true == CompressorFactory::supports_dictionary(UPS_COMPRESSOR_ZLIB));
+
+  const char *dict = "the quick brown fox jumps over the lazy dog";
+  const char *text = "the lazy dog jumps over the quick brown fox";
+  uint32_t text_size = (uint32_t)::strlen(text) + 1;
+
+  c.reset(CompressorFactory::create(UPS_COMPRESSOR_ZLIB));
+  REQUIRE(true == c->set_dictionary((const uint8_t *)dict,
+                          (uint32_t)::strlen(dict)));
+  uint32_t len = c->compress((const uint8_t *)text, text_size);
+  REQUIRE(len < text_size);
+
+  ByteArray tmp; // create a copy of the compressed data
+  tmp.append(c->arena.data(), len);
+  c->decompress(tmp.data(), len, text_size);
+  REQUIRE(0 == ::strcmp(text, (const char *)c->arena.data()));
+#endif
+}
+
+static std::vector<uint8_t>
+similar_record(uint32_t i)
+{
+  char buffer[256];
+  ::sprintf(buffer, "{\"id\": %u, \"name\": \"customer-%u\", "
+                  "\"street\": \"Main Street\", \"city\": \"Springfield\", "
+                  "\"country\": \"United States\", \"status\": \"active\", "
+                  "\"tags\": [\"retail\", \"premium\", \"newsletter\"]}",
+                  i, i * 7);
+  return std::vector<uint8_t>(buffer, buffer + ::strlen(buffer) + 1);
+}
+
+static void
+insert_similar_records(DbProxy &db, uint32_t from, uint32_t to)
+{
+  for (uint32_t i = from; i < to; i++) {
+    std::vector<uint8_t> record = similar_record(i);
+    db.require_insert(i, record);
+  }
+}
+
+static void
+find_similar_records(DbProxy &db, uint32_t from, uint32_t to)
+{
+  for (uint32_t i = from; i < to; i++) {
+    std::vector<uint8_t> record = similar_record(i);
+    db.require_find(i, record);
+  }
+}
+
+static uint64_t
+compressed_bytes(ups_env_t *env)
+{
+  ups_env_metrics_t metrics;
+  REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+  return metrics.record_bytes_after_compression;
+}
+
+static void
+dictionary_test(int library, uint32_t env_flags)
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_RECORD_COMPRESSION, (uint64_t)library },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(env_flags, 0, 0, params);
+  DbProxy db(f.db);
+
+  insert_similar_records(db, 0, 300);
+  uint64_t without_dictionary = compressed_bytes(f.env);
+  REQUIRE(0 == ups_db_train_dictionary(f.db, 0, 0, 0));
+  insert_similar_records(db, 300, 600);
+  uint64_t with_dictionary = compressed_bytes(f.env) - without_dictionary;
+  if (NOTSET(env_flags, UPS_ENABLE_TRANSACTIONS))
+    REQUIRE(with_dictionary < without_dictionary);
+  find_similar_records(db, 0, 600);
+
+  // retraining keeps the previous dictionaries
+  REQUIRE(0 == ups_db_train_dictionary(f.db, 100, 4096, 0));
+  insert_similar_records(db, 600, 800);
+  find_similar_records(db, 0, 800);
+
+  if (ISSET(env_flags, UPS_IN_MEMORY))
+    return;
+
+  f.close()
+   .require_open(env_flags);
+  db = DbProxy(f.db);
+  find_similar_records(db, 0, 800);
+
+  // train a third dictionary after reopening, then overwrite a few of
+  // the old records
+  REQUIRE(0 == ups_db_train_dictionary(f.db, 0, 0, 0));
+  for (uint32_t i = 0; i < 800; i += 50) {
+    std::vector<uint8_t> record = similar_record(i + 1000);
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    db.require_overwrite(&key, record);
+    db.require_find(&key, record);
+  }
+}
+
+TEST_CASE("Compression/ZlibDictionary", "")
+{
+#ifdef HAVE_ZLIB_H
+  dictionary_test(UPS_COMPRESSOR_ZLIB, 0);
+#endif
+}
+
+TEST_CASE("Compression/ZlibDictionaryTxn", "")
+{
+#ifdef HAVE_ZLIB_H
+  dictionary_test(UPS_COMPRESSOR_ZLIB, UPS_ENABLE_TRANSACTIONS);
+#endif
+}
+
+TEST_CASE("Compression/ZlibDictionaryInMemory", "")
+{
+#ifdef HAVE_ZLIB_H
+  dictionary_test(UPS_COMPRESSOR_ZLIB, UPS_IN_MEMORY);
+#endif
+}
+
+TEST_CASE("Compression/ZstdDictionary", "")
+{
+#ifdef HAVE_ZSTD_H
+  dictionary_test(UPS_COMPRESSOR_ZSTD, 0);
+#endif
+}
+
+TEST_CASE("Compression/dictionaryRenameErase", "")
+{
+#ifdef HAVE_ZLIB_H
+  ups_parameter_t params[] = {
+      { UPS_PARAM_RECORD_COMPRESSION, UPS_COMPRESSOR_ZLIB },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, 0, 0, params);
+  DbProxy db(f.db);
+  insert_similar_records(db, 0, 200);
+  REQUIRE(0 == ups_db_train_dictionary(f.db, 0, 0, 0));
+  insert_similar_records(db, 200, 400);
+  REQUIRE(0 != f.lenv()->header->dictionary_blobid());
+  REQUIRE(0 == ups_db_close(f.db, 0));
+
+  REQUIRE(0 == ups_env_rename_db(f.env, 1, 5, 0));
+  f.close();
+  REQUIRE(0 == f.open_env(0));
+  REQUIRE(0 == ups_env_open_db(f.env, &f.db, 5, 0, 0));
+  db = DbProxy(f.db);
+  find_similar_records(db, 0, 400);
+  REQUIRE(0 == ups_db_close(f.db, 0));
+
+  REQUIRE(0 == ups_env_erase_db(f.env, 5, 0));
+  REQUIRE(0 == f.lenv()->header->dictionary_blobid());
+#endif
+}
+
+TEST_CASE("Compression/negativeDictionary", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_RECORD_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  REQUIRE(UPS_INV_PARAMETER == ups_db_train_dictionary(0, 0, 0, 0));
+
+  // no compression
+  f.require_create(0);
+  REQUIRE(UPS_INV_PARAMETER == ups_db_train_dictionary(f.db, 0, 0, 0));
+  f.close();
+
+  // LZF does not support dictionaries
+  f.require_create(0, 0, 0, params);
+  REQUIRE(UPS_INV_PARAMETER == ups_db_train_dictionary(f.db, 0, 0, 0));
+  f.close();
+
+#ifdef HAVE_ZLIB_H
+  params[0].value = UPS_COMPRESSOR_ZLIB;
+  f.require_create(0, 0, 0, params);
+  REQUIRE(UPS_INV_PARAMETER == ups_db_train_dictionary(f.db, 0, 0, 1));
+  // the database is empty
+  REQUIRE(UPS_KEY_NOT_FOUND == ups_db_train_dictionary(f.db, 0, 0, 0));
+#endif
+}
+
+static void
+page_compression_test(int library, uint32_t env_flags,
+                uint64_t cache_size = 0)
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, (uint64_t)library },
+      { UPS_PARAM_CACHE_SIZE, cache_size },
+      { 0, 0 }
+  };
+  ups_parameter_t open_params[] = {
+      { UPS_PARAM_CACHE_SIZE, cache_size },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(env_flags, params);
+  f.require_parameter(UPS_PARAM_PAGE_COMPRESSION, library);
+
+  const uint32_t kCount = 20000;
+  std::vector<uint8_t> record(16, 'x');
+  DbProxy db(f.db);
+  for (uint32_t i = 0; i < kCount; i++)
+    db.require_insert(i, record);
+  for (uint32_t i = 0; i < kCount; i++)
+    db.require_find(i, record);
+
+  f.close()
+   .require_open(env_flags, open_params)
+   .require_parameter(UPS_PARAM_PAGE_COMPRESSION, library);
+  db = DbProxy(f.db);
+  for (uint32_t i = 0; i < kCount; i++)
+    db.require_find(i, record);
+
+  // modify the pages, then write them again
+  std::vector<uint8_t> record2(16, 'y');
+  for (uint32_t i = 0; i < kCount; i += 2) {
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    db.require_overwrite(&key, record2);
+  }
+  for (uint32_t i = 1; i < kCount; i += 4)
+    db.require_erase(i);
+
+  ups_env_metrics_t metrics;
+  f.close()
+   .require_open(env_flags, open_params);
+  db = DbProxy(f.db);
+  for (uint32_t i = 0; i < kCount; i++) {
+    if (i % 4 == 1) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = {0};
+      REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(f.db, 0, &key, &rec, 0));
+    }
+    else
+      db.require_find(i, i % 2 == 0 ? record2 : record);
+  }
+
+  REQUIRE(0 == ups_env_get_metrics(f.env, &metrics));
+  REQUIRE(0 == ups_db_check_integrity(f.db, 0));
+}
+
+TEST_CASE("Compression/ZlibPage", "")
+{
+#ifdef HAVE_ZLIB_H
+  page_compression_test(UPS_COMPRESSOR_ZLIB, 0);
+#endif
+}
+
+TEST_CASE("Compression/LzfPage", "")
+{
+  page_compression_test(UPS_COMPRESSOR_LZF, 0);
+}
+
+TEST_CASE("Compression/Lz4Page", "")
+{
+#ifdef HAVE_LZ4_H
+  page_compression_test(UPS_COMPRESSOR_LZ4, 0);
+#endif
+}
+
+TEST_CASE("Compression/ZstdPage", "")
+{
+#ifdef HAVE_ZSTD_H
+  page_compression_test(UPS_COMPRESSOR_ZSTD, 0);
+#endif
+}
+
+TEST_CASE("Compression/LzfPageNoMmap", "")
+{
+  page_compression_test(UPS_COMPRESSOR_LZF, UPS_DISABLE_MMAP);
+}
+
+TEST_CASE("Compression/LzfPageSmallCache", "")
+{
+  // pages are purged from the cache and fetched again
+  page_compression_test(UPS_COMPRESSOR_LZF, UPS_DISABLE_MMAP, 64 * 1024);
+}
+
+TEST_CASE("Compression/LzfPageCrc32", "")
+{
+  page_compression_test(UPS_COMPRESSOR_LZF, UPS_ENABLE_CRC32);
+}
+
+TEST_CASE("Compression/LzfPageTxn", "")
+{
+  page_compression_test(UPS_COMPRESSOR_LZF, UPS_ENABLE_TRANSACTIONS);
+}
+
+TEST_CASE("Compression/pageMetrics", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, params);
+
+  std::vector<uint8_t> record(8, 'x'); // stored inline
+  DbProxy db(f.db);
+  for (uint32_t i = 0; i < 10000; i++)
+    db.require_insert(i, record);
+  REQUIRE(0 == ups_env_flush(f.env, 0));
+
+  ups_env_metrics_t metrics;
+  REQUIRE(0 == ups_env_get_metrics(f.env, &metrics));
+  REQUIRE(metrics.page_bytes_before_compression > 0);
+  REQUIRE(metrics.page_bytes_after_compression
+                  < metrics.page_bytes_before_compression / 2);
+}
+
+TEST_CASE("Compression/pageDiskSize", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(UPS_DISABLE_MMAP, params);
+
+  std::vector<uint8_t> record(16, 'x');
+  DbProxy db(f.db);
+  for (uint32_t i = 0; i < 50; i++)
+    db.require_insert(i, record);
+  REQUIRE(0 == ups_env_flush(f.env, 0));
+
+  // the root page is a leaf and was compressed when it was flushed
+  Context context(f.lenv(), 0, 0);
+  Page *page = ((LocalDb *)f.db)->btree_index->root_page(&context);
+  REQUIRE(page->is_compressible());
+  REQUIRE(page->disk_size() > 0);
+  REQUIRE(page->disk_size() < f.lenv()->config.page_size_bytes / 2);
+  context.changeset.clear();
+
+  // the page is decompressed when it's read from disk
+  f.close()
+   .require_open(UPS_DISABLE_MMAP);
+  db = DbProxy(f.db);
+  for (uint32_t i = 0; i < 50; i++)
+    db.require_find(i, record);
+
+  Context context2(f.lenv(), 0, 0);
+  page = ((LocalDb *)f.db)->btree_index->root_page(&context2);
+  REQUIRE(page->disk_size() > 0);
+  REQUIRE(page->type() == Page::kTypeBroot);
+  context2.changeset.clear();
+}
+
+TEST_CASE("Compression/negativePage", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_PAGE_COMPRESSION, UPS_COMPRESSOR_LZF },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(UPS_IN_MEMORY, params, UPS_INV_PARAMETER);
+
+  params[0].value = 44;
+  f.require_create(0, params, UPS_INV_PARAMETER);
+
+  // the parameter is only allowed in ups_env_create
+  f.require_create(0)
+   .close();
+  params[0].value = UPS_COMPRESSOR_LZF;
+  f.require_open(0, params, UPS_INV_PARAMETER);
+
+  // the default is "no compression"
+  f.require_open(0)
+   .require_parameter(UPS_PARAM_PAGE_COMPRESSION, 0);
+}
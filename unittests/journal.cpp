@@ -29,6 +29,9 @@ using namespace upscaledb;
 
 namespace upscaledb {
 
+// defined in changeset.cc
+extern void (*g_CHANGESET_POST_LOG_HOOK)(void);
+
 struct JournalEntry {
   JournalEntry(uint64_t lsn_, uint64_t txnid_, uint32_t dbid_,
                   uint32_t type_, const char *key_, const char *record_,
@@ -127,8 +130,11 @@ struct JournalProxy {
       if (e.lsn == 0)
         continue;
 
-      // skip Changesets
-      while (entry.type == Journal::kEntryTypeChangeset && entry.lsn > 0) {
+      // skip Changesets and Checkpoints
+      while ((entry.type == Journal::kEntryTypeChangeset
+                  || entry.type == Journal::kEntryTypeChangesetDelta
+                  || entry.type == Journal::kEntryTypeCheckpoint)
+              && entry.lsn > 0) {
         if (!starting)
           adjust++;
         journal->test_read_entry(&iter, &entry, &auxbuffer);
@@ -435,7 +441,7 @@ struct JournalFixture : BaseFixture {
 
   void iterateOverLogMultipleEntrySwapTest() {
     JournalProxy jp(reset_journal());
-    jp.journal->state.threshold = 5;
+    jp.journal->state.segment_size = 368; // 5 Txns per segment
 
     std::vector<JournalEntry> vec;
     for (uint64_t i = 0; i <= 7; i++) {
@@ -454,8 +460,12 @@ struct JournalFixture : BaseFixture {
 
   void iterateOverLogMultipleEntrySwapTwiceTest() {
     JournalProxy jp(reset_journal());
-    jp.journal->state.threshold = 5;
-    uint64_t lsn = 2;
+    jp.journal->state.segment_size = 368; // 5 Txns per segment
+
+    // an active Txn prevents that the committed Txns are flushed; their
+    // segments cannot be recycled, and a third segment is created
+    TxnProxy longtp(env);
+    uint64_t lsn = 3;
 
     std::vector<JournalEntry> vec;
     for (uint64_t i = 0; i <= 10; i++) {
@@ -465,6 +475,8 @@ struct JournalFixture : BaseFixture {
       vec.push_back( { lsn++, tp.id(), Journal::kEntryTypeTxnBegin } );
       vec.push_back( { lsn++, tp.id(), Journal::kEntryTypeTxnCommit } );
     }
+    REQUIRE(jp.journal->state.segments.size() == 3u);
+    REQUIRE(jp.journal->state.count_segments_recycled == 0u);
 
     // reopen the journal, verify entries
     jp.require_close(true)
@@ -473,13 +485,9 @@ struct JournalFixture : BaseFixture {
   }
 
   void verifyJournalIsEmpty() {
-    uint64_t size;
     Journal *j = lenv()->journal.get();
     REQUIRE(j != 0);
-    size = j->state.files[0].file_size();
-    REQUIRE(0 == size);
-    size = j->state.files[1].file_size();
-    REQUIRE(0 == size);
+    REQUIRE(j->is_empty());
   }
 
   void recoverVerifyTxnIdsTest() {
@@ -838,7 +846,7 @@ struct JournalFixture : BaseFixture {
     TxnProxy longtp(env);
     DbProxy dbp(db);
     JournalProxy jp(reset_journal());
-    jp.journal->state.threshold = 5;
+    jp.journal->state.segment_size = 1024;
 
     int i, j = 0, limit = 100;
     for (i = 0; i < limit; i++) {
@@ -1020,13 +1028,10 @@ struct JournalFixture : BaseFixture {
     close();
     require_create(UPS_ENABLE_TRANSACTIONS, params, 0, 0);
 
-    // verify threshold through ups_env_get_parameters
+    // verify threshold through ups_env_get_parameters; the journal
+    // ignores it
     require_parameter(params[0].name, params[0].value);
 
-    // verify threshold in the Journal object
-    Journal *j = lenv()->journal.get();
-    j->state.threshold = 5;
-
     // open w/o parameter
     close(UPS_AUTO_CLEANUP);
     require_open(UPS_ENABLE_TRANSACTIONS);
@@ -1062,9 +1067,9 @@ struct JournalFixture : BaseFixture {
     // close the environment
     close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
 
-    // verify the journal file sizes
-    require_file_size("test.db.jrn0", 33664);
-    require_file_size("test.db.jrn1", 51168);
+    // verify the journal file sizes; the segments are preallocated
+    require_file_size("test.db.jrn0", 4 * 1024 * 1024);
+    require_file_size("test.db.jrn1", 4 * 1024 * 1024);
   }
 
   void recoverWithCrc32Test() {
@@ -1107,8 +1112,427 @@ struct JournalFixture : BaseFixture {
     require_flags(UPS_ENABLE_CRC32, true);
     require_flags(UPS_ENABLE_FSYNC, true);
   }
+
+  // Inserts |count| keys, each in its own Txn, and returns the number of
+  // bytes written to the journal
+  uint64_t insert_and_measure_journal(uint32_t count, bool deltas) {
+    std::vector<uint8_t> record(16, 'x');
+    ups_parameter_t params[] = {
+        {UPS_PARAM_JOURNAL_DELTAS, deltas ? 1u : 0u},
+        {0, 0}
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < count; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    return metrics.journal_bytes_flushed;
+  }
+
+  void deltaJournalSizeTest() {
+    uint64_t full = insert_and_measure_journal(200, false);
+    uint64_t delta = insert_and_measure_journal(200, true);
+    REQUIRE(delta * 4 < full);
+
+    ups_parameter_t query[] = {{UPS_PARAM_JOURNAL_DELTAS, 0}, {0, 0}};
+    REQUIRE(0 == ups_env_get_parameters(env, query));
+    REQUIRE(query[0].value == 1u);
+
+    // the changesets were logged as deltas
+    Journal::Iterator iter;
+    PJournalEntry entry;
+    ByteArray auxbuffer;
+    int deltas = 0;
+    int full_pages = 0;
+    do {
+      lenv()->journal->test_read_entry(&iter, &entry, &auxbuffer);
+      if (entry.type == Journal::kEntryTypeChangesetDelta)
+        deltas++;
+      if (entry.type == Journal::kEntryTypeChangeset)
+        full_pages++;
+    } while (entry.lsn != 0);
+    REQUIRE(deltas > 0);
+    REQUIRE(full_pages == 0);
+
+    // not supported for in-memory Environments
+    ups_env_t *env2;
+    ups_parameter_t params[] = {{UPS_PARAM_JOURNAL_DELTAS, 1}, {0, 0}};
+    REQUIRE(UPS_INV_PARAMETER == ups_env_create(&env2, 0, UPS_IN_MEMORY,
+                            0, params));
+  }
+
+  static int delta_hook_calls;
+
+  // Creates a backup after the 5th changeset was logged, but (possibly)
+  // before its pages were flushed
+  static void delta_backup_hook() {
+    if (++delta_hook_calls == 5) {
+      REQUIRE(true == os::copy("test.db", "test.db.bak"));
+      REQUIRE(true == os::copy("test.db.jrn0", "test.db.bak0"));
+      REQUIRE(true == os::copy("test.db.jrn1", "test.db.bak1"));
+    }
+  }
+
+  void recoverWithDeltasTest() {
+    const uint32_t kTxns = 20;
+    const uint32_t kKeysPerTxn = 50;
+    std::vector<uint8_t> record(32, 'x');
+    ups_parameter_t params[] = {{UPS_PARAM_JOURNAL_DELTAS, 1}, {0, 0}};
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+
+    delta_hook_calls = 0;
+    g_CHANGESET_POST_LOG_HOOK = delta_backup_hook;
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < kTxns; i++) {
+      TxnProxy tp(env);
+      for (uint32_t j = 0; j < kKeysPerTxn; j++)
+        dbp.require_insert(tp.txn, i * kKeysPerTxn + j, record);
+      tp.commit();
+    }
+    g_CHANGESET_POST_LOG_HOOK = 0;
+    REQUIRE(delta_hook_calls >= 5);
+
+    close(UPS_AUTO_CLEANUP);
+    restore();
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+
+    // the recovered database is consistent, and every Txn was recovered
+    // either completely or not at all
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < kTxns * kKeysPerTxn; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = {0};
+      if (ups_db_find(db, 0, &key, &rec, 0) == 0) {
+        REQUIRE(i == found);
+        REQUIRE(rec.size == record.size());
+        found++;
+      }
+    }
+    REQUIRE(found > 0);
+    REQUIRE(found % kKeysPerTxn == 0);
+  }
+
+  void writerTest() {
+    std::vector<uint8_t> record(64, 'x');
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, 0, 0, 0);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 100; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    // after draining the writer, all flushed bytes are in the files
+    lenv()->journal->test_flush_buffers();
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_queued_bytes == 0u);
+    REQUIRE(metrics.journal_writes >= 100u);
+    REQUIRE(metrics.journal_max_write_latency_us
+                    <= metrics.journal_write_latency_us);
+    JournalState &state = lenv()->journal->state;
+    uint64_t written = 0;
+    for (size_t i = 0; i < state.segments.size(); i++) {
+      if (state.segments[i]->sequence != 0)
+        written += state.segments[i]->offset - sizeof(PJournalSegmentHeader);
+    }
+    REQUIRE(written == metrics.journal_bytes_flushed);
+  }
+
+  void segmentRecyclingTest() {
+    std::vector<uint8_t> record(64, 'x');
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_SEGMENT_SIZE, 256 * 1024 },
+        { UPS_PARAM_JOURNAL_SEGMENTS, 3 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+    require_parameter(params[0].name, params[0].value);
+    require_parameter(params[1].name, params[1].value);
+    JournalState &state = lenv()->journal->state;
+    REQUIRE(state.segments.size() == 3u);
+    REQUIRE(state.segments[2]->file.file_size() == 256 * 1024u);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 1000; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    // the segments were recycled; far fewer segment files were created
+    // than segments were written
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_segments_recycled > 0u);
+    REQUIRE(metrics.journal_segments
+                    < metrics.journal_bytes_flushed / (256 * 1024));
+
+    // recover from the recycled segments
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    DbProxy dbp2(db);
+    for (uint32_t i = 0; i < 1000; i++)
+      dbp2.require_find(i, record);
+  }
+
+  void checkpointTest() {
+    std::vector<uint8_t> record(512, 'x');
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 64 * 1024 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+    require_parameter(params[0].name, params[0].value);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 500; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+
+    // most of the changesets are covered by a checkpoint
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_checkpoints > 0u);
+    REQUIRE(metrics.journal_recovery_changesets < 500u);
+    REQUIRE(metrics.journal_recovery_bytes > 0u);
+    REQUIRE(metrics.journal_recovery_bytes <= metrics.journal_bytes_flushed);
+
+    // recovery skips the changesets up to the newest checkpoint
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    REQUIRE(lenv()->journal->state.count_changesets_skipped > 0u);
+
+    DbProxy dbp2(db);
+    for (uint32_t i = 0; i < 500; i++)
+      dbp2.require_find(i, record);
+  }
+
+  void parallelRecoveryTest(bool deltas) {
+    std::vector<uint8_t> record(512, 'x');
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_DELTAS, deltas ? 1u : 0u },
+        { UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 64 * 1024 * 1024 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 500; i++) {
+      TxnProxy tp(env);
+      record[0] = (uint8_t)i;
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    for (uint32_t i = 0; i < 500; i += 3) {
+      TxnProxy tp(env);
+      dbp.require_erase(tp.txn, i);
+      tp.commit();
+    }
+
+    // the pages are re-applied by 4 threads
+    ups_parameter_t open_params[] = {
+        { UPS_PARAM_RECOVERY_THREADS, 4 },
+        { 0, 0 }
+    };
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, open_params);
+    require_parameter(open_params[0].name, open_params[0].value);
+
+    DbProxy dbp2(db);
+    for (uint32_t i = 0; i < 500; i++) {
+      record[0] = (uint8_t)i;
+      if (i % 3 == 0)
+        dbp2.require_find(i, record, UPS_KEY_NOT_FOUND);
+      else
+        dbp2.require_find(i, record);
+    }
+
+    // the recovered file is consistent
+    close(UPS_AUTO_CLEANUP);
+    require_open(UPS_ENABLE_TRANSACTIONS);
+    DbProxy(db).require_check_integrity();
+  }
+
+  // Applies all pending entries of |cursor| to |follower|; returns the
+  // lsn of the last entry
+  uint64_t apply_tail(ups_journal_cursor_t *cursor, ups_env_t *follower,
+                  uint64_t lsn) {
+    ups_journal_entry_t entry;
+    ups_status_t st;
+    while ((st = ups_journal_cursor_next(cursor, &entry)) == 0) {
+      REQUIRE(entry.type != UPS_JOURNAL_ENTRY_CHANGESET);
+      REQUIRE(entry.size > 0u);
+      REQUIRE(0 == ups_env_apply_journal_entry(follower, &entry));
+      lsn = entry.lsn;
+    }
+    REQUIRE(st == UPS_KEY_NOT_FOUND);
+    return lsn;
+  }
+
+  void tailTest(int compressor) {
+    std::vector<uint8_t> record(64, 'x');
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_COMPRESSION, (uint64_t)compressor },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS,
+                    compressor != UPS_COMPRESSOR_NONE ? params : 0,
+                    UPS_ENABLE_DUPLICATE_KEYS, 0);
+
+    // the follower; the database has to be created
+    ups_env_t *follower;
+    ups_db_t *fdb;
+    REQUIRE(0 == ups_env_create(&follower, "test2.db",
+                            UPS_ENABLE_TRANSACTIONS, 0644, 0));
+    REQUIRE(0 == ups_env_create_db(follower, &fdb, 1,
+                            UPS_ENABLE_DUPLICATE_KEYS, 0));
+
+    ups_journal_cursor_t *cursor;
+    REQUIRE(UPS_INV_PARAMETER == ups_env_open_journal_cursor(env, 0, 0, 0));
+    REQUIRE(UPS_INV_PARAMETER == ups_env_open_journal_cursor(env, 0,
+                            0x100, &cursor));
+    REQUIRE(0 == ups_env_open_journal_cursor(env, 0, 0, &cursor));
+
+    // committed Txns and temporary Txns are shipped; aborted Txns are not
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 20; i++) {
+      TxnProxy tp(env);
+      record[0] = (uint8_t)i;
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    for (uint32_t i = 20; i < 30; i++)
+      dbp.require_insert(i, record);
+    {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, 100u, record);
+      tp.abort();
+    }
+    dbp.require_erase(5u);
+
+    uint64_t lsn = apply_tail(cursor, follower, 0);
+    REQUIRE(lsn > 0u);
+
+    DbProxy fdbp(fdb);
+    for (uint32_t i = 0; i < 30; i++) {
+      record[0] = (uint8_t)(i < 20 ? i : 19);
+      fdbp.require_find(i, record, i == 5 ? UPS_KEY_NOT_FOUND : 0);
+    }
+    fdbp.require_find(100u, record, UPS_KEY_NOT_FOUND);
+
+    // a Txn which is not yet committed is not returned
+    ups_journal_entry_t entry;
+    TxnProxy tp(env);
+    dbp.require_insert(tp.txn, 200u, record);
+    REQUIRE(UPS_KEY_NOT_FOUND == ups_journal_cursor_next(cursor, &entry));
+    tp.commit();
+    lsn = apply_tail(cursor, follower, lsn);
+    fdbp.require_find(200u, record);
+
+    // a second cursor resumes after |lsn|
+    ups_journal_cursor_t *cursor2;
+    REQUIRE(0 == ups_env_open_journal_cursor(env, lsn, 0, &cursor2));
+    REQUIRE(UPS_KEY_NOT_FOUND == ups_journal_cursor_next(cursor2, &entry));
+    dbp.require_insert(300u, record);
+    REQUIRE(0 == ups_journal_cursor_next(cursor2, &entry));
+    REQUIRE(entry.type == UPS_JOURNAL_ENTRY_INSERT);
+    REQUIRE(entry.txn_id == 0u);
+    REQUIRE(entry.dbname == 1);
+    REQUIRE(UPS_KEY_NOT_FOUND == ups_journal_cursor_next(cursor2, &entry));
+    REQUIRE(0 == ups_journal_cursor_close(cursor2));
+
+    apply_tail(cursor, follower, lsn);
+    fdbp.require_find(300u, record);
+
+    REQUIRE(0 == ups_journal_cursor_close(cursor));
+    REQUIRE(0 == ups_env_close(follower, UPS_AUTO_CLEANUP));
+  }
+
+  void tailPinsSegmentsTest() {
+    std::vector<uint8_t> record(512, 'x');
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_SEGMENT_SIZE, 16 * 1024 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params,
+                    UPS_ENABLE_DUPLICATE_KEYS, 0);
+
+    ups_env_t *follower;
+    ups_db_t *fdb;
+    REQUIRE(0 == ups_env_create(&follower, "test2.db", 0, 0644, 0));
+    REQUIRE(0 == ups_env_create_db(follower, &fdb, 1,
+                            UPS_ENABLE_DUPLICATE_KEYS, 0));
+
+    // the cursor does not read while the journal switches segments;
+    // its segments are not recycled
+    ups_journal_cursor_t *cursor;
+    REQUIRE(0 == ups_env_open_journal_cursor(env, 0,
+                            UPS_JOURNAL_INCLUDE_CHANGESETS, &cursor));
+
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 200; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    REQUIRE(lenv()->journal->state.count_segments_recycled == 0u);
+    REQUIRE(lenv()->journal->state.segments.size() > 2u);
+
+    // the follower has no Txns; the entries are applied one by one
+    uint32_t changesets = 0;
+    ups_journal_entry_t entry;
+    while (0 == ups_journal_cursor_next(cursor, &entry)) {
+      if (entry.type == UPS_JOURNAL_ENTRY_CHANGESET)
+        changesets++;
+      REQUIRE(0 == ups_env_apply_journal_entry(follower, &entry));
+    }
+    REQUIRE(changesets > 0u);
+    REQUIRE(0 == ups_journal_cursor_close(cursor));
+
+    DbProxy fdbp(fdb);
+    for (uint32_t i = 0; i < 200; i++)
+      fdbp.require_find(i, record);
+
+    // without the cursor, the segments are recycled again
+    for (uint32_t i = 200; i < 400; i++) {
+      TxnProxy tp(env);
+      dbp.require_insert(tp.txn, i, record);
+      tp.commit();
+    }
+    REQUIRE(lenv()->journal->state.count_segments_recycled > 0u);
+
+    REQUIRE(0 == ups_env_close(follower, UPS_AUTO_CLEANUP));
+  }
 };
 
+int JournalFixture::delta_hook_calls;
+
 TEST_CASE("Journal/createClose", "")
 {
   JournalFixture f;
@@ -1277,5 +1701,67 @@ TEST_CASE("Journal/recoverWithCrc32Test", "")
   f.recoverWithCrc32Test();
 }
 
+TEST_CASE("Journal/deltaJournalSizeTest", "")
+{
+  JournalFixture f;
+  f.deltaJournalSizeTest();
+}
+
+TEST_CASE("Journal/recoverWithDeltasTest", "")
+{
+  JournalFixture f;
+  f.recoverWithDeltasTest();
+}
+
+TEST_CASE("Journal/writerTest", "")
+{
+  JournalFixture f;
+  f.writerTest();
+}
+
+TEST_CASE("Journal/segmentRecyclingTest", "")
+{
+  JournalFixture f;
+  f.segmentRecyclingTest();
+}
+
+TEST_CASE("Journal/checkpointTest", "")
+{
+  JournalFixture f;
+  f.checkpointTest();
+}
+
+TEST_CASE("Journal/parallelRecoveryTest", "")
+{
+  JournalFixture f;
+  f.parallelRecoveryTest(false);
+}
+
+TEST_CASE("Journal/parallelRecoveryDeltasTest", "")
+{
+  JournalFixture f;
+  f.parallelRecoveryTest(true);
+}
+
+TEST_CASE("Journal/tailTest", "")
+{
+  JournalFixture f;
+  f.tailTest(UPS_COMPRESSOR_NONE);
+}
+
+#ifdef HAVE_ZLIB_H
+TEST_CASE("Journal/tailCompressedTest", "")
+{
+  JournalFixture f;
+  f.tailTest(UPS_COMPRESSOR_ZLIB);
+}
+#endif
+
+TEST_CASE("Journal/tailPinsSegmentsTest", "")
+{
+  JournalFixture f;
+  f.tailPinsSegmentsTest();
+}
+
 } // namespace upscaledb
 
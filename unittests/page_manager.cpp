@@ -19,6 +19,7 @@
 #include "3rdparty/catch/catch.hpp"
 
 #include "1base/pickle.h"
+#include "3cache/compressed_cache.h"
 #include "3page_manager/freelist.h"
 #include "3page_manager/page_manager.h"
 #include "4context/context.h"
@@ -404,6 +405,61 @@ struct PageManagerFixture : BaseFixture {
     REQUIRE(page2 != 0);
     REQUIRE(page2->address() == page1->address() + page_size * 2);
   }
+
+  void compressedCacheTest() {
+    EnvConfig config = lenv()->config;
+    uint32_t page_size = config.page_size_bytes;
+    config.compressed_cache_size_bytes = 2048;
+    CompressedCache cc(config);
+    REQUIRE(cc.is_enabled());
+
+    std::vector<uint64_t> addresses;
+    for (int i = 0; i < 20; i++) {
+      Page page(lenv()->device.get());
+      page.alloc(0);
+      ::memset(page.raw_payload(), 'a' + i, page_size);
+      page.set_disk_size(i);
+      addresses.push_back(page.address());
+      cc.put(&page);
+      REQUIRE(cc.current_bytes <= 2048u);
+    }
+
+    // the oldest pages were dropped
+    Page page(lenv()->device.get());
+    REQUIRE(cc.get(addresses[0], &page) == false);
+    REQUIRE(cc.misses == 1u);
+
+    // the newest page is restored and then removed
+    REQUIRE(cc.get(addresses[19], &page) == true);
+    REQUIRE(cc.hits == 1u);
+    REQUIRE(page.address() == addresses[19]);
+    REQUIRE(page.disk_size() == 19u);
+    for (uint32_t i = 0; i < page_size; i++)
+      REQUIRE(page.raw_payload()[i] == 'a' + 19);
+    Page page2(lenv()->device.get());
+    REQUIRE(cc.get(addresses[19], &page2) == false);
+
+    cc.del(addresses[18]);
+    Page page3(lenv()->device.get());
+    REQUIRE(cc.get(addresses[18], &page3) == false);
+
+    cc.truncate(addresses[0]);
+    REQUIRE(cc.current_bytes == 0u);
+    REQUIRE(cc.entries.empty());
+  }
+
+  void compressedCacheDisabledTest() {
+    EnvConfig config = lenv()->config;
+    CompressedCache cc(config);
+    REQUIRE(cc.is_enabled() == false);
+
+    Page page(lenv()->device.get());
+    page.alloc(0);
+    cc.put(&page);
+    REQUIRE(cc.current_bytes == 0u);
+    REQUIRE(cc.get(page.address(), &page) == false);
+    REQUIRE(cc.misses == 0u);
+  }
 };
 
 TEST_CASE("PageManager/fetchPage", "")
@@ -508,6 +564,71 @@ TEST_CASE("PageManager/allocMultiBlobs", "")
   f.allocMultiBlobs();
 }
 
+TEST_CASE("PageManager/compressedCache", "")
+{
+  PageManagerFixture f(false);
+  f.compressedCacheTest();
+}
+
+TEST_CASE("PageManager/compressedCacheDisabled", "")
+{
+  PageManagerFixture f(false);
+  f.compressedCacheDisabledTest();
+}
+
+TEST_CASE("PageManager/compressedCacheFetch", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+      { UPS_PARAM_COMPRESSED_CACHE_SIZE, 16 * 1024 * 1024 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(UPS_DISABLE_MMAP, params);
+
+  std::vector<uint8_t> record(8, 'x');
+  DbProxy db(f.db);
+  for (uint32_t i = 0; i < 20000; i++)
+    db.require_insert(i, record);
+
+  // evicted pages are decompressed from the secondary cache
+  for (int j = 0; j < 2; j++)
+    for (uint32_t i = 0; i < 20000; i++)
+      db.require_find(i, record);
+
+  ups_env_metrics_t metrics;
+  REQUIRE(0 == ups_env_get_metrics(f.env, &metrics));
+  REQUIRE(metrics.compressed_cache_hits > 0);
+  REQUIRE(metrics.compressed_cache_bytes > 0);
+
+  f.require_parameter(UPS_PARAM_COMPRESSED_CACHE_SIZE, 16 * 1024 * 1024);
+
+  // reopen and verify again
+  ups_parameter_t open_params[] = {
+      { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+      { UPS_PARAM_COMPRESSED_CACHE_SIZE, 1024 * 1024 },
+      { 0, 0 }
+  };
+  f.close();
+  f.require_open(UPS_DISABLE_MMAP, open_params);
+  DbProxy db2(f.db);
+  for (int j = 0; j < 2; j++)
+    for (uint32_t i = 0; i < 20000; i++)
+      db2.require_find(i, record);
+}
+
+TEST_CASE("PageManager/compressedCacheInMemory", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_COMPRESSED_CACHE_SIZE, 1024 * 1024 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(UPS_IN_MEMORY, params, UPS_INV_PARAMETER);
+}
+
 TEST_CASE("PageManager-inmem/allocPage", "")
 {
   PageManagerFixture f(true);
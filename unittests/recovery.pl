@@ -16,8 +16,7 @@ sub big_records_test {
   $cmprsn = shift;
   for ($i = $inducer_start; $i < $inducer_stop; $i++) {
     unlink("recovery.db");
-    unlink("recovery.db.jrn0");
-    unlink("recovery.db.jrn1");
+    unlink(glob("recovery.db.jrn*"));
 
     print "===========================================================\n";
     print "inserting $max keys...\n";
@@ -46,8 +45,7 @@ sub simple_test {
   $cmprsn = shift;
   for ($i = $inducer_start; $i < $inducer_stop; $i++) {
     unlink("recovery.db");
-    unlink("recovery.db.jrn0");
-    unlink("recovery.db.jrn1");
+    unlink(glob("recovery.db.jrn*"));
 
     print "===========================================================\n";
     print "inserting $max keys...\n";
@@ -76,8 +74,7 @@ sub extended_test {
   $cmprsn = shift;
   for ($i = $inducer_start; $i < $inducer_stop; $i++) {
     unlink("recovery.db");
-    unlink("recovery.db.jrn0");
-    unlink("recovery.db.jrn1");
+    unlink(glob("recovery.db.jrn*"));
 
     print "===========================================================\n";
     print "inserting $max keys...\n";
@@ -106,8 +103,7 @@ sub duplicate_test {
   $cmprsn = shift;
   for ($i = $inducer_start; $i < $inducer_stop; $i++) {
     unlink("recovery.db");
-    unlink("recovery.db.jrn0");
-    unlink("recovery.db.jrn1");
+    unlink(glob("recovery.db.jrn*"));
 
     print "===========================================================\n";
     print "inserting $max keys...\n";
@@ -133,8 +129,7 @@ sub extended_duplicate_test {
   $cmprsn = shift;
   for ($i = $inducer_start; $i < $inducer_stop; $i++) {
     unlink("recovery.db");
-    unlink("recovery.db.jrn0");
-    unlink("recovery.db.jrn1");
+    unlink(glob("recovery.db.jrn*"));
 
     print "inserting $max keys...\n";
     for ($k = 0; $k < $max; $k++) {
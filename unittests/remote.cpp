@@ -1075,6 +1075,31 @@ struct RemoteFixture {
     REQUIRE(*(uint64_t *)uqi_result_get_record_data(result, &size) == 50);
     uqi_result_close(result);
 
+    uqi_statement_t *stmt;
+    REQUIRE(0 == uqi_prepare(env, "SUM($key) from database 22", &stmt));
+    for (int i = 0; i < 2; i++) {
+      REQUIRE(0 == uqi_execute(stmt, 0, 0, &result));
+      REQUIRE(*(uint64_t *)uqi_result_get_record_data(result, &size) == sum);
+      uqi_result_close(result);
+    }
+    uqi_statement_close(stmt);
+
+    uqi_cursor_t *cursor;
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 22", 0, 0,
+                            &cursor));
+    uint32_t rows = 0;
+    while (0 == uqi_cursor_next(cursor, &result)) {
+      for (uint32_t i = 0; i < uqi_result_get_row_count(result); i++, rows++) {
+        ups_key_t k;
+        uqi_result_get_key(result, i, &k);
+        REQUIRE(*(uint32_t *)k.data == rows);
+      }
+      uqi_result_close(result);
+    }
+    REQUIRE(rows == 50);
+    REQUIRE(UPS_KEY_NOT_FOUND == uqi_cursor_next(cursor, &result));
+    uqi_cursor_close(cursor);
+
     REQUIRE(0 == ups_env_close(env, 0));
   }
 
@@ -109,9 +109,9 @@ struct TxnFixture : BaseFixture {
 
     // clean up
     ldb()->txn_index->remove(node1);
-    delete node1;
+    ldb()->txn_index->release(node1);
     ldb()->txn_index->remove(node2);
-    delete node2;
+    ldb()->txn_index->release(node2);
   }
 
   void txnMultipleNodesTest() {
@@ -128,11 +128,11 @@ struct TxnFixture : BaseFixture {
 
     // clean up
     ldb()->txn_index->remove(node1);
-    delete node1;
+    ldb()->txn_index->release(node1);
     ldb()->txn_index->remove(node2);
-    delete node2;
+    ldb()->txn_index->release(node2);
     ldb()->txn_index->remove(node3);
-    delete node3;
+    ldb()->txn_index->release(node3);
   }
 
   void txnMultipleOpsTest() {
@@ -382,6 +382,35 @@ struct TxnFixture : BaseFixture {
     REQUIRE(0 == ups_txn_commit(txn2, 0));
   }
 
+  void arenaTest() {
+    DbProxy dbp(db);
+    std::vector<uint8_t> small(16, 's');
+    std::vector<uint8_t> large(Arena::kMaxChunkSize * 2, 'l');
+
+    // large records get a chunk of their own
+    TxnProxy txnp(env);
+    for (uint32_t i = 0; i < 1000; i++)
+      dbp.require_insert(txnp.txn, i, i % 100 == 0 ? large : small);
+    REQUIRE(txnp.ltxn()->arena.head != nullptr);
+    REQUIRE(ldb()->txn_index->node_pool.count == 1000u);
+    txnp.commit();
+
+    for (uint32_t i = 0; i < 1000; i++)
+      dbp.require_find(i, i % 100 == 0 ? large : small);
+
+    // the nodes are released when the Txn is flushed
+    REQUIRE(0 == ups_env_flush(env, 0));
+    REQUIRE(ldb()->txn_index->node_pool.count == 0u);
+
+    // ... or when it is aborted
+    TxnProxy txnp2(env);
+    for (uint32_t i = 1000; i < 1100; i++)
+      dbp.require_insert(txnp2.txn, i, small);
+    REQUIRE(ldb()->txn_index->node_pool.count == 100u);
+    txnp2.abort();
+    REQUIRE(ldb()->txn_index->node_pool.count == 0u);
+  }
+
   void issue105Test() {
     const int item_count = 50;
     for (int i = 0; i < item_count; i++) {
@@ -463,6 +492,12 @@ TEST_CASE("Txn/txnMultipleOpsTest", "")
   f.txnMultipleOpsTest();
 }
 
+TEST_CASE("Txn/arenaTest", "")
+{
+  TxnFixture f;
+  f.arenaTest();
+}
+
 TEST_CASE("Txn/txnInsertConflict1Test", "")
 {
   TxnFixture f;
@@ -16,11 +16,20 @@
  * See the file COPYING for License information.
  */
 
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <limits>
+
 #include "3rdparty/catch/catch.hpp"
 
 #include "ups/upscaledb_uqi.h"
 
+#include "3btree/btree_index.h"
 #include "4context/context.h"
+#include "4db/db_local.h"
+#include "4uqi/kernels.h"
 #include "4uqi/plugins.h"
 #include "4uqi/parser.h"
 #include "4uqi/result.h"
@@ -302,6 +311,74 @@ struct UqiFixture : BaseFixture {
     REQUIRE(0 == ups_cursor_close(cursor));
   }
 
+  void prepareTest() {
+    int i;
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_record_t record = {0};
+    uint64_t sum = 0;
+
+    // insert a few keys
+    for (i = 0; i < 10; i++) {
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+      sum += i;
+    }
+
+    uqi_statement_t *stmt;
+    REQUIRE(UPS_INV_PARAMETER == uqi_prepare(0, "SUM($key) from database 1",
+                            &stmt));
+    REQUIRE(UPS_INV_PARAMETER == uqi_prepare(env, 0, &stmt));
+    REQUIRE(UPS_INV_PARAMETER == uqi_prepare(env, "SUM($key) from database 1",
+                            0));
+    REQUIRE(UPS_PARSER_ERROR == uqi_prepare(env, "SUM($key) from", &stmt));
+    REQUIRE(stmt == 0);
+
+    REQUIRE(0 == uqi_prepare(env, "SUM($key) from database 1", &stmt));
+
+    ResultProxy rp;
+    REQUIRE(UPS_INV_PARAMETER == uqi_execute(0, 0, 0, &rp.result));
+    REQUIRE(UPS_INV_PARAMETER == uqi_execute(stmt, 0, 0, 0));
+
+    // the statement can be executed many times
+    for (int j = 0; j < 3; j++) {
+      REQUIRE(0 == uqi_execute(stmt, 0, 0, &rp.result));
+      rp.require("SUM", UPS_TYPE_UINT64, sum)
+        .close();
+    }
+
+    // ... with different cursors
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    i = 5;
+    REQUIRE(0 == ups_cursor_find(cursor, &key, 0, 0));
+    REQUIRE(0 == uqi_execute(stmt, cursor, 0, &rp.result));
+    rp.require("SUM", UPS_TYPE_UINT64, (uint64_t)5 + 6 + 7 + 8 + 9)
+      .close();
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    // ... and it sees modifications of the database
+    i = 10;
+    REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    REQUIRE(0 == uqi_execute(stmt, 0, 0, &rp.result));
+    rp.require("SUM", UPS_TYPE_UINT64, sum + 10)
+      .close();
+    uqi_statement_close(stmt);
+
+    // the comparisons are resolved for every execution
+    REQUIRE(0 == uqi_prepare(env, "count($key) from database 1 "
+                            "where $key > 2 and $key <= 7", &stmt));
+    for (int j = 0; j < 2; j++) {
+      REQUIRE(0 == uqi_execute(stmt, 0, 0, &rp.result));
+      rp.require("COUNT", UPS_TYPE_UINT64, (uint64_t)5)
+        .close();
+    }
+    uqi_statement_close(stmt);
+
+    // an unknown function is only detected when the statement is executed
+    REQUIRE(0 == uqi_prepare(env, "foo($key) from database 1", &stmt));
+    REQUIRE(UPS_PARSER_ERROR == uqi_execute(stmt, 0, 0, &rp.result));
+    uqi_statement_close(stmt);
+  }
+
   void endCursorTest() {
     int i = 0;
     uint64_t sum = 0;
@@ -515,6 +592,153 @@ struct UqiFixture : BaseFixture {
     return ups_db_insert(db, txn, &k, &r, 0);
   }
 
+  // Fetches all chunks of |cursor|; returns the keys
+  std::vector<uint32_t> fetchAll(uqi_cursor_t *cursor, int *pchunks = 0) {
+    std::vector<uint32_t> keys;
+    uqi_result_t *result;
+    ups_status_t st;
+    int chunks = 0;
+    while ((st = uqi_cursor_next(cursor, &result)) == 0) {
+      chunks++;
+      REQUIRE(uqi_result_get_key_type(result) == UPS_TYPE_UINT32);
+      uint32_t rows = uqi_result_get_row_count(result);
+      REQUIRE(rows > 0);
+      for (uint32_t i = 0; i < rows; i++) {
+        ups_key_t k;
+        uqi_result_get_key(result, i, &k);
+        REQUIRE(k.size == sizeof(uint32_t));
+        keys.push_back(*(uint32_t *)k.data);
+      }
+      uqi_result_close(result);
+    }
+    REQUIRE(st == UPS_KEY_NOT_FOUND);
+    // the cursor remains at the end
+    REQUIRE(UPS_KEY_NOT_FOUND == uqi_cursor_next(cursor, &result));
+    if (pchunks)
+      *pchunks = chunks;
+    return keys;
+  }
+
+  static void requireSequence(const std::vector<uint32_t> &keys,
+                  uint32_t first, uint32_t last) {
+    REQUIRE(keys.size() == last - first);
+    for (size_t i = 0; i < keys.size(); i++)
+      REQUIRE(keys[i] == first + i);
+  }
+
+  void selectCursorTest(uint32_t count) {
+    for (uint32_t i = 0; i < count; i++)
+      REQUIRE(0 == insertTxn(0, i));
+
+    uqi_cursor_t *cursor;
+    uqi_result_t *result;
+    REQUIRE(UPS_INV_PARAMETER == uqi_cursor_open(0,
+                            "value($key) from database 1", 0, 0, &cursor));
+    REQUIRE(UPS_INV_PARAMETER == uqi_cursor_open(env, 0, 0, 0, &cursor));
+    REQUIRE(UPS_INV_PARAMETER == uqi_cursor_open(env,
+                            "value($key) from database 1", 0, 0, 0));
+    REQUIRE(UPS_PARSER_ERROR == uqi_cursor_open(env, "value($key) from",
+                            0, 0, &cursor));
+    REQUIRE(cursor == 0);
+    REQUIRE(UPS_PARSER_ERROR == uqi_cursor_open(env,
+                            "foo($key) from database 1", 0, 0, &cursor));
+    REQUIRE(UPS_INV_PARAMETER == uqi_cursor_next(0, &result));
+
+    // the rows are returned in several chunks
+    int chunks = 0;
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1",
+                            0, 0, &cursor));
+    REQUIRE(UPS_INV_PARAMETER == uqi_cursor_next(cursor, 0));
+    requireSequence(fetchAll(cursor, &chunks), 0, count);
+    REQUIRE(chunks > 1);
+    uqi_cursor_close(cursor);
+
+    // aggregating functions return a single chunk
+    REQUIRE(0 == uqi_cursor_open(env, "sum($key) from database 1",
+                            0, 0, &cursor));
+    ResultProxy rp;
+    REQUIRE(0 == uqi_cursor_next(cursor, &rp.result));
+    rp.require("SUM", UPS_TYPE_UINT64, (uint64_t)count * (count - 1) / 2)
+      .close();
+    REQUIRE(UPS_KEY_NOT_FOUND == uqi_cursor_next(cursor, &result));
+    uqi_cursor_close(cursor);
+
+    // with comparisons
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1 "
+                            "where $key >= 1000 and $key < 30000",
+                            0, 0, &cursor));
+    requireSequence(fetchAll(cursor), 1000, 30000);
+    uqi_cursor_close(cursor);
+
+    // no matching rows at all
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1 "
+                            "where $key > 4000000000", 0, 0, &cursor));
+    REQUIRE(UPS_KEY_NOT_FOUND == uqi_cursor_next(cursor, &result));
+    uqi_cursor_close(cursor);
+
+    // with begin and end cursors; they are not modified
+    uint32_t i = 500;
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_cursor_t *begin, *end;
+    REQUIRE(0 == ups_cursor_create(&begin, db, 0, 0));
+    REQUIRE(0 == ups_cursor_find(begin, &key, 0, 0));
+    i = 40000;
+    REQUIRE(0 == ups_cursor_create(&end, db, 0, 0));
+    REQUIRE(0 == ups_cursor_find(end, &key, 0, 0));
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1",
+                            begin, end, &cursor));
+    requireSequence(fetchAll(cursor), 500, 40000);
+    uqi_cursor_close(cursor);
+    REQUIRE(0 == ups_cursor_move(begin, &key, 0, 0));
+    REQUIRE(*(uint32_t *)key.data == 500);
+    REQUIRE(0 == ups_cursor_close(begin));
+    REQUIRE(0 == ups_cursor_close(end));
+
+    // the database cannot be closed while the cursor is open
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1",
+                            0, 0, &cursor));
+    REQUIRE(UPS_CURSOR_STILL_OPEN == ups_db_close(db, 0));
+
+    // modifications are visible in the following chunks
+    REQUIRE(0 == uqi_cursor_next(cursor, &result));
+    uint32_t rows = uqi_result_get_row_count(result);
+    REQUIRE(rows < count);
+    uqi_result_close(result);
+    REQUIRE(0 == insertTxn(0, count));
+    REQUIRE(0 == insertTxn(0, count + 1));
+    requireSequence(fetchAll(cursor), rows, count + 2);
+    uqi_cursor_close(cursor);
+  }
+
+  void selectCursorMixedTest(uint32_t count) {
+    // even keys are stored in the btree, odd keys in a transaction
+    for (uint32_t i = 0; i < count; i += 2)
+      REQUIRE(0 == insertBtree(i));
+
+    ups_txn_t *txn;
+    REQUIRE(0 == ups_txn_begin(&txn, env, 0, 0, 0));
+    for (uint32_t i = count / 2 + 1; i < count / 2 + 2000; i += 2)
+      REQUIRE(0 == insertTxn(txn, i));
+    REQUIRE(0 == ups_txn_commit(txn, 0));
+
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < count; i++) {
+      if ((i & 1) == 0 || (i > count / 2 && i < count / 2 + 2000))
+        expected.push_back(i);
+    }
+
+    uqi_cursor_t *cursor;
+    REQUIRE(0 == uqi_cursor_open(env, "value($key) from database 1",
+                            0, 0, &cursor));
+    REQUIRE(fetchAll(cursor) == expected);
+    uqi_cursor_close(cursor);
+
+    // same result as uqi_select
+    ResultProxy rp;
+    REQUIRE(0 == uqi_select(env, "value($key) from database 1", &rp.result));
+    REQUIRE(uqi_result_get_row_count(rp.result) == expected.size());
+  }
+
   // tests the following sequences:
   // btree
   // btree, txn
@@ -978,6 +1202,56 @@ TEST_CASE("Uqi/parserTest", "")
   REQUIRE(stmt.function.flags == (UQI_STREAM_KEY | UQI_STREAM_RECORD));
 }
 
+TEST_CASE("Uqi/parserComparisonTest", "")
+{
+  SelectStatement stmt;
+  REQUIRE(0 == Parser::parse_select("sum($key) from database 1 "
+                          "where $key > 100 and $key <= 500", stmt));
+  REQUIRE(stmt.predicate.name.empty());
+  REQUIRE(stmt.comparisons.size() == 2);
+  REQUIRE(stmt.comparisons[0].stream == UQI_STREAM_KEY);
+  REQUIRE(stmt.comparisons[0].op == Comparison::kGreater);
+  REQUIRE(stmt.comparisons[0].constant == "100");
+  REQUIRE(stmt.comparisons[1].op == Comparison::kLessEqual);
+  REQUIRE(stmt.comparisons[1].constant == "500");
+
+  stmt = SelectStatement();
+  REQUIRE(0 == Parser::parse_select("count($key) from database 1 "
+                          "WHERE $record BETWEEN -1.5 AND 2e3", stmt));
+  REQUIRE(stmt.comparisons.size() == 2);
+  REQUIRE(stmt.comparisons[0].stream == UQI_STREAM_RECORD);
+  REQUIRE(stmt.comparisons[0].op == Comparison::kGreaterEqual);
+  REQUIRE(stmt.comparisons[0].constant == "-1.5");
+  REQUIRE(stmt.comparisons[1].op == Comparison::kLessEqual);
+  REQUIRE(stmt.comparisons[1].constant == "2e3");
+
+  // comparisons and a predicate
+  stmt = SelectStatement();
+  REQUIRE(0 == Parser::parse_select("top($record) from database 1 "
+                          "where $key = 7 and pred($key) and $record < 3 "
+                          "limit 5", stmt));
+  REQUIRE(stmt.predicate.name == "pred");
+  REQUIRE(stmt.limit == 5);
+  REQUIRE(stmt.comparisons.size() == 2);
+  REQUIRE(stmt.comparisons[0].op == Comparison::kEqual);
+  REQUIRE(stmt.comparisons[1].stream == UQI_STREAM_RECORD);
+  REQUIRE(stmt.comparisons[1].op == Comparison::kLess);
+
+  // the comparisons are reset for each statement
+  REQUIRE(0 == Parser::parse_select("top($record) from database 1 "
+                          "where $key >= 0 limit 5", stmt));
+  REQUIRE(stmt.comparisons.size() == 1);
+
+  REQUIRE(UPS_PARSER_ERROR == Parser::parse_select("sum($key) from "
+                          "database 1 where $key > abc", stmt));
+  REQUIRE(UPS_PARSER_ERROR == Parser::parse_select("sum($key) from "
+                          "database 1 where $key >", stmt));
+  REQUIRE(UPS_PARSER_ERROR == Parser::parse_select("sum($key) from "
+                          "database 1 where $key between 3", stmt));
+  REQUIRE(UPS_PARSER_ERROR == Parser::parse_select("sum($key) from "
+                          "database 1 where a($key) and b($key)", stmt));
+}
+
 TEST_CASE("Uqi/closedDatabaseTest", "")
 {
   UqiFixture f(false, UPS_TYPE_UINT32);
@@ -996,6 +1270,36 @@ TEST_CASE("Uqi/cursorTest", "")
   f.cursorTest();
 }
 
+TEST_CASE("Uqi/prepareTest", "")
+{
+  UqiFixture f(false, UPS_TYPE_UINT32);
+  f.prepareTest();
+}
+
+TEST_CASE("Uqi/prepareTxnTest", "")
+{
+  UqiFixture f(true, UPS_TYPE_UINT32);
+  f.prepareTest();
+}
+
+TEST_CASE("Uqi/selectCursorTest", "")
+{
+  UqiFixture f(false, UPS_TYPE_UINT32);
+  f.selectCursorTest(50000);
+}
+
+TEST_CASE("Uqi/selectCursorTxnTest", "")
+{
+  UqiFixture f(true, UPS_TYPE_UINT32);
+  f.selectCursorTest(50000);
+}
+
+TEST_CASE("Uqi/selectCursorMixedTest", "")
+{
+  UqiFixture f(true, UPS_TYPE_UINT32);
+  f.selectCursorMixedTest(50000);
+}
+
 TEST_CASE("Uqi/endCursorTest", "")
 {
   UqiFixture f(false, UPS_TYPE_UINT32);
@@ -1832,4 +2136,849 @@ TEST_CASE("Uqi/issue102Test", "")
   f.issue102Test();
 }
 
+static std::set<std::thread::id> scan_threads;
+static std::mutex scan_threads_mutex;
+
+static int
+thread_predicate(void *state, const void *key_data, uint32_t key_size,
+                const void *record_data, uint32_t record_size)
+{
+  std::lock_guard<std::mutex> lock(scan_threads_mutex);
+  scan_threads.insert(std::this_thread::get_id());
+  return (*(const uint32_t *)key_data % 3) == 0;
+}
+
+struct ParallelScanFixture : BaseFixture {
+  typedef std::vector<std::pair<std::string, std::string> > Rows;
+
+  ParallelScanFixture(uint32_t page_size, uint32_t key_compressor,
+                  uint32_t count)
+    : page_size(page_size), key_compressor(key_compressor), count(count) {
+  }
+
+  ~ParallelScanFixture() {
+    close();
+  }
+
+  // Runs all queries on a Database with and without parallel scans;
+  // the results must be identical
+  void compareTest() {
+    const char *queries[] = {
+      "sum($key) from database 1",
+      "count($key) from database 1",
+      "min($key) from database 1",
+      "max($key) from database 1",
+      "min($record) from database 1",
+      "max($record) from database 1",
+      "average($record) from database 1",
+      "top($key) from database 1 limit 10",
+      "top($record) from database 1 limit 20",
+      "bottom($record) from database 1 limit 15",
+      "sum($record) from database 1 where thread_pred($key)",
+      "count($key) from database 1 where thread_pred($key)",
+      "max($record) from database 1 where thread_pred($key)",
+      "average($key) from database 1 where thread_pred($key)",
+      "bottom($key) from database 1 where thread_pred($key) limit 7",
+      0
+    };
+
+    uqi_plugin_t plugin = {0};
+    plugin.name = "thread_pred";
+    plugin.type = UQI_PLUGIN_PREDICATE;
+    plugin.pred = thread_predicate;
+    REQUIRE(0 == uqi_register_plugin(&plugin));
+
+    create(4);
+    std::vector<Rows> parallel;
+    scan_threads.clear();
+    for (int i = 0; queries[i] != 0; i++)
+      parallel.push_back(select(queries[i]));
+    REQUIRE(scan_threads.size() > 1);
+    close();
+
+    open(0);
+    scan_threads.clear();
+    for (int i = 0; queries[i] != 0; i++)
+      REQUIRE(select(queries[i]) == parallel[i]);
+    REQUIRE(scan_threads.size() == 1);
+  }
+
+  // A scan with an end cursor, or with pending Transactions, is
+  // performed by a single thread
+  void fallbackTest() {
+    create(4);
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    REQUIRE(0 == ups_cursor_move(cursor, 0, 0, UPS_CURSOR_FIRST));
+
+    uqi_plugin_t plugin = {0};
+    plugin.name = "thread_pred";
+    plugin.type = UQI_PLUGIN_PREDICATE;
+    plugin.pred = thread_predicate;
+    REQUIRE(0 == uqi_register_plugin(&plugin));
+
+    scan_threads.clear();
+    uqi_result_t *result;
+    REQUIRE(0 == uqi_select_range(env, "count($key) from database 1 "
+                            "where thread_pred($key)", cursor, 0, &result));
+    uqi_result_close(result);
+    REQUIRE(scan_threads.size() == 1);
+    ups_cursor_close(cursor);
+  }
+
+  void create(uint32_t threads) {
+    ups_parameter_t env_params[] = {
+        {UPS_PARAM_PAGE_SIZE, page_size},
+        {UPS_PARAM_UQI_THREADS, threads},
+        {0, 0}
+    };
+    ups_parameter_t db_params[] = {
+        {UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32},
+        {UPS_PARAM_RECORD_TYPE, UPS_TYPE_UINT32},
+        {UPS_PARAM_KEY_COMPRESSION, key_compressor},
+        {0, 0}
+    };
+    if (key_compressor == 0)
+      db_params[2].name = 0;
+    require_create(0, env_params, UPS_FORCE_RECORDS_INLINE, db_params);
+    require_parameter(UPS_PARAM_UQI_THREADS, threads);
+
+    // the records have duplicate values; the results of min/max/top/bottom
+    // depend on the order of the keys
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t r = (i * 7) % 1000;
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t record = ups_make_record(&r, sizeof(r));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+  }
+
+  void open(uint32_t threads) {
+    ups_parameter_t env_params[] = {
+        {UPS_PARAM_UQI_THREADS, threads},
+        {0, 0}
+    };
+    require_open(0, env_params);
+  }
+
+  Rows select(const char *query) {
+    uqi_result_t *result;
+    REQUIRE(0 == uqi_select(env, query, &result));
+    Rows rows;
+    for (uint32_t i = 0; i < uqi_result_get_row_count(result); i++) {
+      ups_key_t key;
+      ups_record_t record;
+      uqi_result_get_key(result, i, &key);
+      uqi_result_get_record(result, i, &record);
+      rows.push_back(std::make_pair(
+                  std::string((const char *)key.data, key.size),
+                  std::string((const char *)record.data, record.size)));
+    }
+    uqi_result_close(result);
+    return rows;
+  }
+
+  uint64_t page_size;
+  uint64_t key_compressor;
+  uint32_t count;
+};
+
+TEST_CASE("Uqi/Parallel/compareTest", "")
+{
+  ParallelScanFixture f(1024, 0, 50000);
+  f.compareTest();
+}
+
+TEST_CASE("Uqi/Parallel/compressedKeysTest", "")
+{
+  ParallelScanFixture f(1024 * 16, UPS_COMPRESSOR_UINT32_VARBYTE, 200000);
+  f.compareTest();
+}
+
+TEST_CASE("Uqi/Parallel/fallbackTest", "")
+{
+  ParallelScanFixture f(1024, 0, 10000);
+  f.fallbackTest();
+}
+
+// keys in [1000, 3000), records in (100, 200]
+static int
+zone_predicate(void *state, const void *key_data, uint32_t key_size,
+                const void *record_data, uint32_t record_size)
+{
+  uint32_t k = *(const uint32_t *)key_data;
+  uint32_t r = *(const uint32_t *)record_data;
+  return k >= 1000 && k < 3000 && r > 100 && r <= 200;
+}
+
+struct ZoneMapFixture : BaseFixture {
+  typedef std::vector<std::pair<std::string, std::string> > Rows;
+
+  ~ZoneMapFixture() {
+    close();
+  }
+
+  // The same queries, once filtered by a predicate and once filtered
+  // by key and record ranges, must return identical results
+  void filterTest(uint32_t env_flags, uint32_t threads) {
+    const char *functions[][2] = {
+      {"sum($key)", ""},
+      {"count($key)", ""},
+      {"count($record)", ""},
+      {"min($record)", ""},
+      {"max($key)", ""},
+      {"average($record)", ""},
+      {"top($key)", " limit 10"},
+      {"bottom($record)", " limit 10"},
+      {"value($key)", ""},
+      {0, 0}
+    };
+
+    uqi_plugin_t plugin = {0};
+    plugin.name = "zone_pred";
+    plugin.type = UQI_PLUGIN_PREDICATE;
+    plugin.flags = UQI_PLUGIN_REQUIRE_BOTH_STREAMS;
+    plugin.pred = zone_predicate;
+    REQUIRE(0 == uqi_register_plugin(&plugin));
+
+    create(env_flags, threads, 50000);
+
+    for (int i = 0; functions[i][0] != 0; i++) {
+      std::string query = std::string(functions[i][0]) + " from database 1";
+      std::string limit = functions[i][1];
+      Rows expected = select_rows(
+                      (query + " where zone_pred($key)" + limit).c_str(),
+                      false);
+      REQUIRE(expected.size() > 0);
+      REQUIRE(select_rows((query + limit).c_str(), true) == expected);
+      // the second run uses the zones of the first run
+      REQUIRE(select_rows((query + limit).c_str(), true) == expected);
+    }
+  }
+
+  // Leaves which are not in the range are not fetched
+  void skipTest() {
+    create(0, 0, 50000);
+
+    LocalDb *ldb = (LocalDb *)db;
+    REQUIRE(ldb->btree_index->zone_map()->size() == 0);
+    uint64_t first = fetched_pages();
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 0);
+    first = fetched_pages() - first;
+
+    size_t zones = ldb->btree_index->zone_map()->size();
+    REQUIRE(zones > 100);
+
+    // now all leaves are skipped
+    uint64_t second = fetched_pages();
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 0);
+    second = fetched_pages() - second;
+    REQUIRE(second * 10 < first);
+    REQUIRE(ldb->btree_index->zone_map()->size() == zones);
+  }
+
+  // The zones are discarded when a leaf is modified
+  void invalidateTest() {
+    create(0, 0, 10000);
+
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 0);
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 0);
+
+    // overwrite a record
+    uint32_t k = 500;
+    uint32_t r = 2500;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t record = ups_make_record(&r, sizeof(r));
+    REQUIRE(0 == ups_db_insert(db, 0, &key, &record, UPS_OVERWRITE));
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 1);
+
+    // insert a new key
+    k = 20000;
+    REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 2);
+
+    // overwrite with a cursor
+    ups_cursor_t *cursor;
+    r = 2999;
+    k = 7000;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    REQUIRE(0 == ups_cursor_find(cursor, &key, 0, 0));
+    REQUIRE(0 == ups_cursor_overwrite(cursor, &record, 0));
+    REQUIRE(0 == ups_cursor_close(cursor));
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 3);
+
+    // erasing keys does not invalidate the zones
+    k = 500;
+    REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+    REQUIRE(count("count($key) from database 1", 2000, 3000) == 2);
+  }
+
+  // Ranges require numeric keys or records
+  void binaryTest() {
+    require_create(0);
+
+    SelectStatement stmt;
+    REQUIRE(0 == Parser::parse_select("count($key) from database 1", stmt));
+    stmt.record_range.set_lower(numeric(10), true);
+    Result *result = 0;
+    REQUIRE(UPS_PARSER_ERROR
+                    == ((LocalDb *)db)->select_range(&stmt, 0, 0, &result));
+    REQUIRE(result == 0);
+  }
+
+  void create(uint32_t env_flags, uint32_t threads, uint32_t count) {
+    ups_parameter_t env_params[] = {
+        {UPS_PARAM_PAGE_SIZE, 1024},
+        {UPS_PARAM_CACHE_SIZE, 1024 * 32},
+        {UPS_PARAM_UQI_THREADS, threads},
+        {0, 0}
+    };
+    ups_parameter_t db_params[] = {
+        {UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32},
+        {UPS_PARAM_RECORD_TYPE, UPS_TYPE_UINT32},
+        {0, 0}
+    };
+    require_create(env_flags, env_params, UPS_FORCE_RECORDS_INLINE,
+                    db_params);
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t r = (i * 7) % 1000;
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t record = ups_make_record(&r, sizeof(r));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+  }
+
+  static NumericValue numeric(uint64_t u) {
+    NumericValue v;
+    v.u = u;
+    return v;
+  }
+
+  uint64_t fetched_pages() {
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    return metrics.page_count_fetched;
+  }
+
+  // Runs |query|; if |ranges| is true then the keys are limited to
+  // [1000, 3000) and the records to (100, 200]
+  Rows select_rows(const char *query, bool ranges) {
+    SelectStatement stmt;
+    REQUIRE(0 == Parser::parse_select(query, stmt));
+    stmt.distinct = true;
+    if (ranges) {
+      stmt.key_range.set_lower(numeric(1000), true);
+      stmt.key_range.set_upper(numeric(3000), false);
+      stmt.record_range.set_lower(numeric(100), false);
+      stmt.record_range.set_upper(numeric(200), true);
+    }
+
+    Result *result;
+    REQUIRE(0 == ((LocalDb *)db)->select_range(&stmt, 0, 0, &result));
+    Rows rows;
+    for (uint32_t i = 0; i < result->row_count; i++) {
+      ups_key_t key;
+      ups_record_t record;
+      result->key(i, &key);
+      result->record(i, &record);
+      rows.push_back(std::make_pair(
+                  std::string((const char *)key.data, key.size),
+                  std::string((const char *)record.data, record.size)));
+    }
+    delete result;
+    return rows;
+  }
+
+  // Runs a COUNT |query| with records limited to [lower, upper]
+  uint64_t count(const char *query, uint32_t lower, uint32_t upper) {
+    SelectStatement stmt;
+    REQUIRE(0 == Parser::parse_select(query, stmt));
+    stmt.distinct = true;
+    stmt.record_range.set_lower(numeric(lower), true);
+    stmt.record_range.set_upper(numeric(upper), true);
+
+    Result *result;
+    REQUIRE(0 == ((LocalDb *)db)->select_range(&stmt, 0, 0, &result));
+    REQUIRE(result->row_count == 1);
+    ups_record_t record;
+    result->record(0, &record);
+    uint64_t c = *(uint64_t *)record.data;
+    delete result;
+    return c;
+  }
+};
+
+TEST_CASE("Uqi/ZoneMap/filterTest", "")
+{
+  ZoneMapFixture f;
+  f.filterTest(0, 0);
+}
+
+TEST_CASE("Uqi/ZoneMap/filterParallelTest", "")
+{
+  ZoneMapFixture f;
+  f.filterTest(0, 4);
+}
+
+TEST_CASE("Uqi/ZoneMap/filterTxnTest", "")
+{
+  ZoneMapFixture f;
+  f.filterTest(UPS_ENABLE_TRANSACTIONS, 0);
+}
+
+TEST_CASE("Uqi/ZoneMap/skipTest", "")
+{
+  ZoneMapFixture f;
+  f.skipTest();
+}
+
+TEST_CASE("Uqi/ZoneMap/invalidateTest", "")
+{
+  ZoneMapFixture f;
+  f.invalidateTest();
+}
+
+TEST_CASE("Uqi/ZoneMap/binaryTest", "")
+{
+  ZoneMapFixture f;
+  f.binaryTest();
+}
+
+// Returns the value of a COUNT or SUM query
+static uint64_t
+result_count(uqi_result_t *result)
+{
+  ups_record_t record = {0};
+  uqi_result_get_record(result, 0, &record);
+  return *(uint64_t *)record.data;
+}
+
+struct ComparisonFixture : BaseFixture {
+  ~ComparisonFixture() {
+    close();
+  }
+
+  void integerTest(uint32_t env_flags) {
+    create(env_flags, UPS_TYPE_UINT32, 50000);
+
+    REQUIRE(count("$key > 100 and $key < 500") == 399);
+    REQUIRE(count("$key between 100 and 500") == 401);
+    REQUIRE(count("$key = 777") == 1);
+    REQUIRE(count("$key == 50000") == 0);
+    REQUIRE(count("$key >= 49990") == 10);
+    REQUIRE(count("$key <= 9") == 10);
+    REQUIRE(count("$key > 100 and $key > 200 and $key < 301") == 100);
+    REQUIRE(count("$key > 500 and $key < 100") == 0);
+
+    // constants which are not unsigned integers
+    REQUIRE(count("$key > 100.5 and $key <= 200.9") == 100);
+    REQUIRE(count("$key >= 1e2 and $key < 2e2") == 100);
+    REQUIRE(count("$key > 99.0 and $key < 200.0") == 100);
+    REQUIRE(count("$key < -1") == 0);
+    REQUIRE(count("$key > -1") == 50000);
+    REQUIRE(count("$key = 1.5") == 0);
+    REQUIRE(count("$key > 1e30") == 0);
+    REQUIRE(count("$key < 1e30") == 50000);
+    REQUIRE(count("$key < 99999999999999999999999") == 50000);
+
+    // records
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < 50000; i++) {
+      uint32_t r = (i * 7) % 1000;
+      if (r >= 100 && r <= 200)
+        expected++;
+    }
+    REQUIRE(count("$record between 100 and 200") == expected);
+
+    expected = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+      if ((i * 7) % 1000 == 7)
+        expected++;
+    }
+    REQUIRE(count("$key < 1000 and $record = 7") == expected);
+
+    uqi_result_t *result;
+    REQUIRE(0 == uqi_select(env, "sum($key) from database 1 "
+                            "where $key between 10 and 20", &result));
+    REQUIRE(result_count(result) == 165);
+    uqi_result_close(result);
+
+    // a comparison and a predicate
+    uqi_plugin_t plugin = {0};
+    plugin.name = "zone_pred";
+    plugin.type = UQI_PLUGIN_PREDICATE;
+    plugin.flags = UQI_PLUGIN_REQUIRE_BOTH_STREAMS;
+    plugin.pred = zone_predicate;
+    REQUIRE(0 == uqi_register_plugin(&plugin));
+    expected = 0;
+    for (uint32_t i = 2000; i < 3000; i++) {
+      uint32_t r = (i * 7) % 1000;
+      if (r > 100 && r <= 200)
+        expected++;
+    }
+    REQUIRE(count("zone_pred($key) and $key >= 2000") == expected);
+  }
+
+  // The scan seeks to the first key in the range, and stops after the
+  // last one
+  void seekTest() {
+    create(0, UPS_TYPE_UINT32, 50000);
+
+    uint64_t full = fetched_pages();
+    REQUIRE(count("$record > 2000") == 0);
+    full = fetched_pages() - full;
+
+    uint64_t range = fetched_pages();
+    REQUIRE(count("$key between 20000 and 20100") == 101);
+    range = fetched_pages() - range;
+    REQUIRE(range * 10 < full);
+  }
+
+  // A cursor replaces the lower bound
+  void cursorTest() {
+    create(0, UPS_TYPE_UINT32, 10000);
+
+    uint32_t k = 1000;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    REQUIRE(0 == ups_cursor_find(cursor, &key, 0, 0));
+
+    uqi_result_t *result;
+    REQUIRE(0 == uqi_select_range(env, "count($key) from database 1 "
+                            "where $key < 1500", cursor, 0, &result));
+    REQUIRE(result_count(result) == 500);
+    uqi_result_close(result);
+    REQUIRE(0 == ups_cursor_close(cursor));
+  }
+
+  void realTest(int type) {
+    create(0, type, 1000);
+
+    REQUIRE(count("$key > 10 and $key <= 20") == 20);
+    REQUIRE(count("$key = 2.5") == 1);
+    REQUIRE(count("$key = 2.25") == 0);
+    REQUIRE(count("$key between -10 and 1") == 3);
+    REQUIRE(count("$key > 1e300") == 0);
+    REQUIRE(count("$key >= 499.5") == 1);
+  }
+
+  void smallTypeTest() {
+    create(0, UPS_TYPE_UINT8, 256);
+
+    REQUIRE(count("$key > 300") == 0);
+    REQUIRE(count("$key < 300") == 256);
+    REQUIRE(count("$key >= 255") == 1);
+    REQUIRE(count("$key > 254 and $key < 1000") == 1);
+    REQUIRE(count("$key < 0") == 0);
+  }
+
+  void binaryTest() {
+    require_create(0);
+
+    uqi_result_t *result;
+    REQUIRE(UPS_PARSER_ERROR == uqi_select(env, "count($key) from "
+                            "database 1 where $key > 5", &result));
+    REQUIRE(UPS_PARSER_ERROR == uqi_select(env, "count($key) from "
+                            "database 1 where $record > 5", &result));
+  }
+
+  void create(uint32_t env_flags, int key_type, uint32_t count) {
+    ups_parameter_t env_params[] = {
+        {UPS_PARAM_PAGE_SIZE, 1024},
+        {UPS_PARAM_CACHE_SIZE, 1024 * 32},
+        {0, 0}
+    };
+    ups_parameter_t db_params[] = {
+        {UPS_PARAM_KEY_TYPE, (uint64_t)key_type},
+        {UPS_PARAM_RECORD_TYPE, UPS_TYPE_UINT32},
+        {0, 0}
+    };
+    require_create(env_flags, env_params, UPS_FORCE_RECORDS_INLINE,
+                    db_params);
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint8_t u8 = (uint8_t)i;
+      float f = i * 0.5f;
+      double d = i * 0.5;
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      if (key_type == UPS_TYPE_UINT8)
+        key = ups_make_key(&u8, sizeof(u8));
+      else if (key_type == UPS_TYPE_REAL32)
+        key = ups_make_key(&f, sizeof(f));
+      else if (key_type == UPS_TYPE_REAL64)
+        key = ups_make_key(&d, sizeof(d));
+      uint32_t r = (i * 7) % 1000;
+      ups_record_t record = ups_make_record(&r, sizeof(r));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+  }
+
+  uint64_t fetched_pages() {
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    return metrics.page_count_fetched;
+  }
+
+  uint64_t count(const char *where) {
+    std::string query = std::string("count($key) from database 1 where ")
+            + where;
+    uqi_result_t *result;
+    REQUIRE(0 == uqi_select(env, query.c_str(), &result));
+    uint64_t c = result_count(result);
+    uqi_result_close(result);
+    return c;
+  }
+};
+
+TEST_CASE("Uqi/Comparison/integerTest", "")
+{
+  ComparisonFixture f;
+  f.integerTest(0);
+}
+
+TEST_CASE("Uqi/Comparison/integerTxnTest", "")
+{
+  ComparisonFixture f;
+  f.integerTest(UPS_ENABLE_TRANSACTIONS);
+}
+
+TEST_CASE("Uqi/Comparison/seekTest", "")
+{
+  ComparisonFixture f;
+  f.seekTest();
+}
+
+TEST_CASE("Uqi/Comparison/cursorTest", "")
+{
+  ComparisonFixture f;
+  f.cursorTest();
+}
+
+TEST_CASE("Uqi/Comparison/realTest", "")
+{
+  ComparisonFixture f;
+  f.realTest(UPS_TYPE_REAL64);
+  f.close();
+  f.realTest(UPS_TYPE_REAL32);
+}
+
+TEST_CASE("Uqi/Comparison/smallTypeTest", "")
+{
+  ComparisonFixture f;
+  f.smallTypeTest();
+}
+
+TEST_CASE("Uqi/Comparison/binaryTest", "")
+{
+  ComparisonFixture f;
+  f.binaryTest();
+}
+
+template<typename T>
+static std::vector<T>
+kernel_input(size_t length, uint32_t range)
+{
+  std::vector<T> v(length);
+  for (size_t i = 0; i < length; i++)
+    v[i] = (T)(::rand() % range);
+  return v;
+}
+
+static std::vector<uint8_t>
+kernel_mask(size_t length)
+{
+  std::vector<uint8_t> mask(length);
+  for (size_t i = 0; i < length; i++)
+    mask[i] = (::rand() % 3) == 0;
+  return mask;
+}
+
+// The values are small integers, therefore the sums of floating point
+// values are exact as well
+template<typename T>
+static void
+kernel_test(uint32_t range)
+{
+  for (size_t length = 0; length < 300; length++) {
+    std::vector<T> v = kernel_input<T>(length + 3, range);
+    std::vector<uint8_t> mask = kernel_mask(length + 3);
+    // unaligned input
+    const T *data = v.data() + length % 3;
+    const uint8_t *m = mask.data() + length % 3;
+
+    REQUIRE(Kernels::sum(data, length) == Kernels::scalar_sum(data, length,
+                            (const uint8_t *)0));
+    REQUIRE(Kernels::sum(data, length, m) == Kernels::scalar_sum(data,
+                            length, m));
+
+    T currents[] = {(T)0, (T)(range / 2), std::numeric_limits<T>::max()};
+    for (int c = 0; c < 3; c++) {
+      T current = currents[c];
+      REQUIRE(Kernels::find_min(data, length, (const uint8_t *)0, current)
+              == Kernels::scalar_find<std::less>(data, length,
+                            (const uint8_t *)0, current));
+      REQUIRE(Kernels::find_min(data, length, m, current)
+              == Kernels::scalar_find<std::less>(data, length, m, current));
+      REQUIRE(Kernels::find_max(data, length, (const uint8_t *)0, current)
+              == Kernels::scalar_find<std::greater>(data, length,
+                            (const uint8_t *)0, current));
+      REQUIRE(Kernels::find_max(data, length, m, current)
+              == Kernels::scalar_find<std::greater>(data, length, m,
+                            current));
+    }
+
+    T bounds[][2] = {
+      {(T)(range / 4), (T)(range / 2)},
+      {(T)0, std::numeric_limits<T>::max()},
+      {(T)(range / 2), (T)(range / 2)},
+      {(T)(range / 2), (T)(range / 4)}
+    };
+    for (int b = 0; b < 4; b++) {
+      std::vector<uint8_t> m1(m, m + length);
+      std::vector<uint8_t> m2(m1);
+      Kernels::select_range(data, length, bounds[b][0], bounds[b][1],
+                      m1.data());
+      Kernels::scalar_select_range(data, length, bounds[b][0], bounds[b][1],
+                      m2.data());
+      REQUIRE(m1 == m2);
+    }
+  }
+}
+
+TEST_CASE("Uqi/Kernels/uint8Test", "")
+{
+  kernel_test<uint8_t>(256);
+  kernel_test<uint8_t>(4);
+}
+
+TEST_CASE("Uqi/Kernels/uint16Test", "")
+{
+  kernel_test<uint16_t>(65536);
+  kernel_test<uint16_t>(4);
+}
+
+TEST_CASE("Uqi/Kernels/uint32Test", "")
+{
+  kernel_test<uint32_t>(0xffffffff);
+  kernel_test<uint32_t>(4);
+}
+
+TEST_CASE("Uqi/Kernels/uint64Test", "")
+{
+  // values with the highest bit set
+  for (size_t length = 1; length < 50; length++) {
+    std::vector<uint64_t> v(length);
+    for (size_t i = 0; i < length; i++)
+      v[i] = ((uint64_t)::rand() << 40) ^ (uint64_t)::rand()
+              ^ (i % 2 ? 0x8000000000000000ull : 0);
+    REQUIRE(Kernels::sum(v.data(), length) == Kernels::scalar_sum(v.data(),
+                            length, (const uint8_t *)0));
+    REQUIRE(Kernels::find_min(v.data(), length, (const uint8_t *)0,
+                            std::numeric_limits<uint64_t>::max())
+            == Kernels::scalar_find<std::less>(v.data(), length,
+                            (const uint8_t *)0,
+                            std::numeric_limits<uint64_t>::max()));
+    REQUIRE(Kernels::find_max(v.data(), length, (const uint8_t *)0,
+                            (uint64_t)0)
+            == Kernels::scalar_find<std::greater>(v.data(), length,
+                            (const uint8_t *)0, (uint64_t)0));
+  }
+
+  kernel_test<uint64_t>(0xffffffff);
+  kernel_test<uint64_t>(4);
+}
+
+TEST_CASE("Uqi/Kernels/realTest", "")
+{
+  kernel_test<float>(100000);
+  kernel_test<double>(100000);
+
+  // NaNs are ignored
+  float f[] = {3, std::numeric_limits<float>::quiet_NaN(), 1, 2, 1, 1, 1, 1,
+               5, 1, 7};
+  REQUIRE(Kernels::find_min(f, 11, 0, 10.f) == 2);
+  REQUIRE(Kernels::find_max(f, 11, 0, 0.f) == 10);
+  double d[] = {std::numeric_limits<double>::quiet_NaN(), 4, 1, 2, 9, 1};
+  REQUIRE(Kernels::find_min(d, 6, 0, 10.0) == 2);
+  REQUIRE(Kernels::find_max(d, 6, 0, 0.0) == 4);
+
+  // NaNs are never in a range
+  std::vector<uint8_t> mask(11, 1);
+  Kernels::select_range(f, 11, 1.f, 5.f, mask.data());
+  uint8_t expected[] = {1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0};
+  REQUIRE(mask == std::vector<uint8_t>(expected, expected + 11));
+  mask.assign(6, 1);
+  Kernels::select_range(d, 6, -std::numeric_limits<double>::infinity(),
+                  std::numeric_limits<double>::infinity(), mask.data());
+  REQUIRE(mask[0] == 0);
+  REQUIRE(mask[1] == 1);
+}
+
+template<typename T>
+static void
+kernel_benchmark(const char *name)
+{
+  const size_t kLength = 1024 * 1024;
+  const int kLoops = 50;
+  std::vector<T> v = kernel_input<T>(kLength, 100);
+  std::vector<uint8_t> mask = kernel_mask(kLength);
+
+  struct Run {
+    static double seconds(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now()
+                      - start).count();
+    }
+  };
+
+  double total = 0;
+  const char *labels[] = {"scalar sum", "sum", "scalar masked sum",
+                          "masked sum", "scalar min", "min"};
+  for (int k = 0; k < 6; k++) {
+    std::chrono::steady_clock::time_point start
+            = std::chrono::steady_clock::now();
+    for (int l = 0; l < kLoops; l++) {
+      switch (k) {
+        case 0:
+          total += Kernels::scalar_sum(v.data(), kLength, (const uint8_t *)0);
+          break;
+        case 1:
+          total += Kernels::sum(v.data(), kLength);
+          break;
+        case 2:
+          total += Kernels::scalar_sum(v.data(), kLength, mask.data());
+          break;
+        case 3:
+          total += Kernels::sum(v.data(), kLength, mask.data());
+          break;
+        case 4:
+          total += Kernels::scalar_find<std::less>(v.data(), kLength,
+                          (const uint8_t *)0, (T)50);
+          break;
+        case 5:
+          total += Kernels::find_min(v.data(), kLength, (const uint8_t *)0,
+                          (T)50);
+          break;
+      }
+    }
+    double seconds = Run::seconds(start);
+    printf("%-8s %-18s %8.1f M values/sec\n", name, labels[k],
+                    kLength * kLoops / seconds / 1000000.0);
+  }
+  REQUIRE(total != 0);
+}
+
+// A microbenchmark for the aggregation kernels; it is not run by default.
+// Use ./test "Uqi/Kernels/benchmark"
+TEST_CASE("Uqi/Kernels/benchmark", "[.]")
+{
+  kernel_benchmark<uint8_t>("uint8");
+  kernel_benchmark<uint16_t>("uint16");
+  kernel_benchmark<uint32_t>("uint32");
+  kernel_benchmark<uint64_t>("uint64");
+  kernel_benchmark<float>("real32");
+  kernel_benchmark<double>("real64");
+}
+
 } // namespace upscaledb
@@ -27,6 +27,9 @@
 #endif
 
 #include "1os/os.h"
+#include "3btree/btree_index.h"
+#include "3btree/btree_zint32_avx2.h"
+#include "3btree/btree_zint32_simdfor.h"
 
 #include "os.hpp"
 #include "fixture.hpp"
@@ -190,6 +193,49 @@ struct Zint32Fixture : BaseFixture {
     REQUIRE(size == 8ull);
     uqi_result_close(result);
   }
+
+  // Approximate lookups return the key from the block; two cursors walk
+  // over the keys in opposite directions and switch between blocks
+  void approxMatchTest() {
+    ups_key_t key = {0};
+    ups_record_t record = {0};
+
+    uint32_t max = 20000;
+    for (uint32_t i = 0; i < max; i += 2) {
+      key.data = (void *)&i;
+      key.size = sizeof(i);
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    std::srand(0);
+    for (int i = 0; i < 5000; i++) {
+      uint32_t k = 1 + 2 * (std::rand() % (max / 2 - 1));
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, UPS_FIND_GT_MATCH));
+      REQUIRE(*(uint32_t *)key.data == k + 1);
+
+      k = 1 + 2 * (std::rand() % (max / 2 - 1));
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, UPS_FIND_LT_MATCH));
+      REQUIRE(*(uint32_t *)key.data == k - 1);
+    }
+
+    ups_cursor_t *c1, *c2;
+    REQUIRE(0 == ups_cursor_create(&c1, db, 0, 0));
+    REQUIRE(0 == ups_cursor_create(&c2, db, 0, 0));
+    for (uint32_t i = 0; i < max; i += 2) {
+      ups_key_t k1 = {0};
+      ups_key_t k2 = {0};
+      REQUIRE(0 == ups_cursor_move(c1, &k1, 0, UPS_CURSOR_NEXT));
+      REQUIRE(*(uint32_t *)k1.data == i);
+      REQUIRE(0 == ups_cursor_move(c2, &k2, 0, UPS_CURSOR_PREVIOUS));
+      REQUIRE(*(uint32_t *)k2.data == max - 2 - i);
+    }
+    ups_cursor_close(c1);
+    ups_cursor_close(c2);
+  }
 };
 
 TEST_CASE("Zint32/Pod/randomDataTest", "")
@@ -548,6 +594,26 @@ TEST_CASE("Zint32/SimdFOR/uqiTest-duplicate", "")
 #endif
 }
 
+TEST_CASE("Zint32/Varbyte/approxMatchTest", "")
+{
+  Zint32Fixture f(UPS_COMPRESSOR_UINT32_VARBYTE, false, 0);
+  f.approxMatchTest();
+}
+
+TEST_CASE("Zint32/FOR/approxMatchTest", "")
+{
+  Zint32Fixture f(UPS_COMPRESSOR_UINT32_FOR, false, 0);
+  f.approxMatchTest();
+}
+
+TEST_CASE("Zint32/SimdFOR/approxMatchTest", "")
+{
+#ifdef HAVE_SSE2
+  Zint32Fixture f(UPS_COMPRESSOR_UINT32_SIMDFOR, false, 0);
+  f.approxMatchTest();
+#endif
+}
+
 TEST_CASE("Zint32/Zint32/invalidPagesizeTest", "")
 {
   ups_parameter_t p1[] = {
@@ -568,4 +634,341 @@ TEST_CASE("Zint32/Zint32/invalidPagesizeTest", "")
   ups_env_close(env, 0);
 }
 
+#ifdef HAVE_SSE2
+// Returns |count| sorted integers; the deltas have at most |bits| bits
+static std::vector<uint32_t>
+sorted_integers(uint32_t initvalue, int count, uint32_t bits)
+{
+  std::vector<uint32_t> v;
+  uint32_t mask = bits == 32 ? 0xffffffffu : (1u << bits) - 1;
+  uint32_t current = initvalue;
+  for (int i = 0; i < count; i++) {
+    uint32_t delta = bits == 0 ? 0 : ((uint32_t)std::rand() & mask);
+    if (bits > 16)
+      delta = (delta << 16 | (uint32_t)std::rand()) & mask;
+    if (bits == 32)
+      current = (uint32_t)(std::rand() << 16 | std::rand());
+    else
+      current += delta;
+    v.push_back(current);
+  }
+  if (bits == 32)
+    std::sort(v.begin(), v.end());
+  return v;
+}
+#endif // HAVE_SSE2
+
+TEST_CASE("Zint32/Avx2/simdcompTest", "")
+{
+#ifdef HAVE_SSE2
+  if (!os_has_avx2())
+    return;
+
+  std::srand(0);
+  for (uint32_t bits = 0; bits <= 32; bits++) {
+    uint32_t initvalue = bits == 32 ? 0 : 1000;
+    std::vector<uint32_t> in = sorted_integers(initvalue, 128, bits);
+    uint32_t packed[128];
+    uint32_t b = simdmaxbitsd1(initvalue, &in[0]);
+    REQUIRE(b <= bits);
+    simdpackwithoutmaskd1(initvalue, &in[0], (__m128i *)&packed[0], b);
+
+    uint32_t out1[128];
+    uint32_t out2[128];
+    simdunpackd1(initvalue, (__m128i *)&packed[0], &out1[0], b);
+    Zint32::avx2_unpackd1(initvalue, &packed[0], &out2[0], b);
+    REQUIRE(0 == ::memcmp(out1, out2, sizeof(out1)));
+    REQUIRE(0 == ::memcmp(&in[0], out2, sizeof(out2)));
+
+    // search for existing and missing keys with various lengths
+    for (int length = 1; length <= 128; length += 9) {
+      for (int i = 0; i < length; i++) {
+        uint32_t keys[] = { in[i], in[i] + 1, in[i] - 1 };
+        for (int k = 0; k < 3; k++) {
+          uint32_t r1, r2;
+          int s1 = simdsearchwithlengthd1(initvalue, (__m128i *)&packed[0],
+                          b, length, keys[k], &r1);
+          int s2 = Zint32::avx2_searchd1(initvalue, &packed[0], b, length,
+                          keys[k], &r2);
+          REQUIRE(s1 == s2);
+          if (s2 < length)
+            REQUIRE(r1 == r2);
+          else
+            REQUIRE(r2 == keys[k] + 1);
+        }
+      }
+    }
+  }
+#endif // HAVE_SSE2
+}
+
+TEST_CASE("Zint32/Avx2/simdforTest", "")
+{
+#ifdef HAVE_SSE2
+  if (!os_has_avx2())
+    return;
+
+  std::srand(0);
+  for (uint32_t bits = 0; bits <= 32; bits++) {
+    for (uint32_t length = 1; length <= 300; length += 7) {
+      // random values; the difference between the minimum and the
+      // maximum requires |bits| bits
+      std::vector<uint32_t> in;
+      uint32_t range = bits == 32 ? 0xffffffffu : (1u << bits) - 1;
+      for (uint32_t i = 0; i < length; i++)
+        in.push_back((uint32_t)(std::rand() << 16 ^ std::rand()) & range);
+      std::sort(in.begin(), in.end());
+      // the packed data is followed by a guard which must not be read
+      std::vector<uint32_t> packed(2 + length + 8, 0);
+      uint32_t *end = SimdFor::simd_compress_length_sorted(&in[0], length,
+                      &packed[0]);
+      REQUIRE(end <= &packed[0] + 2 + length + 4);
+
+      std::vector<uint32_t> out1(length + 4), out2(length + 4);
+      SimdFor::simd_uncompress_length(&packed[0], &out1[0], length);
+      Zint32::avx2_for_uncompress(&packed[0], &out2[0], length);
+      REQUIRE(0 == ::memcmp(&out1[0], &out2[0], length * sizeof(uint32_t)));
+      REQUIRE(0 == ::memcmp(&in[0], &out2[0], length * sizeof(uint32_t)));
+
+      // the search in the packed data returns the lower bound
+      for (uint32_t i = 0; i < length; i++) {
+        uint32_t keys[] = { in[i], in[i] + 1, in[i] - 1 };
+        for (int k = 0; k < 3; k++) {
+          uint32_t r;
+          int s = Zint32::avx2_for_search(&packed[0], length, keys[k], &r);
+          std::vector<uint32_t>::iterator it = std::lower_bound(in.begin(),
+                          in.end(), keys[k]);
+          REQUIRE(s == (int)(it - in.begin()));
+          if (it != in.end())
+            REQUIRE(r == *it);
+          else
+            REQUIRE(r == keys[k] + 1);
+        }
+      }
+    }
+  }
+#endif // HAVE_SSE2
+}
+
+struct Zint64Fixture : BaseFixture {
+  typedef std::vector<uint64_t> IntVector;
+
+  Zint64Fixture(uint64_t compressor, uint32_t flags = 0) {
+    ups_parameter_t p[] = {
+      { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+      { UPS_PARAM_KEY_COMPRESSION, compressor },
+      { 0, 0 }
+    };
+
+    require_create(0, nullptr, flags, p);
+  }
+
+  void insertFindEraseFind(const IntVector &ivec) {
+    ups_key_t key = {0};
+    ups_record_t record = {0};
+
+    for (IntVector::const_iterator it = ivec.begin(); it != ivec.end(); it++) {
+      uint64_t k = *it;
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+      record.data = (void *)&k;
+      record.size = sizeof(k);
+
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+
+    // walk with a cursor; the keys are returned in sorted order
+    IntVector sorted(ivec);
+    std::sort(sorted.begin(), sorted.end());
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    for (IntVector::const_iterator it = sorted.begin();
+                    it != sorted.end(); it++) {
+      REQUIRE(0 == ups_cursor_move(cursor, &key, &record, UPS_CURSOR_NEXT));
+      REQUIRE(key.size == sizeof(uint64_t));
+      REQUIRE(*(uint64_t *)key.data == *it);
+    }
+    REQUIRE(UPS_KEY_NOT_FOUND == ups_cursor_move(cursor, 0, 0,
+                            UPS_CURSOR_NEXT));
+    ups_cursor_close(cursor);
+
+    for (IntVector::const_iterator it = ivec.begin();
+                    it != ivec.end(); it++) {
+      uint64_t k = *it;
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(record.size == sizeof(uint64_t));
+      REQUIRE(*(uint64_t *)record.data == k);
+
+      // a missing neighbour is not found
+      k++;
+      if (!std::binary_search(sorted.begin(), sorted.end(), k))
+        REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(db, 0, &key, &record, 0));
+    }
+
+    for (IntVector::const_iterator it = ivec.begin();
+                    it != ivec.end(); it++) {
+      uint64_t k = *it;
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+
+      REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+    }
+
+    for (IntVector::const_iterator it = ivec.begin();
+                    it != ivec.end(); it++) {
+      uint64_t k = *it;
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+
+      REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(db, 0, &key, &record, 0));
+    }
+  }
+
+  void recordNumberTest() {
+    ups_key_t key = {0};
+    ups_record_t record = {0};
+
+    for (uint64_t i = 1; i <= 30000; i++) {
+      ::memset(&key, 0, sizeof(key));
+      record.data = (void *)&i;
+      record.size = sizeof(i);
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+      REQUIRE(*(uint64_t *)key.data == i);
+    }
+
+    for (uint64_t i = 1; i <= 30000; i++) {
+      key.data = (void *)&i;
+      key.size = sizeof(i);
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(*(uint64_t *)record.data == i);
+    }
+
+    uint64_t count;
+    REQUIRE(0 == ups_db_count(db, 0, 0, &count));
+    REQUIRE(count == 30000ull);
+  }
+
+  void uqiTest() {
+    ups_key_t key = {0};
+    ups_record_t record = {0};
+
+    for (uint64_t i = 0; i < 30000; i++) {
+      uint64_t k = (1ull << 40) + i;
+      key.data = (void *)&k;
+      key.size = sizeof(k);
+
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    uqi_result_t *result;
+    uint32_t size;
+
+    REQUIRE(0 == uqi_select(env, "COUNT($key) from database 1", &result));
+    REQUIRE(*(uint64_t *)uqi_result_get_record_data(result, &size) == 30000ull);
+    uqi_result_close(result);
+
+    REQUIRE(0 == uqi_select(env, "MAX($key) from database 1", &result));
+    REQUIRE(*(uint64_t *)uqi_result_get_key_data(result, &size)
+                    == (1ull << 40) + 29999);
+    uqi_result_close(result);
+  }
+};
+
+static Zint64Fixture::IntVector
+zint64_keys(int count, uint64_t stride, bool shuffle)
+{
+  Zint64Fixture::IntVector ivec;
+  for (int i = 0; i < count; i++)
+    ivec.push_back((1ull << 42) + i * stride);
+  if (shuffle) {
+    std::srand(0); // make this reproducable
+    std::random_shuffle(ivec.begin(), ivec.end());
+  }
+  return ivec;
+}
+
+TEST_CASE("Zint64/Varbyte/randomDataTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_VARBYTE);
+  f.insertFindEraseFind(zint64_keys(30000, 1, true));
+}
+
+TEST_CASE("Zint64/Varbyte/sparseDataTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_VARBYTE);
+  f.insertFindEraseFind(zint64_keys(30000, 1000000007ull, true));
+}
+
+TEST_CASE("Zint64/Varbyte/descendingDataTest", "")
+{
+  Zint64Fixture::IntVector ivec = zint64_keys(30000, 3, false);
+  std::reverse(ivec.begin(), ivec.end());
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_VARBYTE);
+  f.insertFindEraseFind(ivec);
+}
+
+TEST_CASE("Zint64/Varbyte/recordNumberTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_VARBYTE, UPS_RECORD_NUMBER64);
+  f.recordNumberTest();
+}
+
+TEST_CASE("Zint64/Varbyte/uqiTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_VARBYTE);
+  f.uqiTest();
+}
+
+TEST_CASE("Zint64/For/randomDataTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_FOR);
+  f.insertFindEraseFind(zint64_keys(30000, 1, true));
+}
+
+TEST_CASE("Zint64/For/sparseDataTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_FOR);
+  f.insertFindEraseFind(zint64_keys(30000, 1000000007ull, true));
+}
+
+TEST_CASE("Zint64/For/descendingDataTest", "")
+{
+  Zint64Fixture::IntVector ivec = zint64_keys(30000, 3, false);
+  std::reverse(ivec.begin(), ivec.end());
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_FOR);
+  f.insertFindEraseFind(ivec);
+}
+
+TEST_CASE("Zint64/For/recordNumberTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_FOR, UPS_RECORD_NUMBER64);
+  f.recordNumberTest();
+}
+
+TEST_CASE("Zint64/For/uqiTest", "")
+{
+  Zint64Fixture f(UPS_COMPRESSOR_UINT64_FOR);
+  f.uqiTest();
+}
+
+TEST_CASE("Zint64/invalidKeyTypeTest", "")
+{
+  ups_parameter_t p[] = {
+    { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32 },
+    { UPS_PARAM_KEY_COMPRESSION, UPS_COMPRESSOR_UINT64_FOR },
+    { 0, 0 }
+  };
+
+  ups_env_t *env;
+  ups_db_t *db;
+
+  REQUIRE(0 == ups_env_create(&env, "test.db", 0, 0644, 0));
+  REQUIRE(UPS_INV_PARAMETER == ups_env_create_db(env, &db, 1, 0, &p[0]));
+  ups_env_close(env, 0);
+}
+
 } // namespace upscaledb